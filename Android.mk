@@ -81,11 +81,16 @@ LOCAL_SRC_FILES := \
     stream/src/StreamContextProxy.cpp \
     stream/src/StreamUltraSound.cpp \
     stream/src/StreamSensorPCMData.cpp\
+    stream/src/StreamPool.cpp \
+    stream/src/StreamVirtualClock.cpp \
+    stream/src/StreamLatencyStats.cpp \
     device/src/Headphone.cpp \
     device/src/USBAudio.cpp \
+    device/src/USBStreamParser.cpp \
     device/src/Device.cpp \
     device/src/Speaker.cpp \
     device/src/Bluetooth.cpp \
+    device/src/BtPluginCache.cpp \
     device/src/SpeakerMic.cpp \
     device/src/HeadsetMic.cpp \
     device/src/HandsetMic.cpp \
@@ -114,16 +119,42 @@ LOCAL_SRC_FILES := \
     session/src/ACDEngine.cpp \
     resource_manager/src/ResourceManager.cpp \
     resource_manager/src/SndCardMonitor.cpp \
+    resource_manager/src/StreamHandleTable.cpp \
+    resource_manager/src/XmlSnapshot.cpp \
     utils/src/SoundTriggerXmlParser.cpp \
     utils/src/SoundTriggerPlatformInfo.cpp \
     utils/src/ACDPlatformInfo.cpp \
     utils/src/PalRingBuffer.cpp \
+    utils/src/PalSharedMutex.cpp \
+    utils/src/PalInitGraph.cpp \
+    utils/src/PalSerialExecutor.cpp \
+    utils/src/PalApiTrace.cpp \
+    utils/src/PalTraceLog.cpp \
     utils/src/SoundTriggerUtils.cpp \
     utils/src/SignalHandler.cpp
 ifeq ($(strip $(AUDIO_FEATURE_ENABLED_EC_REF_CAPTURE)),true)
 LOCAL_SRC_FILES += device/src/ECRefDevice.cpp
 endif
 
+# Optional: compile the platform usecaseKvManager.xml into static KV tables,
+# e.g. AUDIO_FEATURE_PAL_KV_XML := $(PAL_BASE_PATH)/configs/taro/usecaseKvManager.xml
+ifneq ($(strip $(AUDIO_FEATURE_PAL_KV_XML)),)
+LOCAL_CFLAGS += -DPAL_STATIC_KV_TABLES
+PAL_KV_GEN_DIR := $(call local-generated-sources-dir)
+PAL_KV_GEN_HDR := $(PAL_KV_GEN_DIR)/usecase_kv_tables.h
+$(PAL_KV_GEN_HDR): PRIVATE_CUSTOM_TOOL = python3 $(PAL_BASE_PATH)/tools/gen_kv_tables.py $< $@
+$(PAL_KV_GEN_HDR): $(AUDIO_FEATURE_PAL_KV_XML) $(PAL_BASE_PATH)/tools/gen_kv_tables.py
+	$(transform-generated-source)
+LOCAL_GENERATED_SOURCES += $(PAL_KV_GEN_HDR)
+LOCAL_C_INCLUDES += $(PAL_KV_GEN_DIR)
+endif
+
+# Optional: compile out the log sites less severe than a level,
+# e.g. AUDIO_FEATURE_PAL_LOG_MIN_LEVEL := PAL_LOG_DBG drops PAL_VERBOSE
+ifneq ($(strip $(AUDIO_FEATURE_PAL_LOG_MIN_LEVEL)),)
+LOCAL_CFLAGS += -DPAL_LOG_MIN_LEVEL=$(AUDIO_FEATURE_PAL_LOG_MIN_LEVEL)
+endif
+
 LOCAL_HEADER_LIBRARIES := \
     libspf-headers \
     libcapiv2_headers \
@@ -151,7 +182,44 @@ LOCAL_C_INCLUDES       += $(TOP)/external/tinycompress/include
 LOCAL_SHARED_LIBRARIES += libtinyalsa libtinycompress
 endif
 
+# Test build: run on the hardware free backend of test/sim instead of the
+# sound card, AGM and the ADSP.
+ifeq ($(strip $(AUDIO_FEATURE_PAL_SIM)),true)
+LOCAL_SHARED_LIBRARIES := $(filter-out libtinyalsa libtinycompress libqti-tinyalsa \
+                          libqti-tinycompress libaudioroute libagmclient,$(LOCAL_SHARED_LIBRARIES))
+LOCAL_SHARED_LIBRARIES += libpal_sim
+endif
+
+include $(BUILD_SHARED_LIBRARY)
+
+ifeq ($(strip $(AUDIO_FEATURE_PAL_SIM)),true)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE        := libpal_sim
+LOCAL_MODULE_OWNER  := qti
+LOCAL_MODULE_TAGS   := optional
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS        := -Wall -Werror -Wno-unused-parameter
+
+LOCAL_SRC_FILES := \
+    test/sim/PalSimCommon.cpp \
+    test/sim/PalSimMixer.cpp \
+    test/sim/PalSimPcm.cpp \
+    test/sim/PalSimCompress.cpp \
+    test/sim/PalSimRoute.cpp \
+    test/sim/PalSimAgm.cpp
+
+LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)/test/sim
+
+LOCAL_HEADER_LIBRARIES := \
+    libagm_headers \
+    libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := liblog
+
 include $(BUILD_SHARED_LIBRARY)
+endif
 
 endif
 
@@ -198,6 +266,387 @@ include $(BUILD_EXECUTABLE)
 
 include $(CLEAR_VARS)
 
+LOCAL_SRC_FILES  := test/PalUsbStreamBench.cpp \
+                    device/src/USBStreamParser.cpp
+
+LOCAL_MODULE               := PalUsbStreamBench
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalRingBufferBench.cpp \
+                    utils/src/PalRingBuffer.cpp \
+                    utils/src/PalTraceLog.cpp
+
+LOCAL_MODULE               := PalRingBufferBench
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalIpcLoopbackBench.cpp
+
+LOCAL_MODULE               := PalIpcLoopbackBench
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/ipc/HwBinders/pal_ipc_client
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          libhidlbase \
+                          libhidltransport \
+                          libutils \
+                          liblog \
+                          libcutils \
+                          libbase \
+                          libpalclient \
+                          vendor.qti.hardware.pal@1.0 \
+                          vendor.qti.hardware.pal@1.1
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalKvReplayBench.cpp
+
+LOCAL_MODULE               := PalKvReplayBench
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_C_INCLUDES := \
+    $(TOP)/system/media/audio_route/include \
+    $(TOP)/system/media/audio/include
+
+ifneq ($(filter 11 R, $(PLATFORM_VERSION)),)
+LOCAL_C_INCLUDES += $(TOP)/vendor/qcom/opensource/tinyalsa/include
+LOCAL_C_INCLUDES += $(TOP)/vendor/qcom/opensource/tinycompress/include
+else
+LOCAL_C_INCLUDES += $(TOP)/external/tinyalsa/include
+LOCAL_C_INCLUDES += $(TOP)/external/tinycompress/include
+endif
+
+LOCAL_HEADER_LIBRARIES := \
+    libspf-headers \
+    libcapiv2_headers \
+    libagm_headers \
+    libacdb_headers \
+    libpal_headers \
+    libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          libar-pal \
+                          libexpat \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+ifneq ($(strip $(AUDIO_FEATURE_PAL_KV_XML)),)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalKvTablesCheck.cpp
+
+LOCAL_MODULE               := PalKvTablesCheck
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_C_INCLUDES := \
+    $(TOP)/system/media/audio_route/include \
+    $(TOP)/system/media/audio/include
+
+ifneq ($(filter 11 R, $(PLATFORM_VERSION)),)
+LOCAL_C_INCLUDES += $(TOP)/vendor/qcom/opensource/tinyalsa/include
+LOCAL_C_INCLUDES += $(TOP)/vendor/qcom/opensource/tinycompress/include
+else
+LOCAL_C_INCLUDES += $(TOP)/external/tinyalsa/include
+LOCAL_C_INCLUDES += $(TOP)/external/tinycompress/include
+endif
+
+LOCAL_HEADER_LIBRARIES := \
+    libspf-headers \
+    libcapiv2_headers \
+    libagm_headers \
+    libacdb_headers \
+    libpal_headers \
+    libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          libar-pal \
+                          libexpat \
+                          liblog \
+                          liblx-osal
+
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+endif
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalStreamHandleStress.cpp \
+                    resource_manager/src/StreamHandleTable.cpp
+
+LOCAL_MODULE               := PalStreamHandleStress
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalSerialExecutorTest.cpp \
+                    utils/src/PalSerialExecutor.cpp
+
+LOCAL_MODULE               := PalSerialExecutorTest
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalBtTestPlugin.c
+
+LOCAL_MODULE               := libpal_bt_test_plugin
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -fvisibility=hidden
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/plugins/codecs
+
+LOCAL_HEADER_LIBRARIES := \
+    libspf-headers \
+    libarosal_headers
+
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalBtPluginCacheTest.cpp \
+                    device/src/BtPluginCache.cpp
+
+LOCAL_MODULE               := PalBtPluginCacheTest
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/device/inc \
+    $(LOCAL_PATH)/plugins/codecs
+
+LOCAL_HEADER_LIBRARIES := \
+    libspf-headers \
+    libarosal_headers \
+    libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          libdl \
+                          liblog \
+                          liblx-osal
+
+LOCAL_REQUIRED_MODULES := libpal_bt_test_plugin
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalInitGraphTest.cpp \
+                    utils/src/PalInitGraph.cpp
+
+LOCAL_MODULE               := PalInitGraphTest
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalVirtualClockTest.cpp \
+                    stream/src/StreamVirtualClock.cpp
+
+LOCAL_MODULE               := PalVirtualClockTest
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+ifeq ($(strip $(AUDIO_FEATURE_PAL_SIM)),true)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalUsecaseBench.cpp
+
+LOCAL_MODULE               := PalUsecaseBench
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          libar-pal \
+                          libpal_sim \
+                          liblog \
+                          libdl
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+endif
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalApiReplay.cpp
+
+LOCAL_MODULE               := PalApiReplay
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          libar-pal \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalApiTraceTest.cpp \
+                    utils/src/PalApiTrace.cpp
+
+LOCAL_MODULE               := PalApiTraceTest
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalTraceDump.cpp
+
+LOCAL_MODULE               := PalTraceDump
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES  := test/PalTraceLogTest.cpp \
+                    utils/src/PalTraceLog.cpp
+
+LOCAL_MODULE               := PalTraceLogTest
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_CFLAGS += -Wall -Werror -Wno-unused-variable
+
+LOCAL_HEADER_LIBRARIES := libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          liblog \
+                          liblx-osal
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
 include $(PAL_BASE_PATH)/plugins/Android.mk
 include $(PAL_BASE_PATH)/ipc/HwBinders/Android.mk
 
@@ -33,13 +33,22 @@
 #include <set>
 #include <unistd.h>
 #include <stdlib.h>
+#include <cutils/properties.h>
 #include <PalApi.h>
 #include "Stream.h"
 #include "Device.h"
 #include "ResourceManager.h"
+#include "SessionAlsaUtils.h"
+#include "StreamPool.h"
+#include "PalSerialExecutor.h"
+#include "PalApiTrace.h"
+#include "PalTraceLog.h"
 #include "PalCommon.h"
 class Stream;
 
+/* runs the pal_stream_*_async work, one lane per stream */
+static std::shared_ptr<PalSerialExecutor> asyncExecutor = nullptr;
+
 /*
  * enable_gcov - Enable gcov for pal
  *
@@ -68,6 +77,52 @@ static void notify_concurrent_stream(pal_stream_type_t type,
     rm->ConcurrentStreamStatus(type, dir, active);
 }
 
+static void notify_async_done(Stream *s, uint32_t event_id, int32_t status)
+{
+    struct pal_event_async_done_payload payload;
+
+    PAL_DBG(LOG_TAG, "stream %pK event %u status %d", s, event_id, status);
+    if (!s->streamCb)
+        return;
+
+    payload.status = status;
+    s->streamCb(s->getHandle(), event_id,
+                (uint32_t *)&payload, sizeof(payload), s->cookie);
+}
+
+/*
+ * Wait for queued async operations. Each one holds a user count from before
+ * it is posted until it is done, so a close that misses it here still waits
+ * for it in deactivateStreamUserCounter() and never frees the stream under
+ * it. Returns -EDEADLK when called from the stream's own async work, e.g. its
+ * OPEN_DONE callback, where everything queued before the caller already ran.
+ */
+static int drain_async_work(Stream *s)
+{
+    std::shared_ptr<PalSerialExecutor> executor;
+
+    if (!s->mAsyncPending.load())
+        return 0;
+
+    executor = std::atomic_load(&asyncExecutor);
+    return executor ? executor->drain(s) : 0;
+}
+
+/*
+ * Public handle to stream, NULL when the handle is stale or closed. The
+ * stream is only returned once pending async operations are done, so no
+ * call runs against a stream still being opened.
+ */
+static Stream *get_stream(pal_stream_handle_t *stream_handle)
+{
+    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    Stream *s = rm ? rm->getStream(stream_handle) : NULL;
+
+    if (s)
+        drain_async_work(s);
+    return s;
+}
+
 /*
  * pal_init - Initialize PAL
  *
@@ -80,7 +135,12 @@ int32_t pal_init(void)
 {
     PAL_DBG(LOG_TAG, "Enter.");
     int32_t ret = 0;
+    uint32_t workers = PAL_EXECUTOR_DEFAULT_WORKERS;
     std::shared_ptr<ResourceManager> ri = NULL;
+#ifndef FEATURE_IPQ_OPENWRT
+    char value[PROPERTY_VALUE_MAX] = {0};
+#endif
+
     try {
         ri = ResourceManager::getInstance();
     } catch (const std::exception& e) {
@@ -95,6 +155,25 @@ int32_t pal_init(void)
     }
 
     ri->init();
+    StreamPool::init();
+
+#ifndef FEATURE_IPQ_OPENWRT
+    if (property_get("vendor.audio.pal.async_workers", value, "") > 0)
+        workers = atoi(value);
+#endif
+    std::atomic_store(&asyncExecutor,
+                      std::make_shared<PalSerialExecutor>("stream_async", workers));
+
+#ifndef FEATURE_IPQ_OPENWRT
+    /* opt-in API call recording, see PalApiTrace.h */
+    if (property_get("vendor.audio.pal.api_trace", value, "") > 0)
+        PalApiTrace::start(value, property_get_int64("vendor.audio.pal.api_trace_max_bytes",
+                                                     PAL_API_TRACE_DEFAULT_MAX_BYTES));
+    /* binary log of the per buffer PAL_TRACE_* sites, see PalTraceLog.h */
+    if (property_get("vendor.audio.pal.trace_log", value, "") > 0)
+        PalTraceLog::start(value, property_get_int32("vendor.audio.pal.trace_log_entries",
+                                                     PAL_TRACE_DEFAULT_ENTRIES));
+#endif
 
     ret = ri->initContextManager();
     if (ret != 0) {
@@ -118,6 +197,7 @@ void pal_deinit(void)
     PAL_DBG(LOG_TAG, "Enter.");
 
     std::shared_ptr<ResourceManager> ri = NULL;
+    std::shared_ptr<PalSerialExecutor> executor = NULL;
 
     try {
         ri = ResourceManager::getInstance();
@@ -126,7 +206,13 @@ void pal_deinit(void)
     }
     ri->deInitContextManager();
 
+    executor = std::atomic_exchange(&asyncExecutor, std::shared_ptr<PalSerialExecutor>());
+    if (executor)
+        executor->stop();
+    StreamPool::deinit();
     ResourceManager::deinit();
+    PalApiTrace::stop();
+    PalTraceLog::stop();
     PAL_DBG(LOG_TAG, "Exit.");
     return;
 }
@@ -141,8 +227,14 @@ int32_t pal_stream_open(struct pal_stream_attributes *attributes,
     uint64_t *stream = NULL;
     Stream *s = NULL;
     int status;
+    bool pooled = false;
     struct pal_stream_attributes sAttr;
     std::shared_ptr<ResourceManager> rm = NULL;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_OPEN, NULL, status,
+                           {{attributes, sizeof(*attributes)},
+                            {devices, no_of_devices * sizeof(*devices)},
+                            {modifiers, no_of_modifiers * sizeof(*modifiers)},
+                            (uint64_t)(cb != NULL)});
 
     rm = ResourceManager::getInstance();
     if (!rm) {
@@ -159,6 +251,13 @@ int32_t pal_stream_open(struct pal_stream_attributes *attributes,
 
     PAL_INFO(LOG_TAG, "Enter, stream type:%d", attributes->type);
 
+    s = StreamPool::claim(attributes, devices, no_of_devices, no_of_modifiers);
+    if (s) {
+        status = 0;
+        pooled = true;
+        goto opened;
+    }
+
     try {
         s = Stream::create(attributes, devices, no_of_devices, modifiers,
                            no_of_modifiers);
@@ -174,6 +273,11 @@ int32_t pal_stream_open(struct pal_stream_attributes *attributes,
         goto exit;
     }
     status = s->open();
+    /* parked streams keep their front ends, give them back and try once more */
+    if (status == -ENOSPC && StreamPool::reclaim() > 0) {
+        PAL_INFO(LOG_TAG, "no front end left, retrying after reclaiming pooled streams");
+        status = s->open();
+    }
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_open failed with status %d", status);
         if (s->close() != 0) {
@@ -183,26 +287,167 @@ int32_t pal_stream_open(struct pal_stream_attributes *attributes,
         goto exit;
     }
 
+opened:
+    StreamPool::markOpened(s, pooled);
     s->getStreamAttributes(&sAttr);
     notify_concurrent_stream(sAttr.type, sAttr.direction, true);
 
     if (cb)
        s->registerCallBack(cb, cookie);
+    /* kept for the async completions whatever the stream does with cb */
+    s->streamCb = cb;
+    s->cookie = cookie;
 
-    rm->initStreamUserCounter(s);
-    stream = reinterpret_cast<uint64_t *>(s);
+    status = rm->initStreamUserCounter(s);
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "no handle for the stream, status %d", status);
+        notify_concurrent_stream(sAttr.type, sAttr.direction, false);
+        s->setCachedState(STREAM_IDLE);
+        s->close();
+        delete s;
+        goto exit;
+    }
+    stream = s->getHandle();
     *stream_handle = stream;
+    trace.setHandle(stream);
 exit:
     PAL_INFO(LOG_TAG, "Exit. Value of stream_handle %pK, status %d", stream, status);
     return status;
 }
 
+static void stream_open_work(Stream *s, bool pooled)
+{
+    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    struct pal_stream_attributes sAttr;
+    int status = 0;
+
+    if (!pooled) {
+        status = rm->increaseStreamUserCounter(s);
+        if (0 != status) {
+            PAL_ERR(LOG_TAG, "failed to increase stream user count");
+            goto done;
+        }
+        status = s->open();
+        if (status == -ENOSPC && StreamPool::reclaim() > 0) {
+            PAL_INFO(LOG_TAG, "no front end left, retrying after reclaiming pooled streams");
+            status = s->open();
+        }
+        rm->decreaseStreamUserCounter(s);
+        if (0 != status) {
+            PAL_ERR(LOG_TAG, "async open failed with status %d", status);
+            /* half opened, only good for pal_stream_close */
+            s->mPoolable = false;
+        }
+    }
+
+    /* pal_stream_close reports inactive whatever the open status was */
+    s->getStreamAttributes(&sAttr);
+    notify_concurrent_stream(sAttr.type, sAttr.direction, true);
+done:
+    notify_async_done(s, PAL_STREAM_CBK_EVENT_OPEN_DONE, status);
+}
+
+int32_t pal_stream_open_async(struct pal_stream_attributes *attributes,
+                              uint32_t no_of_devices, struct pal_device *devices,
+                              uint32_t no_of_modifiers, struct modifier_kv *modifiers,
+                              pal_stream_callback cb, uint64_t cookie,
+                              pal_stream_handle_t **stream_handle)
+{
+    Stream *s = NULL;
+    int status;
+    bool pooled = false;
+    std::shared_ptr<ResourceManager> rm = NULL;
+    std::shared_ptr<PalSerialExecutor> executor = std::atomic_load(&asyncExecutor);
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_OPEN_ASYNC, NULL, status,
+                           {{attributes, sizeof(*attributes)},
+                            {devices, no_of_devices * sizeof(*devices)},
+                            {modifiers, no_of_modifiers * sizeof(*modifiers)},
+                            (uint64_t)(cb != NULL)});
+
+    rm = ResourceManager::getInstance();
+    if (!rm || !executor) {
+        PAL_ERR(LOG_TAG, "PAL not initialized");
+        status = -EINVAL;
+        return status;
+    }
+
+    if (!attributes || !stream_handle) {
+        status = -EINVAL;
+        PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
+        return status;
+    }
+
+    PAL_INFO(LOG_TAG, "Enter, stream type:%d", attributes->type);
+
+    s = StreamPool::claim(attributes, devices, no_of_devices, no_of_modifiers);
+    if (s) {
+        pooled = true;
+    } else {
+        try {
+            s = Stream::create(attributes, devices, no_of_devices, modifiers,
+                               no_of_modifiers);
+        } catch (const std::exception& e) {
+            status = -EINVAL;
+            PAL_ERR(LOG_TAG, "Stream create failed: %s", e.what());
+            Stream::handleStreamException(attributes, cb, cookie);
+            return status;
+        }
+        if (!s) {
+            status = -EINVAL;
+            PAL_ERR(LOG_TAG, "stream creation failed status %d", status);
+            return status;
+        }
+    }
+
+    StreamPool::markOpened(s, pooled);
+    if (cb)
+       s->registerCallBack(cb, cookie);
+    s->streamCb = cb;
+    s->cookie = cookie;
+
+    /* counted before the handle exists, so every call through it waits for the open */
+    s->mAsyncPending++;
+    /* active from here on so the handle can be closed even if the open fails */
+    status = rm->initStreamUserCounter(s);
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "no handle for the stream, status %d", status);
+        if (pooled) {
+            s->setCachedState(STREAM_IDLE);
+            s->close();
+        }
+        delete s;
+        return status;
+    }
+    *stream_handle = s->getHandle();
+    trace.setHandle(*stream_handle);
+
+    /* pins the stream until the completion is delivered, dropped last */
+    rm->increaseStreamUserCounter(s);
+    status = executor->post(s, [s, pooled, rm] {
+        stream_open_work(s, pooled);
+        s->mAsyncPending--;
+        rm->decreaseStreamUserCounter(s);
+    });
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "queueing failed with status %d, open inline", status);
+        stream_open_work(s, pooled);
+        s->mAsyncPending--;
+        rm->decreaseStreamUserCounter(s);
+        status = 0;
+    }
+
+    PAL_INFO(LOG_TAG, "Exit. Value of stream_handle %pK, status %d", *stream_handle, status);
+    return status;
+}
+
 int32_t pal_stream_close(pal_stream_handle_t *stream_handle)
 {
     Stream *s = NULL;
     int status;
     struct pal_stream_attributes sAttr;
     std::shared_ptr<ResourceManager> rm = NULL;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_CLOSE, stream_handle, status);
+
     if (!stream_handle) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
@@ -217,22 +462,36 @@ int32_t pal_stream_close(pal_stream_handle_t *stream_handle)
         return status;
     }
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
+    s = rm->getStream(stream_handle);
+    if (!s) {
         status = -EINVAL;
-        rm->unlockActiveStream();
         return status;
     }
 
-    rm->unlockActiveStream();
+    status = drain_async_work(s);
+    if (status) {
+        PAL_ERR(LOG_TAG, "close from the stream's own async work, status %d", status);
+        return status;
+    }
+    status = StreamPool::park(s);
+    if (status == -EBUSY) {
+        status = 0;
+        return status;
+    }
+    if (status == 0) {
+        s->getStreamAttributes(&sAttr);
+        notify_concurrent_stream(sAttr.type, sAttr.direction, false);
+        PAL_INFO(LOG_TAG, "Exit. stream parked");
+        return status;
+    }
 
-    s = reinterpret_cast<Stream *>(stream_handle);
     s->setCachedState(STREAM_IDLE);
     status = s->close();
 
     if (rm->deactivateStreamUserCounter(s)) {
         PAL_ERR(LOG_TAG, "stream is being closed by another client");
-        return 0;
+        status = 0;
+        return status;
     }
 
     if (0 != status) {
@@ -243,7 +502,6 @@ exit:
     s->getStreamAttributes(&sAttr);
     notify_concurrent_stream(sAttr.type, sAttr.direction, false);
     delete s;
-    rm->eraseStreamUserCounter(s);
     PAL_INFO(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -253,6 +511,9 @@ int32_t pal_stream_start(pal_stream_handle_t *stream_handle)
     Stream *s = NULL;
     std::shared_ptr<ResourceManager> rm = NULL;
     int status;
+    uint32_t mixerCtlOps = SessionAlsaUtils::getMixerCtlOps();
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_START, stream_handle, status);
+
     if (!stream_handle) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
@@ -267,26 +528,15 @@ int32_t pal_stream_start(pal_stream_handle_t *stream_handle)
         goto exit;
     }
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
-        status = -EINVAL;
-        goto exit;
-    }
-
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockActiveStream();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         goto exit;
     }
-    rm->unlockActiveStream();
+    drain_async_work(s);
     status = s->start();
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "stream start failed. status %d", status);
@@ -294,7 +544,54 @@ int32_t pal_stream_start(pal_stream_handle_t *stream_handle)
     }
 
 exit:
-    PAL_INFO(LOG_TAG, "Exit. status %d", status);
+    PAL_INFO(LOG_TAG, "Exit. status %d, mixer ctl ops %u", status,
+             SessionAlsaUtils::getMixerCtlOps() - mixerCtlOps);
+    return status;
+}
+
+int32_t pal_stream_start_async(pal_stream_handle_t *stream_handle)
+{
+    Stream *s = NULL;
+    std::shared_ptr<ResourceManager> rm = NULL;
+    std::shared_ptr<PalSerialExecutor> executor = std::atomic_load(&asyncExecutor);
+    int status;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_START_ASYNC, stream_handle, status);
+
+    if (!stream_handle) {
+        status = -EINVAL;
+        PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
+        return status;
+    }
+    PAL_DBG(LOG_TAG, "Enter. Stream handle %pK", stream_handle);
+
+    rm = ResourceManager::getInstance();
+    if (!rm || !executor) {
+        PAL_ERR(LOG_TAG, "PAL not initialized");
+        status = -EINVAL;
+        return status;
+    }
+
+    /* pinned until the queued start is done, a close waits for it */
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "failed to increase stream user count");
+        return status;
+    }
+
+    s->mAsyncPending++;
+    status = executor->post(s, [s, stream_handle, rm] {
+        notify_async_done(s, PAL_STREAM_CBK_EVENT_START_DONE,
+                          pal_stream_start(stream_handle));
+        s->mAsyncPending--;
+        rm->decreaseStreamUserCounter(s);
+    });
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "queueing start failed with status %d", status);
+        s->mAsyncPending--;
+        rm->decreaseStreamUserCounter(s);
+    }
+
+    PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
 
@@ -303,6 +600,7 @@ int32_t pal_stream_stop(pal_stream_handle_t *stream_handle)
     Stream *s = NULL;
     std::shared_ptr<ResourceManager> rm = NULL;
     int status;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_STOP, stream_handle, status);
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -317,27 +615,28 @@ int32_t pal_stream_stop(pal_stream_handle_t *stream_handle)
         goto exit;
     }
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
+    s = rm->getStream(stream_handle);
+    if (!s) {
         status = -EINVAL;
         goto exit;
     }
-
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    /* a queued pal_stream_start_async must not run after the stop */
+    status = drain_async_work(s);
+    if (status) {
+        PAL_ERR(LOG_TAG, "stop from the stream's own async work, status %d", status);
+        goto exit;
+    }
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockActiveStream();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         goto exit;
     }
-    rm->unlockActiveStream();
     s->setCachedState(STREAM_STOPPED);
     status = s->stop();
+    /* the session position restarts from zero with the next start */
+    s->resetVirtualClock();
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "stream stop failed. status : %d", status);
@@ -359,12 +658,16 @@ ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *
         return status;
     }
     PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
     status = s->write(buf);
     if (status < 0) {
         PAL_ERR(LOG_TAG, "stream write failed status %d", status);
         return status;
     }
+    if (s->mFirstWritePending)
+        StreamPool::recordFirstWrite(s);
     PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -379,7 +682,9 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
         return status;
     }
     PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
     status = s->read(buf);
     if (status < 0) {
         PAL_ERR(LOG_TAG, "stream read failed status %d", status);
@@ -400,8 +705,14 @@ int32_t pal_stream_get_param(pal_stream_handle_t *stream_handle,
         return status;
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = s->getParameters(param_id, (void **)param_payload);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
+    /* every stream type keeps these, answer them here for all of them */
+    if (param_id == PAL_PARAM_ID_STREAM_LATENCY_STATS)
+        status = s->getLatencyStatsParam(param_payload ? *param_payload : NULL);
+    else
+        status = s->getParameters(param_id, (void **)param_payload);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "get parameters failed status %d param_id %u", status, param_id);
         return status;
@@ -416,6 +727,10 @@ int32_t pal_stream_set_param(pal_stream_handle_t *stream_handle, uint32_t param_
     Stream *s = NULL;
     int status;
     std::shared_ptr<ResourceManager> rm = NULL;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_SET_PARAM, stream_handle, status,
+                           {(uint64_t)param_id,
+                            {param_payload, param_payload ?
+                             sizeof(*param_payload) + param_payload->payload_size : 0}});
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -424,7 +739,11 @@ int32_t pal_stream_set_param(pal_stream_handle_t *stream_handle, uint32_t param_
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK param_id %d", stream_handle,
             param_id);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
+    /* graph state a later owner would inherit, do not pool the stream */
+    s->mPoolable = false;
     status = s->setParameters(param_id, (void *)param_payload);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "set parameters failed status %d param_id %u", status, param_id);
@@ -450,6 +769,10 @@ int32_t pal_stream_set_volume(pal_stream_handle_t *stream_handle,
     Stream *s = NULL;
     int status;
     std::shared_ptr<ResourceManager> rm = NULL;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_SET_VOLUME, stream_handle, status,
+                           {{volume, volume ? sizeof(*volume) +
+                             volume->no_of_volpair * sizeof(struct pal_channel_vol_kv) : 0}});
+
     rm = ResourceManager::getInstance();
     if (!rm) {
         PAL_ERR(LOG_TAG, "Invalid resource manager");
@@ -464,26 +787,15 @@ int32_t pal_stream_set_volume(pal_stream_handle_t *stream_handle,
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
-        status = -EINVAL;
-        return status;
-    }
-
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockActiveStream();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockActiveStream();
+    drain_async_work(s);
     status = s->setVolume(volume);
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "setVolume failed with status %d", status);
@@ -498,6 +810,8 @@ int32_t pal_stream_set_mute(pal_stream_handle_t *stream_handle, bool state)
     Stream *s = NULL;
     std::shared_ptr<ResourceManager> rm = NULL;
     int status = 0;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_SET_MUTE, stream_handle, status,
+                           {(uint64_t)state});
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -514,26 +828,17 @@ int32_t pal_stream_set_mute(pal_stream_handle_t *stream_handle, bool state)
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
-        status = -EINVAL;
-        goto exit;
-    }
-
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockActiveStream();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         goto exit;
     }
-    rm->unlockActiveStream();
+    drain_async_work(s);
+    if (state)
+        s->mPoolable = false;
     status = s->mute(state);
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "mute failed with status %d", status);
@@ -550,13 +855,16 @@ int32_t pal_stream_pause(pal_stream_handle_t *stream_handle)
 {
     Stream *s = NULL;
     int status;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_PAUSE, stream_handle, status);
     if (!stream_handle) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
         return status;
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
     status = s->pause();
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_pause failed with status %d", status);
@@ -570,6 +878,7 @@ int32_t pal_stream_resume(pal_stream_handle_t *stream_handle)
 {
     Stream *s = NULL;
     int status;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_RESUME, stream_handle, status);
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -578,7 +887,9 @@ int32_t pal_stream_resume(pal_stream_handle_t *stream_handle)
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
 
     status = s->resume();
     if (0 != status) {
@@ -595,6 +906,8 @@ int32_t pal_stream_drain(pal_stream_handle_t *stream_handle, pal_drain_type_t ty
     Stream *s = NULL;
     int status;
     std::shared_ptr<ResourceManager> rm = NULL;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_DRAIN, stream_handle, status,
+                           {(uint64_t)type});
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -611,27 +924,15 @@ int32_t pal_stream_drain(pal_stream_handle_t *stream_handle, pal_drain_type_t ty
         goto exit;
     }
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
-        status = -EINVAL;
-        goto exit;
-    }
-
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockActiveStream();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         goto exit;
     }
-    rm->unlockActiveStream();
-
+    drain_async_work(s);
     status = s->drain(type);
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "drain failed with status %d", status);
@@ -646,6 +947,7 @@ int32_t pal_stream_flush(pal_stream_handle_t *stream_handle)
 {
     Stream *s = NULL;
     int status;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_FLUSH, stream_handle, status);
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -654,7 +956,9 @@ int32_t pal_stream_flush(pal_stream_handle_t *stream_handle)
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
 
     status = s->flush();
     if (0 != status) {
@@ -670,6 +974,7 @@ int32_t pal_stream_suspend(pal_stream_handle_t *stream_handle)
 {
     Stream *s = NULL;
     int status;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_SUSPEND, stream_handle, status);
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -678,7 +983,9 @@ int32_t pal_stream_suspend(pal_stream_handle_t *stream_handle)
     }
 
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
 
     status = s->suspend();
     if (0 != status) {
@@ -695,6 +1002,8 @@ int32_t pal_stream_set_buffer_size (pal_stream_handle_t *stream_handle,
 {
     Stream *s = NULL;
     int status;
+    size_t inSize = 0, inCount = 0, outSize = 0, outCount = 0;
+    size_t newInSize = 0, newInCount = 0, newOutSize = 0, newOutCount = 0;
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -702,13 +1011,32 @@ int32_t pal_stream_set_buffer_size (pal_stream_handle_t *stream_handle,
         return status;
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
 
+    s->getBufInfo(&inSize, &inCount, &outSize, &outCount);
     status = s->setBufInfo(in_buffer_cfg, out_buffer_cfg);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_set_buffer_size failed with status %d", status);
         return status;
     }
+
+    /*
+     * A pooled stream that ran before still has its pcm configured with the
+     * previous owner's buffers, reopen it if they changed.
+     */
+    s->getBufInfo(&newInSize, &newInCount, &newOutSize, &newOutCount);
+    if (s->mFromPool && s->getCurState() == STREAM_STOPPED &&
+        (newOutSize != outSize || newOutCount != outCount)) {
+        PAL_DBG(LOG_TAG, "buffers changed on pooled stream, reopen");
+        s->close();
+        status = s->open();
+        if (0 != status) {
+            PAL_ERR(LOG_TAG, "pooled stream reopen failed with status %d", status);
+            return status;
+        }
+    }
     PAL_DBG(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -732,14 +1060,13 @@ int32_t pal_get_timestamp(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockActiveStream();
-    if (rm->isActiveStream(stream_handle)) {
-        s =  reinterpret_cast<Stream *>(stream_handle);
+    if (rm->increaseStreamUserCounter(stream_handle, &s) == 0) {
+        drain_async_work(s);
         status = s->getTimestamp(stime);
+        rm->decreaseStreamUserCounter(s);
     } else {
         PAL_ERR(LOG_TAG, "stream handle in stale state.\n");
     }
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_get_timestamp failed with status %d\n", status);
@@ -759,6 +1086,8 @@ int32_t pal_add_remove_effect(pal_stream_handle_t *stream_handle,
 {
     Stream *s = NULL;
     int status = 0;
+    PalApiTraceScope trace(PAL_API_TRACE_ADD_REMOVE_EFFECT, stream_handle, status,
+                           {(uint64_t)effect, (uint64_t)enable});
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -767,7 +1096,11 @@ int32_t pal_add_remove_effect(pal_stream_handle_t *stream_handle,
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
 
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
+    /* graph state a later owner would inherit, do not pool the stream */
+    s->mPoolable = false;
     status = s->addRemoveEffect(effect, enable);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_add_effect failed with status %d", status);
@@ -789,6 +1122,8 @@ int32_t pal_stream_set_device(pal_stream_handle_t *stream_handle,
     struct pal_device *pDevices = NULL;
     std::vector <std::shared_ptr<Device>> aDevices;
     std::vector <struct pal_device> palDevices;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_SET_DEVICE, stream_handle, status,
+                           {{devices, no_of_devices * sizeof(*devices)}});
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -811,24 +1146,14 @@ int32_t pal_stream_set_device(pal_stream_handle_t *stream_handle,
         return status;
     }
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
-        status = -EINVAL;
-        return status;
-    }
-
     /* Choose best device config for this stream */
     /* TODO: Decide whether to update device config or not based on flag */
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
+    status = rm->increaseStreamUserCounter(stream_handle, &s);
     if (0 != status) {
-        rm->unlockActiveStream();
         PAL_ERR(LOG_TAG, "failed to increase stream user count");
         return status;
     }
-    rm->unlockActiveStream();
-
+    drain_async_work(s);
     s->getStreamAttributes(&sattr);
 
     // device switch will be handled in global param setting for SVA
@@ -928,9 +1253,7 @@ int32_t pal_stream_set_device(pal_stream_handle_t *stream_handle,
     }
 
 exit:
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
     if (pDevices)
         free(pDevices);
     PAL_INFO(LOG_TAG, "Exit. status %d", status);
@@ -950,7 +1273,9 @@ int32_t pal_stream_get_tags_with_module_info(pal_stream_handle_t *stream_handle,
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
 
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
     status = s->getTagsWithModuleInfo(size, payload);
 
     PAL_DBG(LOG_TAG, "Exit. Stream handle: %pK, status %d", stream_handle, status);
@@ -963,6 +1288,8 @@ int32_t pal_set_param(uint32_t param_id, void *param_payload,
     PAL_DBG(LOG_TAG, "Enter: param id %d", param_id);
     int status = 0;
     std::shared_ptr<ResourceManager> rm = NULL;
+    PalApiTraceScope trace(PAL_API_TRACE_SET_PARAM, NULL, status,
+                           {(uint64_t)param_id, {param_payload, payload_size}});
 
     rm = ResourceManager::getInstance();
     if (rm) {
@@ -1014,7 +1341,9 @@ int32_t pal_stream_get_mmap_position(pal_stream_handle_t *stream_handle,
         return status;
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
     status = s->GetMmapPosition(position);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_get_mmap_position failed with status %d", status);
@@ -1036,7 +1365,9 @@ int32_t pal_stream_create_mmap_buffer(pal_stream_handle_t *stream_handle,
         return status;
     }
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
+    s = get_stream(stream_handle);
+    if (!s)
+        return -EINVAL;
     status = s->createMmapBuffer(min_size_frames, info);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_stream_create_mmap_buffer failed with status %d", status);
@@ -137,6 +137,45 @@ int32_t pal_stream_close(pal_stream_handle_t *stream_handle);
   */
 int32_t pal_stream_start(pal_stream_handle_t *stream_handle);
 
+/**
+  * \brief Open the stream without waiting for the graph setup.
+  *
+  * The stream handle is returned right away and the open runs on
+  * a PAL worker thread. Completion is reported to cb with
+  * PAL_STREAM_CBK_EVENT_OPEN_DONE and a
+  * pal_event_async_done_payload. The handle may be used right
+  * away: pal_stream_start_async is queued after the open and
+  * every other call waits for it. On failure the handle must
+  * still be closed with pal_stream_close. The callback runs on
+  * the worker thread; pal_stream_stop and pal_stream_close of
+  * the same stream fail there with -EDEADLK.
+  *
+  * \param[in] same as pal_stream_open
+  *
+  * \return 0 if the open was queued, error code otherwise
+  */
+int32_t pal_stream_open_async(struct pal_stream_attributes *attributes,
+                              uint32_t no_of_devices, struct pal_device *devices,
+                              uint32_t no_of_modifiers, struct modifier_kv *modifiers,
+                              pal_stream_callback cb, uint64_t cookie,
+                              pal_stream_handle_t **stream_handle);
+
+/**
+  * \brief Start the stream on a PAL worker thread.
+  *
+  * Runs after any earlier async operation on the same stream,
+  * streams are started in parallel with each other. Completion is
+  * reported with PAL_STREAM_CBK_EVENT_START_DONE to the callback
+  * given at open. pal_stream_stop and pal_stream_close wait for
+  * pending async operations of the stream.
+  *
+  * \param[in] stream_handle - Valid stream handle obtained
+  *       from pal_stream_open or pal_stream_open_async
+  *
+  * \return 0 if the start was queued, error code otherwise
+  */
+int32_t pal_stream_start_async(pal_stream_handle_t *stream_handle);
+
 /**
   * \brief Stop the stream. Stream must be in started/paused
   *        state before stoping.
@@ -42,27 +42,38 @@
 #define PAL_LOG_DBG             (0x4) /**< debug message, required at minimum for debug.*/
 #define PAL_LOG_VERBOSE         (0x8)/**< verbose message, useful primarily to help developers debug low-level code */
 
+/*
+ * Least severe level compiled in, e.g. -DPAL_LOG_MIN_LEVEL=PAL_LOG_DBG drops
+ * every PAL_VERBOSE site from the build. Levels above it are still subject
+ * to pal_log_lvl at runtime.
+ */
+#ifndef PAL_LOG_MIN_LEVEL
+#define PAL_LOG_MIN_LEVEL       PAL_LOG_VERBOSE
+#endif
+
+#define PAL_LOG_ENABLED(lvl)    (((lvl) <= PAL_LOG_MIN_LEVEL) && (pal_log_lvl & (lvl)))
+
 extern uint32_t pal_log_lvl;
 
 #define PAL_FATAL(log_tag, arg,...)                                       \
-    if (pal_log_lvl & PAL_LOG_ERR) {                              \
+    if (PAL_LOG_ENABLED(PAL_LOG_ERR)) {                           \
         ALOGE("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__);\
         abort();                                                  \
     }
 
 #define PAL_ERR(log_tag, arg,...)                                          \
-    if (pal_log_lvl & PAL_LOG_ERR) {                              \
+    if (PAL_LOG_ENABLED(PAL_LOG_ERR)) {                           \
         ALOGE("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__);\
     }
 #define PAL_DBG(log_tag,arg,...)                                           \
-    if (pal_log_lvl & PAL_LOG_DBG) {                               \
+    if (PAL_LOG_ENABLED(PAL_LOG_DBG)) {                            \
         ALOGD("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__); \
     }
 #define PAL_INFO(log_tag,arg,...)                                         \
-    if (pal_log_lvl & PAL_LOG_INFO) {                             \
+    if (PAL_LOG_ENABLED(PAL_LOG_INFO)) {                          \
         ALOGI("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__);\
     }
 #define PAL_VERBOSE(log_tag,arg,...)                                      \
-    if (pal_log_lvl & PAL_LOG_VERBOSE) {                          \
+    if (PAL_LOG_ENABLED(PAL_LOG_VERBOSE)) {                       \
         ALOGV("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__);\
     }
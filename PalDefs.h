@@ -630,6 +630,8 @@ typedef enum {
     PAL_STREAM_CBK_EVENT_PARTIAL_DRAIN_READY, /* partial drain completed */
     PAL_STREAM_CBK_EVENT_READ_DONE, /* stream hit some error, let AF take action */
     PAL_STREAM_CBK_EVENT_ERROR, /* stream hit some error, let AF take action */
+    PAL_STREAM_CBK_EVENT_OPEN_DONE, /* pal_stream_open_async completed */
+    PAL_STREAM_CBK_EVENT_START_DONE, /* pal_stream_start_async completed */
 } pal_stream_callback_event_t;
 
 /* type of global callback events. */
@@ -903,6 +905,7 @@ typedef enum {
     PAL_PARAM_ID_VOLUME_USING_SET_PARAM = 55,
     PAL_PARAM_ID_UHQA_FLAG = 56,
     PAL_PARAM_ID_STREAM_ATTRIBUTES = 57,
+    PAL_PARAM_ID_STREAM_LATENCY_STATS = 58, /* get only, struct pal_stream_latency_stats */
 } pal_param_id_type_t;
 
 /** HDMI/DP */
@@ -917,6 +920,29 @@ typedef struct pal_param_proxy_channel_config {
     uint32_t num_proxy_channels;
 } pal_param_proxy_channel_config_t;
 
+#define PAL_LATENCY_HIST_BUCKETS 32
+
+/**
+ * Log2 histogram of durations: buckets[0] counts 0 ns, buckets[i] counts
+ * [2^(i-1), 2^i) ns and the last bucket everything from 2^30 ns up.
+ */
+struct pal_latency_histogram {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint32_t buckets[PAL_LATENCY_HIST_BUCKETS];
+};
+
+/** Hot path timing of pal_stream_write/pal_stream_read since stream open */
+struct pal_stream_latency_stats {
+    struct pal_latency_histogram lock_wait; /**< wait for the stream lock */
+    struct pal_latency_histogram session;   /**< session write/read call */
+    struct pal_latency_histogram kernel;    /**< each pcm write/read to the driver */
+    uint64_t xruns;                         /**< driver calls failing with EPIPE */
+    uint64_t short_transfers;               /**< fewer bytes than the buffer size */
+    uint64_t dropped_buffers;               /**< buffers dropped while offline or on SSR */
+};
+
 struct pal_param_context_list {
     uint32_t num_contexts;
     uint32_t context_id[]; /* list of num_contexts context_id */
@@ -1382,6 +1408,14 @@ struct pal_event_read_write_done_payload {
     struct pal_buffer buff; /**< buffer that was passed to pal_stream_read/pal_stream_write */
 };
 
+/**
+ * Event payload passed to client with PAL_STREAM_CBK_EVENT_OPEN_DONE and
+ * PAL_STREAM_CBK_EVENT_START_DONE events
+ */
+struct pal_event_async_done_payload {
+    int32_t status; /**< 0 on success, error code of the open/start otherwise */
+};
+
 /** @brief Callback function prototype to be given for
  *         pal_open_stream.
  *
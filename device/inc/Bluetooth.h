@@ -87,7 +87,6 @@ protected:
     struct pal_media_config    codecConfig;
     codec_format_t             codecFormat;
     void                       *codecInfo;
-    void                       *pluginHandler;
     bt_codec_t                 *pluginCodec;
     bool                       isAbrEnabled;
     bool                       isConfigured;
@@ -103,8 +102,7 @@ protected:
     std::mutex                 mAbrMutex;
     int                        totalActiveSessionRequests;
 
-    int getPluginPayload(void **handle, bt_codec_t **btCodec,
-                         bt_enc_payload_t **out_buf,
+    int getPluginPayload(bt_codec_t **btCodec, bt_enc_payload_t **out_buf,
                          codec_type codecType);
     int configureA2dpEncoderDecoder();
     int configureNrecParameters(bool isNrecEnabled);
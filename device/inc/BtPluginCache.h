@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BT_PLUGIN_CACHE_H
+#define BT_PLUGIN_CACHE_H
+
+#include <bt_intf.h>
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+/* packed plugin payloads kept, least recently used first out */
+#define BT_PAYLOAD_MEMO_MAX_ENTRIES 16
+
+/*
+ * Process wide state behind Bluetooth::getPluginPayload.
+ *
+ * BT codec plugin libraries are loaded once per library path and kept for
+ * the process lifetime. Payloads packed by a plugin are memoized by
+ * library, codec format, direction and serialized codec config, and handed
+ * out as copies laid out like a plugin packed payload, so the plugin's
+ * close_plugin frees them like its own.
+ */
+class BtPluginCache
+{
+public:
+    static int getOpenFn(const std::string &libPath, open_fn_t *openFn);
+    static bool getMemoKey(const std::string &libPath, uint32_t codecFormat,
+                           const void *codecInfo, codec_type codecType,
+                           std::string &key);
+    static bt_enc_payload_t *lookup(const std::string &key);
+    static void insert(const std::string &key, const bt_enc_payload_t *payload);
+    static uint64_t hits() { return payloadMemoHits; }
+    static uint64_t misses() { return payloadMemoMisses; }
+
+private:
+    struct pluginLib {
+        void *handle;
+        open_fn_t plugin_open_fn;
+    };
+
+    struct memoEntry {
+        std::string key;
+        uint32_t channel_count;
+        uint32_t bit_format;
+        uint32_t sample_rate;
+        bool is_abr_enabled;
+        bool is_enc_config_set;
+        bool is_dec_config_set;
+        std::vector<std::pair<uint32_t, std::vector<uint8_t>>> blocks;
+    };
+
+    static std::mutex lock;
+    static std::map<std::string, pluginLib> pluginLibs;
+    static std::list<memoEntry> payloadMemo;
+    static std::unordered_map<std::string,
+            std::list<memoEntry>::iterator> payloadMemoMap;
+    static std::atomic<uint64_t> payloadMemoHits;
+    static std::atomic<uint64_t> payloadMemoMisses;
+};
+
+#endif //BT_PLUGIN_CACHE_H
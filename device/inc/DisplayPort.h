@@ -155,6 +155,7 @@ public:
     static int32_t getExtDispType(struct audio_mixer *mixer, int controller, int stream);
     static int getEdidInfo(struct audio_mixer *mixer, int controller, int stream);
     static void cacheEdid(struct audio_mixer *mixer, int controller, int stream);
+    static void invalidateEdid(int controller, int stream);
     static const char * edidFormatToStr(unsigned char format);
     static bool isSampleRateSupported(unsigned char srByte, int samplingRate);
     static unsigned char getEdidBpsByte(unsigned char byte, unsigned char format);
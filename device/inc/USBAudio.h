@@ -68,16 +68,16 @@
 #include "ResourceManager.h"
 #include "PalAudioRoute.h"
 #include "SessionAlsaUtils.h"
+#include "USBStreamParser.h"
 #include <tinyalsa/asoundlib.h>
 #include <vector>
 #include <map>
+#include <list>
+#include <unordered_map>
+#include <mutex>
 #include <system/audio.h>
 
 #define USB_BUFF_SIZE           4096
-#define CHANNEL_NUMBER_STR      "Channels: "
-#define PLAYBACK_PROFILE_STR    "Playback:"
-#define CAPTURE_PROFILE_STR     "Capture:"
-#define DATA_PACKET_INTERVAL_STR "Data packet interval:"
 #define USB_SIDETONE_GAIN_STR   "usb_sidetone_gain"
 // Supported sample rates for USB
 #define USBID_SIZE                16
@@ -86,15 +86,17 @@
 #define MAX_HIFI_CHANNEL_COUNT 8
 #define MIN_CHANNEL_COUNT 1
 #define DEFAULT_CHANNEL_COUNT 2
-#define  MAX_SAMPLE_RATE_SIZE 15
-#define DEFAULT_SERVICE_INTERVAL_US    0
 #define USB_IN_JACK_SUFFIX "Input Jack"
 #define USB_OUT_JACK_SUFFIX "Output Jack"
+/* parsed stream0 profiles kept across reconnects, least recently used first out */
+#define USB_CAPABILITY_DB_MAX_ENTRIES 8
 
-typedef enum usb_usecase_type{
-    USB_CAPTURE = 0,
-    USB_PLAYBACK,
-} usb_usecase_type_t;
+struct usbCapabilityEntry {
+    std::string key;
+    int status;
+    int endian;
+    std::vector<usbStreamAltset> altsets;
+};
 
 // one card supports multiple devices
 class USBDeviceConfig {
@@ -116,15 +118,14 @@ public:
     void setInterval(unsigned long interval);
     unsigned long getInterval();
     unsigned int getDefaultRate();
-    int getSampleRates(int type, char *rates_str);
+    void setSampleRates(usb_usecase_type_t type, const std::vector<unsigned int> &rates,
+                        unsigned int mask);
     bool isRateSupported(int requested_rate);
     int getBestRate(int requested_rate, int candidate_rate, unsigned int *best_rate);
     void usb_find_sample_rate_candidate(int base, int requested_rate,
                                     int cur_rate, int candidate_rate, unsigned int *best_rate);
     int updateBestChInfo(struct pal_channel_info *requested_ch_info,
                          struct pal_channel_info *best);
-    int getServiceInterval(const char *interval_str_start);
-    static const unsigned int supported_sample_rates_[MAX_SAMPLE_RATE_SIZE];
     void setJackStatus(bool jack_status);
     bool getJackStatus();
     unsigned int getSRMask(usb_usecase_type_t type) {return supported_sample_rates_mask_[type];} ;
@@ -137,7 +138,14 @@ protected:
     std::multimap<uint32_t, std::shared_ptr<USBDeviceConfig>> format_list_map;
     std::vector <std::shared_ptr<USBDeviceConfig>> usb_device_config_list_;
     unsigned int usb_supported_sample_rates_mask_[2] = {0};
+    static std::mutex capability_db_mutex_;
+    static std::list<usbCapabilityEntry> capability_db_;
+    static std::unordered_map<std::string,
+            std::list<usbCapabilityEntry>::iterator> capability_db_map_;
     void usb_info_dump(char* read_buf, int type);
+    static std::string getUsbIdentity(int usb_card);
+    static bool lookupCapabilityDb(const std::string &key, usbCapabilityEntry &entry);
+    static void insertCapabilityDb(const usbCapabilityEntry &entry);
 public:
     USBCardConfig(struct pal_usb_device_address address);
     bool isConfigCached(struct pal_usb_device_address addr);
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef USB_STREAM_PARSER_H
+#define USB_STREAM_PARSER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+/* "Altset N", not the "Sync EP Altset: N" line newer kernels print */
+#define ALTSET_STR              "Altset "
+#define CHANNEL_NUMBER_STR      "Channels: "
+#define PLAYBACK_PROFILE_STR    "Playback:"
+#define CAPTURE_PROFILE_STR     "Capture:"
+#define DATA_PACKET_INTERVAL_STR "Data packet interval:"
+#define  MAX_SAMPLE_RATE_SIZE 15
+#define DEFAULT_SERVICE_INTERVAL_US    0
+
+typedef enum usb_usecase_type{
+    USB_CAPTURE = 0,
+    USB_PLAYBACK,
+} usb_usecase_type_t;
+
+/* one "Altset" block of a /proc/asound/cardN/stream0 profile */
+struct usbStreamAltset {
+    unsigned int bit_width;
+    unsigned int channels;
+    std::vector<unsigned int> rates;
+    unsigned int sample_rates_mask;
+    unsigned long service_interval_us;
+};
+
+/*
+ * Parser for the USB audio stream description exported by the ALSA USB
+ * driver. Kept free of device and mixer state so it can be benchmarked and
+ * its results cached per device identity.
+ */
+class USBStreamParser {
+public:
+    static const unsigned int supported_sample_rates_[MAX_SAMPLE_RATE_SIZE];
+    /*
+     * Returns the altsets of the playback or capture profile in stream_info
+     * with the same status getCapability always reported: -ENOENT if the
+     * profile is missing, else the status of the last optional field parsed.
+     * *endian is updated from the last recognised sample format.
+     */
+    static int parse(const char *stream_info, usb_usecase_type_t type,
+                     std::vector<usbStreamAltset> &altsets, int *endian);
+    static uint64_t hash(const char *stream_info, size_t len);
+    static int getSampleRates(int type, char *rates_str, usbStreamAltset &altset);
+    static int getServiceInterval(const char *interval_str_start,
+                                  usbStreamAltset &altset);
+};
+
+#endif //USB_STREAM_PARSER_H
@@ -35,12 +35,14 @@
 #include "Session.h"
 #include "SessionAlsaUtils.h"
 #include "Device.h"
+#include "BtPluginCache.h"
 #include <dlfcn.h>
 #include <unistd.h>
 #include <cutils/properties.h>
 #include <sstream>
 #include <string>
 #include <regex>
+#include <chrono>
 
 #define PARAM_ID_RESET_PLACEHOLDER_MODULE 0x08001173
 #define BT_IPC_SOURCE_LIB                 "btaudio_offload_if.so"
@@ -132,14 +134,17 @@ bool Bluetooth::isPlaceholderEncoder()
     }
 }
 
-int Bluetooth::getPluginPayload(void **libHandle, bt_codec_t **btCodec,
-              bt_enc_payload_t **out_buf, codec_type codecType)
+int Bluetooth::getPluginPayload(bt_codec_t **btCodec, bt_enc_payload_t **out_buf,
+              codec_type codecType)
 {
     std::string lib_path;
+    std::string key;
     open_fn_t plugin_open_fn = NULL;
     int status = 0;
     bt_codec_t *codec = NULL;
-    void *handle = NULL;
+    bt_enc_payload_t *payload = NULL;
+    bool memoize = false;
+    auto begin = std::chrono::steady_clock::now();
 
     lib_path = rm->getBtCodecLib(codecFormat, (codecType == ENC ? "enc" : "dec"));
     if (lib_path.empty()) {
@@ -147,19 +152,9 @@ int Bluetooth::getPluginPayload(void **libHandle, bt_codec_t **btCodec,
         return -ENOSYS;
     }
 
-    handle = dlopen(lib_path.c_str(), RTLD_NOW);
-    if (handle == NULL) {
-        PAL_ERR(LOG_TAG, "failed to dlopen lib %s", lib_path.c_str());
-        return -EINVAL;
-    }
-
-    dlerror();
-    plugin_open_fn = (open_fn_t)dlsym(handle, "plugin_open");
-    if (!plugin_open_fn) {
-        PAL_ERR(LOG_TAG, "dlsym to open fn failed, err = '%s'", dlerror());
-        status = -EINVAL;
-        goto error;
-    }
+    status = BtPluginCache::getOpenFn(lib_path, &plugin_open_fn);
+    if (status)
+        return status;
 
     status = plugin_open_fn(&codec, codecFormat, codecType);
     if (status) {
@@ -167,21 +162,37 @@ int Bluetooth::getPluginPayload(void **libHandle, bt_codec_t **btCodec,
         goto error;
     }
 
-    status = codec->plugin_populate_payload(codec, codecInfo, (void **)out_buf);
-    if (status != 0) {
-        PAL_ERR(LOG_TAG, "fail to pack the encoder config %d", status);
-        goto error;
+    memoize = BtPluginCache::getMemoKey(lib_path, codecFormat, codecInfo,
+                                         codecType, key);
+    if (memoize)
+        payload = BtPluginCache::lookup(key);
+
+    if (payload) {
+        /* handed to the codec so close_plugin frees it like a packed one */
+        codec->payload = payload;
+        *out_buf = payload;
+    } else {
+        status = codec->plugin_populate_payload(codec, codecInfo, (void **)out_buf);
+        if (status != 0) {
+            PAL_ERR(LOG_TAG, "fail to pack the encoder config %d", status);
+            goto error;
+        }
+        if (memoize && *out_buf)
+            BtPluginCache::insert(key, *out_buf);
     }
     *btCodec = codec;
-    *libHandle = handle;
+
+    PAL_DBG(LOG_TAG, "codec %x payload %s in %lld us, memo hits %llu misses %llu",
+            codecFormat, payload ? "memoized" : "packed",
+            (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin).count(),
+            (unsigned long long)BtPluginCache::hits(),
+            (unsigned long long)BtPluginCache::misses());
     goto done;
 
 error:
     if (codec)
         codec->close_plugin(codec);
-
-    if (handle)
-        dlclose(handle);
 done:
     return status;
 }
@@ -223,7 +234,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
     /* Retrieve plugin library from resource manager.
      * Map to interested symbols.
      */
-    status = getPluginPayload(&pluginHandler, &pluginCodec, &out_buf, codecType);
+    status = getPluginPayload(&pluginCodec, &out_buf, codecType);
     if (status) {
         PAL_ERR(LOG_TAG, "failed to payload from plugin");
         goto error;
@@ -660,7 +671,6 @@ void Bluetooth::startAbr()
     std::ostringstream disconnectCtrlName;
     unsigned int flags;
     uint32_t codecTagId = 0, miid = 0;
-    void *pluginLibHandle = NULL;
     bt_codec_t *codec = NULL;
     bt_enc_payload_t *out_buf = NULL;
     custom_block_t *blk = NULL;
@@ -753,7 +763,7 @@ void Bluetooth::startAbr()
         goto free_fe;
     }
 
-    ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndName.c_str());
+    ret = SessionAlsaUtils::mixerCtlSetEnum(connectCtrl, backEndName.c_str());
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
                 connectCtrlName.str().data(), backEndName.c_str(), ret);
@@ -770,7 +780,7 @@ void Bluetooth::startAbr()
         goto disconnect_fe;
     }
 
-    if (mixer_ctl_set_value(btSetFeedbackChannelCtrl, 0, 1) != 0) {
+    if (SessionAlsaUtils::mixerCtlSetValue(btSetFeedbackChannelCtrl, 0, 1) != 0) {
         PAL_ERR(LOG_TAG, "Failed to set BT usecase");
         goto disconnect_fe;
     }
@@ -800,7 +810,7 @@ void Bluetooth::startAbr()
             goto disconnect_fe;
         }
 
-        ret = getPluginPayload(&pluginLibHandle, &codec, &out_buf, (codecType == DEC ? ENC : DEC));
+        ret = getPluginPayload(&codec, &out_buf, (codecType == DEC ? ENC : DEC));
         if (ret) {
             PAL_ERR(LOG_TAG, "getPluginPayload failed");
             goto disconnect_fe;
@@ -821,7 +831,6 @@ void Bluetooth::startAbr()
                   (uint32_t *)blk->payload, blk->payload_sz, miid, blk->param_id);
 
         codec->close_plugin(codec);
-        dlclose(pluginLibHandle);
 
         if (!paramData) {
             PAL_ERR(LOG_TAG, "Failed to populateAPMHeader");
@@ -906,7 +915,7 @@ void Bluetooth::startAbr()
                 goto disconnect_fe;
             }
 
-            ret = getPluginPayload(&pluginLibHandle, &codec, &out_buf, (codecType == DEC ? ENC : DEC));
+            ret = getPluginPayload(&codec, &out_buf, (codecType == DEC ? ENC : DEC));
             if (ret) {
                 PAL_ERR(LOG_TAG, "getPluginPayload failed");
                 goto disconnect_fe;
@@ -936,7 +945,6 @@ void Bluetooth::startAbr()
             }
 
             codec->close_plugin(codec);
-            dlclose(pluginLibHandle);
 
             if (fbDevice.id == PAL_DEVICE_IN_BLUETOOTH_SCO_HEADSET) {
                 /* COP v2 DEPACKETIZER Module Configuration */
@@ -1117,7 +1125,7 @@ disconnect_fe:
     disconnectCtrlName << "PCM" << fbpcmDevIds.at(0) << " disconnect";
     disconnectCtrl = mixer_get_ctl_by_name(virtualMixerHandle, disconnectCtrlName.str().data());
     if(disconnectCtrl != NULL){
-       mixer_ctl_set_enum_by_string(disconnectCtrl, backEndName.c_str());
+       SessionAlsaUtils::mixerCtlSetEnum(disconnectCtrl, backEndName.c_str());
     }
 free_fe:
     rm->freeFrontEndIds(fbpcmDevIds, sAttr, dir);
@@ -1180,7 +1188,7 @@ void Bluetooth::stopAbr()
     if (!btSetFeedbackChannelCtrl) {
         PAL_ERR(LOG_TAG, "%s mixer control not identified",
                 MIXER_SET_FEEDBACK_CHANNEL);
-    } else if (mixer_ctl_set_value(btSetFeedbackChannelCtrl, 0, 0) != 0) {
+    } else if (SessionAlsaUtils::mixerCtlSetValue(btSetFeedbackChannelCtrl, 0, 0) != 0) {
         PAL_ERR(LOG_TAG, "Failed to reset BT usecase");
     }
 
@@ -1258,7 +1266,6 @@ BtA2dp::BtA2dp(struct pal_device *device, std::shared_ptr<ResourceManager> Rm)
 {
     a2dpRole = (device->id == PAL_DEVICE_IN_BLUETOOTH_A2DP) ? SINK : SOURCE;
     codecType = (device->id == PAL_DEVICE_IN_BLUETOOTH_A2DP) ? DEC : ENC;
-    pluginHandler = NULL;
     pluginCodec = NULL;
 
     init();
@@ -1605,10 +1612,6 @@ int BtA2dp::stopPlayback()
             pluginCodec->close_plugin(pluginCodec);
             pluginCodec = NULL;
         }
-        if (pluginHandler) {
-            dlclose(pluginHandler);
-            pluginHandler = NULL;
-        }
     }
 
     PAL_DBG(LOG_TAG, "Stop A2DP playback, total active sessions :%d",
@@ -1770,10 +1773,6 @@ int BtA2dp::stopCapture()
             pluginCodec->close_plugin(pluginCodec);
             pluginCodec = NULL;
         }
-        if (pluginHandler) {
-            dlclose(pluginHandler);
-            pluginHandler = NULL;
-        }
     }
     PAL_DBG(LOG_TAG, "Stop A2DP capture, total active sessions :%d",
             totalActiveSessionRequests);
@@ -2021,7 +2020,6 @@ BtSco::BtSco(struct pal_device *device, std::shared_ptr<ResourceManager> Rm)
     : Bluetooth(device, Rm)
 {
     codecType = (device->id == PAL_DEVICE_OUT_BLUETOOTH_SCO) ? ENC : DEC;
-    pluginHandler = NULL;
     pluginCodec = NULL;
 }
 
@@ -2294,10 +2292,6 @@ int BtSco::stop()
         pluginCodec->close_plugin(pluginCodec);
         pluginCodec = NULL;
     }
-    if (pluginHandler) {
-        dlclose(pluginHandler);
-        pluginHandler = NULL;
-    }
 
     Device::stop_l();
     if (isAbrEnabled == false)
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: BtPluginCache"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "PalCommon.h"
+#include "BtPluginCache.h"
+
+/* plugin private codec config layouts, used to key the payload memo */
+#undef NUM_CODEC
+#include <bt_bundle.h>
+#undef NUM_CODEC
+#include <bt_aptx.h>
+#undef NUM_CODEC
+#include <bt_ble.h>
+
+std::mutex BtPluginCache::lock;
+std::map<std::string, BtPluginCache::pluginLib> BtPluginCache::pluginLibs;
+std::list<BtPluginCache::memoEntry> BtPluginCache::payloadMemo;
+std::unordered_map<std::string,
+        std::list<BtPluginCache::memoEntry>::iterator> BtPluginCache::payloadMemoMap;
+std::atomic<uint64_t> BtPluginCache::payloadMemoHits(0);
+std::atomic<uint64_t> BtPluginCache::payloadMemoMisses(0);
+
+int BtPluginCache::getOpenFn(const std::string &libPath, open_fn_t *openFn)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    struct pluginLib lib;
+    auto it = pluginLibs.find(libPath);
+
+    if (it != pluginLibs.end()) {
+        *openFn = it->second.plugin_open_fn;
+        return 0;
+    }
+
+    lib.handle = dlopen(libPath.c_str(), RTLD_NOW);
+    if (lib.handle == NULL) {
+        PAL_ERR(LOG_TAG, "failed to dlopen lib %s", libPath.c_str());
+        return -EINVAL;
+    }
+
+    dlerror();
+    lib.plugin_open_fn = (open_fn_t)dlsym(lib.handle, "plugin_open");
+    if (!lib.plugin_open_fn) {
+        PAL_ERR(LOG_TAG, "dlsym to open fn failed, err = '%s'", dlerror());
+        dlclose(lib.handle);
+        return -EINVAL;
+    }
+
+    PAL_INFO(LOG_TAG, "loaded BT codec plugin %s", libPath.c_str());
+    pluginLibs[libPath] = lib;
+    *openFn = lib.plugin_open_fn;
+    return 0;
+}
+
+static void appendMemoKey(std::string &key, const void *data, size_t size)
+{
+    key.append((const char *)data, size);
+}
+
+/*
+ * Serialize codecInfo for the payload memo. Pointers inside the config are
+ * replaced by what they point to; codec formats whose config layout is not
+ * known here are not memoized.
+ */
+bool BtPluginCache::getMemoKey(const std::string &libPath, uint32_t codecFormat,
+                               const void *codecInfo, codec_type codecType,
+                               std::string &key)
+{
+    const audio_aac_encoder_config_t *aacInfo = NULL;
+    audio_aac_encoder_config_t aacCfg;
+    const audio_lc3_codec_cfg_t *lc3Info = NULL;
+    audio_lc3_codec_cfg_t lc3Cfg;
+    size_t size = 0;
+
+    if (!codecInfo)
+        return false;
+
+    key = libPath;
+    key.push_back('\0');
+    appendMemoKey(key, &codecFormat, sizeof(codecFormat));
+    appendMemoKey(key, &codecType, sizeof(codecType));
+
+    switch (codecFormat) {
+    case CODEC_TYPE_SBC:
+        size = sizeof(audio_sbc_encoder_config_t);
+        break;
+    case CODEC_TYPE_CELT:
+        size = sizeof(audio_celt_encoder_config_t);
+        break;
+    case CODEC_TYPE_LDAC:
+        size = sizeof(audio_ldac_encoder_config_t);
+        break;
+    case CODEC_TYPE_APTX:
+        size = sizeof(audio_aptx_encoder_config_t);
+        break;
+    case CODEC_TYPE_APTX_HD:
+        size = sizeof(audio_aptx_hd_encoder_config_t);
+        break;
+    case CODEC_TYPE_APTX_DUAL_MONO:
+        size = sizeof(audio_aptx_dual_mono_config_t);
+        break;
+    case CODEC_TYPE_APTX_AD:
+        size = sizeof(audio_aptx_ad_encoder_config_t);
+        break;
+    case CODEC_TYPE_APTX_AD_SPEECH:
+        /* speech mode, same layout for encoder and decoder */
+        appendMemoKey(key, codecInfo, sizeof(uint32_t));
+        return true;
+    case CODEC_TYPE_AAC:
+        if (codecType != ENC)
+            return false;
+        aacInfo = (const audio_aac_encoder_config_t *)codecInfo;
+        memcpy(&aacCfg, aacInfo, sizeof(aacCfg));
+        aacCfg.frame_ctl_ptr = NULL;
+        aacCfg.abr_ctl_ptr = NULL;
+        appendMemoKey(key, &aacCfg, sizeof(aacCfg));
+        key.push_back(aacInfo->frame_ctl_ptr ? 1 : 0);
+        if (aacInfo->frame_ctl_ptr)
+            appendMemoKey(key, aacInfo->frame_ctl_ptr,
+                          sizeof(struct aac_frame_size_control_t));
+        key.push_back(aacInfo->abr_ctl_ptr ? 1 : 0);
+        if (aacInfo->abr_ctl_ptr)
+            appendMemoKey(key, aacInfo->abr_ctl_ptr, sizeof(struct aac_abr_control_t));
+        return true;
+    case CODEC_TYPE_LC3:
+        lc3Info = (const audio_lc3_codec_cfg_t *)codecInfo;
+        memcpy(&lc3Cfg, lc3Info, sizeof(lc3Cfg));
+        lc3Cfg.enc_cfg.streamMapOut = NULL;
+        lc3Cfg.dec_cfg.streamMapIn = NULL;
+        appendMemoKey(key, &lc3Cfg, sizeof(lc3Cfg));
+        if (lc3Info->enc_cfg.streamMapOut)
+            appendMemoKey(key, lc3Info->enc_cfg.streamMapOut,
+                          lc3Info->enc_cfg.stream_map_size * sizeof(lc3_stream_map_t));
+        if (lc3Info->dec_cfg.streamMapIn)
+            appendMemoKey(key, lc3Info->dec_cfg.streamMapIn,
+                          lc3Info->dec_cfg.stream_map_size * sizeof(lc3_stream_map_t));
+        return true;
+    default:
+        return false;
+    }
+
+    /* remaining A2DP formats only pack an encoder config */
+    if (codecType != ENC)
+        return false;
+
+    appendMemoKey(key, codecInfo, size);
+    return true;
+}
+
+/* returns a copy laid out like a plugin packed payload, owned by the caller */
+bt_enc_payload_t *BtPluginCache::lookup(const std::string &key)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    bt_enc_payload_t *payload = NULL;
+    custom_block_t *blk = NULL;
+    uint32_t i = 0;
+    auto it = payloadMemoMap.find(key);
+
+    if (it == payloadMemoMap.end()) {
+        payloadMemoMisses++;
+        return NULL;
+    }
+
+    const memoEntry &entry = *it->second;
+
+    payload = (bt_enc_payload_t *)calloc(1, sizeof(bt_enc_payload_t) +
+                   entry.blocks.size() * sizeof(custom_block_t *));
+    if (!payload) {
+        PAL_ERR(LOG_TAG, "fail to allocate memory");
+        return NULL;
+    }
+    payload->channel_count = entry.channel_count;
+    payload->bit_format = entry.bit_format;
+    payload->sample_rate = entry.sample_rate;
+    payload->is_abr_enabled = entry.is_abr_enabled;
+    payload->is_enc_config_set = entry.is_enc_config_set;
+    payload->is_dec_config_set = entry.is_dec_config_set;
+    payload->num_blks = entry.blocks.size();
+
+    for (i = 0; i < payload->num_blks; i++) {
+        blk = (custom_block_t *)calloc(1, sizeof(custom_block_t));
+        if (!blk)
+            goto free_payload;
+        payload->blocks[i] = blk;
+        blk->param_id = entry.blocks[i].first;
+        blk->payload_sz = entry.blocks[i].second.size();
+        if (!blk->payload_sz)
+            continue;
+        blk->payload = (uint8_t *)malloc(blk->payload_sz);
+        if (!blk->payload)
+            goto free_payload;
+        memcpy(blk->payload, entry.blocks[i].second.data(), blk->payload_sz);
+    }
+
+    /* move to front, it is the most recently used now */
+    payloadMemo.splice(payloadMemo.begin(), payloadMemo, it->second);
+    payloadMemoHits++;
+    return payload;
+
+free_payload:
+    PAL_ERR(LOG_TAG, "fail to allocate memory");
+    for (i = 0; i < payload->num_blks; i++) {
+        if (payload->blocks[i]) {
+            if (payload->blocks[i]->payload)
+                free(payload->blocks[i]->payload);
+            free(payload->blocks[i]);
+        }
+    }
+    free(payload);
+    return NULL;
+}
+
+void BtPluginCache::insert(const std::string &key, const bt_enc_payload_t *payload)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    memoEntry entry;
+    custom_block_t *blk = NULL;
+    auto it = payloadMemoMap.find(key);
+
+    for (uint32_t i = 0; i < payload->num_blks; i++) {
+        blk = payload->blocks[i];
+        if (!blk || (blk->payload_sz && !blk->payload))
+            return;
+        entry.blocks.emplace_back(blk->param_id,
+                std::vector<uint8_t>(blk->payload, blk->payload + blk->payload_sz));
+    }
+
+    if (it != payloadMemoMap.end()) {
+        payloadMemo.erase(it->second);
+        payloadMemoMap.erase(it);
+    }
+    if (payloadMemo.size() >= BT_PAYLOAD_MEMO_MAX_ENTRIES) {
+        payloadMemoMap.erase(payloadMemo.back().key);
+        payloadMemo.pop_back();
+    }
+
+    entry.key = key;
+    entry.channel_count = payload->channel_count;
+    entry.bit_format = payload->bit_format;
+    entry.sample_rate = payload->sample_rate;
+    entry.is_abr_enabled = payload->is_abr_enabled;
+    entry.is_enc_config_set = payload->is_enc_config_set;
+    entry.is_dec_config_set = payload->is_dec_config_set;
+    payloadMemo.push_front(std::move(entry));
+    payloadMemoMap[key] = payloadMemo.begin();
+}
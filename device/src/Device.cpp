@@ -553,7 +553,7 @@ int32_t Device::configureDeviceClockSrc(char const *mixerStrClockSrc, const uint
     }
 
     PAL_DBG(LOG_TAG, "HwMixer set %s = %d", mixerStrClockSrc, clockSrc);
-    ret = mixer_ctl_set_value(clockSrcCtrl, 0, clockSrc);
+    ret = SessionAlsaUtils::mixerCtlSetValue(clockSrcCtrl, 0, clockSrc);
     if (ret)
         PAL_ERR(LOG_TAG, "HwMixer set %s = %d failed", mixerStrClockSrc, clockSrc);
 
@@ -377,7 +377,7 @@ int DisplayPort::updateAudioAckState(int node_value, int controller, int stream)
             return -EINVAL;
         }
 
-        ret = mixer_ctl_set_enum_by_string(ctl, ack_str);
+        ret = SessionAlsaUtils::mixerCtlSetEnum(ctl, ack_str);
         if (ret)
             PAL_ERR(LOG_TAG, "Could not set ctl for mixer cmd - %s ret %d\n",
                    mixer_ctl_name, ret);
@@ -421,7 +421,7 @@ int DisplayPort::init(pal_param_device_connection_t device_conn)
 int DisplayPort::deinit(pal_param_device_connection_t device_conn __unused)
 {
     updateAudioAckState(EXT_DISPLAY_PLUG_STATUS_NOTIFY_DISCONNECT, dp_controller, dp_stream);
-    //To-Do : Have to invalidate the cahed EDID
+    invalidateEdid(dp_controller, dp_stream);
     return 0;
 }
 
@@ -516,7 +516,7 @@ int32_t DisplayPort::setExtDisplayDevice(struct audio_mixer *mixer, int controll
 
     PAL_DBG(LOG_TAG,"controller/stream: %ld/%ld", deviceValues[0], deviceValues[1]);
 
-    return mixer_ctl_set_array(ctl, deviceValues, ARRAY_SIZE(deviceValues));
+    return SessionAlsaUtils::mixerCtlSetArray(ctl, deviceValues, ARRAY_SIZE(deviceValues));
 }
 
 int32_t DisplayPort::getExtDispType(struct audio_mixer *mixer, int controller, int stream)
@@ -559,7 +559,7 @@ int32_t DisplayPort::getExtDispType(struct audio_mixer *mixer, int controller, i
             return -EINVAL;
         }
 
-        dispType = mixer_ctl_get_value(ctl, 0);
+        dispType = SessionAlsaUtils::mixerCtlGetValue(ctl, 0);
         if (dispType == EXT_DISPLAY_TYPE_NONE) {
             PAL_ERR(LOG_TAG,"Invalid external display type: %d", dispType);
             return -EINVAL;
@@ -642,7 +642,7 @@ int DisplayPort::getEdidInfo(struct audio_mixer *mixer, int controller, int stre
     if (count > (int)sizeof(block))
         count = (int)sizeof(block);
 
-    ret = mixer_ctl_get_array(ctl, block, count);
+    ret = SessionAlsaUtils::mixerCtlGetArray(ctl, block, count);
     if (ret != 0) {
         PAL_ERR(LOG_TAG," mixer_ctl_get_array() failed to get EDID info");
         goto fail;
@@ -673,6 +673,20 @@ void DisplayPort::cacheEdid(struct audio_mixer *mixer, int controller, int strea
     getEdidInfo(mixer, controller, stream);
 }
 
+/*
+ * The next connect on this controller/stream may be a different sink, read
+ * its EDID again. The resolved capabilities stay until then so late queries
+ * still see the last sink.
+ */
+void DisplayPort::invalidateEdid(int controller, int stream)
+{
+    if (controller < 0 || controller >= MAX_CONTROLLERS ||
+        stream < 0 || stream >= MAX_STREAMS_PER_CONTROLLER)
+        return;
+
+    extDisp[controller][stream].valid = false;
+}
+
 int32_t DisplayPort::isSampleRateSupported(uint32_t sampleRate)
 {
     int32_t rc = 0;
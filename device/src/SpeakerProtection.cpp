@@ -277,14 +277,14 @@ int SpeakerProtection::getCpsDevNumber(std::string mixer_name)
     PAL_DBG(LOG_TAG, "Mixer control %s", mixer_name.c_str());
     PAL_DBG(LOG_TAG, "audio_hw_mixer %pK", hwMixer);
 
-    ctl = mixer_get_ctl_by_name(hwMixer, mixer_name.c_str());
+    ctl = SessionAlsaUtils::getMixerControl(hwMixer, mixer_name);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_name.c_str());
         status = -ENOENT;
         return status;
     }
 
-    status = mixer_ctl_get_value(ctl, 0);
+    status = SessionAlsaUtils::mixerCtlGetValue(ctl, 0);
     PAL_DBG(LOG_TAG, "Value for Mixer control %d", status);
     return status;
 }
@@ -308,14 +308,14 @@ int SpeakerProtection::getSpeakerTemperature(int spkr_pos)
 
     PAL_DBG(LOG_TAG, "audio_mixer %pK", hwMixer);
 
-    ctl = mixer_get_ctl_by_name(hwMixer, mixer_ctl_name.c_str());
+    ctl = SessionAlsaUtils::getMixerControl(hwMixer, mixer_ctl_name);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_ctl_name.c_str());
         status = -EINVAL;
         return status;
     }
 
-    status = mixer_ctl_get_value(ctl, 0);
+    status = SessionAlsaUtils::mixerCtlGetValue(ctl, 0);
 
     PAL_DBG(LOG_TAG, "Exiting Speaker Get Temperature %d", status);
 
@@ -345,7 +345,7 @@ void SpeakerProtection::disconnectFeandBe(std::vector<int> pcmDevIds,
     }
 
     disconnectCtrlNameBe<< backEndName << " metadata";
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, disconnectCtrlNameBe.str().data());
+    beMetaDataMixerCtrl = SessionAlsaUtils::getMixerControl(virtMixer, disconnectCtrlNameBe.str());
     if (!beMetaDataMixerCtrl) {
         ret = -EINVAL;
         PAL_ERR(LOG_TAG, "Error: %d, invalid mixer control %s", ret, backEndName.c_str());
@@ -353,20 +353,20 @@ void SpeakerProtection::disconnectFeandBe(std::vector<int> pcmDevIds,
     }
 
     disconnectCtrlName << "PCM" << pcmDevIds.at(0) << " disconnect";
-    disconnectCtrl = mixer_get_ctl_by_name(virtMixer, disconnectCtrlName.str().data());
+    disconnectCtrl = SessionAlsaUtils::getMixerControl(virtMixer, disconnectCtrlName.str());
     if (!disconnectCtrl) {
         ret = -EINVAL;
         PAL_ERR(LOG_TAG, "Error: %d, invalid mixer control: %s", ret, disconnectCtrlName.str().data());
         goto exit;
     }
-    ret = mixer_ctl_set_enum_by_string(disconnectCtrl, backEndName.c_str());
+    ret = SessionAlsaUtils::mixerCtlSetEnum(disconnectCtrl, backEndName.c_str());
     if (ret) {
         PAL_ERR(LOG_TAG, "Error: %d, Mixer control %s set with %s failed", ret,
         disconnectCtrlName.str().data(), backEndName.c_str());
     }
 
     if (deviceMetaData.size) {
-        ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        ret = SessionAlsaUtils::mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
@@ -529,7 +529,7 @@ int SpeakerProtection::spkrStartCalibrationV2()
     }
 
     connectCtrlNameBeVI<< backEndNameTx << " metadata";
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameBeVI.str().data());
+    beMetaDataMixerCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlNameBeVI.str());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control for VI : %s", backEndNameTx.c_str());
         ret = -EINVAL;
@@ -537,7 +537,7 @@ int SpeakerProtection::spkrStartCalibrationV2()
     }
 
     if (deviceMetaData.size) {
-        ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        ret = SessionAlsaUtils::mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
@@ -565,12 +565,12 @@ int SpeakerProtection::spkrStartCalibrationV2()
     }
 
     connectCtrlName << "PCM" << pcmDevIdsTx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlName.str().data());
+    connectCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlName.str());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         goto free_fe;
     }
-    ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndNameTx.c_str());
+    ret = SessionAlsaUtils::mixerCtlSetEnum(connectCtrl, backEndNameTx.c_str());
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlName.str().data(), backEndNameTx.c_str(), ret);
@@ -802,7 +802,7 @@ int SpeakerProtection::spkrStartCalibrationV2()
 
     connectCtrlNameBe<< backEndNameRx << " metadata";
 
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameBe.str().data());
+    beMetaDataMixerCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlNameBe.str());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", backEndNameRx.c_str());
         ret = -EINVAL;
@@ -810,7 +810,7 @@ int SpeakerProtection::spkrStartCalibrationV2()
     }
 
     if (deviceMetaData.size) {
-        ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        ret = SessionAlsaUtils::mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                                     deviceMetaData.size);
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
@@ -839,13 +839,13 @@ int SpeakerProtection::spkrStartCalibrationV2()
     }
 
     connectCtrlNameRx << "PCM" << pcmDevIdsRx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameRx.str().data());
+    connectCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlNameRx.str());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlNameRx.str().data());
         ret = -ENOSYS;
         goto err_pcm_open;
     }
-    ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndNameRx.c_str());
+    ret = SessionAlsaUtils::mixerCtlSetEnum(connectCtrl, backEndNameRx.c_str());
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlNameRx.str().data(), backEndNameRx.c_str(), ret);
@@ -1182,7 +1182,7 @@ int SpeakerProtection::spkrStartCalibration()
     }
 
     connectCtrlNameBeVI<< backEndNameTx << " metadata";
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameBeVI.str().data());
+    beMetaDataMixerCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlNameBeVI.str());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control for VI : %s", backEndNameTx.c_str());
         ret = -EINVAL;
@@ -1190,7 +1190,7 @@ int SpeakerProtection::spkrStartCalibration()
     }
 
     if (deviceMetaData.size) {
-        ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        ret = SessionAlsaUtils::mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
@@ -1218,12 +1218,12 @@ int SpeakerProtection::spkrStartCalibration()
     }
 
     connectCtrlName << "PCM" << pcmDevIdsTx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlName.str().data());
+    connectCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlName.str());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         goto free_fe;
     }
-    ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndNameTx.c_str());
+    ret = SessionAlsaUtils::mixerCtlSetEnum(connectCtrl, backEndNameTx.c_str());
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlName.str().data(), backEndNameTx.c_str(), ret);
@@ -1454,7 +1454,7 @@ int SpeakerProtection::spkrStartCalibration()
 
     connectCtrlNameBe<< backEndNameRx << " metadata";
 
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameBe.str().data());
+    beMetaDataMixerCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlNameBe.str());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", backEndNameRx.c_str());
         ret = -EINVAL;
@@ -1462,7 +1462,7 @@ int SpeakerProtection::spkrStartCalibration()
     }
 
     if (deviceMetaData.size) {
-        ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        ret = SessionAlsaUtils::mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                                     deviceMetaData.size);
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
@@ -1491,13 +1491,13 @@ int SpeakerProtection::spkrStartCalibration()
     }
 
     connectCtrlNameRx << "PCM" << pcmDevIdsRx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameRx.str().data());
+    connectCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlNameRx.str());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlNameRx.str().data());
         ret = -ENOSYS;
         goto err_pcm_open;
     }
-    ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndNameRx.c_str());
+    ret = SessionAlsaUtils::mixerCtlSetEnum(connectCtrl, backEndNameRx.c_str());
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlNameRx.str().data(), backEndNameRx.c_str(), ret);
@@ -1817,14 +1817,14 @@ int SpeakerProtection::getDeviceTemperatureList()
     for(i = 0; i < spDevInfo.numChannels; i++) {
         PAL_ERR(LOG_TAG, "audio_mixer %pK", hwMixer);
         mixer_ctl_name = temp_ctrls[i];
-        ctl = mixer_get_ctl_by_name(hwMixer, mixer_ctl_name.c_str());
+        ctl = SessionAlsaUtils::getMixerControl(hwMixer, mixer_ctl_name);
         if(!ctl) {
             PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n",
                     mixer_ctl_name.c_str());
             return -EINVAL;
         }
 
-        value = mixer_ctl_get_value(ctl, 0);
+        value = SessionAlsaUtils::mixerCtlGetValue(ctl, 0);
         PAL_INFO(LOG_TAG, "Device Get Temperature %s  %d",mixer_ctl_name.c_str(),
                                                                            value);
         if ((value == -EINVAL) ||
@@ -2472,8 +2472,8 @@ int32_t SpeakerProtection::spkrProtProcessingModeV2(bool flag)
             goto exit;
         }
         connectCtrlNameBeVI<< backEndName << " metadata";
-        beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer,
-                                    connectCtrlNameBeVI.str().data());
+        beMetaDataMixerCtrl = SessionAlsaUtils::getMixerControl(virtMixer,
+                                    connectCtrlNameBeVI.str());
         if (!beMetaDataMixerCtrl) {
             PAL_ERR(LOG_TAG, "invalid mixer control for VI : %s", backEndName.c_str());
             ret = -EINVAL;
@@ -2481,7 +2481,7 @@ int32_t SpeakerProtection::spkrProtProcessingModeV2(bool flag)
         }
 
         if (deviceMetaData.size) {
-            ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+            ret = SessionAlsaUtils::mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                         deviceMetaData.size);
             free(deviceMetaData.buf);
             deviceMetaData.buf = nullptr;
@@ -2510,13 +2510,13 @@ int32_t SpeakerProtection::spkrProtProcessingModeV2(bool flag)
         }
 
         connectCtrlName << "PCM" << pcmDevIdTx.at(0) << " connect";
-        connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlName.str().data());
+        connectCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlName.str());
         if (!connectCtrl) {
             PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
             goto free_fe;
         }
 
-        ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndName.c_str());
+        ret = SessionAlsaUtils::mixerCtlSetEnum(connectCtrl, backEndName.c_str());
         if (ret) {
             PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
             connectCtrlName.str().data(), backEndName.c_str(), ret);
@@ -3169,8 +3169,8 @@ int32_t SpeakerProtection::spkrProtProcessingMode(bool flag)
             goto exit;
         }
         connectCtrlNameBeVI<< backEndName << " metadata";
-        beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer,
-                                    connectCtrlNameBeVI.str().data());
+        beMetaDataMixerCtrl = SessionAlsaUtils::getMixerControl(virtMixer,
+                                    connectCtrlNameBeVI.str());
         if (!beMetaDataMixerCtrl) {
             PAL_ERR(LOG_TAG, "invalid mixer control for VI : %s", backEndName.c_str());
             ret = -EINVAL;
@@ -3178,7 +3178,7 @@ int32_t SpeakerProtection::spkrProtProcessingMode(bool flag)
         }
 
         if (deviceMetaData.size) {
-            ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+            ret = SessionAlsaUtils::mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                         deviceMetaData.size);
             free(deviceMetaData.buf);
             deviceMetaData.buf = nullptr;
@@ -3207,13 +3207,13 @@ int32_t SpeakerProtection::spkrProtProcessingMode(bool flag)
         }
 
         connectCtrlName << "PCM" << pcmDevIdTx.at(0) << " connect";
-        connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlName.str().data());
+        connectCtrl = SessionAlsaUtils::getMixerControl(virtMixer, connectCtrlName.str());
         if (!connectCtrl) {
             PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
             goto free_fe;
         }
 
-        ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndName.c_str());
+        ret = SessionAlsaUtils::mixerCtlSetEnum(connectCtrl, backEndName.c_str());
         if (ret) {
             PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
             connectCtrlName.str().data(), backEndName.c_str(), ret);
@@ -3754,7 +3754,7 @@ int32_t SpeakerProtection::getFTMParameter(void **param)
         goto exit;
     }
 
-    ctl = mixer_get_ctl_by_name(virtMixer, cntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(virtMixer, cntrlName.str());
     if (!ctl) {
         status = -ENOENT;
         PAL_ERR(LOG_TAG, "Error: %d Invalid mixer control: %s\n", status,cntrlName.str().data());
@@ -3778,7 +3778,7 @@ int32_t SpeakerProtection::getFTMParameter(void **param)
     builder->payloadSPConfig (&payload, &payloadSize, miid,
             PARAM_ID_SP_TH_VI_FTM_PARAMS, &ftm);
 
-    status = mixer_ctl_set_array(ctl, payload, payloadSize);
+    status = SessionAlsaUtils::mixerCtlSetArray(ctl, payload, payloadSize);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Set failed status = %d", status);
         goto exit;
@@ -3786,7 +3786,7 @@ int32_t SpeakerProtection::getFTMParameter(void **param)
 
     memset(payload, 0, payloadSize);
 
-    status = mixer_ctl_get_array(ctl, payload, payloadSize);
+    status = SessionAlsaUtils::mixerCtlGetArray(ctl, payload, payloadSize);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Get failed status = %d", status);
     }
@@ -3814,7 +3814,7 @@ int32_t SpeakerProtection::getFTMParameter(void **param)
     builder->payloadSPConfig (&payload, &payloadSize, miid,
             PARAM_ID_SP_EX_VI_FTM_PARAMS, &exFtm);
 
-    status = mixer_ctl_set_array(ctl, payload, payloadSize);
+    status = SessionAlsaUtils::mixerCtlSetArray(ctl, payload, payloadSize);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Error: %d Mixer cntrl Set failed", status);
         goto exit;
@@ -3822,7 +3822,7 @@ int32_t SpeakerProtection::getFTMParameter(void **param)
 
     memset(payload, 0, payloadSize);
 
-    status = mixer_ctl_get_array(ctl, payload, payloadSize);
+    status = SessionAlsaUtils::mixerCtlGetArray(ctl, payload, payloadSize);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Error: %d Get failed ", status);
     }
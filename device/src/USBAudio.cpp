@@ -374,6 +374,11 @@ const unsigned int USBCardConfig::in_chn_mask_[MAX_SUPPORTED_CHANNEL_MASKS] =
     {0x10, 0x80000001, 0xc, 0x80000003, 0x80000007, 0x8000000f, 0x8000001f,
     0x8000003f};
 
+std::mutex USBCardConfig::capability_db_mutex_;
+std::list<usbCapabilityEntry> USBCardConfig::capability_db_;
+std::unordered_map<std::string,
+        std::list<usbCapabilityEntry>::iterator> USBCardConfig::capability_db_map_;
+
 bool USBCardConfig::isConfigCached(struct pal_usb_device_address addr) {
     if(address_.card_id == addr.card_id && address_.device_num == addr.device_num)
         return true;
@@ -401,29 +406,87 @@ void USBCardConfig::usb_info_dump(char* read_buf, int type) {
     }
 }
 
+/*
+ * USB identity of the card: "VID:PID" from usbid plus the device serial
+ * when it has one. Empty if the card is not a USB audio card.
+ */
+std::string USBCardConfig::getUsbIdentity(int usb_card)
+{
+    char path[128];
+    char buf[USBID_SIZE + 128] = {0};
+    std::string identity;
+    FILE *fp = NULL;
+
+    snprintf(path, sizeof(path), "/proc/asound/card%u/usbid", usb_card);
+    fp = fopen(path, "r");
+    if (!fp)
+        return identity;
+    if (fgets(buf, USBID_SIZE, fp))
+        identity = buf;
+    fclose(fp);
+    if (identity.empty())
+        return identity;
+    identity.erase(identity.find_last_not_of(" \n") + 1);
+
+    snprintf(path, sizeof(path), "/sys/class/sound/card%u/device/../serial", usb_card);
+    fp = fopen(path, "r");
+    if (fp) {
+        memset(buf, 0, sizeof(buf));
+        if (fgets(buf, sizeof(buf), fp)) {
+            identity += "/";
+            identity += buf;
+            identity.erase(identity.find_last_not_of(" \n") + 1);
+        }
+        fclose(fp);
+    }
+
+    return identity;
+}
+
+bool USBCardConfig::lookupCapabilityDb(const std::string &key, usbCapabilityEntry &entry)
+{
+    std::lock_guard<std::mutex> lock(capability_db_mutex_);
+    auto it = capability_db_map_.find(key);
+
+    if (it == capability_db_map_.end())
+        return false;
+
+    /* move to front, it is the most recently used now */
+    capability_db_.splice(capability_db_.begin(), capability_db_, it->second);
+    entry = *it->second;
+    return true;
+}
+
+void USBCardConfig::insertCapabilityDb(const usbCapabilityEntry &entry)
+{
+    std::lock_guard<std::mutex> lock(capability_db_mutex_);
+    auto it = capability_db_map_.find(entry.key);
+
+    if (it != capability_db_map_.end()) {
+        capability_db_.erase(it->second);
+        capability_db_map_.erase(it);
+    }
+    if (capability_db_.size() >= USB_CAPABILITY_DB_MAX_ENTRIES) {
+        capability_db_map_.erase(capability_db_.back().key);
+        capability_db_.pop_back();
+    }
+
+    capability_db_.push_front(entry);
+    capability_db_map_[entry.key] = capability_db_.begin();
+}
+
 int USBCardConfig::getCapability(usb_usecase_type_t type,
                                         struct pal_usb_device_address addr) {
-    int32_t size = 0;
     FILE *fd = NULL;
-    int32_t channels_no;
-    char *str_start = NULL;
-    char *str_end = NULL;
-    char *channel_start = NULL;
-    char *bit_width_start = NULL;
-    char *rates_str_start = NULL;
-    char *target = NULL;
     char *read_buf = NULL;
-    char *rates_str = NULL;
-    char *interval_str_start = NULL;
     char path[128];
     int ret = 0;
-    char *bit_width_str = NULL;
     size_t num_read = 0;
     const char* suffix;
-    bool jack_status;
-    //std::shared_ptr<USBDeviceConfig> usb_device_info = nullptr;
-
-    bool check = false;
+    bool jack_status = true;
+    std::string identity;
+    usbCapabilityEntry entry;
+    bool cached = false;
 
     memset(path, 0, sizeof(path));
     PAL_INFO(LOG_TAG, "for %s", (type == USB_PLAYBACK) ?
@@ -451,36 +514,45 @@ int USBCardConfig::getCapability(usb_usecase_type_t type,
         goto done;
     }
 
-    if ((num_read = fread(read_buf, 1, USB_BUFF_SIZE, fd)) < 0) {
-        PAL_ERR(LOG_TAG, "file read error");
-        goto done;
-    }
+    num_read = fread(read_buf, 1, USB_BUFF_SIZE, fd);
     read_buf[num_read] = '\0';
 
-    str_start = strstr(read_buf, ((type == USB_PLAYBACK) ?
-                       PLAYBACK_PROFILE_STR : CAPTURE_PROFILE_STR));
-    if (str_start == NULL) {
-        PAL_INFO(LOG_TAG, "error %s section not found in usb config file",
-                ((type == USB_PLAYBACK) ?
-               PLAYBACK_PROFILE_STR : CAPTURE_PROFILE_STR));
-        ret = -ENOENT;
-        goto done;
+    /*
+     * A known headset or dock reports the same stream0 text on every
+     * connect, reuse its parsed profile instead of parsing again.
+     */
+    identity = getUsbIdentity(addr.card_id);
+    if (!identity.empty()) {
+        char hash[32];
+
+        snprintf(hash, sizeof(hash), "#%d#%016llx", type,
+                 (unsigned long long)USBStreamParser::hash(read_buf, num_read));
+        entry.key = identity + hash;
+        cached = lookupCapabilityDb(entry.key, entry);
     }
 
-    str_end = strstr(read_buf, ((type == USB_PLAYBACK) ?
-                       CAPTURE_PROFILE_STR : PLAYBACK_PROFILE_STR));
+    if (!cached) {
+        entry.endian = endian_;
+        entry.status = USBStreamParser::parse(read_buf, type, entry.altsets, &entry.endian);
+        if (!identity.empty())
+            insertCapabilityDb(entry);
+    } else {
+        PAL_INFO(LOG_TAG, "usb %s capability found in cache", identity.c_str());
+    }
 
-    if (str_end > str_start)
-        check = true;
+    ret = entry.status;
+    if (ret == -ENOENT)
+        goto done;
+    setEndian(entry.endian);
 
-    while (str_start != NULL) {
-        str_start = strstr(str_start, "Altset");
-        if ((str_start == NULL) || (check  && (str_start >= str_end))) {
-            PAL_VERBOSE(LOG_TAG,"done parsing %s\n", str_start);
-            break;
-        }
-        PAL_VERBOSE(LOG_TAG,"remaining string %s\n", str_start);
-        str_start += sizeof("Altset");
+    /* jack status parsing, the same mixer control serves every altset */
+    if (!entry.altsets.empty()) {
+        suffix = (type == USB_PLAYBACK) ? USB_OUT_JACK_SUFFIX : USB_IN_JACK_SUFFIX;
+        jack_status = getJackConnectionStatus(addr.card_id, suffix);
+        PAL_DBG(LOG_TAG, "jack_status %d", jack_status);
+    }
+
+    for (auto &altset : entry.altsets) {
         std::shared_ptr<USBDeviceConfig> usb_device_info(new USBDeviceConfig());
         if (!usb_device_info) {
             PAL_ERR(LOG_TAG, "error unable to create usb device config object");
@@ -488,95 +560,12 @@ int USBCardConfig::getCapability(usb_usecase_type_t type,
             break;
         }
         usb_device_info->setType(type);
-        /* Bit bit_width parsing */
-        bit_width_start = strstr(str_start, "Format: ");
-        if (bit_width_start == NULL) {
-            PAL_INFO(LOG_TAG, "Could not find bit_width string");
-            continue;
-        }
-        target = strchr(bit_width_start, '\n');
-        if (target == NULL) {
-            PAL_INFO(LOG_TAG, "end of line not found");
-            continue;
-        }
-        size = target - bit_width_start;
-        if ((bit_width_str = (char *)malloc(size + 1)) == NULL) {
-            PAL_ERR(LOG_TAG, "unable to allocate memory to hold bit width strings");
-            ret = -EINVAL;
-            break;
-        }
-        memcpy(bit_width_str, bit_width_start, size);
-        bit_width_str[size] = '\0';
-
-        const char *formats[] = {"S32", "S24_3", "S24", "S16", "U32"};
-        const int bit_width[] = {32, 24, 24, 16, 32};
-        for (size_t i = 0; i < sizeof(formats)/sizeof(formats[0]); i++) {
-            const char * s = strstr(bit_width_str, formats[i]);
-            if (s) {
-                usb_device_info->setBitWidth(bit_width[i]);
-                setEndian(strstr(s, "BE") ? 1 : 0);
-                break;
-            }
-        }
-
-        if (bit_width_str)
-            free(bit_width_str);
-
-        /* channels parsing */
-        channel_start = strstr(str_start, CHANNEL_NUMBER_STR);
-        if (channel_start == NULL) {
-            PAL_INFO(LOG_TAG, "could not find Channels string");
-            continue;
-        }
-        channels_no = atoi(channel_start + strlen(CHANNEL_NUMBER_STR));
-        usb_device_info->setChannels(channels_no);
-
-        /* Sample rates parsing */
-        rates_str_start = strstr(str_start, "Rates: ");
-        if (rates_str_start == NULL) {
-            PAL_INFO(LOG_TAG, "cant find rates string");
-            continue;
-        }
-        target = strchr(rates_str_start, '\n');
-        if (target == NULL) {
-            PAL_INFO(LOG_TAG, "end of line not found");
-            continue;
-        }
-        size = target - rates_str_start;
-        if ((rates_str = (char *)malloc(size + 1)) == NULL) {
-            PAL_INFO(LOG_TAG, "unable to allocate memory to hold sample rate strings");
-            ret = -EINVAL;
-
-            break;
-        }
-        memcpy(rates_str, rates_str_start, size);
-        rates_str[size] = '\0';
-        ret = usb_device_info->getSampleRates(type, rates_str);
-        if (rates_str)
-            free(rates_str);
-        if (ret < 0) {
-            PAL_INFO(LOG_TAG, "error unable to get sample rate values");
-            continue;
-        }
-        // Data packet interval is an optional field.
-        // Assume 0ms interval if this cannot be read
-        // LPASS USB and HLOS USB will figure out the default to use
-        usb_device_info->setInterval(DEFAULT_SERVICE_INTERVAL_US);
-        interval_str_start = strstr(str_start, DATA_PACKET_INTERVAL_STR);
-        if (interval_str_start != NULL) {
-            interval_str_start += strlen(DATA_PACKET_INTERVAL_STR);
-            ret = usb_device_info->getServiceInterval(interval_str_start);
-            if (ret < 0) {
-                PAL_INFO(LOG_TAG, "error unable to get service interval, assume default");
-            }
-        }
-        /* jack status parsing */
-        suffix = (type == USB_PLAYBACK) ? USB_OUT_JACK_SUFFIX : USB_IN_JACK_SUFFIX;
-        jack_status = getJackConnectionStatus(addr.card_id, suffix);
-        PAL_DBG(LOG_TAG, "jack_status %d", jack_status);
+        usb_device_info->setBitWidth(altset.bit_width);
+        usb_device_info->setChannels(altset.channels);
+        usb_device_info->setSampleRates(type, altset.rates, altset.sample_rates_mask);
+        usb_device_info->setInterval(altset.service_interval_us);
         usb_device_info->setJackStatus(jack_status);
 
-        /* Add to list if every field is valid */
         usb_device_config_list_.push_back(usb_device_info);
         format_list_map.insert( std::pair<int, std::shared_ptr<USBDeviceConfig>>(usb_device_info->getBitWidth(),usb_device_info));
     }
@@ -595,6 +584,7 @@ done:
 
 USBCardConfig::USBCardConfig(struct pal_usb_device_address address) {
     address_ = address;
+    endian_ = 0;
 }
 
 unsigned int USBCardConfig::getMax(unsigned int x, unsigned int y) {
@@ -719,7 +709,7 @@ unsigned int USBCardConfig::readSupportedSampleRate(bool is_playback, uint32_t *
     int i = 0;
     while (tries) {
         int idx = __builtin_ffs(bm) - 1;
-        sample_rate[i++] = USBDeviceConfig::supported_sample_rates_[idx];
+        sample_rate[i++] = USBStreamParser::supported_sample_rates_[idx];
         bm &= ~(1<<idx);
         tries--;
     }
@@ -913,10 +903,6 @@ UpdateBestCh:
     return 0;
 }
 
-const unsigned int USBDeviceConfig::supported_sample_rates_[] =
-    {384000, 352800, 192000, 176400, 96000, 88200, 64000,
-     48000, 44100, 32000, 24000, 22050, 16000, 11025, 8000};
-
 void USBDeviceConfig::setBitWidth(unsigned int bit_width) {
     bit_width_ = bit_width;
 }
@@ -937,6 +923,13 @@ void USBDeviceConfig::setInterval(unsigned long interval) {
     service_interval_us_ = interval;
 }
 
+void USBDeviceConfig::setSampleRates(usb_usecase_type_t type,
+                                     const std::vector<unsigned int> &rates,
+                                     unsigned int mask) {
+    rates_ = rates;
+    supported_sample_rates_mask_[type] |= mask;
+}
+
 unsigned int USBDeviceConfig::getBitWidth() {
     return bit_width_;
 }
@@ -1036,106 +1029,6 @@ int USBDeviceConfig::updateBestChInfo(struct pal_channel_info *requested_ch_info
     return 0;
 }
 
-int USBDeviceConfig::getSampleRates(int type, char *rates_str) {
-    unsigned int i;
-    char *next_sr_string, *temp_ptr;
-    unsigned int sr, min_sr, max_sr, sr_size = 0;
-
-    /* Sample rate string can be in any of the folloing two bit_widthes:
-     * Rates: 8000 - 48000 (continuous)
-     * Rates: 8000, 44100, 48000
-     * Support both the bit_widths
-     */
-
-    PAL_VERBOSE(LOG_TAG, "rates_str %s", rates_str);
-    next_sr_string = strtok_r(rates_str, "Rates: ", &temp_ptr);
-    if (next_sr_string == NULL) {
-        PAL_ERR(LOG_TAG, "could not find min rates string");
-        return -EINVAL;
-    }
-    if (strstr(rates_str, "continuous") != NULL) {
-        min_sr = (unsigned int)atoi(next_sr_string);
-        next_sr_string = strtok_r(NULL, " ,.-", &temp_ptr);
-        if (next_sr_string == NULL) {
-            PAL_ERR(LOG_TAG, "could not find max rates string");
-            return -EINVAL;
-        }
-        max_sr = (unsigned int)atoi(next_sr_string);
-
-        for (i = 0; i < MAX_SAMPLE_RATE_SIZE; i++) {
-            if (supported_sample_rates_[i] >= min_sr &&
-                supported_sample_rates_[i] <= max_sr) {
-                // FIXME: we don't support >192KHz in recording path for now
-                if ((supported_sample_rates_[i] > SAMPLE_RATE_192000) &&
-                        (type == USB_CAPTURE))
-                    continue;
-                rates_.push_back(supported_sample_rates_[i]);
-                supported_sample_rates_mask_[type] |= (1<<i);
-                PAL_DBG(LOG_TAG, "continuous sample rate supported_sample_rates_[%d] %d",
-                        i, supported_sample_rates_[i]);
-            }
-        }
-    } else {
-        do {
-            sr = (unsigned int)atoi(next_sr_string);
-            // FIXME: we don't support >192KHz in recording path for now
-            if ((sr > SAMPLE_RATE_192000) && (type == USB_CAPTURE)) {
-                next_sr_string = strtok_r(NULL, " ,.-", &temp_ptr);
-                continue;
-            }
-
-            for (i = 0; i < MAX_SAMPLE_RATE_SIZE; i++) {
-                if (supported_sample_rates_[i] == sr) {
-                    PAL_DBG(LOG_TAG, "sr %d, supported_sample_rates_[%d] %d -> matches!!",
-                              sr, i, supported_sample_rates_[i]);
-                    rates_.push_back(supported_sample_rates_[i]);
-                    supported_sample_rates_mask_[type] |= (1<<i);
-                }
-            }
-            next_sr_string = strtok_r(NULL, " ,.-", &temp_ptr);
-        } while (next_sr_string != NULL);
-    }
-    return 0;
-}
-
-int USBDeviceConfig::getServiceInterval(const char *interval_str_start)
-{
-    unsigned long interval = 0;
-    char time_unit[8] = {0};
-    int multiplier = 0;
-
-    const char *eol = strchr(interval_str_start, '\n');
-    if (!eol) {
-        PAL_ERR(LOG_TAG, "No EOL found");
-        return -1;
-    }
-    char *tmp = (char *)calloc(1, eol-interval_str_start+1);
-    if (!tmp) {
-        PAL_ERR(LOG_TAG, "failed to allocate tmp");
-        return -1;
-    }
-    memcpy(tmp, interval_str_start, eol-interval_str_start);
-    tmp[eol-interval_str_start] = '\0';
-    sscanf(tmp, "%lu %2s", &interval, &time_unit[0]);
-    if (!strcmp(time_unit, "us")) {
-        multiplier = 1;
-    } else if (!strcmp(time_unit, "ms")) {
-        multiplier = 1000;
-    } else if (!strcmp(time_unit, "s")) {
-        multiplier = 1000000;
-    } else {
-        PAL_ERR(LOG_TAG, "unknown time_unit %s, assume default", time_unit);
-        interval = DEFAULT_SERVICE_INTERVAL_US;
-        multiplier = 1;
-    }
-    interval *= multiplier;
-    PAL_DBG(LOG_TAG, "set service_interval_us %lu", interval);
-    service_interval_us_ = interval;
-    free(tmp);
-
-    return 0;
-}
-
 bool USB::isUsbAlive(int card)
 {
     char path[128];
@@ -1183,7 +1076,7 @@ bool USBCardConfig::getJackConnectionStatus(int usb_card, const char* suffix)
         return true;
     }
     mixer_ctl_update(ctrl);
-    value = mixer_ctl_get_value(ctrl, 0);
+    value = SessionAlsaUtils::mixerCtlGetValue(ctrl, 0);
     PAL_DBG(LOG_TAG, "ctrl %s - value %d", mixer_ctl_get_name(ctrl), value);
     mixer_close(usb_card_mixer);
 
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: USBStreamParser"
+
+#include "USBStreamParser.h"
+#include "PalCommon.h"
+#include "PalDefs.h"
+#include <errno.h>
+
+const unsigned int USBStreamParser::supported_sample_rates_[] =
+    {384000, 352800, 192000, 176400, 96000, 88200, 64000,
+     48000, 44100, 32000, 24000, 22050, 16000, 11025, 8000};
+
+/* strstr that ignores matches at or past end, end NULL for no limit */
+static const char *findField(const char *start, const char *end, const char *field)
+{
+    const char *s = strstr(start, field);
+
+    return (s && end && s >= end) ? NULL : s;
+}
+
+uint64_t USBStreamParser::hash(const char *stream_info, size_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (uint8_t)stream_info[i]) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+int USBStreamParser::parse(const char *stream_info, usb_usecase_type_t type,
+                           std::vector<usbStreamAltset> &altsets, int *endian)
+{
+    int32_t size = 0;
+    int32_t channels_no;
+    const char *str_start = NULL;
+    const char *str_end = NULL;
+    const char *altset_end = NULL;
+    const char *channel_start = NULL;
+    const char *bit_width_start = NULL;
+    const char *rates_str_start = NULL;
+    const char *target = NULL;
+    char *rates_str = NULL;
+    const char *interval_str_start = NULL;
+    char *bit_width_str = NULL;
+    int ret = 0;
+    bool check = false;
+
+    str_start = strstr(stream_info, ((type == USB_PLAYBACK) ?
+                       PLAYBACK_PROFILE_STR : CAPTURE_PROFILE_STR));
+    if (str_start == NULL) {
+        PAL_INFO(LOG_TAG, "error %s section not found in usb config file",
+                ((type == USB_PLAYBACK) ?
+               PLAYBACK_PROFILE_STR : CAPTURE_PROFILE_STR));
+        return -ENOENT;
+    }
+
+    str_end = strstr(stream_info, ((type == USB_PLAYBACK) ?
+                       CAPTURE_PROFILE_STR : PLAYBACK_PROFILE_STR));
+
+    if (str_end > str_start)
+        check = true;
+
+    while (str_start != NULL) {
+        str_start = strstr(str_start, ALTSET_STR);
+        if ((str_start == NULL) || (check  && (str_start >= str_end))) {
+            PAL_VERBOSE(LOG_TAG,"done parsing %s\n", str_start);
+            break;
+        }
+        PAL_VERBOSE(LOG_TAG,"remaining string %s\n", str_start);
+        str_start += strlen(ALTSET_STR);
+        usbStreamAltset altset = {};
+
+        /*
+         * Fields are looked up within this altset only, optional ones like
+         * the data packet interval must not be taken from the next one.
+         */
+        altset_end = strstr(str_start, ALTSET_STR);
+        if (check && (altset_end == NULL || altset_end > str_end))
+            altset_end = str_end;
+
+        /* Bit bit_width parsing */
+        bit_width_start = findField(str_start, altset_end, "Format: ");
+        if (bit_width_start == NULL) {
+            PAL_INFO(LOG_TAG, "Could not find bit_width string");
+            continue;
+        }
+        target = strchr(bit_width_start, '\n');
+        if (target == NULL) {
+            PAL_INFO(LOG_TAG, "end of line not found");
+            continue;
+        }
+        size = target - bit_width_start;
+        if ((bit_width_str = (char *)malloc(size + 1)) == NULL) {
+            PAL_ERR(LOG_TAG, "unable to allocate memory to hold bit width strings");
+            ret = -EINVAL;
+            break;
+        }
+        memcpy(bit_width_str, bit_width_start, size);
+        bit_width_str[size] = '\0';
+
+        const char *formats[] = {"S32", "S24_3", "S24", "S16", "U32"};
+        const int bit_width[] = {32, 24, 24, 16, 32};
+        for (size_t i = 0; i < sizeof(formats)/sizeof(formats[0]); i++) {
+            const char * s = strstr(bit_width_str, formats[i]);
+            if (s) {
+                altset.bit_width = bit_width[i];
+                *endian = strstr(s, "BE") ? 1 : 0;
+                break;
+            }
+        }
+
+        if (bit_width_str)
+            free(bit_width_str);
+
+        /* channels parsing */
+        channel_start = findField(str_start, altset_end, CHANNEL_NUMBER_STR);
+        if (channel_start == NULL) {
+            PAL_INFO(LOG_TAG, "could not find Channels string");
+            continue;
+        }
+        channels_no = atoi(channel_start + strlen(CHANNEL_NUMBER_STR));
+        altset.channels = channels_no;
+
+        /* Sample rates parsing */
+        rates_str_start = findField(str_start, altset_end, "Rates: ");
+        if (rates_str_start == NULL) {
+            PAL_INFO(LOG_TAG, "cant find rates string");
+            continue;
+        }
+        target = strchr(rates_str_start, '\n');
+        if (target == NULL) {
+            PAL_INFO(LOG_TAG, "end of line not found");
+            continue;
+        }
+        size = target - rates_str_start;
+        if ((rates_str = (char *)malloc(size + 1)) == NULL) {
+            PAL_INFO(LOG_TAG, "unable to allocate memory to hold sample rate strings");
+            ret = -EINVAL;
+
+            break;
+        }
+        memcpy(rates_str, rates_str_start, size);
+        rates_str[size] = '\0';
+        ret = getSampleRates(type, rates_str, altset);
+        if (rates_str)
+            free(rates_str);
+        if (ret < 0) {
+            PAL_INFO(LOG_TAG, "error unable to get sample rate values");
+            continue;
+        }
+        // Data packet interval is an optional field.
+        // Assume 0ms interval if this cannot be read
+        // LPASS USB and HLOS USB will figure out the default to use
+        altset.service_interval_us = DEFAULT_SERVICE_INTERVAL_US;
+        interval_str_start = findField(str_start, altset_end, DATA_PACKET_INTERVAL_STR);
+        if (interval_str_start != NULL) {
+            interval_str_start += strlen(DATA_PACKET_INTERVAL_STR);
+            ret = getServiceInterval(interval_str_start, altset);
+            if (ret < 0) {
+                PAL_INFO(LOG_TAG, "error unable to get service interval, assume default");
+            }
+        }
+
+        /* Add to list if every field is valid */
+        altsets.push_back(std::move(altset));
+    }
+
+    return ret;
+}
+
+int USBStreamParser::getSampleRates(int type, char *rates_str, usbStreamAltset &altset)
+{
+    unsigned int i;
+    char *next_sr_string, *temp_ptr;
+    unsigned int sr, min_sr, max_sr;
+    bool continuous = strstr(rates_str, "continuous") != NULL;
+
+    /* Sample rate string can be in any of the folloing two bit_widthes:
+     * Rates: 8000 - 48000 (continuous)
+     * Rates: 8000, 44100, 48000
+     * Support both the bit_widths
+     */
+
+    PAL_VERBOSE(LOG_TAG, "rates_str %s", rates_str);
+    next_sr_string = strtok_r(rates_str, "Rates: ", &temp_ptr);
+    if (next_sr_string == NULL) {
+        PAL_ERR(LOG_TAG, "could not find min rates string");
+        return -EINVAL;
+    }
+    if (continuous) {
+        min_sr = (unsigned int)atoi(next_sr_string);
+        next_sr_string = strtok_r(NULL, " ,.-", &temp_ptr);
+        if (next_sr_string == NULL) {
+            PAL_ERR(LOG_TAG, "could not find max rates string");
+            return -EINVAL;
+        }
+        max_sr = (unsigned int)atoi(next_sr_string);
+
+        for (i = 0; i < MAX_SAMPLE_RATE_SIZE; i++) {
+            if (supported_sample_rates_[i] >= min_sr &&
+                supported_sample_rates_[i] <= max_sr) {
+                // FIXME: we don't support >192KHz in recording path for now
+                if ((supported_sample_rates_[i] > SAMPLE_RATE_192000) &&
+                        (type == USB_CAPTURE))
+                    continue;
+                altset.rates.push_back(supported_sample_rates_[i]);
+                altset.sample_rates_mask |= (1<<i);
+                PAL_DBG(LOG_TAG, "continuous sample rate supported_sample_rates_[%d] %d",
+                        i, supported_sample_rates_[i]);
+            }
+        }
+    } else {
+        do {
+            sr = (unsigned int)atoi(next_sr_string);
+            // FIXME: we don't support >192KHz in recording path for now
+            if ((sr > SAMPLE_RATE_192000) && (type == USB_CAPTURE)) {
+                next_sr_string = strtok_r(NULL, " ,.-", &temp_ptr);
+                continue;
+            }
+
+            for (i = 0; i < MAX_SAMPLE_RATE_SIZE; i++) {
+                if (supported_sample_rates_[i] == sr) {
+                    PAL_DBG(LOG_TAG, "sr %d, supported_sample_rates_[%d] %d -> matches!!",
+                              sr, i, supported_sample_rates_[i]);
+                    altset.rates.push_back(supported_sample_rates_[i]);
+                    altset.sample_rates_mask |= (1<<i);
+                }
+            }
+            next_sr_string = strtok_r(NULL, " ,.-", &temp_ptr);
+        } while (next_sr_string != NULL);
+    }
+    return 0;
+}
+
+int USBStreamParser::getServiceInterval(const char *interval_str_start,
+                                        usbStreamAltset &altset)
+{
+    unsigned long interval = 0;
+    char time_unit[8] = {0};
+    int multiplier = 0;
+
+    const char *eol = strchr(interval_str_start, '\n');
+    if (!eol) {
+        PAL_ERR(LOG_TAG, "No EOL found");
+        return -1;
+    }
+    char *tmp = (char *)calloc(1, eol-interval_str_start+1);
+    if (!tmp) {
+        PAL_ERR(LOG_TAG, "failed to allocate tmp");
+        return -1;
+    }
+    memcpy(tmp, interval_str_start, eol-interval_str_start);
+    tmp[eol-interval_str_start] = '\0';
+    sscanf(tmp, "%lu %2s", &interval, &time_unit[0]);
+    if (!strcmp(time_unit, "us")) {
+        multiplier = 1;
+    } else if (!strcmp(time_unit, "ms")) {
+        multiplier = 1000;
+    } else if (!strcmp(time_unit, "s")) {
+        multiplier = 1000000;
+    } else {
+        PAL_ERR(LOG_TAG, "unknown time_unit %s, assume default", time_unit);
+        interval = DEFAULT_SERVICE_INTERVAL_US;
+        multiplier = 1;
+    }
+    interval *= multiplier;
+    PAL_DBG(LOG_TAG, "set service_interval_us %lu", interval);
+    altset.service_interval_us = interval;
+    free(tmp);
+
+    return 0;
+}
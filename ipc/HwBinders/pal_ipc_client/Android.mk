@@ -18,7 +18,8 @@ LOCAL_SHARED_LIBRARIES := \
     libcutils \
     libhardware \
     libbase \
-    vendor.qti.hardware.pal@1.0
+    vendor.qti.hardware.pal@1.0 \
+    vendor.qti.hardware.pal@1.1
 
 include $(BUILD_SHARED_LIBRARY)
 
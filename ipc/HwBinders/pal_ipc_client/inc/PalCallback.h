@@ -30,6 +30,7 @@
 #pragma once
 
 #include <vendor/qti/hardware/pal/1.0/IPALCallback.h>
+#include <vendor/qti/hardware/pal/1.1/types.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include "PalApi.h"
@@ -46,6 +47,7 @@ using PalDeviceId = ::vendor::qti::hardware::pal::V1_0::PalDeviceId;
 using PalDrainType = ::vendor::qti::hardware::pal::V1_0::PalDrainType;
 using PalBuffer = ::vendor::qti::hardware::pal::V1_0::PalBuffer;
 using PalBufferConfig = ::vendor::qti::hardware::pal::V1_0::PalBufferConfig;
+using PalSharedBufferDesc = ::vendor::qti::hardware::pal::V1_1::PalSharedBufferDesc;
 using PalStreamHandle = ::vendor::qti::hardware::pal::V1_0::PalStreamHandle;
 using PalChannelVolKv = ::vendor::qti::hardware::pal::V1_0::PalChannelVolKv;
 using PalVolumeData = ::vendor::qti::hardware::pal::V1_0::PalVolumeData;
@@ -29,25 +29,148 @@
 
 #define LOG_TAG "pal_client_wrapper"
 #include <vendor/qti/hardware/pal/1.0/IPAL.h>
+#include <vendor/qti/hardware/pal/1.1/IPAL.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <log/log.h>
+#include <cutils/ashmem.h>
+#include <sys/mman.h>
+#include <map>
 #include "PalApi.h"
 #include "inc/PalCallback.h"
 
 using android::hardware::Return;
 using android::hardware::hidl_vec;
 using vendor::qti::hardware::pal::V1_0::IPAL;
+using IPAL_V1_1 = vendor::qti::hardware::pal::V1_1::IPAL;
 
 using vendor::qti::hardware::pal::V1_0::implementation::PalCallback;
 using android::sp;
 
 bool pal_server_died = false;
 android::sp<IPAL> pal_client = NULL;
+/* null when the server only implements @1.0, no shared buffer path then */
+android::sp<IPAL_V1_1> pal_client_v1_1 = NULL;
 sp<server_death_notifier> Server_death_notifier = NULL;
 
 std::mutex gLock;
 
+/*
+ * Per-stream shared memory negotiated with pal_stream_set_buffer_size.
+ * The region holds the playback (out) ring followed by the capture (in)
+ * ring, steady state reads and writes only exchange offsets and sizes.
+ */
+struct shared_buffer_info {
+    int fd;
+    uint8_t *base;
+    size_t size;
+    uint32_t out_buf_size;
+    uint32_t out_buf_count;
+    uint32_t out_index;
+    uint32_t in_buf_size;
+    uint32_t in_buf_count;
+    uint32_t in_index;
+    size_t in_ring_offset;
+    std::mutex lock;
+};
+
+std::map<pal_stream_handle_t *, std::shared_ptr<shared_buffer_info>> gSharedBuffers;
+std::mutex gSharedBuffersLock;
+
+static void release_shared_buffer(pal_stream_handle_t *stream_handle)
+{
+    std::shared_ptr<shared_buffer_info> shm;
+
+    {
+        std::lock_guard<std::mutex> guard(gSharedBuffersLock);
+        auto it = gSharedBuffers.find(stream_handle);
+        if (it == gSharedBuffers.end())
+            return;
+        shm = it->second;
+        gSharedBuffers.erase(it);
+    }
+    std::lock_guard<std::mutex> guard(shm->lock);
+    munmap(shm->base, shm->size);
+    close(shm->fd);
+}
+
+static std::shared_ptr<shared_buffer_info> get_shared_buffer(
+                                          pal_stream_handle_t *stream_handle)
+{
+    std::lock_guard<std::mutex> guard(gSharedBuffersLock);
+    auto it = gSharedBuffers.find(stream_handle);
+    return (it == gSharedBuffers.end()) ? nullptr : it->second;
+}
+
+static void setup_shared_buffer(android::sp<IPAL_V1_1> pal_client,
+                                pal_stream_handle_t *stream_handle,
+                                pal_buffer_config_t *in_buff_cfg,
+                                pal_buffer_config_t *out_buff_cfg)
+{
+    auto shm = std::make_shared<shared_buffer_info>();
+    PalBufferConfig in_buffer_cfg = {}, out_buffer_cfg = {};
+    native_handle_t *memHandle = nullptr;
+    int32_t ret = -EINVAL;
+
+    release_shared_buffer(stream_handle);
+    if (pal_client == nullptr)
+        return;
+
+    if (in_buff_cfg) {
+        shm->in_buf_size = in_buffer_cfg.buf_size = in_buff_cfg->buf_size;
+        shm->in_buf_count = in_buffer_cfg.buf_count = in_buff_cfg->buf_count;
+    }
+    if (out_buff_cfg) {
+        shm->out_buf_size = out_buffer_cfg.buf_size = out_buff_cfg->buf_size;
+        shm->out_buf_count = out_buffer_cfg.buf_count = out_buff_cfg->buf_count;
+    }
+    shm->in_ring_offset = (size_t)shm->out_buf_size * shm->out_buf_count;
+    shm->size = shm->in_ring_offset + (size_t)shm->in_buf_size * shm->in_buf_count;
+    if (!shm->size)
+        return;
+
+    shm->fd = ashmem_create_region("arpal_stream_shared_buffer", shm->size);
+    if (shm->fd < 0) {
+        ALOGE("%s: failed to create shared buffer of size %zu", __func__, shm->size);
+        return;
+    }
+    shm->base = (uint8_t *)mmap(nullptr, shm->size, PROT_READ | PROT_WRITE,
+                                MAP_SHARED, shm->fd, 0);
+    if (shm->base == MAP_FAILED) {
+        ALOGE("%s: failed to map shared buffer, errno %d", __func__, errno);
+        close(shm->fd);
+        return;
+    }
+
+    memHandle = native_handle_create(1, 0);
+    if (!memHandle) {
+        ALOGE("%s:%d Failed to create memHandle", __func__, __LINE__);
+        goto error;
+    }
+    memHandle->data[0] = shm->fd;
+    ret = pal_client->ipc_pal_stream_set_shared_buffer((PalStreamHandle)stream_handle,
+                          hidl_memory("arpal_stream_shared_buffer", hidl_handle(memHandle),
+                                      shm->size),
+                          in_buffer_cfg, out_buffer_cfg);
+    native_handle_delete(memHandle);
+    if (ret) {
+        /* server does not support shared buffers, stay on the hidl_vec path */
+        ALOGW("%s: shared buffer setup failed %d", __func__, ret);
+        goto error;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(gSharedBuffersLock);
+        gSharedBuffers[stream_handle] = shm;
+    }
+    ALOGD("%s: handle %pK shared buffer size %zu", __func__, stream_handle, shm->size);
+    return;
+
+error:
+    munmap(shm->base, shm->size);
+    close(shm->fd);
+}
+
 void server_death_notifier::serviceDied(uint64_t cookie,
                    const android::wp<::android::hidl::base::V1_0::IBase>& who)
 {
@@ -71,6 +194,9 @@ android::sp<IPAL> get_pal_server() {
             pal_client->linkToDeath(Server_death_notifier, 0);
             ALOGE("palclient linked to death server death \n", __func__);
         }
+        pal_client_v1_1 = IPAL_V1_1::castFrom(pal_client).withDefault(nullptr);
+        if (pal_client_v1_1 == nullptr)
+            ALOGI("PAL service does not implement @1.1, using hidl_vec buffers");
     }
 exit:
     return pal_client ;
@@ -299,6 +425,7 @@ int32_t pal_stream_close(pal_stream_handle_t *stream_handle)
         if (pal_client == nullptr)
             return -EINVAL;
 
+        release_shared_buffer(stream_handle);
         return pal_client->ipc_pal_stream_close((PalStreamHandle)stream_handle);
     }
     return -EINVAL;
@@ -442,6 +569,8 @@ int32_t pal_stream_set_buffer_size(pal_stream_handle_t *stream_handle,
                                 }
                                 ret = ret_;
                            });
+        if (!ret)
+            setup_shared_buffer(pal_client_v1_1, stream_handle, in_buff_cfg, out_buff_cfg);
     }
     return ret;
 }
@@ -459,6 +588,27 @@ ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *
         if (pal_client == nullptr)
             return ret;
 
+        std::shared_ptr<shared_buffer_info> shm = get_shared_buffer(stream_handle);
+        /* extern-mem buffers carry an fd and offset, keep them on hidl_vec */
+        if (shm && buf->buffer && buf->size <= shm->out_buf_size &&
+            shm->out_buf_count && !buf->metadata_size &&
+            buf->alloc_info.alloc_handle <= 0 && !buf->offset) {
+            PalSharedBufferDesc desc = {};
+            std::lock_guard<std::mutex> guard(shm->lock);
+
+            desc.offset = shm->out_index * shm->out_buf_size;
+            desc.size = buf->size;
+            desc.flags = buf->flags;
+            if (buf->ts) {
+                desc.timeStamp.tvSec = buf->ts->tv_sec;
+                desc.timeStamp.tvNSec = buf->ts->tv_nsec;
+            }
+            memcpy(shm->base + desc.offset, buf->buffer, buf->size);
+            shm->out_index = (shm->out_index + 1) % shm->out_buf_count;
+            return pal_client_v1_1->ipc_pal_stream_write_shared((PalStreamHandle)stream_handle,
+                                                                desc);
+        }
+
         hidl_vec<PalBuffer> buf_hidl;
         buf_hidl.resize(sizeof(struct pal_buffer));
         PalBuffer *palBuff = buf_hidl.data();
@@ -511,6 +661,39 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
         if (pal_client == nullptr)
             return ret;
 
+        std::shared_ptr<shared_buffer_info> shm = get_shared_buffer(stream_handle);
+        if (shm && buf->buffer && buf->size <= shm->in_buf_size &&
+            shm->in_buf_count && !buf->metadata_size &&
+            buf->alloc_info.alloc_handle <= 0 && !buf->offset) {
+            PalSharedBufferDesc desc = {};
+            std::lock_guard<std::mutex> guard(shm->lock);
+
+            desc.offset = shm->in_ring_offset + shm->in_index * shm->in_buf_size;
+            desc.size = buf->size;
+            shm->in_index = (shm->in_index + 1) % shm->in_buf_count;
+            pal_client_v1_1->ipc_pal_stream_read_shared((PalStreamHandle)stream_handle, desc,
+                   [&](int32_t ret_, const PalSharedBufferDesc& desc_ret)
+                      {
+                          if (ret_ > 0) {
+                              if (desc_ret.size > buf->size) {
+                                  ALOGE("ret buf sz %u bigger than request buf sz %zu",
+                                         desc_ret.size, buf->size);
+                                  ret_ = -ENOMEM;
+                              } else {
+                                  memcpy(buf->buffer, shm->base + desc.offset,
+                                         desc_ret.size);
+                                  if (buf->ts) {
+                                      buf->ts->tv_sec = desc_ret.timeStamp.tvSec;
+                                      buf->ts->tv_nsec = desc_ret.timeStamp.tvNSec;
+                                  }
+                                  buf->flags = desc_ret.flags;
+                              }
+                          }
+                          ret = ret_;
+                      });
+            return ret;
+        }
+
         hidl_vec<PalBuffer> buf_hidl;
         buf_hidl.resize(sizeof(struct pal_buffer));
         PalBuffer *palBuff = buf_hidl.data();
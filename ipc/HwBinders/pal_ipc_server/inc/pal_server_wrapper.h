@@ -33,10 +33,15 @@
 
 #include <vendor/qti/hardware/pal/1.0/IPALCallback.h>
 #include <vendor/qti/hardware/pal/1.0/IPAL.h>
+#include <vendor/qti/hardware/pal/1.1/IPAL.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <utils/RefBase.h>
 #include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "PalApi.h"
 #include<log/log.h>
 
@@ -56,11 +61,65 @@ using ::android::hardware::hidl_vec;
 using ::android::hardware::Return;
 using ::android::hardware::Void;
 using IPALCallback = ::vendor::qti::hardware::pal::V1_0::IPALCallback;
+using PalSharedBufferDesc = ::vendor::qti::hardware::pal::V1_1::PalSharedBufferDesc;
 using ::android::sp;
 
 class PalClientDeathRecipient;
 
 
+/*
+ * Scratch buffers reused across ipc_pal_stream_write/read calls of one
+ * stream. Storage only grows, so once sized from the negotiated buffer
+ * configuration the data copies perform no allocation, read replies are
+ * sent straight from here. What is left per call is the fd bookkeeping in
+ * SrvrClbk::sharedMemFdList, counted in fdListAllocations.
+ */
+struct ipc_buffer_arena {
+    std::mutex lock;
+    std::vector<uint8_t> buffer;
+    std::vector<uint8_t> metadata;
+    struct timespec ts;
+    uint64_t allocations;
+    uint64_t reuses;
+
+    ipc_buffer_arena() : ts{0, 0}, allocations(0), reuses(0) {}
+    void reserve(size_t bufSize, size_t metadataSize)
+    {
+        if (bufSize > buffer.size()) {
+            buffer.resize(bufSize);
+            allocations++;
+        }
+        if (metadataSize > metadata.size()) {
+            metadata.resize(metadataSize);
+            allocations++;
+        }
+    }
+    uint8_t *getBuffer(size_t size)
+    {
+        if (size > buffer.size()) {
+            buffer.resize(size);
+            allocations++;
+        } else {
+            reuses++;
+        }
+        return size ? buffer.data() : nullptr;
+    }
+    void release()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<uint8_t>().swap(buffer);
+        std::vector<uint8_t>().swap(metadata);
+    }
+    uint8_t *getMetadata(size_t size)
+    {
+        if (size > metadata.size()) {
+            metadata.resize(size);
+            allocations++;
+        }
+        return size ? metadata.data() : nullptr;
+    }
+};
+
 class SrvrClbk : public ::android::RefBase {
     public :
     sp<IPALCallback> clbk_binder;
@@ -69,12 +128,29 @@ class SrvrClbk : public ::android::RefBase {
     int pid_;
     bool client_died;
     std::vector<std::pair<int, int>> sharedMemFdList;
+    /* sharedMemFdList grows by one entry per write/read, count its reallocations */
+    uint64_t fdListAllocations;
+    /*
+     * shared memory set up with ipc_pal_stream_set_shared_buffer, readers
+     * of the mapping hold sharedBufLock shared across the PAL call so it
+     * cannot be unmapped underneath them.
+     */
+    std::shared_timed_mutex sharedBufLock;
+    int sharedBufFd;
+    uint8_t *sharedBufBase;
+    size_t sharedBufSize;
+    ipc_buffer_arena writeArena;
+    ipc_buffer_arena readArena;
 
     SrvrClbk()
     {
         clbk_binder = NULL;
         client_data_ = 0;
         pid_ = 0;
+        sharedBufFd = -1;
+        sharedBufBase = nullptr;
+        sharedBufSize = 0;
+        fdListAllocations = 0;
     }
     SrvrClbk(sp<IPALCallback> binder,
              uint64_t client_data, int pid)
@@ -83,14 +159,34 @@ class SrvrClbk : public ::android::RefBase {
         client_data_ = client_data;
         pid_ = pid;
         client_died = false;
+        sharedBufFd = -1;
+        sharedBufBase = nullptr;
+        sharedBufSize = 0;
+        fdListAllocations = 0;
     }
     void setSessionAttr(struct pal_stream_attributes *attr)
     {
         memcpy(&session_attr, attr, sizeof(session_attr));
     }
+    void releaseSharedBuffer()
+    {
+        std::lock_guard<std::shared_timed_mutex> guard(sharedBufLock);
+        releaseSharedBufferLocked();
+    }
+    void releaseSharedBufferLocked()
+    {
+        if (sharedBufBase)
+            munmap(sharedBufBase, sharedBufSize);
+        if (sharedBufFd >= 0)
+            close(sharedBufFd);
+        sharedBufFd = -1;
+        sharedBufBase = nullptr;
+        sharedBufSize = 0;
+    }
     ~SrvrClbk()
     {
       ALOGV("%s:%d",__func__,__LINE__);
+      releaseSharedBuffer();
     }
 };
 
@@ -105,7 +201,7 @@ struct client_info {
     std::mutex mActiveSessionsLock;
 };
 
-struct PAL : public IPAL /*, public android::hardware::hidl_death_recipient*/{
+struct PAL : public ::vendor::qti::hardware::pal::V1_1::IPAL /*, public android::hardware::hidl_death_recipient*/{
     public:
     PAL()
     {
@@ -192,12 +288,22 @@ struct PAL : public IPAL /*, public android::hardware::hidl_death_recipient*/{
     Return<void>ipc_pal_stream_get_tags_with_module_info(const uint64_t streamHandle,
                                      uint32_t size,
                                      ipc_pal_stream_get_tags_with_module_info_cb _hidl_cb) override;
+    Return<int32_t> ipc_pal_stream_set_shared_buffer(const uint64_t streamHandle,
+                                     const hidl_memory& sharedMem,
+                                     const PalBufferConfig& in_buff_cfg,
+                                     const PalBufferConfig& out_buff_cfg) override;
+    Return<int32_t> ipc_pal_stream_write_shared(const uint64_t streamHandle,
+                                     const PalSharedBufferDesc& desc) override;
+    Return<void> ipc_pal_stream_read_shared(const uint64_t streamHandle,
+                                     const PalSharedBufferDesc& desc,
+                                     ipc_pal_stream_read_shared_cb _hidl_cb) override;
     sp<PalClientDeathRecipient> mDeathRecipient;
     std::vector<std::shared_ptr<client_info>> mPalClients;
 private:
     static PAL* sInstance;
     int find_dup_fd_from_input_fd(const uint64_t streamHandle, int input_fd, int *dup_fd);
     void add_input_and_dup_fd(const uint64_t streamHandle, int input_fd, int dup_fd);
+    sp<SrvrClbk> get_session_clbk(const uint64_t streamHandle);
 };
 
 class PalClientDeathRecipient : public android::hardware::hidl_death_recipient
@@ -99,13 +99,27 @@ void PAL::add_input_and_dup_fd(const uint64_t streamHandle, int input_fd, int du
                     ALOGE("%s cache limit exceeded handle %p fd [input %d - dup %d]",
                             __func__ , streamHandle, input_fd, dup_fd );
                 }
-                session.callback_binder->sharedMemFdList.push_back(
-                                            std::make_pair(input_fd, dup_fd));
+                auto &fdList = session.callback_binder->sharedMemFdList;
+                if (fdList.size() == fdList.capacity())
+                    session.callback_binder->fdListAllocations++;
+                fdList.push_back(std::make_pair(input_fd, dup_fd));
             }
         }
     }
 }
 
+sp<SrvrClbk> PAL::get_session_clbk(const uint64_t streamHandle)
+{
+    for (auto& s: mPalClients) {
+        std::lock_guard<std::mutex> lock(s->mActiveSessionsLock);
+        for (int i = 0; i < s->mActiveSessions.size(); i++) {
+            if (s->mActiveSessions[i].session_handle == streamHandle)
+                return s->mActiveSessions[i].callback_binder;
+        }
+    }
+    return nullptr;
+}
+
 
 static void printFdList(const std::vector<std::pair<int, int>> &list, const char * caller) {
     if (list.size() > 0 ) {
@@ -485,6 +499,17 @@ Return<int32_t> PAL::ipc_pal_stream_close(const uint64_t streamHandle)
                         }
                         ALOGV("Closing the session %pK", streamHandle);
                         sItr->callback_binder->sharedMemFdList.clear();
+                        sItr->callback_binder->releaseSharedBuffer();
+                        ALOGI("%s: handle %pK write arena allocs %llu reuses %llu, "
+                              "read arena allocs %llu reuses %llu, fd list allocs %llu",
+                              __func__, streamHandle,
+                              (unsigned long long)sItr->callback_binder->writeArena.allocations,
+                              (unsigned long long)sItr->callback_binder->writeArena.reuses,
+                              (unsigned long long)sItr->callback_binder->readArena.allocations,
+                              (unsigned long long)sItr->callback_binder->readArena.reuses,
+                              (unsigned long long)sItr->callback_binder->fdListAllocations);
+                        sItr->callback_binder->writeArena.release();
+                        sItr->callback_binder->readArena.release();
                         sItr->callback_binder.clear();
                         break;
                     }
@@ -557,6 +582,19 @@ Return<void> PAL::ipc_pal_stream_set_buffer_size(const uint64_t streamHandle,
 
     ret = pal_stream_set_buffer_size((pal_stream_handle_t *)streamHandle,
                                     &in_buf_cfg, &out_buf_cfg);
+    if (!ret) {
+        sp<SrvrClbk> sr_clbk_dat = get_session_clbk(streamHandle);
+        if (sr_clbk_dat != nullptr) {
+            {
+                std::lock_guard<std::mutex> lock(sr_clbk_dat->writeArena.lock);
+                sr_clbk_dat->writeArena.reserve(out_buf_cfg.buf_size,
+                                                out_buf_cfg.max_metadata_size);
+            }
+            std::lock_guard<std::mutex> lock(sr_clbk_dat->readArena.lock);
+            sr_clbk_dat->readArena.reserve(in_buf_cfg.buf_size,
+                                           in_buf_cfg.max_metadata_size);
+        }
+    }
 
     in_buff_config_ret.buf_count = in_buf_cfg.buf_count;
     in_buff_config_ret.buf_size = in_buf_cfg.buf_size;
@@ -593,26 +631,27 @@ Return<int32_t> PAL::ipc_pal_stream_write(const uint64_t streamHandle,
     struct pal_buffer buf = {0};
     uint32_t bufSize;
     const native_handle *allochandle = nullptr;
+    sp<SrvrClbk> sr_clbk_dat = get_session_clbk(streamHandle);
+
+    if (sr_clbk_dat == nullptr) {
+        ALOGE("%s: invalid session %pK", __func__, streamHandle);
+        return -EINVAL;
+    }
+    ipc_buffer_arena &arena = sr_clbk_dat->writeArena;
+    std::lock_guard<std::mutex> lock(arena.lock);
+
     bufSize = buff_hidl.data()->size;
     if (buff_hidl.data()->buffer.size() == bufSize)
-        buf.buffer = (uint8_t *)calloc(1, bufSize);
+        buf.buffer = arena.getBuffer(bufSize);
     buf.size = (size_t)bufSize;
     buf.offset = (size_t)buff_hidl.data()->offset;
-    buf.ts = (struct timespec *) calloc(1, sizeof(struct timespec));
-    if (!buf.ts) {
-        ALOGE("Not enough memory for buf.ts ");
-        goto exit;
-    }
+    buf.ts = &arena.ts;
     buf.ts->tv_sec =  buff_hidl.data()->timeStamp.tvSec;
     buf.ts->tv_nsec = buff_hidl.data()->timeStamp.tvNSec;
     buf.flags = buff_hidl.data()->flags;
     if (buff_hidl.data()->metadataSz) {
         buf.metadata_size = buff_hidl.data()->metadataSz;
-        buf.metadata = (uint8_t *)calloc(1, buf.metadata_size);
-        if (!buf.metadata) {
-            ALOGE("Not enough memory for buf.metadata");
-            goto exit;
-        }
+        buf.metadata = arena.getMetadata(buf.metadata_size);
         memcpy(buf.metadata, buff_hidl.data()->metadata.data(),
                buf.metadata_size);
     }
@@ -630,35 +669,34 @@ Return<int32_t> PAL::ipc_pal_stream_write(const uint64_t streamHandle,
         memcpy(buf.buffer, buff_hidl.data()->buffer.data(), bufSize);
     ALOGV("%s:%d sz %d", __func__,__LINE__,bufSize);
     ret = pal_stream_write((pal_stream_handle_t *)streamHandle, &buf);
-exit:
-    if (buf.buffer)
-        free(buf.buffer);
-    if (buf.ts)
-        free(buf.ts);
-    if (buf.metadata)
-        free(buf.metadata);
     return ret;
 }
 
 Return<void> PAL::ipc_pal_stream_read(const uint64_t streamHandle,
                                       const hidl_vec<PalBuffer>& inBuff_hidl,
                                       ipc_pal_stream_read_cb _hidl_cb) {
-    struct pal_buffer buf;
+    struct pal_buffer buf = {0};
     int32_t ret = 0;
+    PalBuffer outBuf;
     hidl_vec<PalBuffer> outBuff_hidl;
     uint32_t bufSize;
     const native_handle *allochandle = nullptr;
+    sp<SrvrClbk> sr_clbk_dat = get_session_clbk(streamHandle);
+
+    if (sr_clbk_dat == nullptr) {
+        ALOGE("%s: invalid session %pK", __func__, streamHandle);
+        _hidl_cb(-EINVAL, outBuff_hidl);
+        return Void();
+    }
+    ipc_buffer_arena &arena = sr_clbk_dat->readArena;
+    std::lock_guard<std::mutex> lock(arena.lock);
 
     bufSize = inBuff_hidl.data()->size;
-    buf.buffer = (uint8_t *)calloc(1, bufSize);
+    buf.buffer = arena.getBuffer(bufSize);
     buf.size = (size_t)bufSize;
     buf.metadata_size = inBuff_hidl.data()->metadataSz;
-    buf.metadata = (uint8_t *)calloc(1, buf.metadata_size);
-    if (!buf.metadata) {
-        ALOGE("Not enough memory for buf.metadata");
-        goto exit;
-    }
-
+    buf.metadata = arena.getMetadata(buf.metadata_size);
+    buf.ts = &arena.ts;
 
     allochandle = inBuff_hidl.data()->alloc_info.alloc_handle.handle();
 
@@ -671,28 +709,135 @@ Return<void> PAL::ipc_pal_stream_read(const uint64_t streamHandle,
 
     ret = pal_stream_read((pal_stream_handle_t *)streamHandle, &buf);
     if (ret > 0) {
-        outBuff_hidl.resize(sizeof(struct pal_buffer));
-        outBuff_hidl.data()->size = (uint32_t)buf.size;
-        outBuff_hidl.data()->offset = (uint32_t)buf.offset;
-        outBuff_hidl.data()->buffer.resize(buf.size);
-        memcpy(outBuff_hidl.data()->buffer.data(), buf.buffer,
-               buf.size);
+        /*
+         * Point the reply at the arena instead of copying into freshly
+         * allocated vectors, it is serialized by _hidl_cb while the arena
+         * lock is still held. The client only reads the first PalBuffer.
+         */
+        outBuf.size = (uint32_t)buf.size;
+        outBuf.offset = (uint32_t)buf.offset;
+        outBuf.buffer.setToExternal((uint8_t *)buf.buffer, buf.size);
         if (buf.ts) {
-          outBuff_hidl.data()->timeStamp.tvSec = buf.ts->tv_sec;
-          outBuff_hidl.data()->timeStamp.tvNSec = buf.ts->tv_nsec;
-        }
-        if (buf.metadata_size) {
-           outBuff_hidl.data()->metadata.resize(buf.metadata_size);
-           memcpy(outBuff_hidl.data()->metadata.data(),
-                  buf.metadata, buf.metadata_size);
+          outBuf.timeStamp.tvSec = buf.ts->tv_sec;
+          outBuf.timeStamp.tvNSec = buf.ts->tv_nsec;
         }
+        if (buf.metadata_size)
+           outBuf.metadata.setToExternal(buf.metadata, buf.metadata_size);
+        outBuff_hidl.setToExternal(&outBuf, 1);
     }
     _hidl_cb(ret, outBuff_hidl);
-exit:
-    if (buf.buffer)
-        free(buf.buffer);
-    if (buf.metadata)
-        free(buf.metadata);
+    return Void();
+}
+
+Return<int32_t> PAL::ipc_pal_stream_set_shared_buffer(const uint64_t streamHandle,
+                                                      const hidl_memory& sharedMem,
+                                                      const PalBufferConfig& in_buff_cfg,
+                                                      const PalBufferConfig& out_buff_cfg)
+{
+    sp<SrvrClbk> sr_clbk_dat = get_session_clbk(streamHandle);
+    const native_handle *memhandle = sharedMem.handle();
+    uint64_t ringSize = 0;
+    void *base = nullptr;
+    int fd = -1;
+
+    if (sr_clbk_dat == nullptr || !memhandle || memhandle->numFds < 1) {
+        ALOGE("%s: invalid session %pK or shared memory handle", __func__, streamHandle);
+        return -EINVAL;
+    }
+
+    ringSize = (uint64_t)in_buff_cfg.buf_count * in_buff_cfg.buf_size +
+               (uint64_t)out_buff_cfg.buf_count * out_buff_cfg.buf_size;
+    if (!ringSize || ringSize > sharedMem.size()) {
+        ALOGE("%s: ring size %llu does not fit shared memory size %llu", __func__,
+              (unsigned long long)ringSize, (unsigned long long)sharedMem.size());
+        return -EINVAL;
+    }
+
+    fd = dup(memhandle->data[0]);
+    if (fd < 0) {
+        ALOGE("%s: failed to dup shared memory fd, errno %d", __func__, errno);
+        return -errno;
+    }
+    base = mmap(nullptr, sharedMem.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("%s: failed to map shared memory, errno %d", __func__, errno);
+        close(fd);
+        return -ENOMEM;
+    }
+
+    std::lock_guard<std::shared_timed_mutex> guard(sr_clbk_dat->sharedBufLock);
+    sr_clbk_dat->releaseSharedBufferLocked();
+    sr_clbk_dat->sharedBufFd = fd;
+    sr_clbk_dat->sharedBufBase = (uint8_t *)base;
+    sr_clbk_dat->sharedBufSize = sharedMem.size();
+    ALOGD("%s: handle %pK shared buffer size %zu", __func__, streamHandle,
+          sr_clbk_dat->sharedBufSize);
+    return 0;
+}
+
+Return<int32_t> PAL::ipc_pal_stream_write_shared(const uint64_t streamHandle,
+                                                 const PalSharedBufferDesc& desc)
+{
+    sp<SrvrClbk> sr_clbk_dat = get_session_clbk(streamHandle);
+    struct pal_buffer buf = {0};
+    struct timespec ts;
+
+    if (sr_clbk_dat == nullptr) {
+        ALOGE("%s: invalid session %pK", __func__, streamHandle);
+        return -EINVAL;
+    }
+    std::shared_lock<std::shared_timed_mutex> guard(sr_clbk_dat->sharedBufLock);
+    if (!sr_clbk_dat->sharedBufBase ||
+        (uint64_t)desc.offset + desc.size > sr_clbk_dat->sharedBufSize) {
+        ALOGE("%s: invalid shared buffer offset %u size %u", __func__,
+              desc.offset, desc.size);
+        return -EINVAL;
+    }
+
+    ts.tv_sec = desc.timeStamp.tvSec;
+    ts.tv_nsec = desc.timeStamp.tvNSec;
+    buf.buffer = sr_clbk_dat->sharedBufBase + desc.offset;
+    buf.size = (size_t)desc.size;
+    buf.ts = &ts;
+    buf.flags = desc.flags;
+    return pal_stream_write((pal_stream_handle_t *)streamHandle, &buf);
+}
+
+Return<void> PAL::ipc_pal_stream_read_shared(const uint64_t streamHandle,
+                                             const PalSharedBufferDesc& desc,
+                                             ipc_pal_stream_read_shared_cb _hidl_cb)
+{
+    sp<SrvrClbk> sr_clbk_dat = get_session_clbk(streamHandle);
+    PalSharedBufferDesc desc_ret = desc;
+    struct pal_buffer buf = {0};
+    struct timespec ts = {0, 0};
+    int32_t ret = -EINVAL;
+
+    if (sr_clbk_dat == nullptr) {
+        ALOGE("%s: invalid session %pK", __func__, streamHandle);
+        _hidl_cb(ret, desc_ret);
+        return Void();
+    }
+    std::shared_lock<std::shared_timed_mutex> guard(sr_clbk_dat->sharedBufLock);
+    if (!sr_clbk_dat->sharedBufBase ||
+        (uint64_t)desc.offset + desc.size > sr_clbk_dat->sharedBufSize) {
+        ALOGE("%s: invalid shared buffer offset %u size %u", __func__,
+              desc.offset, desc.size);
+        _hidl_cb(ret, desc_ret);
+        return Void();
+    }
+
+    buf.buffer = sr_clbk_dat->sharedBufBase + desc.offset;
+    buf.size = (size_t)desc.size;
+    buf.ts = &ts;
+    ret = pal_stream_read((pal_stream_handle_t *)streamHandle, &buf);
+    if (ret > 0) {
+        desc_ret.size = (uint32_t)buf.size;
+        desc_ret.timeStamp.tvSec = ts.tv_sec;
+        desc_ret.timeStamp.tvNSec = ts.tv_nsec;
+        desc_ret.flags = buf.flags;
+    }
+    _hidl_cb(ret, desc_ret);
     return Void();
 }
 
@@ -87,6 +87,9 @@
 #include "ACDPlatformInfo.h"
 #include "ContextManager.h"
 #include "SignalHandler.h"
+#include "StreamHandleTable.h"
+#include "PalSharedMutex.h"
+#include "XmlSnapshot.h"
 #include <fstream>
 
 typedef enum {
@@ -165,6 +168,9 @@ typedef enum {
     TAG_CONFIG_LPM,
     TAG_CONFIG_LPM_SUPPORTED_STREAM,
     TAG_CONFIG_LPM_SUPPORTED_STREAMS,
+    TAG_CONFIG_STREAM_POOL,
+    TAG_CONFIG_STREAM_POOL_SUPPORTED_STREAM,
+    TAG_CONFIG_STREAM_POOL_SUPPORTED_STREAMS,
 } resource_xml_tags_t;
 
 typedef enum {
@@ -215,6 +221,8 @@ struct xml_userdata {
     resource_xml_tags_t tag;
     bool inCustomConfig;
     XML_Parser parser;
+    int specified_attr_count;
+    XmlSnapshot *snapshot;
 };
 
 typedef enum {
@@ -312,6 +320,21 @@ struct disable_lpm_info {
     std::vector<uint32_t> streams_;
 };
 
+struct stream_pool_prewarm {
+    pal_device_id_t device;
+    pal_stream_type_t type;
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint32_t bitWidth;
+};
+
+struct stream_pool_info {
+    uint32_t maxStreams;
+    uint32_t idleTimeoutMs;
+    std::vector<uint32_t> streams_;
+    std::vector<struct stream_pool_prewarm> prewarm_;
+};
+
 struct tx_ecinfo {
     int tx_stream_type;
     std::vector<int> disabled_rx_streams;
@@ -481,7 +504,7 @@ protected:
     std::vector <std::pair<std::shared_ptr<Device>, Stream*>> active_devices;
     std::vector <std::shared_ptr<Device>> plugin_devices_;
     std::vector <pal_device_id_t> avail_devices_;
-    std::map<Stream*, std::pair<uint32_t, bool>> mActiveStreamUserCounter;
+    StreamHandleTable mStreamHandles;
     bool bOverwriteFlag;
     bool screen_state_ = true;
     bool charging_state_;
@@ -490,9 +513,9 @@ protected:
     bool use_lpi_;
     pal_speaker_rotation_type rotation_type_;
     bool isDeviceSwitch = false;
-    static std::mutex mResourceManagerMutex;
+    static PalSharedMutex mResourceManagerMutex;
     static std::mutex mGraphMutex;
-    static std::mutex mActiveStreamMutex;
+    static PalSharedMutex mActiveStreamMutex;
     static std::mutex mSleepMonitorMutex;
     static std::mutex mListFrontEndsMutex;
     static int snd_virt_card;
@@ -541,6 +564,7 @@ protected:
     static struct vsid_info vsidInfo;
     static struct volume_set_param_info volumeSetParamInfo_;
     static struct disable_lpm_info disableLpmInfo_;
+    static struct stream_pool_info streamPoolInfo_;
     static std::vector<struct pal_amp_db_and_gain_table> gainLvlMap;
     static SndCardMonitor *sndmon;
     static std::vector <uint32_t> lpi_vote_streams_;
@@ -651,16 +675,18 @@ public:
     int32_t getVsidInfo(struct vsid_info  *info);
     int32_t getVolumeSetParamInfo(struct volume_set_param_info *volinfo);
     int32_t getDisableLpmInfo(struct disable_lpm_info *lpminfo);
+    int32_t getStreamPoolInfo(struct stream_pool_info *poolinfo);
     int getMaxVoiceVol();
     void getChannelMap(uint8_t *channel_map, int channels);
     pal_audio_fmt_t getAudioFmt(uint32_t bitWidth);
     int registerStream(Stream *s);
     int deregisterStream(Stream *s);
     int isActiveStream(pal_stream_handle_t *handle);
+    Stream *getStream(pal_stream_handle_t *handle);
     int initStreamUserCounter(Stream *s);
     int deactivateStreamUserCounter(Stream *s);
-    int eraseStreamUserCounter(Stream *s);
     int increaseStreamUserCounter(Stream* s);
+    int increaseStreamUserCounter(pal_stream_handle_t *handle, Stream **s);
     int decreaseStreamUserCounter(Stream* s);
     int getStreamUserCounter(Stream *s);
     int printStreamUserCounter(Stream *s);
@@ -685,6 +711,8 @@ public:
     int checkAndGetDeviceConfig(struct pal_device *device ,bool* bIsUpdated);
     static void getFileNameExtn(const char* in_snd_card_name, char* file_name_extn);
     int init_audio();
+    int initPhases();
+    std::string initFailedPhase;
     void loadAdmLib();
     static int init();
     static void deinit();
@@ -825,6 +853,8 @@ public:
     static void process_config_voice(struct xml_userdata *data, const XML_Char *tag_name);
     static void process_config_volume(struct xml_userdata *data, const XML_Char *tag_name);
     static void process_config_lpm(struct xml_userdata *data, const XML_Char *tag_name);
+    static void process_config_stream_pool(struct xml_userdata *data, const XML_Char *tag_name);
+    static void process_stream_pool_prewarm(const XML_Char **attr, const int attr_count);
     static void process_lpi_vote_streams(struct xml_userdata *data, const XML_Char *tag_name);
     static void process_kvinfo(const XML_Char **attr, bool overwrite);
     static void process_voicemode_info(const XML_Char **attr);
@@ -878,10 +908,12 @@ public:
      */
     void lockGraph() { mGraphMutex.lock(); };
     void unlockGraph() { mGraphMutex.unlock(); };
-    void lockActiveStream() { mActiveStreamMutex.lock(); };
+    void lockActiveStream(pal_lock_site site) { mActiveStreamMutex.lock(site); };
     void unlockActiveStream() { mActiveStreamMutex.unlock(); };
-    void lockResourceManagerMutex() {mResourceManagerMutex.lock();};
+    void lockResourceManagerMutex(pal_lock_site site) {mResourceManagerMutex.lock(site);};
     void unlockResourceManagerMutex() {mResourceManagerMutex.unlock();};
+    void lockResourceManagerMutexShared(pal_lock_site site) {mResourceManagerMutex.lock_shared(site);};
+    void unlockResourceManagerMutexShared() {mResourceManagerMutex.unlock_shared();};
     void getSharedBEActiveStreamDevs(std::vector <std::tuple<Stream *, uint32_t>> &activeStreamDevs,
                                      int dev_id);
     int32_t streamDevSwitch(std::vector <std::tuple<Stream *, uint32_t>> streamDevDisconnectList,
@@ -920,6 +952,7 @@ public:
     static uint32_t palFormatToBitwidthLookup(const pal_audio_fmt_t format);
     void chargerListenerFeatureInit();
     static void chargerListenerInit(charger_status_change_fn_t);
+    static int chargerListenerLoad();
     static void chargerListenerDeinit();
     static void onChargerListenerStatusChanged(int event_type, int status,
                                                  bool concurrent_state);
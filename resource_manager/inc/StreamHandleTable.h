@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef STREAM_HANDLE_TABLE_H
+#define STREAM_HANDLE_TABLE_H
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+
+/*
+ * Must be a power of two and comfortably larger than the number of
+ * streams that can be open at once, so probe sequences stay short.
+ */
+#define STREAM_HANDLE_TABLE_SIZE 256
+
+/*
+ * Per slot state word:
+ *   bits  0..31 : number of in flight API calls on the stream
+ *   bit      32 : stream accepts new users
+ *   bits 33..63 : slot generation, bumped whenever the slot is (re)used
+ */
+#define STREAM_HANDLE_USERS_MASK  0xFFFFFFFFULL
+#define STREAM_HANDLE_ACTIVE      (1ULL << 32)
+#define STREAM_HANDLE_GEN_SHIFT   33
+
+/*
+ * Public handle returned by pal_stream_open:
+ *   bit      0 : always set, a handle is never NULL nor a Stream pointer
+ *   bits  1..8 : slot index
+ *   bits 9..   : low bits of the slot generation, 23 bits on 32 bit builds
+ */
+#define STREAM_HANDLE_TAG         ((uintptr_t)1)
+#define STREAM_HANDLE_SLOT_SHIFT  1
+#define STREAM_HANDLE_HGEN_SHIFT  9
+
+/*
+ * Lock free lookup table for stream handles handed out by pal_stream_open.
+ *
+ * Each stream is bound to a slot found by hashing its pointer. The slot
+ * state carries a generation that is bumped when the slot is taken or
+ * freed and whenever the stream is activated or deactivated, and clients
+ * only ever see slot index plus generation. A handle kept after close, or
+ * after its stream went back to StreamPool and was handed to another
+ * client, no longer matches and is rejected.
+ * insert/remove are serialized with a private mutex; everything else is
+ * wait free for readers. Calls taking a Stream pointer are for PAL
+ * internal use, calls taking a uintptr_t take a public handle.
+ */
+class StreamHandleTable
+{
+public:
+    StreamHandleTable();
+    int insert(const void *handle);
+    int remove(const void *handle);
+    int activate(const void *handle, uintptr_t *publicHandle);
+    int deactivate(const void *handle, uint32_t *users);
+    int acquire(const void *handle, uint32_t *users);
+    void *lookup(uintptr_t publicHandle);
+    void *acquire(uintptr_t publicHandle, uint32_t *users);
+    int release(const void *handle, uint32_t *users, bool *drained);
+    int getUsers(const void *handle);
+    void dump();
+    uint32_t size() { return count_.load(std::memory_order_relaxed); };
+
+private:
+    typedef struct {
+        std::atomic<uintptr_t> key;
+        std::atomic<uint64_t> state;
+    } stream_handle_slot;
+
+    int findSlot(uintptr_t key);
+    int decode(uintptr_t publicHandle, uint64_t *gen);
+    static uint32_t hash(uintptr_t key);
+
+    stream_handle_slot slots_[STREAM_HANDLE_TABLE_SIZE];
+    std::atomic<uint32_t> count_;
+    std::mutex mutex_;
+};
+
+#endif //STREAM_HANDLE_TABLE_H
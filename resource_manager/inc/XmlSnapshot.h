@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef XML_SNAPSHOT_H
+#define XML_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define XML_SNAPSHOT_MAGIC   0x584C4150 /* "PALX" */
+#define XML_SNAPSHOT_VERSION 1
+#define XML_SNAPSHOT_DIR     "/data/vendor/audio"
+
+/*
+ * Binary snapshot of the expat event stream produced by one XML file.
+ *
+ * Recording captures every start/end/character data callback exactly as
+ * expat delivered it. A later boot maps the snapshot read only and replays
+ * the events into the same handlers, so all tables and side effects of the
+ * XML parse are rebuilt without tokenizing the XML again. The snapshot
+ * carries the size and FNV-1a hash of the XML it was taken from and is
+ * rejected when either no longer matches.
+ *
+ * File layout (native endian, all records 4 byte aligned):
+ *   header
+ *   events: u32 type, then
+ *     START: u32 specified attr count, u32 attr count, name, attrs...
+ *     END:   name
+ *     DATA:  string
+ *   strings are u32 length followed by the bytes and a terminating NUL.
+ */
+class XmlSnapshot
+{
+public:
+    typedef void (*StartHandler)(void *userdata, const char *name,
+                                 const char **attr, int specifiedAttrCount);
+    typedef void (*EndHandler)(void *userdata, const char *name);
+    typedef void (*DataHandler)(void *userdata, const char *s, int len);
+
+    XmlSnapshot();
+    ~XmlSnapshot();
+
+    static uint64_t hash(const void *buf, size_t len);
+    static std::string pathFor(const std::string &xmlFile);
+
+    void recordStart(const char *name, const char **attr, int specifiedAttrCount);
+    void recordEnd(const char *name);
+    void recordData(const char *s, int len);
+    int save(const std::string &path, uint64_t srcHash, uint64_t srcSize);
+
+    int load(const std::string &path, uint64_t srcHash, uint64_t srcSize);
+    void replay(void *userdata, StartHandler start, EndHandler end, DataHandler data);
+
+private:
+    struct header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t src_size;
+        uint64_t src_hash;
+        uint32_t num_events;
+        uint32_t payload_size;
+    };
+
+    enum : uint32_t {
+        EVENT_START = 1,
+        EVENT_END,
+        EVENT_DATA,
+    };
+
+    void putWord(uint32_t v);
+    void putString(const char *s, size_t len);
+    bool validate();
+
+    std::vector<char> events_;
+    uint32_t numEvents_;
+    uint32_t maxAttrs_;
+    void *map_;
+    size_t mapSize_;
+};
+
+#endif //XML_SNAPSHOT_H
@@ -63,6 +63,7 @@
 #define LOG_TAG "PAL: ResourceManager"
 #include "ResourceManager.h"
 #include "Session.h"
+#include "SessionAlsaUtils.h"
 #include "Device.h"
 #include "Stream.h"
 #include "StreamPCM.h"
@@ -74,6 +75,7 @@
 #include "StreamContextProxy.h"
 #include "StreamUltraSound.h"
 #include "StreamSensorPCMData.h"
+#include "StreamPool.h"
 #include "gsl_intf.h"
 #include "Headphone.h"
 #include "PayloadBuilder.h"
@@ -87,12 +89,16 @@
 #include "DisplayPort.h"
 #include "Handset.h"
 #include "SndCardMonitor.h"
+#include "SoundTriggerUtils.h"
+#include "PalInitGraph.h"
+#include "PalTraceLog.h"
 #include "UltrasoundDevice.h"
 #include <agm/agm_api.h>
 #include <cutils/properties.h>
 #include <unistd.h>
 #include <dlfcn.h>
 #include <mutex>
+#include <chrono>
 #include <sys/ioctl.h>
 #ifdef EC_REF_CAPTURE_ENABLED
 #include "ECRefDevice.h"
@@ -409,9 +415,9 @@ std::vector <int> ResourceManager::streamPpTag = {0};
 std::vector <int> ResourceManager::mixerTag = {0};
 std::vector <int> ResourceManager::devicePpTag = {0};
 std::vector <int> ResourceManager::deviceTag = {0};
-std::mutex ResourceManager::mResourceManagerMutex;
+PalSharedMutex ResourceManager::mResourceManagerMutex("ResourceManager");
 std::mutex ResourceManager::mGraphMutex;
-std::mutex ResourceManager::mActiveStreamMutex;
+PalSharedMutex ResourceManager::mActiveStreamMutex("ActiveStream");
 std::mutex ResourceManager::mSleepMonitorMutex;
 std::mutex ResourceManager::mListFrontEndsMutex;
 std::vector <int> ResourceManager::listAllFrontEndIds = {0};
@@ -502,6 +508,7 @@ std::vector<tx_ecinfo> ResourceManager::txEcInfo;
 struct vsid_info ResourceManager::vsidInfo;
 struct volume_set_param_info ResourceManager::volumeSetParamInfo_;
 struct disable_lpm_info ResourceManager::disableLpmInfo_;
+struct stream_pool_info ResourceManager::streamPoolInfo_;
 std::vector<struct pal_amp_db_and_gain_table> ResourceManager::gainLvlMap;
 std::map<std::pair<uint32_t, std::string>, std::string> ResourceManager::btCodecMap;
 std::map<int, std::string> ResourceManager::spkrTempCtrlsMap;
@@ -677,6 +684,92 @@ void ResourceManager::sendCrashSignal(int signal, pid_t pid, uid_t uid)
     ALOGV("%s: signal %d, pid %u, uid %u", __func__, signal, pid, uid);
     struct agm_dump_info dump_info = {signal, (uint32_t)pid, (uint32_t)uid};
     agm_dump(&dump_info);
+    if (PalTraceLog::enabled())
+        PalTraceLog::dump();
+}
+
+/*
+ * Boot time work of the constructor as a dependency graph: the card and
+ * resource manager XML chain (card-defs -> mixers/audio route -> RM XML),
+ * the usecase KV XML and the library loads are independent of each other
+ * and run on a few threads. Per phase timing is logged by PalInitGraph.
+ */
+int ResourceManager::initPhases()
+{
+    uint32_t workers = PAL_INIT_DEFAULT_WORKERS;
+    int ret = 0;
+
+#ifndef FEATURE_IPQ_OPENWRT
+    char value[PROPERTY_VALUE_MAX] = {0};
+
+    if (property_get("vendor.audio.pal.init_workers", value, "") > 0)
+        workers = atoi(value);
+#endif
+
+    PalInitGraph graph("pal_init", workers);
+
+    graph.addPhase("card_defs_xml", [] {
+        int status = ResourceManager::XmlParser(SNDPARSER);
+        if (status)
+            PAL_ERR(LOG_TAG, "error in snd xml parsing ret %d", status);
+        return status;
+    });
+    graph.addPhase("audio_route", [this] {
+        int status = init_audio();
+        if (status)
+            PAL_ERR(LOG_TAG, "error in init audio route and audio mixer ret %d", status);
+        return status;
+    }, {"card_defs_xml"});
+    graph.addPhase("rm_xml", [] {
+        int status = ResourceManager::XmlParser(rmngr_xml_file);
+        if (status)
+            PAL_ERR(LOG_TAG, "error in resource xml parsing ret %d", status);
+        return status;
+    }, {"audio_route"});
+    graph.addPhase("usecase_kv_xml", [] {
+        int status = PayloadBuilder::init();
+        if (status)
+            PAL_ERR(LOG_TAG, "Failed to parse usecase manager xml ret %d", status);
+        else
+            PAL_INFO(LOG_TAG, "usecase manager xml parsing successful");
+        return status;
+    });
+    graph.addPhase("agm_crash_cb", [this] {
+        // Get AGM service handle
+        int status = agm_register_service_crash_callback(&agmServiceCrashHandler,
+                                                         (uint64_t)this);
+        if (status)
+            PAL_ERR(LOG_TAG, "AGM service not up%d", status);
+        return 0;
+    }, {"audio_route"});
+    graph.addPhase("adm_lib", [this] {
+        loadAdmLib();
+        return 0;
+    });
+    graph.addPhase("wake_locks", [] {
+        ResourceManager::initWakeLocks();
+        return 0;
+    });
+    graph.addPhase("sml_lib", [] {
+        std::shared_ptr<SoundTriggerPlatformInfo> st_info =
+            SoundTriggerPlatformInfo::GetInstance();
+
+        /* only warms up the loader, the library stays owned by SoundModelLib */
+        if (st_info && !st_info->GetSoundModelLib().empty())
+            SoundModelLib::GetInstance();
+        return 0;
+    }, {"rm_xml"});
+    graph.addPhase("charger_lib", [] {
+        if (isChargeConcurrencyEnabled)
+            ResourceManager::chargerListenerLoad();
+        return 0;
+    }, {"rm_xml"});
+
+    ret = graph.run();
+    if (ret)
+        initFailedPhase = graph.failedPhase();
+
+    return ret;
 }
 
 ResourceManager::ResourceManager()
@@ -698,22 +791,10 @@ ResourceManager::ResourceManager()
 
     vsidInfo.loopback_delay = 0;
 
-    ret = ResourceManager::XmlParser(SNDPARSER);
-    if (ret) {
-        PAL_ERR(LOG_TAG, "error in snd xml parsing ret %d", ret);
-        throw std::runtime_error("error in snd xml parsing");
-    }
-
-    ret = ResourceManager::init_audio();
-    if (ret) {
-        PAL_ERR(LOG_TAG, "error in init audio route and audio mixer ret %d", ret);
-        throw std::runtime_error("error in init audio route and audio mixer");
-    }
-
-    ret = ResourceManager::XmlParser(rmngr_xml_file);
+    ret = initPhases();
     if (ret) {
-        PAL_ERR(LOG_TAG, "error in resource xml parsing ret %d", ret);
-        throw std::runtime_error("error in resource xml parsing");
+        PAL_ERR(LOG_TAG, "init phase %s failed ret %d", initFailedPhase.c_str(), ret);
+        throw std::runtime_error("pal init phase " + initFailedPhase + " failed");
     }
 
     if (isHifiFilterEnabled)
@@ -812,27 +893,11 @@ ResourceManager::ResourceManager()
      for (int i = 0; i < max_nt_sessions; i++)
           listAllNonTunnelSessionIds.push_back(maxDeviceIdInUse + i);
 
-    // Get AGM service handle
-    ret = agm_register_service_crash_callback(&agmServiceCrashHandler,
-                                               (uint64_t)this);
-    if (ret) {
-        PAL_ERR(LOG_TAG, "AGM service not up%d", ret);
-    }
-
     auto encodeMap = std::make_shared<std::unordered_map<uint32_t, bool>>();
     auto decodeMap = std::make_shared<std::unordered_map<uint32_t, bool>>();
     mNTStreamInstancesList[NT_PATH_ENCODE] = encodeMap;
     mNTStreamInstancesList[NT_PATH_DECODE] = decodeMap;
 
-    ResourceManager::loadAdmLib();
-    ResourceManager::initWakeLocks();
-    ret = PayloadBuilder::init();
-    if (ret) {
-        throw std::runtime_error("Failed to parse usecase manager xml");
-    } else {
-        PAL_INFO(LOG_TAG, "usecase manager xml parsing successful");
-    }
-
     PAL_DBG(LOG_TAG, "Creating ContextManager");
     ctxMgr = new ContextManager();
     if (!ctxMgr) {
@@ -968,7 +1033,7 @@ void ResourceManager::deInitWakeLocks(void) {
 void ResourceManager::acquireWakeLock() {
     int ret = 0;
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
     if (wake_lock_fd < 0) {
         PAL_ERR(LOG_TAG, "Invalid fd %d", wake_lock_fd);
         goto exit;
@@ -990,7 +1055,7 @@ exit:
 void ResourceManager::releaseWakeLock() {
     int ret = 0;
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
     if (wake_unlock_fd < 0) {
         PAL_ERR(LOG_TAG, "Invalid fd %d", wake_unlock_fd);
         goto exit;
@@ -1033,9 +1098,16 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
             if (state == CARD_STATUS_NONE)
                 break;
 
-            mActiveStreamMutex.lock();
+            PAL_LOCK(mActiveStreamMutex);
             rm->cardState = state;
             if (state != prevState) {
+                /* control handles may not survive the DSP/card restart */
+                SessionAlsaUtils::invalidateMixerCtlCache();
+                /* parked streams are inactive and skipped below, drop them */
+                if (state == CARD_STATUS_OFFLINE)
+                    StreamPool::evictAll("card offline");
+                else if (state == CARD_STATUS_ONLINE)
+                    StreamPool::requestPrewarm();
                 if (rm->globalCb) {
                     PAL_DBG(LOG_TAG, "Notifying client about sound card state %d global cb %pK",
                                       rm->cardState, rm->globalCb);
@@ -1058,7 +1130,7 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
                         if (0 != ret) {
                             PAL_ERR(LOG_TAG, "Ssr up handling failed for ContextManager ret %d", ret);
                         }
-                        mActiveStreamMutex.lock();
+                        PAL_LOCK(mActiveStreamMutex);
                     }
                 }
 
@@ -1095,7 +1167,7 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
                     if (0 != ret) {
                         PAL_ERR(LOG_TAG, "Ssr down handling failed for ContextManager ret %d", ret);
                     }
-                    mActiveStreamMutex.lock();
+                    PAL_LOCK(mActiveStreamMutex);
                 }
                 prevState = state;
             } else if (state == CARD_STATUS_ONLINE) {
@@ -1105,7 +1177,7 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
                     if (0 != ret) {
                         PAL_ERR(LOG_TAG, "Ssr up handling failed for ContextManager ret %d", ret);
                     }
-                    mActiveStreamMutex.lock();
+                    PAL_LOCK(mActiveStreamMutex);
                 }
 
                 SoundTriggerCaptureProfile = GetCaptureProfileByPriority(nullptr);
@@ -1253,6 +1325,9 @@ int ResourceManager::init_audio()
         goto exit;
     }
 
+    /* freshly opened mixers may reuse addresses of previously closed ones */
+    SessionAlsaUtils::invalidateMixerCtlCache();
+
     audio_virt_mixer = mixer_open(snd_virt_card);
     if(!audio_virt_mixer) {
         PAL_ERR(LOG_TAG, "Error: %d virtual audio mixer open failure", -EIO);
@@ -1329,10 +1404,19 @@ void ResourceManager::deInitContextManager()
 int ResourceManager::init()
 {
     std::shared_ptr<Device> dev = nullptr;
+    char value[256] = {0};
 
     // Initialize Speaker Protection calibration mode
     struct pal_device dattr;
 
+#ifndef FEATURE_IPQ_OPENWRT
+    property_get("vendor.audio.pal.lock_stats", value, "");
+    if (!strncmp("true", value, sizeof("true"))) {
+        mActiveStreamMutex.enableStats(true);
+        mResourceManagerMutex.enableStats(true);
+    }
+#endif
+
     mixerEventTread = std::thread(mixerEventWaitThreadLoop, rm);
 
     //Initialize audio_charger_listener
@@ -1540,13 +1624,17 @@ void ResourceManager::onChargerListenerStatusChanged(int event_type, int status,
     }
 }
 
-void ResourceManager::chargerListenerInit(charger_status_change_fn_t fn)
+/* dlopen/dlsym half of chargerListenerInit, run early as an init phase */
+int ResourceManager::chargerListenerLoad()
 {
+    if (cl_lib_handle)
+        return 0;
+
     cl_lib_handle = dlopen(CL_LIBRARY_PATH, RTLD_NOW);
 
     if (!cl_lib_handle) {
         PAL_ERR(LOG_TAG, "dlopen for charger_listener failed %s", dlerror());
-        return;
+        return -EINVAL;
     }
 
     cl_init = (cl_init_t)dlsym(cl_lib_handle, "chargerPropertiesListenerInit");
@@ -1557,8 +1645,7 @@ void ResourceManager::chargerListenerInit(charger_status_change_fn_t fn)
         PAL_ERR(LOG_TAG, "dlsym for charger_listener failed");
         goto feature_disabled;
     }
-    cl_init(fn);
-    return;
+    return 0;
 
 feature_disabled:
     if (cl_lib_handle) {
@@ -1570,6 +1657,15 @@ feature_disabled:
     cl_deinit = NULL;
     cl_set_boost_state = NULL;
     PAL_INFO(LOG_TAG, "---- Feature charger_listener is disabled ----");
+    return -EINVAL;
+}
+
+void ResourceManager::chargerListenerInit(charger_status_change_fn_t fn)
+{
+    if (chargerListenerLoad())
+        return;
+
+    cl_init(fn);
 }
 
 void ResourceManager::chargerListenerDeinit()
@@ -1792,6 +1888,16 @@ int32_t ResourceManager::getDisableLpmInfo(struct disable_lpm_info *lpminfo)
     return 0;
 }
 
+int32_t ResourceManager::getStreamPoolInfo(struct stream_pool_info *poolinfo)
+{
+    if (!poolinfo)
+       return 0;
+
+    *poolinfo = streamPoolInfo_;
+
+    return 0;
+}
+
 int32_t ResourceManager::getVsidInfo(struct vsid_info  *info) {
     int status = 0;
     struct vsid_modepair modePair = {};
@@ -2497,7 +2603,7 @@ int ResourceManager::registerStream(Stream *s)
         return ret;
     }
     PAL_DBG(LOG_TAG, "stream type %d", type);
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     switch (type) {
         case PAL_STREAM_LOW_LATENCY:
         case PAL_STREAM_VOIP_RX:
@@ -2619,6 +2725,11 @@ int ResourceManager::registerStream(Stream *s)
             break;
     }
     mActiveStreams.push_back(s);
+    if (mStreamHandles.insert(s)) {
+        /* initStreamUserCounter fails next and the open is unwound */
+        PAL_ERR(LOG_TAG, "failed to add stream %pK to handle table", s);
+        ret = -ENOSPC;
+    }
 
 #if 0
     s->getStreamAttributes(&incomingStreamAttr);
@@ -2670,7 +2781,7 @@ int ResourceManager::deregisterStream(Stream *s)
     and store in mHighestPriorityActiveStream
 #endif
     PAL_INFO(LOG_TAG, "stream type %d", type);
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     switch (type) {
         case PAL_STREAM_LOW_LATENCY:
         case PAL_STREAM_VOIP_RX:
@@ -2795,6 +2906,7 @@ int ResourceManager::deregisterStream(Stream *s)
     }
 
     deregisterstream(s, mActiveStreams);
+    mStreamHandles.remove(s);
     mActiveStreamMutex.unlock();
 exit:
     PAL_DBG(LOG_TAG, "Exit. ret %d", ret);
@@ -2817,130 +2929,114 @@ bool isStreamActive(T s, std::list<T> &streams)
     return ret;
 }
 
+/*
+ * Stream handle validation and user counting go through mStreamHandles and
+ * do not need mActiveStreamMutex, so API calls on different streams do not
+ * serialize on it. Callers that already hold the lock may still use these.
+ * The handle slot lives from registerStream to deregisterStream, the public
+ * handle from initStreamUserCounter to deactivateStreamUserCounter.
+ */
 int ResourceManager::isActiveStream(pal_stream_handle_t *handle) {
-    for (auto &s : mActiveStreams) {
-        if (handle == reinterpret_cast<uint64_t *>(s)) {
-            return true;
-        }
-    }
-    return false;
+    return mStreamHandles.lookup((uintptr_t)handle) != NULL;
+}
+
+Stream *ResourceManager::getStream(pal_stream_handle_t *handle)
+{
+    Stream *s = static_cast<Stream *>(mStreamHandles.lookup((uintptr_t)handle));
+
+    if (!s)
+        PAL_ERR(LOG_TAG, "stream handle %p is stale or invalid", handle);
+    return s;
 }
 
 int ResourceManager::initStreamUserCounter(Stream *s)
 {
-    lockActiveStream();
-    mActiveStreamUserCounter.insert(std::make_pair(s, std::make_pair(0, true)));
+    uintptr_t handle = 0;
+
     s->initStreamSmph();
-    unlockActiveStream();
+    if (mStreamHandles.activate(s, &handle)) {
+        PAL_ERR(LOG_TAG, "stream %p is not registered", s);
+        s->deinitStreamSmph();
+        return -EINVAL;
+    }
+    s->setHandle(reinterpret_cast<pal_stream_handle_t *>(handle));
     return 0;
 }
 
 int ResourceManager::deactivateStreamUserCounter(Stream *s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    lockActiveStream();
+    uint32_t users = 0;
+
     printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end() && it->second.second == true) {
-        PAL_DBG(LOG_TAG, "stream %p is to be deactivated.", s);
-        it->second.second = false;
-        unlockActiveStream();
-        s->waitStreamSmph();
-        PAL_DBG(LOG_TAG, "stream %p is inactive.", s);
-        s->deinitStreamSmph();
-        return 0;
-    } else {
+    if (mStreamHandles.deactivate(s, &users)) {
         PAL_ERR(LOG_TAG, "stream %p is not found or inactive", s);
-        unlockActiveStream();
         return -EINVAL;
     }
+
+    PAL_DBG(LOG_TAG, "stream %p is to be deactivated, users %u", s, users);
+    /* the user dropping the count to zero posts the semaphore */
+    if (users > 0)
+        s->waitStreamSmph();
+    PAL_DBG(LOG_TAG, "stream %p is inactive.", s);
+    s->deinitStreamSmph();
+    return 0;
 }
 
-int ResourceManager::eraseStreamUserCounter(Stream *s)
+int ResourceManager::increaseStreamUserCounter(Stream* s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    lockActiveStream();
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        mActiveStreamUserCounter.erase(it);
-        PAL_DBG(LOG_TAG, "stream counter for %p is erased.", s);
-        unlockActiveStream();
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream counter for %p is not found.", s);
-        unlockActiveStream();
+    uint32_t users = 0;
+
+    if (mStreamHandles.acquire(s, &users)) {
+        PAL_ERR(LOG_TAG, "stream %p is not found or inactive.", s);
         return -EINVAL;
     }
+    PAL_DBG(LOG_TAG, "stream %p counter increased to %u", s, users);
+    return 0;
 }
 
-int ResourceManager::increaseStreamUserCounter(Stream* s)
+/* validates the public handle and takes a user count in one step */
+int ResourceManager::increaseStreamUserCounter(pal_stream_handle_t *handle, Stream **s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end() &&
-        it->second.second) {
-        if (0 == it->second.first) {
-            s->waitStreamSmph();
-            PAL_DBG(LOG_TAG, "stream %p in use", s);
-        }
-        PAL_DBG(LOG_TAG, "stream %p counter was %d", s, it->second.first);
-        it->second.first = it->second.first + 1;
-        PAL_DBG(LOG_TAG, "stream %p counter increased to %d", s, it->second.first);
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream %p is not found or inactive.", s);
+    uint32_t users = 0;
+
+    *s = static_cast<Stream *>(mStreamHandles.acquire((uintptr_t)handle, &users));
+    if (!*s) {
+        PAL_ERR(LOG_TAG, "stream handle %p is stale or inactive.", handle);
         return -EINVAL;
     }
+    PAL_DBG(LOG_TAG, "stream %p counter increased to %u", *s, users);
+    return 0;
 }
 
 int ResourceManager::decreaseStreamUserCounter(Stream* s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        PAL_DBG(LOG_TAG, "stream %p counter was %d", s, it->second.first);
-        if (0 == it->second.first) {
-            PAL_ERR(LOG_TAG, "counter of stream %p has already been 0.", s);
-            return -EINVAL;
-        }
+    uint32_t users = 0;
+    bool drained = false;
 
-        it->second.first = it->second.first - 1;
-        if (0 == it->second.first) {
-            PAL_DBG(LOG_TAG, "stream %p not in use", s);
-            s->postStreamSmph();
-        }
-        PAL_DBG(LOG_TAG, "stream %p counter decreased to %d", s, it->second.first);
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream %p is not found.", s);
+    if (mStreamHandles.release(s, &users, &drained)) {
+        PAL_ERR(LOG_TAG, "stream %p is not found or counter is already 0.", s);
         return -EINVAL;
     }
+    PAL_DBG(LOG_TAG, "stream %p counter decreased to %u", s, users);
+    if (drained) {
+        PAL_DBG(LOG_TAG, "stream %p not in use", s);
+        s->postStreamSmph();
+    }
+    return 0;
 }
 
 int ResourceManager::getStreamUserCounter(Stream *s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        return it->second.first;
-    } else {
+    int users = mStreamHandles.getUsers(s);
+
+    if (users < 0)
         PAL_ERR(LOG_TAG, "stream %p is not found.", s);
-        return -EINVAL;
-    }
+    return users;
 }
 
-int ResourceManager::printStreamUserCounter(Stream *s)
+int ResourceManager::printStreamUserCounter(Stream *s __unused)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    for (it = mActiveStreamUserCounter.begin();
-            it != mActiveStreamUserCounter.end(); it++) {
-        PAL_VERBOSE(LOG_TAG, "stream = %p count = %d active = %d",
-                    it->first, it->second.first, it->second.second);
-    }
-
+    mStreamHandles.dump();
     return 0;
 }
 
@@ -3115,7 +3211,7 @@ int ResourceManager::registerDevice(std::shared_ptr<Device> d, Stream *s)
         goto exit;
     }
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
     if (registerDevice_l(d, s)) {
         PAL_DBG(LOG_TAG, "device %d is already registered for stream %pK",
             d->getSndDeviceId(), s);
@@ -3153,7 +3249,7 @@ int ResourceManager::registerDevice(std::shared_ptr<Device> d, Stream *s)
             } else {
                 mResourceManagerMutex.unlock();
                 status = s->setECRef_l(dev, true);
-                mResourceManagerMutex.lock();
+                PAL_LOCK(mResourceManagerMutex);
                 if (status) {
                     if(status != -ENODEV) {
                         PAL_ERR(LOG_TAG, "Failed to enable EC Ref");
@@ -3196,7 +3292,7 @@ int ResourceManager::registerDevice(std::shared_ptr<Device> d, Stream *s)
                     status = str->setECRef_l(d, true);
                 else
                     status = str->setECRef(d, true);
-                mResourceManagerMutex.lock();
+                PAL_LOCK(mResourceManagerMutex);
                 if (status) {
                     if(status != -ENODEV) {
                         PAL_ERR(LOG_TAG, "Failed to enable EC Ref");
@@ -3258,7 +3354,7 @@ int ResourceManager::registerDevice(std::shared_ptr<Device> d, Stream *s)
                         status = str->setECRef_l(d, true);
                     else
                         status = str->setECRef(d, true);
-                    mResourceManagerMutex.lock();
+                    PAL_LOCK(mResourceManagerMutex);
                     if (status) {
                         if(status != -ENODEV) {
                             PAL_ERR(LOG_TAG, "Failed to enable EC Ref");
@@ -3317,7 +3413,7 @@ int ResourceManager::deregisterDevice(std::shared_ptr<Device> d, Stream *s)
         goto exit;
     }
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
     if (deregisterDevice_l(d, s)) {
         PAL_DBG(LOG_TAG, "Device %d not found for stream %pK, skip EC handling",
             d->getSndDeviceId(), s);
@@ -3327,7 +3423,7 @@ int ResourceManager::deregisterDevice(std::shared_ptr<Device> d, Stream *s)
         updateECDeviceMap(nullptr, d, s, 0, true);
         mResourceManagerMutex.unlock();
         status = s->setECRef_l(nullptr, false);
-        mResourceManagerMutex.lock();
+        PAL_LOCK(mResourceManagerMutex);
         if (status) {
             PAL_ERR(LOG_TAG, "Failed to disable EC Ref");
         }
@@ -3372,7 +3468,7 @@ int ResourceManager::deregisterDevice(std::shared_ptr<Device> d, Stream *s)
                         status = str->setECRef_l(d, false);
                     else
                         status = str->setECRef(d, false);
-                    mResourceManagerMutex.lock();
+                    PAL_LOCK(mResourceManagerMutex);
                     if (status) {
                         PAL_ERR(LOG_TAG, "Failed to disable EC Ref");
                     }
@@ -3404,7 +3500,7 @@ int ResourceManager::deregisterDevice(std::shared_ptr<Device> d, Stream *s)
                     status = str->setECRef_l(d, false);
                 else
                     status = str->setECRef(d, false);
-                mResourceManagerMutex.lock();
+                PAL_LOCK(mResourceManagerMutex);
                 if (status) {
                     PAL_ERR(LOG_TAG, "Failed to disable EC Ref");
                 }
@@ -3424,7 +3520,7 @@ bool ResourceManager::isDeviceActive(pal_device_id_t deviceId)
     int candidateDeviceId;
     PAL_DBG(LOG_TAG, "Enter.");
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK_SHARED(mResourceManagerMutex);
     for (int i = 0; i < active_devices.size(); i++) {
         candidateDeviceId = active_devices[i].first->getSndDeviceId();
         if (deviceId == candidateDeviceId) {
@@ -3434,7 +3530,7 @@ bool ResourceManager::isDeviceActive(pal_device_id_t deviceId)
         }
     }
 
-    mResourceManagerMutex.unlock();
+    mResourceManagerMutex.unlock_shared();
     PAL_DBG(LOG_TAG, "Exit.");
     return is_active;
 }
@@ -3444,9 +3540,9 @@ bool ResourceManager::isDeviceActive(std::shared_ptr<Device> d, Stream *s)
     bool is_active = false;
 
     PAL_DBG(LOG_TAG, "Enter.");
-    mResourceManagerMutex.lock();
+    PAL_LOCK_SHARED(mResourceManagerMutex);
     is_active = isDeviceActive_l(d, s);
-    mResourceManagerMutex.unlock();
+    mResourceManagerMutex.unlock_shared();
     PAL_DBG(LOG_TAG, "Exit.");
     return is_active;
 }
@@ -3510,10 +3606,10 @@ int ResourceManager::removePlugInDevice(pal_device_id_t device_id,
 int ResourceManager::getActiveDevices(std::vector<std::shared_ptr<Device>> &deviceList)
 {
     int ret = 0;
-    mResourceManagerMutex.lock();
+    PAL_LOCK_SHARED(mResourceManagerMutex);
     for (int i = 0; i < active_devices.size(); i++)
         deviceList.push_back(active_devices[i].first);
-    mResourceManagerMutex.unlock();
+    mResourceManagerMutex.unlock_shared();
     return ret;
 }
 
@@ -3629,9 +3725,9 @@ bool ResourceManager::IsDedicatedBEForUPDEnabled()
 void ResourceManager::GetSoundTriggerConcurrencyCount(
     pal_stream_type_t type,
     int32_t *enable_count, int32_t *disable_count) {
-    mActiveStreamMutex.lock();
+    PAL_LOCK_SHARED(mActiveStreamMutex);
     GetSoundTriggerConcurrencyCount_l(type, enable_count, disable_count);
-    mActiveStreamMutex.unlock();
+    mActiveStreamMutex.unlock_shared();
 }
 
 // this should only be called when LPI supported by platform
@@ -4037,7 +4133,7 @@ int ResourceManager::SwitchSoundTriggerDevices(bool connect_state,
     /* This is called from mResourceManagerMutex lock, unlock before calling
      * HandleDetectionStreamAction */
     mResourceManagerMutex.unlock();
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     if (is_sva_ds_supported)
         HandleDetectionStreamAction(PAL_STREAM_VOICE_UI, ST_HANDLE_DISCONNECT_DEVICE, (void *)&device_to_disconnect);
 
@@ -4056,7 +4152,7 @@ int ResourceManager::SwitchSoundTriggerDevices(bool connect_state,
                                     (void *)&device_to_connect);
     }
     mActiveStreamMutex.unlock();
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
 exit:
     PAL_DBG(LOG_TAG, "Exit, status %d", status);
     return status;
@@ -4082,7 +4178,7 @@ int ResourceManager::registerMixerEventCallback(const std::vector<int> &DevIds,
         return -EINVAL;
     }
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
     if (mixerEventRegisterCount == 0 && !is_register) {
         PAL_ERR(LOG_TAG, "Cannot deregister unregistered callback");
         mResourceManagerMutex.unlock();
@@ -4206,7 +4302,7 @@ int ResourceManager::handleMixerEvent(struct mixer *mixer, char *mixer_str) {
         goto exit;
     }
 
-    status = mixer_ctl_get_array(ctl, buf, num_values);
+    status = SessionAlsaUtils::mixerCtlGetArray(ctl, buf, num_values);
     if (status < 0) {
         PAL_ERR(LOG_TAG, "Failed to mixer_ctl_get_array");
         goto exit;
@@ -4514,7 +4610,7 @@ void ResourceManager::handleDeferredSwitch()
 {
     bool active = false;
     std::vector<pal_stream_type_t> st_streams;
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
 
     PAL_DBG(LOG_TAG, "enter, isAnyVUIStreambuffering:%d deferred state:%d",
         isAnyVUIStreamBuffering(), deferredSwitchState);
@@ -4566,7 +4662,7 @@ void ResourceManager::HandleConcurrencyForSoundTriggerStreams(pal_stream_type_t
     bool do_st_stream_switch = false;
     bool use_lpi_temp = use_lpi_;
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     PAL_DBG(LOG_TAG, "Enter, stream type %d, direction %d, active %d", type, dir, active);
 
     st_streams.push_back(PAL_STREAM_VOICE_UI);
@@ -4709,9 +4805,9 @@ std::shared_ptr<Device> ResourceManager::getActiveEchoReferenceRxDevices(
 {
     std::shared_ptr<Device> rx_device = nullptr;
     PAL_DBG(LOG_TAG, "Enter.");
-    mResourceManagerMutex.lock();
+    PAL_LOCK_SHARED(mResourceManagerMutex);
     rx_device = getActiveEchoReferenceRxDevices_l(tx_str);
-    mResourceManagerMutex.unlock();
+    mResourceManagerMutex.unlock_shared();
     PAL_DBG(LOG_TAG, "Exit.");
     return rx_device;
 }
@@ -4782,9 +4878,9 @@ std::vector<Stream*> ResourceManager::getConcurrentTxStream(
 {
     std::vector<Stream*> tx_stream_list;
     PAL_DBG(LOG_TAG, "Enter.");
-    mResourceManagerMutex.lock();
+    PAL_LOCK_SHARED(mResourceManagerMutex);
     tx_stream_list = getConcurrentTxStream_l(rx_str, rx_device);
-    mResourceManagerMutex.unlock();
+    mResourceManagerMutex.unlock_shared();
     PAL_DBG(LOG_TAG, "Exit.");
     return tx_stream_list;
 }
@@ -4825,7 +4921,7 @@ int ResourceManager::updateECDeviceMap_l(std::shared_ptr<Device> rx_dev,
     std::shared_ptr<Device> tx_dev, Stream *tx_str, int count, bool is_txstop)
 {
     int status = 0;
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
     status = updateECDeviceMap(rx_dev, tx_dev, tx_str, count, is_txstop);
     mResourceManagerMutex.unlock();
 
@@ -4998,9 +5094,9 @@ void ResourceManager::getHigherPriorityActiveStreams(const int inComingStreamPri
 
 template <class T>
 void getActiveStreams(std::shared_ptr<Device> d, std::vector<Stream*> &activestreams,
-                      std::list<T> sourcestreams)
+                      const std::list<T> &sourcestreams)
 {
-    for (typename std::list<T>::iterator iter = sourcestreams.begin();
+    for (typename std::list<T>::const_iterator iter = sourcestreams.begin();
                  iter != sourcestreams.end(); iter++) {
         std::vector <std::shared_ptr<Device>> devices;
         (*iter)->getAssociatedDevices(devices);
@@ -5059,9 +5155,9 @@ int ResourceManager::getActiveStream(std::vector<Stream*> &activestreams,
 {
     int ret = 0;
     PAL_DBG(LOG_TAG, "Enter.");
-    mResourceManagerMutex.lock();
+    PAL_LOCK_SHARED(mResourceManagerMutex);
     ret = getActiveStream_l(activestreams, d);
-    mResourceManagerMutex.unlock();
+    mResourceManagerMutex.unlock_shared();
     PAL_DBG(LOG_TAG, "Exit. ret %d", ret);
     return ret;
 }
@@ -5069,9 +5165,9 @@ int ResourceManager::getActiveStream(std::vector<Stream*> &activestreams,
 template <class T>
 void getOrphanStreams(std::vector<Stream*> &orphanstreams,
                       std::vector<Stream*> &retrystreams,
-                      std::list<T> sourcestreams)
+                      const std::list<T> &sourcestreams)
 {
-    for (typename std::list<T>::iterator iter = sourcestreams.begin();
+    for (typename std::list<T>::const_iterator iter = sourcestreams.begin();
                  iter != sourcestreams.end(); iter++) {
         std::vector <std::shared_ptr<Device>> devices;
         (*iter)->getAssociatedDevices(devices);
@@ -5119,9 +5215,9 @@ int ResourceManager::getOrphanStream(std::vector<Stream*> &orphanstreams,
 {
     int ret = 0;
     PAL_DBG(LOG_TAG, "Enter.");
-    mResourceManagerMutex.lock();
+    PAL_LOCK_SHARED(mResourceManagerMutex);
     ret = getOrphanStream_l(orphanstreams, retrystreams);
-    mResourceManagerMutex.unlock();
+    mResourceManagerMutex.unlock_shared();
     PAL_DBG(LOG_TAG, "Exit. ret %d", ret);
     return ret;
 }
@@ -5630,7 +5726,7 @@ int ResourceManager::checkAndUpdateGroupDevConfig(struct pal_device *deviceattr,
 std::shared_ptr<ResourceManager> ResourceManager::getInstance()
 {
     if(!rm) {
-        std::lock_guard<std::mutex> lock(ResourceManager::mResourceManagerMutex);
+        PalLockGuard lock(ResourceManager::mResourceManagerMutex, PAL_LOCK_SITE);
         if (!rm) {
             std::shared_ptr<ResourceManager> sp(new ResourceManager());
             rm = sp;
@@ -5693,6 +5789,8 @@ void ResourceManager::deinit()
     card_status_t state = CARD_STATUS_NONE;
 
     mixerClosed = true;
+    SessionAlsaUtils::dumpMixerCtlCacheStats();
+    SessionAlsaUtils::invalidateMixerCtlCache();
     mixer_close(audio_virt_mixer);
     mixer_close(audio_hw_mixer);
     if (audio_route) {
@@ -5717,6 +5815,8 @@ void ResourceManager::deinit()
     while (!msgQ.empty())
         msgQ.pop();
 
+    mActiveStreamMutex.dumpStats();
+    mResourceManagerMutex.dumpStats();
     rm = nullptr;
 }
 
@@ -6617,7 +6717,7 @@ int32_t ResourceManager::streamDevSwitch(std::vector <std::tuple<Stream *, uint3
         status = -EINVAL;
         goto exit_no_unlock;
     }
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
 
     SortAndUnique(streamDevDisconnectList);
     SortAndUnique(streamDevConnectList);
@@ -6746,7 +6846,7 @@ bool ResourceManager::updateDeviceConfig(std::shared_ptr<Device> *inDev,
     rm->getDeviceInfo(inDevAttr->id, inStrAttr->type,
                       inDevAttr->custom_config.custom_key, &inDeviceInfo);
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     if(!is_multiple_sample_rate_combo_supported) {
     /* handle headphone and speaker concurrency */
        checkSpeakerConcurrency(inDevAttr, inStrAttr, streamsToSwitch, &streamDevAttr);
@@ -6906,7 +7006,7 @@ int32_t ResourceManager::forceDeviceSwitch(std::shared_ptr<Device> inDev,
     }
 
     // get active streams on the device
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     getActiveStream_l(activeStreams, inDev);
     if (activeStreams.size() == 0) {
         PAL_ERR(LOG_TAG, "no other active streams found");
@@ -6922,7 +7022,7 @@ int32_t ResourceManager::forceDeviceSwitch(std::shared_ptr<Device> inDev,
     mActiveStreamMutex.unlock();
     status = streamDevSwitch(streamDevDisconnect, streamDevConnect);
     if (!status) {
-        mActiveStreamMutex.lock();
+        PAL_LOCK(mActiveStreamMutex);
         for (sIter = activeStreams.begin(); sIter != activeStreams.end(); sIter++) {
             if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
                 (*sIter)->lockStreamMutex();
@@ -6955,7 +7055,7 @@ int32_t ResourceManager::forceDeviceSwitch(std::shared_ptr<Device> inDev,
     }
 
     // create dev switch vectors
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     for (sIter = prevActiveStreams.begin(); sIter != prevActiveStreams.end(); sIter++) {
         if (((*sIter) != NULL) && isStreamActive((*sIter), mActiveStreams)) {
             streamDevDisconnect.push_back({(*sIter), inDev->getSndDeviceId()});
@@ -6965,7 +7065,7 @@ int32_t ResourceManager::forceDeviceSwitch(std::shared_ptr<Device> inDev,
     mActiveStreamMutex.unlock();
     status = streamDevSwitch(streamDevDisconnect, streamDevConnect);
     if (!status) {
-        mActiveStreamMutex.lock();
+        PAL_LOCK(mActiveStreamMutex);
         for (sIter = prevActiveStreams.begin(); sIter != prevActiveStreams.end(); sIter++) {
             if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
                 (*sIter)->lockStreamMutex();
@@ -7493,7 +7593,7 @@ int32_t ResourceManager::a2dpSuspend()
         goto exit;
     }
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     getActiveStream_l(activeA2dpStreams, a2dpDev);
     if (activeA2dpStreams.size() == 0) {
         PAL_DBG(LOG_TAG, "no active streams found");
@@ -7614,7 +7714,7 @@ int32_t ResourceManager::a2dpSuspend()
 
     forceDeviceSwitch(a2dpDev, &switchDevDattr, activeA2dpStreams);
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
         if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
             (*sIter)->lockStreamMutex();
@@ -7676,7 +7776,7 @@ int32_t ResourceManager::a2dpResume()
         goto exit;
     }
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     getActiveStream_l(activeStreams, activeDev);
     /* No-Streams active on Speaker - possibly streams are
      * associated handset device (due to voip/voice sco ended) and
@@ -7758,7 +7858,7 @@ int32_t ResourceManager::a2dpResume()
         goto exit;
     }
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     for (sIter = restoredStreams.begin(); sIter != restoredStreams.end(); sIter++) {
         if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
             (*sIter)->lockStreamMutex();
@@ -7818,7 +7918,7 @@ int32_t ResourceManager::a2dpCaptureSuspend()
     a2dpDattr.id = PAL_DEVICE_IN_BLUETOOTH_A2DP;
     a2dpDev = Device::getInstance(&a2dpDattr, rm);
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     getActiveStream_l(activeA2dpStreams, a2dpDev);
     if (activeA2dpStreams.size() == 0) {
         PAL_DBG(LOG_TAG, "no active streams found");
@@ -7862,7 +7962,7 @@ int32_t ResourceManager::a2dpCaptureSuspend()
     PAL_DBG(LOG_TAG, "selecting handset_mic and muting stream");
     forceDeviceSwitch(a2dpDev, &handsetmicDattr, activeA2dpStreams);
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
         if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
             (*sIter)->suspendedDevIds.clear();
@@ -7898,7 +7998,7 @@ int32_t ResourceManager::a2dpCaptureResume()
     a2dpDattr.id = PAL_DEVICE_IN_BLUETOOTH_A2DP;
     getDeviceConfig(&a2dpDattr, NULL);
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     getActiveStream_l(activeStreams, handsetmicDev);
     getOrphanStream_l(orphanStreams, retryStreams);
     if (activeStreams.empty() && orphanStreams.empty()) {
@@ -7941,7 +8041,7 @@ int32_t ResourceManager::a2dpCaptureResume()
         goto exit;
     }
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     for (sIter = restoredStreams.begin(); sIter != restoredStreams.end(); sIter++) {
         if ((*sIter) && isStreamActive(*sIter, mActiveStreams)) {
             (*sIter)->suspendedDevIds.clear();
@@ -7962,7 +8062,7 @@ int ResourceManager::getParameter(uint32_t param_id, void **param_payload,
     int status = 0;
 
     PAL_DBG(LOG_TAG, "param_id=%d", param_id);
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
     switch (param_id) {
         case PAL_PARAM_ID_BT_A2DP_RECONFIG_SUPPORTED:
         case PAL_PARAM_ID_BT_A2DP_SUSPENDED:
@@ -8108,7 +8208,7 @@ int ResourceManager::getParameter(uint32_t param_id, void *param_payload,
         {
             bool match = false;
             std::list<Stream*>::iterator sIter;
-            lockActiveStream();
+            lockActiveStream(PAL_LOCK_SITE);
             for(sIter = mActiveStreams.begin(); sIter != mActiveStreams.end(); sIter++) {
                 match = (*sIter)->checkStreamMatch(pal_device_id, pal_stream_type);
                 if (match) {
@@ -8116,7 +8216,7 @@ int ResourceManager::getParameter(uint32_t param_id, void *param_payload,
                         continue;
                     unlockActiveStream();
                     status = (*sIter)->getEffectParameters(param_payload);
-                    lockActiveStream();
+                    lockActiveStream(PAL_LOCK_SITE);
                     decreaseStreamUserCounter(*sIter);
                     break;
                 }
@@ -8140,7 +8240,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
 
     PAL_DBG(LOG_TAG, "Enter param id: %d", param_id);
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
     switch (param_id) {
         case PAL_PARAM_ID_UHQA_FLAG:
         {
@@ -8178,10 +8278,10 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
             PAL_INFO(LOG_TAG, "Device Rotation :%d", param_device_rot->rotation_type);
             if (payload_size == sizeof(pal_param_device_rotation_t)) {
                 mResourceManagerMutex.unlock();
-                mActiveStreamMutex.lock();
+                PAL_LOCK(mActiveStreamMutex);
                 status = handleDeviceRotationChange(*param_device_rot);
                 mActiveStreamMutex.unlock();
-                mResourceManagerMutex.lock();
+                PAL_LOCK(mResourceManagerMutex);
             } else {
                 PAL_ERR(LOG_TAG,"Incorrect size : expected (%zu), received(%zu)",
                         sizeof(pal_param_device_rotation_t), payload_size);
@@ -8280,7 +8380,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                                mResourceManagerMutex.unlock();
                                status = dev->setDeviceParameter(PAL_PARAM_ID_BT_A2DP_SUSPENDED,
                                                                 &param_bt_a2dp);
-                               mResourceManagerMutex.lock();
+                               PAL_LOCK(mResourceManagerMutex);
                            } else {
                                a2dp_suspended = false;
                            }
@@ -8317,10 +8417,10 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                     }
                     charging_state_ = battery_charging_state->charging_state;
                     mResourceManagerMutex.unlock();
-                    mActiveStreamMutex.lock();
+                    PAL_LOCK(mActiveStreamMutex);
                     onChargingStateChange();
                     mActiveStreamMutex.unlock();
-                    mResourceManagerMutex.lock();
+                    PAL_LOCK(mResourceManagerMutex);
                 } else {
                     PAL_ERR(LOG_TAG,
                             "Incorrect size : expected (%zu), received(%zu)",
@@ -8421,7 +8521,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
              */
             if (param_bt_sco->bt_sco_on == true) {
                 mResourceManagerMutex.unlock();
-                mActiveStreamMutex.lock();
+                PAL_LOCK(mActiveStreamMutex);
                 for (auto& str : mActiveStreams) {
                     str->getStreamAttributes(&sAttr);
                     associatedDevices.clear();
@@ -8491,7 +8591,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                 for (auto& device : txDevices) {
                     rm->forceDeviceSwitch(device, &sco_tx_dattr);
                 }
-                mResourceManagerMutex.lock();
+                PAL_LOCK(mResourceManagerMutex);
             }
         }
         break;
@@ -8583,7 +8683,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                         usleep(retryPeriodMs * 1000);
                         retrycnt--;
                     }
-                    mResourceManagerMutex.lock();
+                    PAL_LOCK(mResourceManagerMutex);
 
                     param_bt_a2dp.reconfig = false;
                     dev->setDeviceParameter(param_id, &param_bt_a2dp);
@@ -8638,7 +8738,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                 Stream *stream = NULL;
                 pal_stream_type_t streamType;
 
-                mActiveStreamMutex.lock();
+                PAL_LOCK(mActiveStreamMutex);
                 /* Handle bt sco mic running usecase */
                 sco_tx_dattr.id = PAL_DEVICE_IN_BLUETOOTH_SCO_HEADSET;
                 if (isDeviceAvailable(sco_tx_dattr.id)) {
@@ -8655,7 +8755,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                         updateSndName(handset_tx_dattr.id, devInfo.sndDevName);
                         mActiveStreamMutex.unlock();
                         rm->forceDeviceSwitch(sco_tx_dev, &handset_tx_dattr);
-                        mActiveStreamMutex.lock();
+                        PAL_LOCK(mActiveStreamMutex);
                     }
                 }
 
@@ -8686,7 +8786,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
             }
 
             status = a2dp_dev->setDeviceParameter(param_id, param_payload);
-            mResourceManagerMutex.lock();
+            PAL_LOCK(mResourceManagerMutex);
             if (status) {
                 PAL_ERR(LOG_TAG, "set Parameter %d failed\n", param_id);
                 goto exit;
@@ -8783,7 +8883,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                 status = -EINVAL;
                 goto exit;
             }
-            mixer_ctl_set_value(ctl, 0, hInt->intensity);
+            SessionAlsaUtils::mixerCtlSetValue(ctl, 0, hInt->intensity);
         }
         break;
         case PAL_PARAM_ID_HAPTICS_VOLUME:
@@ -8853,14 +8953,14 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                         getDeviceConfig(&speaker_dattr, &sAttr);
                         mResourceManagerMutex.unlock();
                         rm->forceDeviceSwitch(sco_rx_dev, &speaker_dattr);
-                        mResourceManagerMutex.lock();
+                        PAL_LOCK(mResourceManagerMutex);
                     }
                 }
             }
 
             mResourceManagerMutex.unlock();
             status = a2dp_dev->setDeviceParameter(param_id, param_payload);
-            mResourceManagerMutex.lock();
+            PAL_LOCK(mResourceManagerMutex);
             if (status) {
                 PAL_ERR(LOG_TAG, "set Parameter %d failed\n", param_id);
                 goto exit;
@@ -8893,7 +8993,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
         case PAL_PARAM_ID_UIEFFECT:
         {
             bool match = false;
-            lockActiveStream();
+            lockActiveStream(PAL_LOCK_SITE);
             std::list<Stream*>::iterator sIter;
             for(sIter = mActiveStreams.begin(); sIter != mActiveStreams.end();
                     sIter++) {
@@ -8905,7 +9005,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                             continue;
                         unlockActiveStream();
                         status = (*sIter)->setParameters(param_id, param_payload);
-                        lockActiveStream();
+                        lockActiveStream(PAL_LOCK_SITE);
                         decreaseStreamUserCounter(*sIter);
                         if (status) {
                             PAL_ERR(LOG_TAG, "failed to set param for pal_device_id=%x stream_type=%x",
@@ -9015,6 +9115,11 @@ int ResourceManager::handleScreenStatusChange(pal_param_screen_state_t screen_st
             PAL_VERBOSE(LOG_TAG, "Screen State printout");
         }
         screen_state_ = screen_state.screen_state;
+        /* no ui sounds are expected with the screen off, do not hold idle graphs */
+        if (screen_state_)
+            StreamPool::requestPrewarm();
+        else
+            StreamPool::evictAll("screen off");
         /* update
          * for (typename std::vector<StreamSoundTrigger*>::iterator iter = active_streams_st.begin();
          *    iter != active_streams_st.end(); iter++) {
@@ -9215,6 +9320,8 @@ int ResourceManager::handleDeviceConnectionChange(pal_param_device_connection_t
     }
 
     PAL_DBG(LOG_TAG, "Enter");
+    /* parked streams were configured for the previous device state */
+    StreamPool::evictDevice(device_id);
     memset(&conn_device, 0, sizeof(struct pal_device));
     if (is_connected && !device_available) {
         if (isPluginDevice(device_id) || isDpDevice(device_id)) {
@@ -9343,7 +9450,7 @@ int ResourceManager::resetStreamInstanceID(Stream *str, uint32_t sInstanceID) {
         return status;
     }
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
 
     switch (StrAttr.type) {
         case PAL_STREAM_VOICE_UI: {
@@ -9411,7 +9518,7 @@ int ResourceManager::getStreamInstanceID(Stream *str) {
         return status;
     }
 
-    mResourceManagerMutex.lock();
+    PAL_LOCK(mResourceManagerMutex);
 
     switch (StrAttr.type) {
         case PAL_STREAM_VOICE_UI: {
@@ -10050,6 +10157,82 @@ void ResourceManager::process_config_lpm(struct xml_userdata *data, const XML_Ch
     }
 }
 
+void ResourceManager::process_config_stream_pool(struct xml_userdata *data,
+                                                 const XML_Char *tag_name)
+{
+    if (data->offs <= 0 || data->resourcexml_parsed)
+        return;
+
+    data->data_buf[data->offs] = '\0';
+    if (data->tag == TAG_CONFIG_STREAM_POOL) {
+        if (strcmp(tag_name, "pool_max_streams") == 0) {
+            streamPoolInfo_.maxStreams = atoi(data->data_buf);
+        } else if (strcmp(tag_name, "pool_idle_timeout_ms") == 0) {
+            streamPoolInfo_.idleTimeoutMs = atoi(data->data_buf);
+        }
+    }
+    if (data->tag == TAG_CONFIG_STREAM_POOL_SUPPORTED_STREAM) {
+        std::string stream_name(data->data_buf);
+        PAL_DBG(LOG_TAG, "Stream name to be added : %s", stream_name.c_str());
+        uint32_t st = usecaseIdLUT.at(stream_name);
+        streamPoolInfo_.streams_.push_back(st);
+        PAL_DBG(LOG_TAG, "Stream type added for stream pool : %d", st);
+    }
+    if (!strcmp(tag_name, "pool_supported_stream")) {
+        data->tag = TAG_CONFIG_STREAM_POOL_SUPPORTED_STREAMS;
+    } else if (!strcmp(tag_name, "pool_supported_streams")) {
+        data->tag = TAG_CONFIG_STREAM_POOL;
+    } else if (!strcmp(tag_name, "config_stream_pool")) {
+        data->tag = TAG_RESOURCE_MANAGER_INFO;
+    }
+}
+
+void ResourceManager::process_stream_pool_prewarm(const XML_Char **attr, const int attr_count)
+{
+    struct stream_pool_prewarm prewarm = {};
+    bool has_device = false, has_stream = false;
+
+    prewarm.sampleRate = SAMPLINGRATE_48K;
+    prewarm.channels = CHANNELS_2;
+    prewarm.bitWidth = BITWIDTH_16;
+
+    for (int i = 0; i + 1 < attr_count; i += 2) {
+        if (!strcmp(attr[i], "device")) {
+            auto it = deviceIdLUT.find(std::string(attr[i + 1]));
+            if (it == deviceIdLUT.end()) {
+                PAL_ERR(LOG_TAG, "invalid pool_prewarm device %s", attr[i + 1]);
+                return;
+            }
+            prewarm.device = it->second;
+            has_device = true;
+        } else if (!strcmp(attr[i], "stream")) {
+            auto it = usecaseIdLUT.find(std::string(attr[i + 1]));
+            if (it == usecaseIdLUT.end()) {
+                PAL_ERR(LOG_TAG, "invalid pool_prewarm stream %s", attr[i + 1]);
+                return;
+            }
+            prewarm.type = (pal_stream_type_t)it->second;
+            has_stream = true;
+        } else if (!strcmp(attr[i], "sample_rate")) {
+            prewarm.sampleRate = atoi(attr[i + 1]);
+        } else if (!strcmp(attr[i], "channels")) {
+            prewarm.channels = atoi(attr[i + 1]);
+        } else if (!strcmp(attr[i], "bit_width")) {
+            prewarm.bitWidth = atoi(attr[i + 1]);
+        }
+    }
+
+    if (!has_device || !has_stream) {
+        PAL_ERR(LOG_TAG, "pool_prewarm needs both device and stream");
+        return;
+    }
+
+    PAL_DBG(LOG_TAG, "stream pool prewarm type %d device %d rate %u ch %u bw %u",
+            prewarm.type, prewarm.device, prewarm.sampleRate, prewarm.channels,
+            prewarm.bitWidth);
+    streamPoolInfo_.prewarm_.push_back(prewarm);
+}
+
 void ResourceManager::process_config_voice(struct xml_userdata *data, const XML_Char *tag_name)
 {
     if(data->voice_info_parsed)
@@ -10564,7 +10747,7 @@ void ResourceManager::startTag(void *userdata, const XML_Char *tag_name,
     } else if(strcmp(tag_name, "param") == 0) {
         processConfigParams(attr);
     } else if (strcmp(tag_name, "codec") == 0) {
-        processBTCodecInfo(attr, XML_GetSpecifiedAttributeCount(data->parser));
+        processBTCodecInfo(attr, data->specified_attr_count);
         return;
     } else if (strcmp(tag_name, "config_gapless") == 0) {
         setGaplessMode(attr);
@@ -10573,7 +10756,10 @@ void ResourceManager::startTag(void *userdata, const XML_Char *tag_name,
         processSpkrTempCtrls(attr);
         return;
     } else if(strcmp(tag_name, "device_temp_ctrl") == 0) {
-        processDeviceTempCtrls(attr, XML_GetSpecifiedAttributeCount(data->parser));
+        processDeviceTempCtrls(attr, data->specified_attr_count);
+        return;
+    } else if (strcmp(tag_name, "pool_prewarm") == 0) {
+        process_stream_pool_prewarm(attr, data->specified_attr_count);
         return;
     }
 
@@ -10637,6 +10823,12 @@ void ResourceManager::startTag(void *userdata, const XML_Char *tag_name,
         data->tag = TAG_CONFIG_LPM_SUPPORTED_STREAMS;
     } else if (!strcmp(tag_name, "lpm_supported_stream")) {
         data->tag = TAG_CONFIG_LPM_SUPPORTED_STREAM;
+    } else if (!strcmp(tag_name, "config_stream_pool")) {
+        data->tag = TAG_CONFIG_STREAM_POOL;
+    } else if (!strcmp(tag_name, "pool_supported_streams")) {
+        data->tag = TAG_CONFIG_STREAM_POOL_SUPPORTED_STREAMS;
+    } else if (!strcmp(tag_name, "pool_supported_stream")) {
+        data->tag = TAG_CONFIG_STREAM_POOL_SUPPORTED_STREAM;
     }
 
     if (!strcmp(tag_name, "card"))
@@ -10697,6 +10889,7 @@ void ResourceManager::endTag(void *userdata, const XML_Char *tag_name)
     process_lpi_vote_streams(data, tag_name);
     process_config_volume(data, tag_name);
     process_config_lpm(data, tag_name);
+    process_config_stream_pool(data, tag_name);
 
     if (data->card_parsed)
         return;
@@ -10740,11 +10933,24 @@ int ResourceManager::XmlParser(std::string xmlFile)
     XML_Parser parser;
     FILE *file = NULL;
     int ret = 0;
-    int bytes_read;
-    void *buf = NULL;
+    long size = 0;
+    std::vector<char> buf;
     struct xml_userdata data;
+    bool useSnapshot = false;
+    uint64_t xmlHash = 0;
+    std::string snapshotPath;
+    XmlSnapshot snapshot;
+    std::chrono::time_point<std::chrono::steady_clock> begin =
+        std::chrono::steady_clock::now();
     memset(&data, 0, sizeof(data));
 
+#ifndef FEATURE_IPQ_OPENWRT
+    char value[PROPERTY_VALUE_MAX] = {0};
+
+    property_get("vendor.audio.pal.xml_snapshot", value, "");
+    useSnapshot = !strncmp("true", value, sizeof("true"));
+#endif
+
     PAL_INFO(LOG_TAG, "XML parsing started - file name %s", xmlFile.c_str());
     file = fopen(xmlFile.c_str(), "r");
     if(!file) {
@@ -10753,6 +10959,35 @@ int ResourceManager::XmlParser(std::string xmlFile)
         goto done;
     }
 
+    /* read the whole file once, it is hashed and parsed from memory */
+    if (fseek(file, 0, SEEK_END) || (size = ftell(file)) < 0 ||
+        fseek(file, 0, SEEK_SET)) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "Failed to get size of %s ret %d", xmlFile.c_str(), ret);
+        goto closeFile;
+    }
+    buf.resize(size);
+    if (size && fread(buf.data(), 1, size, file) != (size_t)size) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "fread failed ret %d", ret);
+        goto closeFile;
+    }
+
+    if (useSnapshot) {
+        xmlHash = XmlSnapshot::hash(buf.data(), buf.size());
+        snapshotPath = XmlSnapshot::pathFor(xmlFile);
+        if (!snapshot.load(snapshotPath, xmlHash, buf.size())) {
+            snapshot.replay(&data,
+                [](void *ud, const char *name, const char **attr, int specified) {
+                    ((struct xml_userdata *)ud)->specified_attr_count = specified;
+                    startTag(ud, name, attr);
+                },
+                endTag, snd_data_handler);
+            goto parsed;
+        }
+        data.snapshot = &snapshot;
+    }
+
     parser = XML_ParserCreate(NULL);
     if (!parser) {
         ret = -EINVAL;
@@ -10762,35 +10997,46 @@ int ResourceManager::XmlParser(std::string xmlFile)
 
     data.parser = parser;
     XML_SetUserData(parser, &data);
-    XML_SetElementHandler(parser, startTag, endTag);
-    XML_SetCharacterDataHandler(parser, snd_data_handler);
-
-    while (1) {
-        buf = XML_GetBuffer(parser, 1024);
-        if(buf == NULL) {
-            ret = -EINVAL;
-            PAL_ERR(LOG_TAG, "XML_Getbuffer failed ret %d", ret);
-            goto freeParser;
-        }
-
-        bytes_read = fread(buf, 1, 1024, file);
-        if(bytes_read < 0) {
-            ret = -EINVAL;
-            PAL_ERR(LOG_TAG, "fread failed ret %d", ret);
-            goto freeParser;
-        }
-
-        if(XML_ParseBuffer(parser, bytes_read, bytes_read == 0) == XML_STATUS_ERROR) {
-            ret = -EINVAL;
-            PAL_ERR(LOG_TAG, "XML ParseBuffer failed for %s file ret %d", xmlFile.c_str(), ret);
-            goto freeParser;
-        }
-        if (bytes_read == 0)
-            break;
+    XML_SetElementHandler(parser,
+        [](void *ud, const XML_Char *name, const XML_Char **attr) {
+            struct xml_userdata *d = (struct xml_userdata *)ud;
+
+            d->specified_attr_count = XML_GetSpecifiedAttributeCount(d->parser);
+            if (d->snapshot)
+                d->snapshot->recordStart(name, attr, d->specified_attr_count);
+            startTag(ud, name, attr);
+        },
+        [](void *ud, const XML_Char *name) {
+            struct xml_userdata *d = (struct xml_userdata *)ud;
+
+            if (d->snapshot)
+                d->snapshot->recordEnd(name);
+            endTag(ud, name);
+        });
+    XML_SetCharacterDataHandler(parser,
+        [](void *ud, const XML_Char *s, int len) {
+            struct xml_userdata *d = (struct xml_userdata *)ud;
+
+            if (d->snapshot)
+                d->snapshot->recordData(s, len);
+            snd_data_handler(ud, s, len);
+        });
+
+    if (XML_Parse(parser, buf.data(), buf.size(), 1) == XML_STATUS_ERROR) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "XML ParseBuffer failed for %s file ret %d", xmlFile.c_str(), ret);
+        goto freeParser;
     }
 
+    if (data.snapshot && snapshot.save(snapshotPath, xmlHash, buf.size()))
+        PAL_INFO(LOG_TAG, "could not save snapshot of %s", xmlFile.c_str());
+
 freeParser:
     XML_ParserFree(parser);
+parsed:
+    PAL_INFO(LOG_TAG, "%s %s in %lld us", data.parser ? "parsed" : "replayed snapshot of",
+             xmlFile.c_str(), (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - begin).count());
 closeFile:
     fclose(file);
 done:
@@ -10867,7 +11113,7 @@ void ResourceManager::restoreDevice(std::shared_ptr<Device> dev)
     /*get current running device info*/
     dev->getDeviceAttributes(&curDevAttr);
 
-    mActiveStreamMutex.lock();
+    PAL_LOCK(mActiveStreamMutex);
     // check if need to update active group devcie config when usecase goes aways
     // if stream device is with same virtual backend, it can be handled in shared backend case
     if (dev->getDeviceCount() == 0) {
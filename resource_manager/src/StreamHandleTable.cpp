@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: StreamHandleTable"
+
+#include <errno.h>
+#include "PalCommon.h"
+#include "StreamHandleTable.h"
+
+#define STREAM_HANDLE_EMPTY     ((uintptr_t)0)
+#define STREAM_HANDLE_TOMBSTONE ((uintptr_t)1)
+#define STREAM_HANDLE_TABLE_MASK (STREAM_HANDLE_TABLE_SIZE - 1)
+
+#define STREAM_HANDLE_HGEN_MASK (UINTPTR_MAX >> STREAM_HANDLE_HGEN_SHIFT)
+
+static_assert(STREAM_HANDLE_TABLE_SIZE <=
+              (1 << (STREAM_HANDLE_HGEN_SHIFT - STREAM_HANDLE_SLOT_SHIFT)),
+              "slot index does not fit the public handle");
+
+static inline uint64_t nextGeneration(uint64_t state)
+{
+    return ((state >> STREAM_HANDLE_GEN_SHIFT) + 1) << STREAM_HANDLE_GEN_SHIFT;
+}
+
+/* keeps users and the active bit, only the generation moves */
+static inline uint64_t bumpGeneration(uint64_t state)
+{
+    return nextGeneration(state) | (state & ~(~0ULL << STREAM_HANDLE_GEN_SHIFT));
+}
+
+static inline uint64_t handleGeneration(uint64_t state)
+{
+    return (state >> STREAM_HANDLE_GEN_SHIFT) & STREAM_HANDLE_HGEN_MASK;
+}
+
+StreamHandleTable::StreamHandleTable()
+{
+    for (int i = 0; i < STREAM_HANDLE_TABLE_SIZE; i++) {
+        slots_[i].key.store(STREAM_HANDLE_EMPTY, std::memory_order_relaxed);
+        slots_[i].state.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+}
+
+uint32_t StreamHandleTable::hash(uintptr_t key)
+{
+    /* heap pointers are at least 16 byte aligned, drop the constant bits */
+    uint64_t h = ((uint64_t)key >> 4) * 0x9E3779B97F4A7C15ULL;
+
+    return (uint32_t)(h >> 32) & STREAM_HANDLE_TABLE_MASK;
+}
+
+int StreamHandleTable::findSlot(uintptr_t key)
+{
+    uint32_t idx = hash(key);
+    uintptr_t cur;
+
+    for (int i = 0; i < STREAM_HANDLE_TABLE_SIZE; i++) {
+        cur = slots_[idx].key.load(std::memory_order_acquire);
+        if (cur == key)
+            return idx;
+        if (cur == STREAM_HANDLE_EMPTY)
+            return -1;
+        idx = (idx + 1) & STREAM_HANDLE_TABLE_MASK;
+    }
+    return -1;
+}
+
+int StreamHandleTable::insert(const void *handle)
+{
+    uintptr_t key = (uintptr_t)handle;
+    uint32_t idx = hash(key);
+    uintptr_t cur;
+    uint64_t state;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (key <= STREAM_HANDLE_TOMBSTONE)
+        return -EINVAL;
+
+    if (findSlot(key) >= 0) {
+        PAL_ERR(LOG_TAG, "handle %p already registered", handle);
+        return -EEXIST;
+    }
+
+    for (int i = 0; i < STREAM_HANDLE_TABLE_SIZE; i++) {
+        cur = slots_[idx].key.load(std::memory_order_relaxed);
+        if (cur == STREAM_HANDLE_EMPTY || cur == STREAM_HANDLE_TOMBSTONE) {
+            state = slots_[idx].state.load(std::memory_order_relaxed);
+            slots_[idx].state.store(nextGeneration(state),
+                                    std::memory_order_relaxed);
+            /* publish the key last so lookups never see a stale state */
+            slots_[idx].key.store(key, std::memory_order_release);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        idx = (idx + 1) & STREAM_HANDLE_TABLE_MASK;
+    }
+
+    PAL_ERR(LOG_TAG, "no free slot for handle %p", handle);
+    return -ENOSPC;
+}
+
+int StreamHandleTable::remove(const void *handle)
+{
+    uintptr_t key = (uintptr_t)handle;
+    uint64_t state;
+    uint32_t idx;
+    int slot;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    slot = findSlot(key);
+    if (slot < 0)
+        return -EINVAL;
+
+    idx = (uint32_t)slot;
+    /* new generation fails any CAS raced against this removal */
+    state = slots_[idx].state.load(std::memory_order_relaxed);
+    slots_[idx].state.store(nextGeneration(state), std::memory_order_release);
+
+    /*
+     * A slot followed by an empty one ends every probe chain through it,
+     * so it and any tombstones right before it can go back to empty.
+     */
+    if (slots_[(idx + 1) & STREAM_HANDLE_TABLE_MASK].key.load(
+            std::memory_order_relaxed) == STREAM_HANDLE_EMPTY) {
+        do {
+            slots_[idx].key.store(STREAM_HANDLE_EMPTY, std::memory_order_release);
+            idx = (idx - 1) & STREAM_HANDLE_TABLE_MASK;
+        } while (slots_[idx].key.load(std::memory_order_relaxed) ==
+                 STREAM_HANDLE_TOMBSTONE);
+    } else {
+        slots_[idx].key.store(STREAM_HANDLE_TOMBSTONE, std::memory_order_release);
+    }
+    count_.fetch_sub(1, std::memory_order_relaxed);
+    return 0;
+}
+
+int StreamHandleTable::decode(uintptr_t publicHandle, uint64_t *gen)
+{
+    uintptr_t slot = (publicHandle >> STREAM_HANDLE_SLOT_SHIFT) &
+                     STREAM_HANDLE_TABLE_MASK;
+    uintptr_t key;
+
+    if (!(publicHandle & STREAM_HANDLE_TAG))
+        return -1;
+
+    key = slots_[slot].key.load(std::memory_order_acquire);
+    if (key == STREAM_HANDLE_EMPTY || key == STREAM_HANDLE_TOMBSTONE)
+        return -1;
+
+    *gen = publicHandle >> STREAM_HANDLE_HGEN_SHIFT;
+    return (int)slot;
+}
+
+/* a fresh generation on every activation, handles of earlier owners go stale */
+int StreamHandleTable::activate(const void *handle, uintptr_t *publicHandle)
+{
+    uintptr_t key = (uintptr_t)handle;
+    int idx = findSlot(key);
+    uint64_t state, next;
+
+    if (idx < 0)
+        return -EINVAL;
+
+    state = slots_[idx].state.load(std::memory_order_acquire);
+    do {
+        if (slots_[idx].key.load(std::memory_order_acquire) != key)
+            return -EINVAL;
+        next = bumpGeneration(state) | STREAM_HANDLE_ACTIVE;
+    } while (!slots_[idx].state.compare_exchange_weak(state, next,
+                 std::memory_order_acq_rel, std::memory_order_acquire));
+
+    if (publicHandle)
+        *publicHandle = (handleGeneration(next) << STREAM_HANDLE_HGEN_SHIFT) |
+                        ((uintptr_t)idx << STREAM_HANDLE_SLOT_SHIFT) |
+                        STREAM_HANDLE_TAG;
+    return 0;
+}
+
+int StreamHandleTable::deactivate(const void *handle, uint32_t *users)
+{
+    uintptr_t key = (uintptr_t)handle;
+    int idx = findSlot(key);
+    uint64_t state;
+
+    if (idx < 0)
+        return -EINVAL;
+
+    state = slots_[idx].state.load(std::memory_order_acquire);
+    do {
+        if (slots_[idx].key.load(std::memory_order_acquire) != key ||
+            !(state & STREAM_HANDLE_ACTIVE))
+            return -EINVAL;
+    } while (!slots_[idx].state.compare_exchange_weak(state,
+                 bumpGeneration(state) & ~STREAM_HANDLE_ACTIVE,
+                 std::memory_order_acq_rel, std::memory_order_acquire));
+
+    if (users)
+        *users = (uint32_t)(state & STREAM_HANDLE_USERS_MASK);
+    return 0;
+}
+
+int StreamHandleTable::acquire(const void *handle, uint32_t *users)
+{
+    uintptr_t key = (uintptr_t)handle;
+    int idx = findSlot(key);
+    uint64_t state;
+
+    if (idx < 0)
+        return -EINVAL;
+
+    state = slots_[idx].state.load(std::memory_order_acquire);
+    do {
+        if (slots_[idx].key.load(std::memory_order_acquire) != key ||
+            !(state & STREAM_HANDLE_ACTIVE))
+            return -EINVAL;
+        if ((state & STREAM_HANDLE_USERS_MASK) == STREAM_HANDLE_USERS_MASK)
+            return -EBUSY;
+    } while (!slots_[idx].state.compare_exchange_weak(state, state + 1,
+                 std::memory_order_acq_rel, std::memory_order_acquire));
+
+    if (users)
+        *users = (uint32_t)((state + 1) & STREAM_HANDLE_USERS_MASK);
+    return 0;
+}
+
+void *StreamHandleTable::lookup(uintptr_t publicHandle)
+{
+    uint64_t gen = 0, state;
+    uintptr_t key;
+    int idx = decode(publicHandle, &gen);
+
+    if (idx < 0)
+        return NULL;
+
+    state = slots_[idx].state.load(std::memory_order_acquire);
+    key = slots_[idx].key.load(std::memory_order_acquire);
+    /* the generation moves on any reuse of the slot, recheck it after the key */
+    if (handleGeneration(state) != gen || !(state & STREAM_HANDLE_ACTIVE) ||
+        slots_[idx].state.load(std::memory_order_acquire) != state ||
+        key == STREAM_HANDLE_EMPTY || key == STREAM_HANDLE_TOMBSTONE)
+        return NULL;
+    return (void *)key;
+}
+
+void *StreamHandleTable::acquire(uintptr_t publicHandle, uint32_t *users)
+{
+    uint64_t gen = 0, state;
+    int idx = decode(publicHandle, &gen);
+
+    if (idx < 0)
+        return NULL;
+
+    state = slots_[idx].state.load(std::memory_order_acquire);
+    do {
+        if (handleGeneration(state) != gen || !(state & STREAM_HANDLE_ACTIVE))
+            return NULL;
+        if ((state & STREAM_HANDLE_USERS_MASK) == STREAM_HANDLE_USERS_MASK)
+            return NULL;
+    } while (!slots_[idx].state.compare_exchange_weak(state, state + 1,
+                 std::memory_order_acq_rel, std::memory_order_acquire));
+
+    if (users)
+        *users = (uint32_t)((state + 1) & STREAM_HANDLE_USERS_MASK);
+    /* the held user count keeps the stream from being deactivated and removed */
+    return (void *)slots_[idx].key.load(std::memory_order_acquire);
+}
+
+int StreamHandleTable::release(const void *handle, uint32_t *users, bool *drained)
+{
+    uintptr_t key = (uintptr_t)handle;
+    int idx = findSlot(key);
+    uint64_t state;
+
+    if (idx < 0)
+        return -EINVAL;
+
+    state = slots_[idx].state.load(std::memory_order_acquire);
+    do {
+        if (slots_[idx].key.load(std::memory_order_acquire) != key ||
+            (state & STREAM_HANDLE_USERS_MASK) == 0)
+            return -EINVAL;
+    } while (!slots_[idx].state.compare_exchange_weak(state, state - 1,
+                 std::memory_order_acq_rel, std::memory_order_acquire));
+
+    state = state - 1;
+    if (users)
+        *users = (uint32_t)(state & STREAM_HANDLE_USERS_MASK);
+    if (drained)
+        *drained = (state & STREAM_HANDLE_USERS_MASK) == 0 &&
+                   !(state & STREAM_HANDLE_ACTIVE);
+    return 0;
+}
+
+int StreamHandleTable::getUsers(const void *handle)
+{
+    int idx = findSlot((uintptr_t)handle);
+
+    if (idx < 0)
+        return -EINVAL;
+
+    return (int)(slots_[idx].state.load(std::memory_order_acquire) &
+                 STREAM_HANDLE_USERS_MASK);
+}
+
+void StreamHandleTable::dump()
+{
+    uintptr_t key;
+    uint64_t state;
+
+    for (int i = 0; i < STREAM_HANDLE_TABLE_SIZE; i++) {
+        key = slots_[i].key.load(std::memory_order_acquire);
+        if (key == STREAM_HANDLE_EMPTY || key == STREAM_HANDLE_TOMBSTONE)
+            continue;
+        state = slots_[i].state.load(std::memory_order_acquire);
+        PAL_VERBOSE(LOG_TAG, "slot %d stream = %p gen = %llu count = %u active = %d",
+                    i, (void *)key,
+                    (unsigned long long)(state >> STREAM_HANDLE_GEN_SHIFT),
+                    (uint32_t)(state & STREAM_HANDLE_USERS_MASK),
+                    !!(state & STREAM_HANDLE_ACTIVE));
+    }
+}
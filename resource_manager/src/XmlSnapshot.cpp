@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: XmlSnapshot"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "PalCommon.h"
+#include "XmlSnapshot.h"
+
+#define XML_SNAPSHOT_MAX_ATTRS 256
+
+static inline size_t alignWord(size_t len)
+{
+    return (len + 3) & ~((size_t)3);
+}
+
+XmlSnapshot::XmlSnapshot()
+    : numEvents_(0), maxAttrs_(0), map_(nullptr), mapSize_(0)
+{
+}
+
+XmlSnapshot::~XmlSnapshot()
+{
+    if (map_)
+        munmap(map_, mapSize_);
+}
+
+uint64_t XmlSnapshot::hash(const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+std::string XmlSnapshot::pathFor(const std::string &xmlFile)
+{
+    size_t pos = xmlFile.find_last_of('/');
+    std::string base = (pos == std::string::npos) ? xmlFile : xmlFile.substr(pos + 1);
+
+    return std::string(XML_SNAPSHOT_DIR) + "/pal_" + base + ".snap";
+}
+
+void XmlSnapshot::putWord(uint32_t v)
+{
+    const char *p = (const char *)&v;
+
+    events_.insert(events_.end(), p, p + sizeof(v));
+}
+
+void XmlSnapshot::putString(const char *s, size_t len)
+{
+    putWord((uint32_t)len);
+    events_.insert(events_.end(), s, s + len);
+    events_.resize(events_.size() + alignWord(len + 1) - len, '\0');
+}
+
+void XmlSnapshot::recordStart(const char *name, const char **attr, int specifiedAttrCount)
+{
+    uint32_t count = 0;
+
+    while (attr[count])
+        count++;
+
+    putWord(EVENT_START);
+    putWord((uint32_t)specifiedAttrCount);
+    putWord(count);
+    putString(name, strlen(name));
+    for (uint32_t i = 0; i < count; i++)
+        putString(attr[i], strlen(attr[i]));
+    numEvents_++;
+}
+
+void XmlSnapshot::recordEnd(const char *name)
+{
+    putWord(EVENT_END);
+    putString(name, strlen(name));
+    numEvents_++;
+}
+
+void XmlSnapshot::recordData(const char *s, int len)
+{
+    putWord(EVENT_DATA);
+    putString(s, len < 0 ? 0 : (size_t)len);
+    numEvents_++;
+}
+
+int XmlSnapshot::save(const std::string &path, uint64_t srcHash, uint64_t srcSize)
+{
+    struct header hdr;
+    std::string tmp = path + ".tmp";
+    int fd = -1;
+    int ret = 0;
+
+    hdr.magic = XML_SNAPSHOT_MAGIC;
+    hdr.version = XML_SNAPSHOT_VERSION;
+    hdr.src_size = srcSize;
+    hdr.src_hash = srcHash;
+    hdr.num_events = numEvents_;
+    hdr.payload_size = (uint32_t)events_.size();
+
+    fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ret = -errno;
+        PAL_DBG(LOG_TAG, "cannot create %s, ret %d", tmp.c_str(), ret);
+        goto exit;
+    }
+
+    if (write(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr) ||
+        write(fd, events_.data(), events_.size()) != (ssize_t)events_.size()) {
+        ret = -EIO;
+        PAL_ERR(LOG_TAG, "short write to %s", tmp.c_str());
+        goto close_fd;
+    }
+
+    if (fsync(fd))
+        ret = -errno;
+
+close_fd:
+    close(fd);
+    if (!ret && rename(tmp.c_str(), path.c_str()))
+        ret = -errno;
+    if (ret)
+        unlink(tmp.c_str());
+    else
+        PAL_INFO(LOG_TAG, "saved %s, %u events, %zu bytes", path.c_str(),
+                 numEvents_, events_.size());
+exit:
+    return ret;
+}
+
+int XmlSnapshot::load(const std::string &path, uint64_t srcHash, uint64_t srcSize)
+{
+    struct header hdr;
+    struct stat st;
+    int fd = -1;
+    int ret = 0;
+
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -errno;
+
+    if (fstat(fd, &st) || st.st_size < (off_t)sizeof(hdr)) {
+        ret = -EINVAL;
+        goto close_fd;
+    }
+
+    map_ = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        ret = -errno;
+        goto close_fd;
+    }
+    mapSize_ = st.st_size;
+
+    memcpy(&hdr, map_, sizeof(hdr));
+    if (hdr.magic != XML_SNAPSHOT_MAGIC || hdr.version != XML_SNAPSHOT_VERSION ||
+        hdr.src_size != srcSize || hdr.src_hash != srcHash ||
+        hdr.payload_size != mapSize_ - sizeof(hdr)) {
+        PAL_INFO(LOG_TAG, "%s is stale", path.c_str());
+        ret = -ESTALE;
+        goto unmap;
+    }
+    numEvents_ = hdr.num_events;
+
+    if (!validate()) {
+        PAL_ERR(LOG_TAG, "%s is corrupted", path.c_str());
+        ret = -EINVAL;
+        goto unmap;
+    }
+    goto close_fd;
+
+unmap:
+    munmap(map_, mapSize_);
+    map_ = nullptr;
+    mapSize_ = 0;
+close_fd:
+    close(fd);
+    return ret;
+}
+
+/*
+ * Walk the whole payload once with bounds checks so that replay() never
+ * has to bail out halfway through and leave the tables partially filled.
+ */
+bool XmlSnapshot::validate()
+{
+    const char *p = (const char *)map_ + sizeof(struct header);
+    const char *end = (const char *)map_ + mapSize_;
+    uint32_t type, count, len;
+
+    auto getWord = [&](uint32_t *v) {
+        if (end - p < (ptrdiff_t)sizeof(*v))
+            return false;
+        memcpy(v, p, sizeof(*v));
+        p += sizeof(*v);
+        return true;
+    };
+    auto skipString = [&]() {
+        if (!getWord(&len) || (size_t)(end - p) < alignWord((size_t)len + 1) ||
+            p[len] != '\0')
+            return false;
+        p += alignWord((size_t)len + 1);
+        return true;
+    };
+
+    for (uint32_t i = 0; i < numEvents_; i++) {
+        if (!getWord(&type))
+            return false;
+        switch (type) {
+        case EVENT_START:
+            if (!getWord(&count) || !getWord(&count) || count > XML_SNAPSHOT_MAX_ATTRS)
+                return false;
+            if (count > maxAttrs_)
+                maxAttrs_ = count;
+            if (!skipString())
+                return false;
+            for (uint32_t a = 0; a < count; a++) {
+                if (!skipString())
+                    return false;
+            }
+            break;
+        case EVENT_END:
+        case EVENT_DATA:
+            if (!skipString())
+                return false;
+            break;
+        default:
+            return false;
+        }
+    }
+    return p == end;
+}
+
+void XmlSnapshot::replay(void *userdata, StartHandler start, EndHandler end, DataHandler data)
+{
+    const char *p = (const char *)map_ + sizeof(struct header);
+    std::vector<const char *> attr(maxAttrs_ + 1);
+    uint32_t type, specified, count, len;
+    const char *name;
+
+    auto getWord = [&]() {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        p += sizeof(v);
+        return v;
+    };
+    auto getString = [&](uint32_t *l) {
+        const char *s;
+        *l = getWord();
+        s = p;
+        p += alignWord((size_t)*l + 1);
+        return s;
+    };
+
+    if (!map_)
+        return;
+
+    for (uint32_t i = 0; i < numEvents_; i++) {
+        type = getWord();
+        switch (type) {
+        case EVENT_START:
+            specified = getWord();
+            count = getWord();
+            name = getString(&len);
+            for (uint32_t a = 0; a < count; a++)
+                attr[a] = getString(&len);
+            attr[count] = nullptr;
+            start(userdata, name, attr.data(), (int)specified);
+            break;
+        case EVENT_END:
+            name = getString(&len);
+            end(userdata, name);
+            break;
+        case EVENT_DATA:
+            name = getString(&len);
+            data(userdata, name, (int)len);
+            break;
+        }
+    }
+}
@@ -42,6 +42,9 @@
 #include <algorithm>
 #include <expat.h>
 #include <map>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <regex>
 #include <sstream>
 #include "Stream.h"
@@ -112,6 +115,7 @@ typedef enum {
     CUSTOM_CONFIG_SEL,
     HOSTLESS_SEL,
     SIDETONE_MODE_SEL,
+    SELECTOR_TYPE_MAX,
 } selector_type_t;
 
 const std::map<std::string, selector_type_t> selectorstypeLUT {
@@ -148,6 +152,114 @@ struct allKVs {
     std::vector<kvInfo> keys_values;
 };
 
+/* selector tuples longer than this are matched by the linear scan */
+#define KV_INDEX_MAX_SELECTORS 32
+
+/*
+ * Lookup index compiled from one of the all_* tables at init. Every
+ * (selector type, value) pair is interned to an integer code, and each
+ * keys_values entry keeps its codes sorted so matching needs no string
+ * compares and no sorting.
+ */
+struct kvIndexEntry {
+    std::vector<uint32_t> codes;
+};
+
+struct kvIndexBlock {
+    std::vector<kvIndexEntry> entries;
+    /* hash of the sorted codes -> entry indexes with that hash, ascending */
+    std::unordered_map<uint64_t, std::vector<uint32_t>> exact;
+    /* entry indexes ordered by code count descending, then index ascending */
+    std::vector<uint32_t> by_size;
+    int32_t first_empty;
+};
+
+struct kvIndexType {
+    std::vector<uint32_t> blocks;
+    std::vector<std::string> selectors;
+    /* bit (1 << selector_type_t) set for each of the selectors above */
+    uint32_t selector_mask;
+};
+
+struct kvIndexTable {
+    bool built;
+    std::vector<kvIndexBlock> blocks;
+    std::unordered_map<int32_t, kvIndexType> types;
+};
+
+/*
+ * Static tables generated from a platform usecaseKvManager.xml by
+ * tools/gen_kv_tables.py, see loadStaticKVTables(). They are only a fast
+ * load cache for the all_* tables and are not looked up directly. Ids,
+ * selector names and values are indexes into the interned string table;
+ * first_* fields index the next table down.
+ */
+enum kvTableSection : uint32_t {
+    KV_TABLE_STREAMS,
+    KV_TABLE_STREAMPPS,
+    KV_TABLE_DEVICES,
+    KV_TABLE_DEVICEPPS,
+};
+
+struct kvTableBlock {
+    kvTableSection section;
+    uint32_t first_id;
+    uint32_t num_ids;
+    uint32_t first_entry;
+    uint32_t num_entries;
+};
+
+struct kvTableEntry {
+    uint32_t first_selector;
+    uint32_t num_selectors;
+    uint32_t first_kv;
+    uint32_t num_kvs;
+};
+
+struct kvTableSelector {
+    uint32_t name;
+    uint32_t first_value;
+    uint32_t num_values;
+};
+
+/* resolved key vectors kept by resolveKVs, least recently used first out */
+#define KV_CACHE_MAX_ENTRIES 128
+
+/*
+ * The stream and device fields getSelectorValues() reads for one table and
+ * type. Fields no selector of that type uses are left at their defaults so
+ * e.g. all streams on a device share the device's entry.
+ */
+struct kvCacheKey {
+    const std::vector<allKVs> *table;
+    int32_t type;
+    int32_t direction;
+    int32_t stream_type;
+    int32_t sub_type;
+    int32_t instance_id;
+    bool pcm;
+    std::string stream_selector;
+    std::string devicepp_selector;
+    std::string custom_key;
+    kvCacheKey():table(nullptr), type(0), direction(0), stream_type(0),
+    sub_type(0), instance_id(0), pcm(false) {}
+    bool operator==(const kvCacheKey &other) const {
+        return table == other.table && type == other.type &&
+               direction == other.direction && stream_type == other.stream_type &&
+               sub_type == other.sub_type && instance_id == other.instance_id &&
+               pcm == other.pcm && stream_selector == other.stream_selector &&
+               devicepp_selector == other.devicepp_selector &&
+               custom_key == other.custom_key;
+    }
+};
+
+struct kvCacheEntry {
+    uint64_t hash;
+    kvCacheKey key;
+    int status;
+    std::vector<std::pair<int, int>> kvs;
+};
+
 typedef enum {
     TAG_USECASEXML_ROOT,
     TAG_STREAM_SEL,
@@ -181,6 +293,16 @@ protected:
    static std::vector<allKVs> all_streampps;
    static std::vector<allKVs> all_devices;
    static std::vector<allKVs> all_devicepps;
+   static kvIndexTable stream_index;
+   static kvIndexTable streampp_index;
+   static kvIndexTable device_index;
+   static kvIndexTable devicepp_index;
+   static std::unordered_map<std::string, uint32_t> selector_codes[SELECTOR_TYPE_MAX];
+   static std::list<kvCacheEntry> kv_cache;
+   static std::unordered_map<uint64_t, std::list<kvCacheEntry>::iterator> kv_cache_map;
+   static std::mutex kv_cache_mutex;
+   static uint64_t kv_cache_hits;
+   static uint64_t kv_cache_misses;
 
 public:
     void payloadUsbAudioConfig(uint8_t** payload, size_t* size,
@@ -261,6 +383,8 @@ public:
     int populateTagKeyVector(Stream *s, std::vector <std::pair<int,int>> &tkv, int tag, uint32_t* gsltag);
     void payloadTimestamp(std::shared_ptr<std::vector<uint8_t>>& module_payload, size_t *size, uint32_t moduleId);
     static int init();
+    static int parseKVXml(const char *xmlFile);
+    static int loadStaticKVTables(const char *xmlFile);
     static void endTag(void *userdata, const XML_Char *tag_name);
     static void startTag(void *userdata, const XML_Char *tag_name, const XML_Char **attr);
     static void handleData(void *userdata, const char *s, int len);
@@ -282,6 +406,21 @@ public:
     static bool findKVs(std::vector<std::pair<selector_type_t, std::string>>
         &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
         std::vector<std::pair<int32_t, int32_t>> &keyVector);
+    static void buildKVIndex(std::vector<allKVs> &any_type, kvIndexTable &index);
+    static kvIndexTable *getKVIndex(std::vector<allKVs> &any_type);
+    static int getKVCacheKey(Stream *s, struct pal_device *dAttr, int32_t type,
+        std::vector<allKVs> &any_type, kvCacheKey &key);
+    static bool lookupKVCache(const kvCacheKey &key,
+        std::vector<std::pair<int32_t, int32_t>> &keyVector, int *status);
+    static void insertKVCache(const kvCacheKey &key, int status,
+        std::vector<std::pair<int32_t, int32_t>>::const_iterator first,
+        std::vector<std::pair<int32_t, int32_t>>::const_iterator last);
+    static int resolveKVs(Stream *s, struct pal_device *dAttr, int32_t type,
+        std::vector<allKVs> &any_type, std::vector<std::pair<int32_t, int32_t>> &keyVector);
+    static void clearKVCache();
+    static int findKVsIndexed(std::vector<std::pair<selector_type_t, std::string>>
+        &filled_selector_pairs, uint32_t type, kvIndexTable &index,
+        std::vector<allKVs> &any_type, std::vector<std::pair<int32_t, int32_t>> &keyVector);
     static std::string removeSpaces(const std::string& str);
     static std::vector<std::string> splitStrings(const std::string& str);
     static int getBtDeviceKV(int dev_id, std::vector<std::pair<int, int>> &deviceKV,
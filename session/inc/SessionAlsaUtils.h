@@ -40,6 +40,12 @@
 
 #include <tinyalsa/asoundlib.h>
 #include <sound/asound.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 
 class Stream;
@@ -77,16 +83,30 @@ enum BeCtrlsIndex {
     BE_MAX_NUM_MIXER_CONTROLS,
 };
 
-
 class SessionAlsaUtils
 {
 private:
     SessionAlsaUtils() {};
-    static struct mixer_ctl *getFeMixerControl(struct mixer *am, std::string feName,
-        uint32_t idx);
-    static struct mixer_ctl *getBeMixerControl(struct mixer *am, std::string beName,
-        uint32_t idx);
     static struct mixer_ctl *getStaticMixerControl(struct mixer *am, std::string name);
+    /* handles of one mixer, see getMixerControl() and getFeMixerControl() */
+    struct mixerCtls {
+        /* full control name */
+        std::unordered_map<std::string, struct mixer_ctl *> names;
+        /* (PCM/COMPRESS, FE id, FeCtrlsIndex), see feCtlKey() */
+        std::unordered_map<uint64_t, struct mixer_ctl *> feIds;
+        /* FE name -> FeCtrlsIndex, BE name -> BeCtrlsIndex */
+        std::unordered_map<std::string,
+                std::array<struct mixer_ctl *, FE_MAX_NUM_MIXER_CONTROLS>> fes;
+        std::unordered_map<std::string,
+                std::array<struct mixer_ctl *, BE_MAX_NUM_MIXER_CONTROLS>> bes;
+    };
+    static std::unordered_map<struct mixer *, mixerCtls> mixerCtlCache;
+    static std::mutex mixerCtlCacheMutex;
+    static std::atomic<uint64_t> mixerCtlCacheHits;
+    static std::atomic<uint64_t> mixerCtlCacheMisses;
+    /* mixer ctl ioctls issued by the calling thread and by everyone */
+    static thread_local uint32_t mixerCtlOps;
+    static std::atomic<uint64_t> mixerCtlOpsTotal;
 public:
     ~SessionAlsaUtils();
     static bool isRxDevice(uint32_t devId);
@@ -167,6 +187,21 @@ public:
    static int mixerWriteDatapathParams(struct mixer *mixer, int device,
                                         void *payload, int size);
    static int flush(std::shared_ptr<ResourceManager> rm, uint32_t id);
+    static struct mixer_ctl *getMixerControl(struct mixer *am, const std::string &name);
+    static struct mixer_ctl *getFeMixerControl(struct mixer *am, const std::string &feName,
+        uint32_t idx);
+    static struct mixer_ctl *getFeMixerControl(struct mixer *am, int32_t feId,
+        uint32_t idx, bool compress = false);
+    static struct mixer_ctl *getBeMixerControl(struct mixer *am, const std::string &beName,
+        uint32_t idx);
+    static void invalidateMixerCtlCache(struct mixer *am = nullptr);
+    static void dumpMixerCtlCacheStats();
+    static int mixerCtlSetArray(struct mixer_ctl *ctl, const void *data, size_t size);
+    static int mixerCtlSetEnum(struct mixer_ctl *ctl, const char *value);
+    static int mixerCtlSetValue(struct mixer_ctl *ctl, unsigned int id, int value);
+    static int mixerCtlGetArray(struct mixer_ctl *ctl, void *data, size_t size);
+    static int mixerCtlGetValue(struct mixer_ctl *ctl, unsigned int id);
+    static uint32_t getMixerCtlOps() { return mixerCtlOps; }
 
 };
 
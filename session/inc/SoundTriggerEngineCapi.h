@@ -40,6 +40,12 @@
 class Stream;
 class SecondStageConfig;
 
+struct reader_wait_stats {
+    uint32_t wait_count;
+    uint32_t timeout_count;
+    uint64_t wait_duration_us;
+};
+
 class SoundTriggerEngineCapi : public SoundTriggerEngine {
  public:
     SoundTriggerEngineCapi(Stream *s,
@@ -99,6 +105,7 @@ class SoundTriggerEngineCapi : public SoundTriggerEngine {
     int32_t StopSoundEngine();
     int32_t StartKeywordDetection();
     int32_t StartUserVerification();
+    int32_t WaitForBufferData(size_t bytes, struct reader_wait_stats *stats);
     static void BufferThreadLoop(SoundTriggerEngineCapi *capi_engine);
 
     std::string lib_name_;
@@ -119,6 +119,8 @@ class SoundTriggerEngineGsl : public SoundTriggerEngine {
 
  private:
     int32_t StartBuffering(Stream *s);
+    size_t WriteMmapDataToRingBuffer(size_t offset, size_t size,
+                                     FILE *dump_fd);
     int32_t RestartRecognition_l(Stream *s);
     int32_t UpdateSessionPayload(st_param_id_type_t param);
     int32_t ParseDetectionPayloadPDK(void *event_data);
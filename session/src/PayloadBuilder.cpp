@@ -36,6 +36,7 @@
 #include "PayloadBuilder.h"
 #include "SessionGsl.h"
 #include "StreamSoundTrigger.h"
+#include "PalTraceLog.h"
 #include "spr_api.h"
 #include "pop_suppressor_api.h"
 #include <agm/agm_api.h>
@@ -170,6 +171,27 @@ std::vector<allKVs> PayloadBuilder::all_streams;
 std::vector<allKVs> PayloadBuilder::all_streampps;
 std::vector<allKVs> PayloadBuilder::all_devices;
 std::vector<allKVs> PayloadBuilder::all_devicepps;
+kvIndexTable PayloadBuilder::stream_index;
+kvIndexTable PayloadBuilder::streampp_index;
+kvIndexTable PayloadBuilder::device_index;
+kvIndexTable PayloadBuilder::devicepp_index;
+std::unordered_map<std::string, uint32_t> PayloadBuilder::selector_codes[SELECTOR_TYPE_MAX];
+std::list<kvCacheEntry> PayloadBuilder::kv_cache;
+std::unordered_map<uint64_t, std::list<kvCacheEntry>::iterator> PayloadBuilder::kv_cache_map;
+std::mutex PayloadBuilder::kv_cache_mutex;
+uint64_t PayloadBuilder::kv_cache_hits = 0;
+uint64_t PayloadBuilder::kv_cache_misses = 0;
+
+static uint64_t hashSelectorCodes(const uint32_t *codes, size_t count)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < count; i++) {
+        hash ^= codes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
 
 template <typename T>
 void PayloadBuilder::populateChannelMap(T pcmChannel, uint8_t numChannel)
@@ -799,7 +821,7 @@ void PayloadBuilder::handleData(void *userdata, const char *s, int len)
    }
 }
 
-int PayloadBuilder::init()
+int PayloadBuilder::parseKVXml(const char *xmlFile)
 {
     XML_Parser parser;
     FILE *file = NULL;
@@ -808,18 +830,9 @@ int PayloadBuilder::init()
     void *buf = NULL;
     struct user_xml_data tag_data;
     memset(&tag_data, 0, sizeof(tag_data));
-    all_streams.clear();
-    all_streampps.clear();
-    all_devices.clear();
-    all_devicepps.clear();
 
-    if (getSocId() == ARRAX_SOC_ID) {
-        PAL_INFO(LOG_TAG, "XML parsing started %s", USECASE_ARRAX_XML_FILE);
-        file = fopen(USECASE_ARRAX_XML_FILE, "r");
-    } else {
-        PAL_INFO(LOG_TAG, "XML parsing started %s", USECASE_XML_FILE);
-        file = fopen(USECASE_XML_FILE, "r");
-    }
+    PAL_INFO(LOG_TAG, "XML parsing started %s", xmlFile);
+    file = fopen(xmlFile, "r");
     if (!file) {
         PAL_ERR(LOG_TAG, "Failed to open xml");
         ret = -EINVAL;
@@ -867,6 +880,219 @@ done:
     return ret;
 }
 
+#ifdef PAL_STATIC_KV_TABLES
+#include <sys/stat.h>
+#include "usecase_kv_tables.h"
+
+/*
+ * Fast load cache for the all_* tables, like XmlSnapshot is for the
+ * resource manager XML: the tables generated at build time only replace
+ * the expat/regex parse. findKVs and the lookup index still run on all_*,
+ * which are filled here exactly as parseKVXml fills them, including the
+ * per block sort endTag does. PalKvTablesCheck compares the two.
+ *
+ * The XML on the device is the source of truth, so it is still read and
+ * hashed to catch tables generated from another file; a size mismatch is
+ * caught by stat() without reading it.
+ */
+int PayloadBuilder::loadStaticKVTables(const char *xmlFile)
+{
+    struct stat st;
+    FILE *file = NULL;
+    std::vector<char> xml;
+    std::vector<allKVs> *tables[] = {&all_streams, &all_streampps,
+                                     &all_devices, &all_devicepps};
+
+    if (stat(xmlFile, &st) || (uint64_t)st.st_size != PAL_KV_TABLES_XML_SIZE) {
+        PAL_INFO(LOG_TAG, "%s differs from the built in KV tables", xmlFile);
+        return -EINVAL;
+    }
+
+    file = fopen(xmlFile, "r");
+    if (!file)
+        return -EINVAL;
+    xml.resize(st.st_size);
+    if (fread(xml.data(), 1, xml.size(), file) != xml.size())
+        xml.clear();
+    fclose(file);
+
+    if (xml.size() != PAL_KV_TABLES_XML_SIZE ||
+        XmlSnapshot::hash(xml.data(), xml.size()) != PAL_KV_TABLES_XML_HASH) {
+        PAL_INFO(LOG_TAG, "%s differs from the built in KV tables", xmlFile);
+        return -EINVAL;
+    }
+
+    for (uint32_t b = 0; b < PAL_KV_TABLES_NUM_BLOCKS; b++) {
+        const kvTableBlock &block = kv_table_blocks[b];
+        std::vector<allKVs> &any_type = *tables[block.section];
+        allKVs kvs;
+
+        kvs.id_type.reserve(block.num_ids);
+        for (uint32_t i = block.first_id; i < block.first_id + block.num_ids; i++) {
+            std::string name(kv_table_strings[kv_table_ids[i]]);
+
+            if (block.section == KV_TABLE_STREAMS || block.section == KV_TABLE_STREAMPPS)
+                kvs.id_type.push_back(ResourceManager::getStreamType(name));
+            else
+                kvs.id_type.push_back(ResourceManager::getDeviceId(name));
+        }
+
+        kvs.keys_values.resize(block.num_entries);
+        for (uint32_t e = 0; e < block.num_entries; e++) {
+            const kvTableEntry &entry = kv_table_entries[block.first_entry + e];
+            kvInfo &info = kvs.keys_values[e];
+
+            info.selector_names.reserve(entry.num_selectors);
+            for (uint32_t i = entry.first_selector;
+                 i < entry.first_selector + entry.num_selectors; i++) {
+                const kvTableSelector &sel = kv_table_selectors[i];
+                selector_type_t type = selectorstypeLUT.at(kv_table_strings[sel.name]);
+
+                info.selector_names.push_back(kv_table_strings[sel.name]);
+                for (uint32_t v = sel.first_value; v < sel.first_value + sel.num_values; v++)
+                    info.selector_pairs.push_back(std::make_pair(type,
+                        std::string(kv_table_strings[kv_table_values[v]])));
+            }
+            info.kv_pairs.assign(kv_table_kvs + entry.first_kv,
+                                 kv_table_kvs + entry.first_kv + entry.num_kvs);
+        }
+        std::sort(kvs.keys_values.begin(), kvs.keys_values.end(), compareNumSelectors);
+        any_type.push_back(std::move(kvs));
+    }
+
+    PAL_INFO(LOG_TAG, "loaded built in KV tables for %s", xmlFile);
+    return 0;
+}
+#else
+int PayloadBuilder::loadStaticKVTables(const char *xmlFile __unused)
+{
+    return -ENOSYS;
+}
+#endif
+
+int PayloadBuilder::init()
+{
+    int ret = 0;
+    const char *xmlFile = USECASE_XML_FILE;
+
+    all_streams.clear();
+    all_streampps.clear();
+    all_devices.clear();
+    all_devicepps.clear();
+    stream_index.built = false;
+    streampp_index.built = false;
+    device_index.built = false;
+    devicepp_index.built = false;
+    for (int i = 0; i < SELECTOR_TYPE_MAX; i++)
+        selector_codes[i].clear();
+    clearKVCache();
+
+    if (getSocId() == ARRAX_SOC_ID)
+        xmlFile = USECASE_ARRAX_XML_FILE;
+
+    if (loadStaticKVTables(xmlFile)) {
+        ret = parseKVXml(xmlFile);
+        if (ret)
+            goto done;
+    }
+
+    buildKVIndex(all_streams, stream_index);
+    buildKVIndex(all_streampps, streampp_index);
+    buildKVIndex(all_devices, device_index);
+    buildKVIndex(all_devicepps, devicepp_index);
+
+done:
+    return ret;
+}
+
+void PayloadBuilder::buildKVIndex(std::vector<allKVs> &any_type, kvIndexTable &index)
+{
+    uint32_t code;
+    uint64_t hash;
+
+    index.built = false;
+    index.blocks.clear();
+    index.types.clear();
+    index.blocks.resize(any_type.size());
+
+    for (uint32_t i = 0; i < any_type.size(); i++) {
+        kvIndexBlock &block = index.blocks[i];
+
+        block.first_empty = -1;
+        block.entries.resize(any_type[i].keys_values.size());
+        for (uint32_t j = 0; j < any_type[i].keys_values.size(); j++) {
+            kvIndexEntry &entry = block.entries[j];
+
+            for (auto &pair : any_type[i].keys_values[j].selector_pairs) {
+                std::unordered_map<std::string, uint32_t> &codes =
+                    selector_codes[pair.first];
+                auto it = codes.find(pair.second);
+
+                if (it == codes.end()) {
+                    code = ((uint32_t)pair.first << 24) | (uint32_t)(codes.size() + 1);
+                    codes.emplace(pair.second, code);
+                } else {
+                    code = it->second;
+                }
+                entry.codes.push_back(code);
+            }
+            std::sort(entry.codes.begin(), entry.codes.end());
+            hash = hashSelectorCodes(entry.codes.data(), entry.codes.size());
+            block.exact[hash].push_back(j);
+            if (entry.codes.empty() && block.first_empty < 0)
+                block.first_empty = j;
+            block.by_size.push_back(j);
+        }
+        std::stable_sort(block.by_size.begin(), block.by_size.end(),
+            [&block](uint32_t a, uint32_t b) {
+                return block.entries[a].codes.size() > block.entries[b].codes.size();
+            });
+
+        for (auto id : any_type[i].id_type) {
+            std::vector<uint32_t> &blocks = index.types[id].blocks;
+
+            if (blocks.empty() || blocks.back() != i)
+                blocks.push_back(i);
+        }
+    }
+
+    /* selector names per type, as retrieveSelectors would collect them */
+    for (auto &type : index.types) {
+        for (auto i : type.second.blocks) {
+            for (auto &kv : any_type[i].keys_values)
+                type.second.selectors.insert(type.second.selectors.end(),
+                    kv.selector_names.begin(), kv.selector_names.end());
+        }
+        if (type.second.selectors.size())
+            removeDuplicateSelectors(type.second.selectors);
+        type.second.selector_mask = 0;
+        for (auto &name : type.second.selectors)
+            type.second.selector_mask |= 1U << selectorstypeLUT.at(name);
+    }
+
+    index.built = true;
+    PAL_DBG(LOG_TAG, "kv index built, blocks %zu types %zu",
+            index.blocks.size(), index.types.size());
+}
+
+kvIndexTable *PayloadBuilder::getKVIndex(std::vector<allKVs> &any_type)
+{
+    kvIndexTable *index = NULL;
+
+    if (&any_type == &all_streams)
+        index = &stream_index;
+    else if (&any_type == &all_streampps)
+        index = &streampp_index;
+    else if (&any_type == &all_devices)
+        index = &device_index;
+    else if (&any_type == &all_devicepps)
+        index = &devicepp_index;
+
+    if (index && !index->built)
+        index = NULL;
+    return index;
+}
+
 void PayloadBuilder::payloadTimestamp(std::shared_ptr<std::vector<uint8_t>>& payload,
                                       size_t *size, uint32_t moduleId)
 {
@@ -2052,7 +2278,6 @@ int PayloadBuilder::populateStreamKV(Stream* s, std::vector<std::pair<int,int>>
 {
     int status = 0;
     struct pal_stream_attributes *sattr = NULL;
-    std::vector<std::string> selector_names;
     std::vector<std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
 
@@ -2086,10 +2311,7 @@ int PayloadBuilder::populateStreamKV(Stream* s, std::vector<std::pair<int,int>>
         } else if (sattr->info.opt_stream_info.loopback_type == PAL_STREAM_LOOPBACK_HFP_TX) {
            /* no StreamKV for HFP TX */
         } else {
-            selector_names = retrieveSelectors(sattr->type, all_streams);
-            if (selector_names.empty() != true)
-               filled_selector_pairs = getSelectorValues(selector_names, s, NULL);
-            retrieveKVs(filled_selector_pairs ,sattr->type, all_streams, keyVectorRx);
+            resolveKVs(s, NULL, sattr->type, all_streams, keyVectorRx);
         }
     } else if (sattr->type == PAL_STREAM_VOICE_CALL) {
         filled_selector_pairs.push_back(std::make_pair(DIRECTION_SEL, "RX"));
@@ -2118,8 +2340,6 @@ int PayloadBuilder::populateStreamPPKV(Stream* s, std::vector <std::pair<int,int
 {
     int status = 0;
     struct pal_stream_attributes *sattr = NULL;
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
     PAL_DBG(LOG_TAG, "Enter");
     sattr = new struct pal_stream_attributes();
@@ -2138,10 +2358,7 @@ int PayloadBuilder::populateStreamPPKV(Stream* s, std::vector <std::pair<int,int
     PAL_INFO(LOG_TAG, "stream type %d", sattr->type);
 
     if (sattr->type == PAL_STREAM_VOICE_CALL) {
-        selectors = retrieveSelectors(sattr->type, all_streampps);
-        if (selectors.empty() != true)
-            filled_selector_pairs = getSelectorValues(selectors, s, NULL);
-        retrieveKVs(filled_selector_pairs ,sattr->type, all_streampps, keyVectorRx);
+        resolveKVs(s, NULL, sattr->type, all_streampps, keyVectorRx);
     } else {
         PAL_DBG(LOG_TAG, "KVs not provided for stream type:%d", sattr->type);
     }
@@ -2191,11 +2408,113 @@ exit:
     return result;
 }
 
+/*
+ * Same matching rules as compareSelectorPairs over the precompiled index:
+ * within each block holding the type, the first entry (in keys_values
+ * order) that equals the filled selectors, or when the sizes differ that
+ * contains every filled selector, wins. Returns -1 when the index cannot
+ * serve the lookup and the caller has to scan.
+ */
+int PayloadBuilder::findKVsIndexed(std::vector<std::pair<selector_type_t, std::string>>
+    &filled_selector_pairs, uint32_t type, kvIndexTable &index,
+    std::vector<allKVs> &any_type, std::vector<std::pair<int, int>> &keyVector)
+{
+    uint32_t codes[KV_INDEX_MAX_SELECTORS];
+    size_t count = filled_selector_pairs.size();
+    bool has_dup = false;
+    bool found = false;
+    uint64_t hash;
+    uint32_t best, code;
+    size_t k, n;
+
+    if (count > KV_INDEX_MAX_SELECTORS)
+        return -1;
+
+    auto type_it = index.types.find(type);
+    if (type_it == index.types.end())
+        return 0;
+
+    for (k = 0; k < count; k++) {
+        selector_type_t sel = filled_selector_pairs[k].first;
+
+        if (sel >= SELECTOR_TYPE_MAX)
+            return -1;
+        auto it = selector_codes[sel].find(filled_selector_pairs[k].second);
+        /* a value no entry uses can neither be equal nor contained */
+        if (it == selector_codes[sel].end())
+            return 0;
+        /* insertion sort, tuples are only a handful of selectors */
+        code = it->second;
+        for (n = k; n > 0 && codes[n - 1] > code; n--)
+            codes[n] = codes[n - 1];
+        codes[n] = code;
+    }
+    for (k = 1; k < count; k++) {
+        if (codes[k] == codes[k - 1])
+            has_dup = true;
+    }
+    hash = hashSelectorCodes(codes, count);
+
+    for (auto i : type_it->second.blocks) {
+        kvIndexBlock &block = index.blocks[i];
+
+        best = UINT32_MAX;
+        if (count == 0) {
+            if (block.first_empty >= 0)
+                best = block.first_empty;
+        } else {
+            auto exact_it = block.exact.find(hash);
+            if (exact_it != block.exact.end()) {
+                for (auto j : exact_it->second) {
+                    if (block.entries[j].codes.size() == count &&
+                        std::equal(codes, codes + count, block.entries[j].codes.begin())) {
+                        best = j;
+                        break;
+                    }
+                }
+            }
+            for (auto j : block.by_size) {
+                std::vector<uint32_t> &entry_codes = block.entries[j].codes;
+
+                /* without duplicates only larger entries can contain us */
+                if (!has_dup && entry_codes.size() <= count)
+                    break;
+                if (entry_codes.size() == count || j >= best)
+                    continue;
+                for (k = 0; k < count; k++) {
+                    if (!std::binary_search(entry_codes.begin(), entry_codes.end(),
+                            codes[k]))
+                        break;
+                }
+                if (k == count)
+                    best = j;
+            }
+        }
+        if (best == UINT32_MAX)
+            continue;
+
+        for (auto &kv : any_type[i].keys_values[best].kv_pairs) {
+            keyVector.push_back(std::make_pair(kv.key, kv.value));
+            PAL_TRACE_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n", kv.key, kv.value);
+        }
+        found = true;
+    }
+    return found;
+}
+
 bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>>
     &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
     std::vector<std::pair<int, int>> &keyVector)
 {
     bool found = false;
+    kvIndexTable *index = getKVIndex(any_type);
+    int ret;
+
+    if (index) {
+        ret = findKVsIndexed(filled_selector_pairs, type, *index, any_type, keyVector);
+        if (ret >= 0)
+            return ret > 0;
+    }
 
     for (int32_t i = 0; i < any_type.size(); i++) {
         if (isIdTypeAvailable(type, any_type[i].id_type)) {
@@ -2207,7 +2526,7 @@ bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>
                             keyVector.push_back(
                                 std::make_pair(any_type[i].keys_values[j].kv_pairs[k].key,
                                 any_type[i].keys_values[j].kv_pairs[k].value));
-                            PAL_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
+                            PAL_TRACE_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
                                 any_type[i].keys_values[j].kv_pairs[k].key,
                                 any_type[i].keys_values[j].kv_pairs[k].value);
                         }
@@ -2220,7 +2539,7 @@ bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>
                             keyVector.push_back(
                                 std::make_pair(any_type[i].keys_values[j].kv_pairs[k].key,
                                 any_type[i].keys_values[j].kv_pairs[k].value));
-                            PAL_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
+                            PAL_TRACE_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
                                 any_type[i].keys_values[j].kv_pairs[k].key,
                                 any_type[i].keys_values[j].kv_pairs[k].value);
                         }
@@ -2234,6 +2553,180 @@ bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>
     return found;
 }
 
+static uint64_t hashKVCacheKey(const kvCacheKey &key)
+{
+    std::hash<std::string> hashString;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    hash = (hash ^ (uint64_t)(uintptr_t)key.table) * 0x100000001b3ULL;
+    hash = (hash ^ (uint32_t)key.type) * 0x100000001b3ULL;
+    hash = (hash ^ (uint32_t)key.direction) * 0x100000001b3ULL;
+    hash = (hash ^ (uint32_t)key.stream_type) * 0x100000001b3ULL;
+    hash = (hash ^ (uint32_t)key.sub_type) * 0x100000001b3ULL;
+    hash = (hash ^ (uint32_t)key.instance_id) * 0x100000001b3ULL;
+    hash = (hash ^ (uint64_t)key.pcm) * 0x100000001b3ULL;
+    if (!key.stream_selector.empty())
+        hash = (hash ^ (uint64_t)hashString(key.stream_selector)) * 0x100000001b3ULL;
+    if (!key.devicepp_selector.empty())
+        hash = (hash ^ (uint64_t)hashString(key.devicepp_selector)) * 0x100000001b3ULL;
+    if (!key.custom_key.empty())
+        hash = (hash ^ (uint64_t)hashString(key.custom_key)) * 0x100000001b3ULL;
+    return hash;
+}
+
+#define KV_SEL_BIT(sel) (1U << (sel))
+
+/*
+ * Read only what getSelectorValues() would turn into selector values for
+ * this type, without building any of the strings. Fails when the lookup
+ * has to go the long way, i.e. there is no index or a value is invalid.
+ */
+int PayloadBuilder::getKVCacheKey(Stream *s, struct pal_device *dAttr, int32_t type,
+    std::vector<allKVs> &any_type, kvCacheKey &key)
+{
+    struct pal_stream_attributes sattr = {};
+    kvIndexTable *index = getKVIndex(any_type);
+    uint32_t mask;
+    int status;
+
+    if (!index)
+        return -EINVAL;
+
+    key = kvCacheKey();
+    key.table = &any_type;
+    key.type = type;
+
+    auto it = index->types.find(type);
+    /* getSelectorValues() fills nothing without a stream */
+    if (it == index->types.end() || !s)
+        return 0;
+    mask = it->second.selector_mask;
+
+    if (mask & ~(KV_SEL_BIT(CUSTOM_CONFIG_SEL))) {
+        status = s->getStreamAttributes(&sattr);
+        if (status)
+            return status;
+    }
+    if (mask & (KV_SEL_BIT(DIRECTION_SEL) | KV_SEL_BIT(SUB_TYPE_SEL)))
+        key.direction = sattr.direction;
+    if (mask & (KV_SEL_BIT(STREAM_TYPE_SEL) | KV_SEL_BIT(SUB_TYPE_SEL)))
+        key.stream_type = sattr.type;
+    if (mask & KV_SEL_BIT(SUB_TYPE_SEL)) {
+        if (sattr.type == PAL_STREAM_PROXY)
+            key.sub_type = sattr.info.opt_stream_info.tx_proxy_type;
+        else if (sattr.type == PAL_STREAM_LOOPBACK)
+            key.sub_type = sattr.info.opt_stream_info.loopback_type;
+    }
+    if (mask & KV_SEL_BIT(INSTANCE_SEL)) {
+        if (sattr.type == PAL_STREAM_VOICE_UI)
+            key.instance_id = dynamic_cast<StreamSoundTrigger *>(s)->GetInstanceId();
+        else
+            key.instance_id = ResourceManager::getInstance()->getStreamInstanceID(s);
+        if (key.instance_id < INSTANCE_1)
+            return -EINVAL;
+    }
+    if (mask & (KV_SEL_BIT(VUI_MODULE_TYPE_SEL) | KV_SEL_BIT(ACD_MODULE_TYPE_SEL)))
+        key.stream_selector = s->getStreamSelector();
+    if (mask & KV_SEL_BIT(DEVICEPP_TYPE_SEL))
+        key.devicepp_selector = s->getDevicePPSelector();
+    if (mask & KV_SEL_BIT(AUD_FMT_SEL))
+        key.pcm = isPalPCMFormat(sattr.out_media_config.aud_fmt_id);
+    if ((mask & KV_SEL_BIT(CUSTOM_CONFIG_SEL)) && dAttr)
+        key.custom_key = dAttr->custom_config.custom_key;
+
+    return 0;
+}
+
+void PayloadBuilder::clearKVCache()
+{
+    std::lock_guard<std::mutex> lock(kv_cache_mutex);
+
+    if (kv_cache_hits || kv_cache_misses)
+        PAL_INFO(LOG_TAG, "kv cache hits %llu misses %llu",
+                 (unsigned long long)kv_cache_hits,
+                 (unsigned long long)kv_cache_misses);
+    kv_cache.clear();
+    kv_cache_map.clear();
+    kv_cache_hits = 0;
+    kv_cache_misses = 0;
+}
+
+bool PayloadBuilder::lookupKVCache(const kvCacheKey &key,
+    std::vector<std::pair<int, int>> &keyVector, int *status)
+{
+    std::lock_guard<std::mutex> lock(kv_cache_mutex);
+    auto it = kv_cache_map.find(hashKVCacheKey(key));
+
+    if (it == kv_cache_map.end() || !(it->second->key == key)) {
+        kv_cache_misses++;
+        return false;
+    }
+
+    /* move to front, it is the most recently used now */
+    kv_cache.splice(kv_cache.begin(), kv_cache, it->second);
+    keyVector.insert(keyVector.end(), it->second->kvs.begin(), it->second->kvs.end());
+    *status = it->second->status;
+    kv_cache_hits++;
+    PAL_DBG(LOG_TAG, "kv cache hit for type/dev id %d, %zu kvs", key.type,
+            it->second->kvs.size());
+    return true;
+}
+
+void PayloadBuilder::insertKVCache(const kvCacheKey &key, int status,
+    std::vector<std::pair<int, int>>::const_iterator first,
+    std::vector<std::pair<int, int>>::const_iterator last)
+{
+    std::lock_guard<std::mutex> lock(kv_cache_mutex);
+    kvCacheEntry entry;
+    uint64_t hash = hashKVCacheKey(key);
+    auto it = kv_cache_map.find(hash);
+
+    if (it != kv_cache_map.end()) {
+        kv_cache.erase(it->second);
+        kv_cache_map.erase(it);
+    }
+    if (kv_cache.size() >= KV_CACHE_MAX_ENTRIES) {
+        kv_cache_map.erase(kv_cache.back().hash);
+        kv_cache.pop_back();
+    }
+
+    entry.hash = hash;
+    entry.key = key;
+    entry.status = status;
+    entry.kvs.assign(first, last);
+    kv_cache.push_front(std::move(entry));
+    kv_cache_map[hash] = kv_cache.begin();
+}
+
+/*
+ * retrieveSelectors() + getSelectorValues() + retrieveKVs() for a stream on
+ * a device, memoized on the attributes the selectors are filled from so a
+ * repeated open or re-route skips building them.
+ */
+int PayloadBuilder::resolveKVs(Stream *s, struct pal_device *dAttr, int32_t type,
+    std::vector<allKVs> &any_type, std::vector<std::pair<int, int>> &keyVector)
+{
+    int status = 0;
+    bool cacheable;
+    kvCacheKey key;
+    size_t kv_start = keyVector.size();
+    std::vector<std::string> selectors;
+    std::vector<std::pair<selector_type_t, std::string>> filled_selector_pairs;
+
+    cacheable = !getKVCacheKey(s, dAttr, type, any_type, key);
+    if (cacheable && lookupKVCache(key, keyVector, &status))
+        return status;
+
+    selectors = retrieveSelectors(type, any_type);
+    if (selectors.empty() != true)
+        filled_selector_pairs = getSelectorValues(selectors, s, dAttr);
+    status = retrieveKVs(filled_selector_pairs, type, any_type, keyVector);
+
+    if (cacheable)
+        insertKVCache(key, status, keyVector.begin() + kv_start, keyVector.end());
+    return status;
+}
+
 int PayloadBuilder::retrieveKVs(std::vector<std::pair<selector_type_t, std::string>>
     &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
     std::vector<std::pair<int, int>> &keyVector)
@@ -2280,20 +2773,14 @@ std::vector<std::pair<selector_type_t, std::string>> PayloadBuilder::getSelector
 {
     int instance_id = 0;
     int status = 0;
-    struct pal_stream_attributes *sattr = NULL;
+    struct pal_stream_attributes attr = {};
+    struct pal_stream_attributes *sattr = &attr;
     std::stringstream st;
     std::vector<std::shared_ptr<Device>> associatedDevices;
     std::vector<std::pair<selector_type_t, std::string>> filled_selector_pairs;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
 
     PAL_DBG(LOG_TAG, "Enter");
-    sattr = new struct pal_stream_attributes();
-    if (!sattr) {
-        PAL_ERR(LOG_TAG, "sattr alloc failed %s", strerror(errno));
-        goto exit;
-    }
-    memset(sattr, 0, sizeof(struct pal_stream_attributes));
-
     if (!s) {
         PAL_ERR(LOG_TAG, "stream is NULL");
         filled_selector_pairs.clear();
@@ -2303,7 +2790,7 @@ std::vector<std::pair<selector_type_t, std::string>> PayloadBuilder::getSelector
     status = s->getStreamAttributes(sattr);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "getStreamAttributes failed status %d", status);
-        goto free_sattr;
+        goto exit;
     }
 
     for (int i = 0; i < selector_names.size(); i++) {
@@ -2331,7 +2818,7 @@ std::vector<std::pair<selector_type_t, std::string>> PayloadBuilder::getSelector
                     instance_id = rm->getStreamInstanceID(s);
                 if (instance_id < INSTANCE_1) {
                     PAL_ERR(LOG_TAG, "Invalid instance id %d", instance_id);
-                    goto free_sattr;
+                    goto exit;
                 }
                 st << instance_id;
                 filled_selector_pairs.push_back(std::make_pair(selector_type, st.str()));
@@ -2359,7 +2846,7 @@ std::vector<std::pair<selector_type_t, std::string>> PayloadBuilder::getSelector
             case VUI_MODULE_TYPE_SEL:
                 if (!s) {
                     PAL_ERR(LOG_TAG, "Invalid stream");
-                    goto free_sattr;
+                    goto exit;
                 }
 
                 filled_selector_pairs.push_back(std::make_pair(selector_type,
@@ -2369,7 +2856,7 @@ std::vector<std::pair<selector_type_t, std::string>> PayloadBuilder::getSelector
             case ACD_MODULE_TYPE_SEL:
                 if (!s) {
                     PAL_ERR(LOG_TAG, "Invalid stream");
-                    goto free_sattr;
+                    goto exit;
                 }
 
                 filled_selector_pairs.push_back(std::make_pair(selector_type,
@@ -2379,7 +2866,7 @@ std::vector<std::pair<selector_type_t, std::string>> PayloadBuilder::getSelector
             case DEVICEPP_TYPE_SEL:
                 if (!s) {
                     PAL_ERR(LOG_TAG, "Invalid stream");
-                    goto free_sattr;
+                    goto exit;
                 }
 
                 filled_selector_pairs.push_back(std::make_pair(selector_type,
@@ -2416,8 +2903,6 @@ std::vector<std::pair<selector_type_t, std::string>> PayloadBuilder::getSelector
                 break;
         }
     }
-free_sattr:
-    delete sattr;
 exit:
     PAL_DBG(LOG_TAG, "Exit");
     return filled_selector_pairs;
@@ -2446,7 +2931,15 @@ bool PayloadBuilder::isIdTypeAvailable(int32_t type, std::vector<int>& id_type)
 std::vector<std::string> PayloadBuilder::retrieveSelectors(int32_t type, std::vector<allKVs> &any_type)
 {
     std::vector<std::string> gkv_selectors;
+    kvIndexTable *index = getKVIndex(any_type);
+
     PAL_DBG(LOG_TAG, "Enter: size_of_all :%zu type:%d", any_type.size(), type);
+    if (index) {
+        auto it = index->types.find(type);
+        if (it != index->types.end())
+            gkv_selectors = it->second.selectors;
+        return gkv_selectors;
+    }
 
     /* looping for all keys_and_values selectors and store in the gkv_selectors */
     for (int32_t i = 0; i < any_type.size(); i++) {
@@ -2473,33 +2966,17 @@ int PayloadBuilder::populateStreamKV(Stream* s,
         std::vector <std::pair<int,int>> &keyVector)
 {
     int status = -EINVAL;
-    struct pal_stream_attributes *sattr = NULL;
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
+    struct pal_stream_attributes sattr = {};
 
     PAL_DBG(LOG_TAG, "enter");
-    sattr = new struct pal_stream_attributes;
-    if (!sattr) {
-        status = -ENOMEM;
-        PAL_ERR(LOG_TAG,"sattr malloc failed %s status %d", strerror(errno), status);
-        goto exit;
-    }
-    memset(sattr, 0, sizeof(struct pal_stream_attributes));
-
-    status = s->getStreamAttributes(sattr);
+    status = s->getStreamAttributes(&sattr);
     if (0 != status) {
         PAL_ERR(LOG_TAG,"getStreamAttributes Failed status %d", status);
-        goto free_sattr;
+        goto exit;
     }
-    PAL_INFO(LOG_TAG, "stream type %d", sattr->type);
-    selectors = retrieveSelectors(sattr->type, all_streams);
-    if (selectors.empty() != true)
-        filled_selector_pairs = getSelectorValues(selectors, s, NULL);
-
-    retrieveKVs(filled_selector_pairs ,sattr->type, all_streams, keyVector);
+    PAL_INFO(LOG_TAG, "stream type %d", sattr.type);
+    resolveKVs(s, NULL, sattr.type, all_streams, keyVector);
 
-free_sattr:
-    delete sattr;
 exit:
     return status;
 }
@@ -2595,8 +3072,6 @@ int PayloadBuilder::populateDeviceKV(Stream* s, int32_t beDevId,
         std::vector <std::pair<int,int>> &keyVector)
 {
     int status = 0;
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
     struct pal_device dAttr;
     std::shared_ptr<Device> dev = nullptr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
@@ -2625,10 +3100,7 @@ int PayloadBuilder::populateDeviceKV(Stream* s, int32_t beDevId,
         dev = Device::getInstance(&dAttr, rm);
         if (dev) {
             status = dev->getDeviceAttributes(&dAttr);
-            selectors = retrieveSelectors(beDevId, all_devices);
-            if (selectors.empty() != true)
-                filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-            retrieveKVs(filled_selector_pairs, beDevId, all_devices, keyVector);
+            resolveKVs(s, &dAttr, beDevId, all_devices, keyVector);
         }
     }
 
@@ -2676,8 +3148,6 @@ int PayloadBuilder::populateDeviceKVTunnel(Stream* s, int32_t beDevId,
         std::vector <std::pair<int,int>> &keyVector)
 {
     int status = 0;
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
     struct pal_device dAttr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
 
@@ -2694,10 +3164,7 @@ int PayloadBuilder::populateDeviceKVTunnel(Stream* s, int32_t beDevId,
     if (beDevId > 0) {
         memset (&dAttr, 0, sizeof(struct pal_device));
         dAttr.id = (pal_device_id_t)beDevId;
-        selectors = retrieveSelectors(beDevId, all_devices);
-        if (selectors.empty() != true)
-            filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-        retrieveKVs(filled_selector_pairs, beDevId, all_devices, keyVector);
+        resolveKVs(s, &dAttr, beDevId, all_devices, keyVector);
     }
 
     PAL_INFO(LOG_TAG, "Exit device id:%d, status %d", beDevId, status);
@@ -2711,8 +3178,6 @@ int PayloadBuilder::populateDevicePPKVTunnel(Stream* s, int32_t rxBeDevId,
     int status = 0;
     struct pal_device dAttr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
     /* Populate Rx Device PP KV */
     if (rxBeDevId > 0) {
@@ -2720,12 +3185,7 @@ int PayloadBuilder::populateDevicePPKVTunnel(Stream* s, int32_t rxBeDevId,
         memset (&dAttr, 0, sizeof(struct pal_device));
         dAttr.id = (pal_device_id_t)rxBeDevId;
 
-        selectors = retrieveSelectors(dAttr.id, all_devicepps);
-        if (selectors.empty() != true)
-            filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-
-        retrieveKVs(filled_selector_pairs, rxBeDevId, all_devicepps,
-            keyVectorRx);
+        resolveKVs(s, &dAttr, rxBeDevId, all_devicepps, keyVectorRx);
     }
 
     PAL_DBG(LOG_TAG, "Exit, status: %d", status);
@@ -2740,8 +3200,6 @@ int PayloadBuilder::populateDevicePPKV(Stream* s, int32_t rxBeDevId,
     struct pal_device dAttr;
     std::shared_ptr<Device> dev = nullptr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-    std::vector <std::string> selectors;
-    std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
 
     PAL_DBG(LOG_TAG, "Enter");
 
@@ -2753,17 +3211,10 @@ int PayloadBuilder::populateDevicePPKV(Stream* s, int32_t rxBeDevId,
         dev = Device::getInstance(&dAttr, rm);
         if (dev) {
             status = dev->getDeviceAttributes(&dAttr);
-            selectors = retrieveSelectors(dAttr.id, all_devicepps);
-            if (selectors.empty() != true)
-                filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-            retrieveKVs(filled_selector_pairs, rxBeDevId, all_devicepps,
-                keyVectorRx);
+            resolveKVs(s, &dAttr, rxBeDevId, all_devicepps, keyVectorRx);
         }
     }
 
-    filled_selector_pairs.clear();
-    selectors.clear();
-
     /* Populate Tx Device PP KV */
     if (txBeDevId > 0) {
         PAL_INFO(LOG_TAG, "Tx device id:%d", txBeDevId);
@@ -2772,11 +3223,7 @@ int PayloadBuilder::populateDevicePPKV(Stream* s, int32_t rxBeDevId,
         dev = Device::getInstance(&dAttr, rm);
         if (dev) {
             status = dev->getDeviceAttributes(&dAttr);
-            selectors = retrieveSelectors(dAttr.id, all_devicepps);
-            if (selectors.empty() != true)
-                filled_selector_pairs = getSelectorValues(selectors, s, &dAttr);
-            retrieveKVs(filled_selector_pairs, txBeDevId, all_devicepps,
-                keyVectorTx);
+            resolveKVs(s, &dAttr, txBeDevId, all_devicepps, keyVectorTx);
         }
     }
     PAL_DBG(LOG_TAG, "Exit, status: %d", status);
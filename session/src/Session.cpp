@@ -68,16 +68,16 @@ void Session::setPmQosMixerCtl(pmQosVote vote)
     struct mixer_ctl *ctl;
 
     if (0 == rm->getHwAudioMixer(&hwMixer)) {
-        ctl = mixer_get_ctl_by_name(hwMixer, "PM_QOS Vote");
+        ctl = SessionAlsaUtils::getMixerControl(hwMixer, "PM_QOS Vote");
         if (!ctl) {
             PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n",
                                                "PM_QOS Vote");
         } else {
             if (vote == PM_QOS_VOTE_DISABLE) {
-                mixer_ctl_set_enum_by_string(ctl, "Disable");
+                SessionAlsaUtils::mixerCtlSetEnum(ctl, "Disable");
                 PAL_DBG(LOG_TAG,"mixer control disabled for PM_QOS Vote \n");
             } else if (vote == PM_QOS_VOTE_ENABLE) {
-                mixer_ctl_set_enum_by_string(ctl, "Enable");
+                SessionAlsaUtils::mixerCtlSetEnum(ctl, "Enable");
                 PAL_DBG(LOG_TAG,"mixer control enabled for PM_QOS Vote \n");
             }
         }
@@ -258,13 +258,13 @@ int Session::getEffectParameters(Stream *s __unused, effect_pal_payload_t *effec
     builder.payloadQuery(&payloadData, &payloadSize,
                             miid, effectCustomPayload->paramId,
                             effectPayload->payloadSize - sizeof(uint32_t));
-    status = mixer_ctl_set_array(ctl, payloadData, payloadSize);
+    status = SessionAlsaUtils::mixerCtlSetArray(ctl, payloadData, payloadSize);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Set custom config failed, status = %d", status);
         goto exit;
     }
 
-    status = mixer_ctl_get_array(ctl, payloadData, payloadSize);
+    status = SessionAlsaUtils::mixerCtlGetArray(ctl, payloadData, payloadSize);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Get custom config failed, status = %d", status);
         goto exit;
@@ -346,7 +346,7 @@ int Session::rwACDBParameters(void *payload, uint32_t sampleRate,
     }
 
    if (isParamWrite) {
-        status = mixer_ctl_set_array(ctl, payloadData, payloadSize);
+        status = SessionAlsaUtils::mixerCtlSetArray(ctl, payloadData, payloadSize);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "Set custom config failed, status = %d", status);
             goto exit;
@@ -546,14 +546,8 @@ int Session::setSlotMask(const std::shared_ptr<ResourceManager>& rm, struct pal_
     int status = 0;
     std::vector <std::pair<int, int>> tkv;
     struct agm_tag_config* tagConfig = NULL;
-    const char *setParamTagControl = " setParamTag";
-    const char *streamPcm = "PCM";
-    const char *streamComp = "COMPRESS";
-    const char *streamVoice = "VOICEMMODE";
-    const char *feCtl = " control";
     struct mixer_ctl *ctl;
-    std::ostringstream tagCntrlName;
-    std::ostringstream feName;
+    struct mixer_ctl *tagCtl;
     std::string backendname;
     int tkv_size = 0;
 
@@ -571,43 +565,39 @@ int Session::setSlotMask(const std::shared_ptr<ResourceManager>& rm, struct pal_
         goto exit;
     }
 
-    if (PAL_STREAM_COMPRESSED == sAttr.type) {
-        tagCntrlName<<streamComp<<pcmDevIds.at(0)<<setParamTagControl;
-        feName<<streamComp<<pcmDevIds.at(0)<<feCtl;
-    } else if (PAL_STREAM_VOICE_CALL == sAttr.type) {
-        if (sAttr.info.voice_call_info.VSID == VOICEMMODE1 ||
-            sAttr.info.voice_call_info.VSID == VOICELBMMODE1){
-            tagCntrlName<<streamVoice<<1<<"p"<<setParamTagControl;
-            feName<<streamVoice<<1<<"p"<<feCtl;
-        } else {
-            tagCntrlName<<streamVoice<<2<<"p"<<setParamTagControl;
-            feName<<streamVoice<<2<<"p"<<feCtl;
-        }
+    if (PAL_STREAM_VOICE_CALL == sAttr.type) {
+        const std::string voiceFe =
+            (sAttr.info.voice_call_info.VSID == VOICEMMODE1 ||
+             sAttr.info.voice_call_info.VSID == VOICELBMMODE1) ?
+            "VOICEMMODE1p" : "VOICEMMODE2p";
+        ctl = SessionAlsaUtils::getFeMixerControl(mixer, voiceFe, FE_CONTROL);
+        tagCtl = SessionAlsaUtils::getFeMixerControl(mixer, voiceFe, FE_SETPARAMTAG);
     } else {
-        tagCntrlName<<streamPcm<<pcmDevIds.at(0)<<setParamTagControl;
-        feName << streamPcm<<pcmDevIds.at(0)<<feCtl;
+        bool compress = (PAL_STREAM_COMPRESSED == sAttr.type);
+        ctl = SessionAlsaUtils::getFeMixerControl(mixer, pcmDevIds.at(0),
+                                                  FE_CONTROL, compress);
+        tagCtl = SessionAlsaUtils::getFeMixerControl(mixer, pcmDevIds.at(0),
+                                                     FE_SETPARAMTAG, compress);
     }
 
     // set FE ctl to BE first in case this is called from connectionSessionDevice
     rm->getBackendName(dAttr.id, backendname);
-    ctl = mixer_get_ctl_by_name(mixer, feName.str().data());
     if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", feName.str().data());
+        PAL_ERR(LOG_TAG, "Invalid mixer control: FE %d control\n", pcmDevIds.at(0));
         status = -EINVAL;
         goto exit;
     }
-    mixer_ctl_set_enum_by_string(ctl, backendname.c_str());
-    ctl = NULL;
+    SessionAlsaUtils::mixerCtlSetEnum(ctl, backendname.c_str());
 
     // set tag data
-    ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+    ctl = tagCtl;
     if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
+        PAL_ERR(LOG_TAG, "Invalid mixer control: FE %d setParamTag\n", pcmDevIds.at(0));
         status = -EINVAL;
         goto exit;
     }
     tkv_size = tkv.size()*sizeof(struct agm_key_value);
-    status = mixer_ctl_set_array(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
+    status = SessionAlsaUtils::mixerCtlSetArray(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
     if (status != 0) {
         PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
     }
@@ -942,14 +932,14 @@ int setConfig(Stream * s, pal_stream_type_t sType, configType type, uint32_t tag
                 goto exit;
             }
             tagCntrlName << stream << pcmDevIds.at(0) << " " << setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, tagCntrlName.str());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 return -ENOENT;
             }
 
             tkv_size = tkv.size() * sizeof(struct agm_key_value);
-            status = mixer_ctl_set_array(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
                 goto exit;
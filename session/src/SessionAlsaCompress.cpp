@@ -33,6 +33,7 @@
 #include "SessionAlsaUtils.h"
 #include "Stream.h"
 #include "ResourceManager.h"
+#include "PalTraceLog.h"
 #include "media_fmt_api.h"
 #include "gapless_api.h"
 #include <agm/agm_api.h>
@@ -912,10 +913,7 @@ int SessionAlsaCompress::setTKV(Stream * s __unused, configType type, effect_pal
     int status = 0;
     uint32_t tagsent;
     struct agm_tag_config* tagConfig = nullptr;
-    const char *setParamTagControl = "setParamTag";
-    const char *stream = "COMPRESS";
     struct mixer_ctl *ctl;
-    std::ostringstream tagCntrlName;
     int tkv_size = 0;
 
     switch (type) {
@@ -946,17 +944,18 @@ int SessionAlsaCompress::setTKV(Stream * s __unused, configType type, effect_pal
             if (0 != status) {
                 goto exit;
             }
-            tagCntrlName<<stream<<compressDevIds.at(0)<<" "<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getFeMixerControl(mixer, compressDevIds.at(0),
+                                                      FE_SETPARAMTAG, true);
             if (!ctl) {
-                PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
+                PAL_ERR(LOG_TAG, "Invalid mixer control: COMPRESS%d setParamTag\n",
+                        compressDevIds.at(0));
                 status = -ENOENT;
                 goto exit;
             }
-            PAL_VERBOSE(LOG_TAG, "mixer control: %s\n", tagCntrlName.str().data());
+            PAL_VERBOSE(LOG_TAG, "mixer control: COMPRESS%d setParamTag\n", compressDevIds.at(0));
 
             tkv_size = tkv.size()*sizeof(struct agm_key_value);
-            status = mixer_ctl_set_array(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
                 goto exit;
@@ -988,9 +987,6 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, uint32_t tag1,
     int status = 0;
     uint32_t tagsent = 0;
     struct agm_tag_config* tagConfig = nullptr;
-    std::ostringstream tagCntrlName;
-    char const *stream = "COMPRESS";
-    const char *setParamTagControl = "setParamTag";
     struct mixer_ctl *ctl = nullptr;
     uint32_t tkv_size = 0;
 
@@ -1019,16 +1015,17 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, uint32_t tag1,
             if (0 != status) {
                 goto exit;
             }
-            tagCntrlName << stream << compressDevIds.at(0) << " " << setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getFeMixerControl(mixer, compressDevIds.at(0),
+                                                      FE_SETPARAMTAG, true);
             if (!ctl) {
-                PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
+                PAL_ERR(LOG_TAG, "Invalid mixer control: COMPRESS%d setParamTag\n",
+                        compressDevIds.at(0));
                 status = -ENOENT;
                 goto exit;
             }
 
             tkv_size = tkv.size() * sizeof(struct agm_key_value);
-            status = mixer_ctl_set_array(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
                 goto exit;
@@ -1054,14 +1051,10 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
     struct pal_stream_attributes sAttr;
     uint32_t tagsent;
     struct agm_tag_config* tagConfig;
-    const char *setParamTagControl = "setParamTag";
     const char *stream = "COMPRESS";
     const char *setCalibrationControl = "setCalibration";
-    const char *setBEControl = "control";
     struct mixer_ctl *ctl;
     struct agm_cal_config *calConfig;
-    std::ostringstream beCntrlName;
-    std::ostringstream tagCntrlName;
     std::ostringstream calCntrlName;
     int tkv_size = 0;
     int ckv_size = 0;
@@ -1079,15 +1072,17 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
         return -EINVAL;
     }
 
-    if (compressDevIds.size() > 0)
-        beCntrlName<<stream<<compressDevIds.at(0)<<" "<<setBEControl;
+    if (compressDevIds.empty()) {
+        PAL_ERR(LOG_TAG, "compressDevIds not found.");
+        return -ENOENT;
+    }
 
-    ctl = mixer_get_ctl_by_name(mixer, beCntrlName.str().data());
+    ctl = SessionAlsaUtils::getFeMixerControl(mixer, compressDevIds.at(0), FE_CONTROL, true);
     if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", beCntrlName.str().data());
+        PAL_ERR(LOG_TAG, "Invalid mixer control: COMPRESS%d control\n", compressDevIds.at(0));
         return -ENOENT;
     }
-    mixer_ctl_set_enum_by_string(ctl, (sAttr.direction == PAL_AUDIO_OUTPUT) ?
+    SessionAlsaUtils::mixerCtlSetEnum(ctl, (sAttr.direction == PAL_AUDIO_OUTPUT) ?
                                  rxAifBackEnds[0].second.data() : txAifBackEnds[0].second.data());
 
     switch (type) {
@@ -1117,16 +1112,17 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
                 goto exit;
             }
             //TODO: how to get the id '5'
-            tagCntrlName<<stream<<compressDevIds.at(0)<<" "<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getFeMixerControl(mixer, compressDevIds.at(0),
+                                                      FE_SETPARAMTAG, true);
             if (!ctl) {
-                PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
+                PAL_ERR(LOG_TAG, "Invalid mixer control: COMPRESS%d setParamTag\n",
+                        compressDevIds.at(0));
                 return -ENOENT;
             }
-            PAL_VERBOSE(LOG_TAG, "mixer control: %s\n", tagCntrlName.str().data());
+            PAL_VERBOSE(LOG_TAG, "mixer control: COMPRESS%d setParamTag\n", compressDevIds.at(0));
 
             tkv_size = tkv.size()*sizeof(struct agm_key_value);
-            status = mixer_ctl_set_array(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
             }
@@ -1157,7 +1153,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
             status = SessionAlsaUtils::getCalMetadata(ckv, calConfig);
             //TODO: how to get the id '0'
             calCntrlName<<stream<<compressDevIds.at(0)<<" "<<setCalibrationControl;
-            ctl = mixer_get_ctl_by_name(mixer, calCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, calCntrlName.str());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", calCntrlName.str().data());
                 return -ENOENT;
@@ -1165,7 +1161,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
             PAL_VERBOSE(LOG_TAG, "mixer control: %s\n", calCntrlName.str().data());
             ckv_size = ckv.size()*sizeof(struct agm_key_value);
             //TODO make struct mixer and struct pcm as class private variables.
-            status = mixer_ctl_set_array(ctl, calConfig, sizeof(struct agm_cal_config) + ckv_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, calConfig, sizeof(struct agm_cal_config) + ckv_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
             }
@@ -1712,12 +1708,12 @@ int SessionAlsaCompress::write(Stream *s __unused, int tag __unused, struct pal_
         return -EINVAL;
     }
 
-    PAL_DBG(LOG_TAG, "buf->size is %zu buf->buffer is %pK ",
+    PAL_TRACE_DBG(LOG_TAG, "buf->size is %zu buf->buffer is %pK ",
             buf->size, buf->buffer);
 
     bytes_written = compress_write(compress, buf->buffer, buf->size);
 
-    PAL_VERBOSE(LOG_TAG, "writing buffer (%zu bytes) to compress device returned %d",
+    PAL_TRACE_VERBOSE(LOG_TAG, "writing buffer (%zu bytes) to compress device returned %d",
              buf->size, bytes_written);
 
     if (bytes_written >= 0 && bytes_written < (ssize_t)buf->size && non_blocking) {
@@ -1764,7 +1760,7 @@ struct mixer_ctl* SessionAlsaCompress::getFEMixerCtl(const char *controlName, in
 
     *device = compressDevIds.at(0);
     CntrlName << "COMPRESS" << compressDevIds.at(0) << " " << controlName;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return nullptr;
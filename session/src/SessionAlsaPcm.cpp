@@ -128,14 +128,14 @@ int SessionAlsaPcm::open(Stream * s)
         pcmDevIds = rm->allocateFrontEndIds(sAttr, ldir);
         if (pcmDevIds.size() == 0) {
             PAL_ERR(LOG_TAG, "allocateFrontEndIds failed");
-            status = -EINVAL;
+            status = -ENOSPC;
             goto exit;
         }
     } else if (sAttr.direction == PAL_AUDIO_OUTPUT) {
         pcmDevIds = rm->allocateFrontEndIds(sAttr, 0);
         if (pcmDevIds.size() == 0) {
             PAL_ERR(LOG_TAG, "allocateFrontEndIds failed");
-            status = -EINVAL;
+            status = -ENOSPC;
             goto exit;
         }
     } else {
@@ -233,9 +233,6 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, uint32_t tag1,
     int status = 0;
     uint32_t tagsent = 0;
     struct agm_tag_config* tagConfig = nullptr;
-    std::ostringstream tagCntrlName;
-    char const *stream = "PCM";
-    const char *setParamTagControl = "setParamTag";
     struct mixer_ctl *ctl = nullptr;
     uint32_t tkv_size = 0;
     PAL_DBG(LOG_TAG, "Enter tags: %d %d %d", tag1, tag2, tag3);
@@ -263,21 +260,19 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, uint32_t tag1,
             if (0 != status) {
                 goto exit;
             }
-            if (pcmDevIds.size() > 0) {
-                tagCntrlName << stream << pcmDevIds.at(0) << " " << setParamTagControl;
-            } else {
+            if (pcmDevIds.size() == 0) {
                 PAL_ERR(LOG_TAG, "pcmDevIds not found.");
                 status = -EINVAL;
                 goto exit;
             }
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getFeMixerControl(mixer, pcmDevIds.at(0), FE_SETPARAMTAG);
             if (!ctl) {
-                PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
+                PAL_ERR(LOG_TAG, "Invalid mixer control: PCM%d setParamTag\n", pcmDevIds.at(0));
                 return -ENOENT;
             }
 
             tkv_size = tkv.size() * sizeof(struct agm_key_value);
-            status = mixer_ctl_set_array(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
                 goto exit;
@@ -310,7 +305,7 @@ struct mixer_ctl* SessionAlsaPcm::getFEMixerCtl(const char *controlName, int *de
 
     *device = pcmDevIds.at(0);
     CntrlName << "PCM" <<pcmDevIds.at(0) << " " << controlName;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return nullptr;
@@ -412,14 +407,11 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
     uint32_t tagsent;
     struct agm_tag_config *tagConfig = nullptr;
     struct agm_cal_config *calConfig = nullptr;
-    const char *setParamTagControl = "setParamTag";
     const char *stream = "PCM";
     const char *setCalibrationControl = "setCalibration";
-    const char *setBEControl = "control";
     struct mixer_ctl *ctl;
-    std::ostringstream tagCntrlName;
     std::ostringstream calCntrlName;
-    std::ostringstream beCntrlName;
+    int32_t feId = -1;
     pal_stream_attributes sAttr;
     int tag_config_size = 0;
     int cal_config_size = 0;
@@ -441,18 +433,19 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
 
         if (PAL_STREAM_LOOPBACK == sAttr.type) {
             if (pcmDevRxIds.size() > 0)
-                beCntrlName << stream << pcmDevRxIds.at(0) << " " << setBEControl;
+                feId = pcmDevRxIds.at(0);
         } else {
             if (pcmDevIds.size() > 0)
-                beCntrlName << stream << pcmDevIds.at(0) << " " << setBEControl;
+                feId = pcmDevIds.at(0);
         }
 
-        ctl = mixer_get_ctl_by_name(mixer, beCntrlName.str().data());
+        ctl = (feId < 0) ? nullptr :
+              SessionAlsaUtils::getFeMixerControl(mixer, feId, FE_CONTROL);
         if (!ctl) {
-            PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", beCntrlName.str().data());
+            PAL_ERR(LOG_TAG, "Invalid mixer control: PCM%d control\n", feId);
             return -ENOENT;
         }
-        mixer_ctl_set_enum_by_string(ctl, (sAttr.direction == PAL_AUDIO_INPUT) ?
+        SessionAlsaUtils::mixerCtlSetEnum(ctl, (sAttr.direction == PAL_AUDIO_INPUT) ?
                                      txAifBackEnds[0].second.data() : rxAifBackEnds[0].second.data());
     }
 
@@ -487,25 +480,25 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
 
             if (PAL_STREAM_LOOPBACK == sAttr.type) {
                 if (pcmDevRxIds.size() > 0)
-                    tagCntrlName << stream << pcmDevRxIds.at(0) << " " << setParamTagControl;
+                    feId = pcmDevRxIds.at(0);
             } else {
                 if (pcmDevIds.size() > 0)
-                    tagCntrlName << stream << pcmDevIds.at(0) << " " << setParamTagControl;
+                    feId = pcmDevIds.at(0);
             }
 
-            if (tagCntrlName.str().length() == 0) {
+            if (feId < 0) {
                 status = -EINVAL;
                 goto exit;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getFeMixerControl(mixer, feId, FE_SETPARAMTAG);
             if (!ctl) {
-                PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
+                PAL_ERR(LOG_TAG, "Invalid mixer control: PCM%d setParamTag\n", feId);
                 status = -ENOENT;
                 goto exit;
             }
 
-            status = mixer_ctl_set_array(ctl, tagConfig, tag_config_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, tagConfig, tag_config_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
                 goto exit;
@@ -548,14 +541,14 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
                 goto exit;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, calCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, calCntrlName.str());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", calCntrlName.str().data());
                 status = -ENOENT;
                 goto exit;
             }
 
-            status = mixer_ctl_set_array(ctl, calConfig, cal_config_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, calConfig, cal_config_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
                 goto exit;
@@ -583,10 +576,8 @@ int SessionAlsaPcm::setTKV(Stream * s, configType type, effect_pal_payload_t *ef
     int status = 0;
     uint32_t tagsent;
     struct agm_tag_config* tagConfig = nullptr;
-    const char *setParamTagControl = "setParamTag";
-    const char *stream = "PCM";
     struct mixer_ctl *ctl;
-    std::ostringstream tagCntrlName;
+    int32_t feId = -1;
     int tkv_size = 0;
     pal_stream_attributes sAttr;
     uint32_t miid = 0;
@@ -653,28 +644,28 @@ int SessionAlsaPcm::setTKV(Stream * s, configType type, effect_pal_payload_t *ef
 
             if (PAL_STREAM_LOOPBACK == sAttr.type) {
                 if (pcmDevRxIds.size() > 0)
-                    tagCntrlName<<stream<<pcmDevRxIds.at(0)<<" "<<setParamTagControl;
+                    feId = pcmDevRxIds.at(0);
             } else {
                 if (pcmDevIds.size() > 0)
-                    tagCntrlName<<stream<<pcmDevIds.at(0)<<" "<<setParamTagControl;
+                    feId = pcmDevIds.at(0);
             }
 
-            if (tagCntrlName.str().length() == 0) {
-                PAL_ERR(LOG_TAG, "Invalid tagCntrlName.");
+            if (feId < 0) {
+                PAL_ERR(LOG_TAG, "pcmDevIds not found.");
                 status = -EINVAL;
                 goto exit;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getFeMixerControl(mixer, feId, FE_SETPARAMTAG);
             if (!ctl) {
-                PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
+                PAL_ERR(LOG_TAG, "Invalid mixer control: PCM%d setParamTag\n", feId);
                 status = -ENOENT;
                 goto exit;
             }
-            PAL_VERBOSE(LOG_TAG, "mixer control: %s\n", tagCntrlName.str().data());
+            PAL_VERBOSE(LOG_TAG, "mixer control: PCM%d setParamTag\n", feId);
 
             tkv_size = tkv.size()*sizeof(struct agm_key_value);
-            status = mixer_ctl_set_array(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
+            status = SessionAlsaUtils::mixerCtlSetArray(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "failed to set the tag calibration %d", status);
                 goto exit;
@@ -1208,19 +1199,20 @@ set_mixer:
                     PAL_ERR(LOG_TAG, "configure MFC failed");
                     goto exit;
                 }
-                if (customPayload) {
-                    if (pcmDevIds.size() == 0) {
-                        PAL_ERR(LOG_TAG, "frontendIDs is not available.");
-                        status = -EINVAL;
-                        goto exit;
-                    }
-                    status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevIds.at(0),
-                                                     customPayload, customPayloadSize);
-                    freeCustomPayload();
-                    if (status != 0) {
-                        PAL_ERR(LOG_TAG, "setMixerParameter failed");
-                        goto exit;
-                    }
+            }
+            /* MFC params of all devices go down in one setParam payload */
+            if (customPayload) {
+                if (pcmDevIds.size() == 0) {
+                    PAL_ERR(LOG_TAG, "frontendIDs is not available.");
+                    status = -EINVAL;
+                    goto exit;
+                }
+                status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevIds.at(0),
+                                                 customPayload, customPayloadSize);
+                freeCustomPayload();
+                if (status != 0) {
+                    PAL_ERR(LOG_TAG, "setMixerParameter failed");
+                    goto exit;
                 }
             }
 
@@ -1299,19 +1291,19 @@ pcm_start:
                     PAL_ERR(LOG_TAG, "configure MFC failed");
                     goto exit;
                 }
-                if (customPayload) {
-                    if (!pcmDevRxIds.size()) {
-                        PAL_ERR(LOG_TAG, "pcmDevRxIds not found.");
-                        status = -EINVAL;
-                        goto exit;
-                    }
-                    status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevRxIds.at(0),
-                                                             customPayload, customPayloadSize);
-                    freeCustomPayload();
-                    if (status != 0) {
-                        PAL_ERR(LOG_TAG, "setMixerParameter failed");
-                        goto exit;
-                    }
+            }
+            if (customPayload) {
+                if (!pcmDevRxIds.size()) {
+                    PAL_ERR(LOG_TAG, "pcmDevRxIds not found.");
+                    status = -EINVAL;
+                    goto exit;
+                }
+                status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevRxIds.at(0),
+                                                         customPayload, customPayloadSize);
+                freeCustomPayload();
+                if (status != 0) {
+                    PAL_ERR(LOG_TAG, "setMixerParameter failed");
+                    goto exit;
                 }
             }
 
@@ -1856,6 +1848,8 @@ int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, in
 {
     int status = 0, bytesRead = 0, bytesToRead = 0, offset = 0, pcmReadSize = 0;
     struct pal_stream_attributes sAttr;
+    StreamLatencyStats *stats = s->getLatencyStats();
+    uint64_t beginNs;
 
     PAL_VERBOSE(LOG_TAG, "Enter")
     status = s->getStreamAttributes(&sAttr);
@@ -1882,10 +1876,14 @@ int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, in
                 ns = pcm_bytes_to_frames(pcm, pcmReadSize)*1000000000LL/
                     sAttr.in_media_config.sample_rate;
             requestAdmFocus(s, ns);
+            beginNs = StreamLatencyStats::now();
             status =  pcm_mmap_read(pcm, data,  pcmReadSize);
+            stats->recordKernel(beginNs, status);
             releaseAdmFocus(s);
         } else {
+            beginNs = StreamLatencyStats::now();
             status =  pcm_read(pcm, data,  pcmReadSize);
+            stats->recordKernel(beginNs, status);
         }
 
         if ((0 != status) || (pcmReadSize == 0)) {
@@ -1907,6 +1905,8 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
     int status = 0, bytesWritten = 0, bytesRemaining = 0, offset = 0;
     uint32_t sizeWritten = 0;
     struct pal_stream_attributes sAttr;
+    StreamLatencyStats *stats = s->getLatencyStats();
+    uint64_t beginNs;
 
 
     PAL_VERBOSE(LOG_TAG, "Enter buf:%p tag:%d flag:%d", buf, tag, flag);
@@ -1945,10 +1945,14 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
                     sAttr.out_media_config.sample_rate;
             PAL_DBG(LOG_TAG, "1.bufsize:%u ns:%ld", sizeWritten, ns);
             requestAdmFocus(s, ns);
+            beginNs = StreamLatencyStats::now();
             status =  pcm_mmap_write(pcm, data,  sizeWritten);
+            stats->recordKernel(beginNs, status);
             releaseAdmFocus(s);
         } else {
+            beginNs = StreamLatencyStats::now();
             status =  pcm_write(pcm, data,  sizeWritten);
+            stats->recordKernel(beginNs, status);
         }
 
         if (0 != status) {
@@ -1977,7 +1981,9 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
                     sAttr.out_media_config.sample_rate;
             PAL_DBG(LOG_TAG, "2.bufsize:%u ns:%ld", sizeWritten, ns);
             requestAdmFocus(s, ns);
+            beginNs = StreamLatencyStats::now();
             status =  pcm_mmap_write(pcm, data,  sizeWritten);
+            stats->recordKernel(beginNs, status);
             releaseAdmFocus(s);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "Error! pcm_mmap_write failed");
@@ -1985,7 +1991,9 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
             }
         }
     } else {
+        beginNs = StreamLatencyStats::now();
         status =  pcm_write(pcm, data,  sizeWritten);
+        stats->recordKernel(beginNs, status);
         if (status != 0) {
             PAL_ERR(LOG_TAG, "Error! pcm_write failed");
             goto exit;
@@ -2508,7 +2516,7 @@ int SessionAlsaPcm::getParameters(Stream *s __unused, int tagId, uint32_t param_
         status = -EINVAL;
         goto exit;
     }
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         status = -ENOENT;
@@ -2559,13 +2567,13 @@ int SessionAlsaPcm::getParameters(Stream *s __unused, int tagId, uint32_t param_
             goto exit;
     }
 
-    status = mixer_ctl_set_array(ctl, payloadData, payloadSize);
+    status = SessionAlsaUtils::mixerCtlSetArray(ctl, payloadData, payloadSize);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Set custom config failed, status = %d", status);
         goto exit;
     }
 
-    status = mixer_ctl_get_array(ctl, payloadData, payloadSize);
+    status = SessionAlsaUtils::mixerCtlGetArray(ctl, payloadData, payloadSize);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Get custom config failed, status = %d", status);
         goto exit;
@@ -2837,7 +2845,7 @@ int SessionAlsaPcm::createMmapBuffer(Stream *s, int32_t min_size_frames,
 
 
         CntrlName << stream << pcmDevIds.at(0) << " " << control;
-        ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+        ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str());
         if (!ctl) {
             PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
             status = -ENOENT;
@@ -2846,7 +2854,7 @@ int SessionAlsaPcm::createMmapBuffer(Stream *s, int32_t min_size_frames,
 
         //TODO call a mixer control to get the fd.
         memset(&buf_info, 0, sizeof(buf_info));
-        status = mixer_ctl_get_array(ctl, (void *)&buf_info, sizeof(struct agm_buf_info));
+        status = SessionAlsaUtils::mixerCtlGetArray(ctl, (void *)&buf_info, sizeof(struct agm_buf_info));
         if (status < 0) {
             // Fall back to non exclusive mode
             info->fd = pcm_get_poll_fd(pcm);
@@ -170,13 +170,13 @@ int SessionAlsaUtils::setMixerCtlData(struct mixer_ctl *ctl, MixerCtlType id, vo
 
     switch (id) {
         case MixerCtlType::MIXER_SET_ID_STRING:
-            mixer_ctl_set_enum_by_string(ctl, (const char *)data);
+            mixerCtlSetEnum(ctl, (const char *)data);
             break;
         case MixerCtlType::MIXER_SET_ID_VALUE:
-            mixer_ctl_set_value(ctl, SNDRV_CTL_ELEM_TYPE_BYTES, *((int *)data));
+            mixerCtlSetValue(ctl, SNDRV_CTL_ELEM_TYPE_BYTES, *((int *)data));
             break;
         case MixerCtlType::MIXER_SET_ID_ARRAY:
-            mixer_ctl_set_array(ctl, data, size);
+            mixerCtlSetArray(ctl, data, size);
             break;
     }
 
@@ -295,39 +295,206 @@ bool SessionAlsaUtils::isMmapUsecase(struct pal_stream_attributes sAttr)
 
 }
 
+std::unordered_map<struct mixer *, SessionAlsaUtils::mixerCtls> SessionAlsaUtils::mixerCtlCache;
+std::mutex SessionAlsaUtils::mixerCtlCacheMutex;
+std::atomic<uint64_t> SessionAlsaUtils::mixerCtlCacheHits(0);
+std::atomic<uint64_t> SessionAlsaUtils::mixerCtlCacheMisses(0);
+thread_local uint32_t SessionAlsaUtils::mixerCtlOps = 0;
+std::atomic<uint64_t> SessionAlsaUtils::mixerCtlOpsTotal(0);
+
+/*
+ * mixer_get_ctl_by_name() is a linear strcmp scan over every control of the
+ * card. Handles stay valid until the mixer is closed, so remember them per
+ * mixer. Failed lookups are not cached as plugin controls may show up later.
+ * ResourceManager drops the cache on SSR and whenever a card is (re)opened
+ * or closed. FE/BE controls are better looked up with getFeMixerControl()
+ * and getBeMixerControl(), which only build the name on a miss.
+ */
+struct mixer_ctl *SessionAlsaUtils::getMixerControl(struct mixer *am, const std::string &name)
+{
+    struct mixer_ctl *ctl = NULL;
+
+    if (!am)
+        return NULL;
+
+    std::lock_guard<std::mutex> lock(mixerCtlCacheMutex);
+    auto &ctls = mixerCtlCache[am].names;
+    auto it = ctls.find(name);
+    if (it != ctls.end()) {
+        mixerCtlCacheHits++;
+        return it->second;
+    }
+
+    mixerCtlCacheMisses++;
+    ctl = mixer_get_ctl_by_name(am, name.c_str());
+    if (ctl)
+        ctls.emplace(name, ctl);
+
+    return ctl;
+}
+
+static inline uint64_t feCtlKey(int32_t feId, uint32_t idx, bool compress)
+{
+    return ((uint64_t)compress << 48) | ((uint64_t)(uint32_t)feId << 16) | idx;
+}
+
+void SessionAlsaUtils::invalidateMixerCtlCache(struct mixer *am)
+{
+    std::lock_guard<std::mutex> lock(mixerCtlCacheMutex);
+
+    if (am)
+        mixerCtlCache.erase(am);
+    else
+        mixerCtlCache.clear();
+}
+
+void SessionAlsaUtils::dumpMixerCtlCacheStats()
+{
+    size_t entries = 0;
+
+    std::lock_guard<std::mutex> lock(mixerCtlCacheMutex);
+    for (auto &m : mixerCtlCache) {
+        entries += m.second.names.size() + m.second.feIds.size();
+        for (auto &fe : m.second.fes)
+            entries += std::count_if(fe.second.begin(), fe.second.end(),
+                                     [](struct mixer_ctl *ctl) { return ctl != NULL; });
+        for (auto &be : m.second.bes)
+            entries += std::count_if(be.second.begin(), be.second.end(),
+                                     [](struct mixer_ctl *ctl) { return ctl != NULL; });
+    }
+
+    PAL_INFO(LOG_TAG, "mixer ctl cache: %zu mixers, %zu entries, hits %llu, misses %llu",
+            mixerCtlCache.size(), entries,
+            (unsigned long long)mixerCtlCacheHits.load(),
+            (unsigned long long)mixerCtlCacheMisses.load());
+    PAL_INFO(LOG_TAG, "mixer ctl ops: %llu", (unsigned long long)mixerCtlOpsTotal.load());
+}
+
+/*
+ * Every mixer ctl access is one ioctl, AGM does its graph work synchronously
+ * inside it. Session, device (speaker protection, BT, DisplayPort) and
+ * ResourceManager code all go through these, counted per calling thread so
+ * an API call can report what it cost, see pal_stream_start(). Writes made
+ * from other threads, e.g. the speaker protection calibration thread, land
+ * in the total only.
+ */
+int SessionAlsaUtils::mixerCtlSetArray(struct mixer_ctl *ctl, const void *data, size_t size)
+{
+    mixerCtlOps++;
+    mixerCtlOpsTotal++;
+    return mixer_ctl_set_array(ctl, data, size);
+}
+
+int SessionAlsaUtils::mixerCtlSetEnum(struct mixer_ctl *ctl, const char *value)
+{
+    mixerCtlOps++;
+    mixerCtlOpsTotal++;
+    return mixer_ctl_set_enum_by_string(ctl, value);
+}
+
+int SessionAlsaUtils::mixerCtlSetValue(struct mixer_ctl *ctl, unsigned int id, int value)
+{
+    mixerCtlOps++;
+    mixerCtlOpsTotal++;
+    return mixer_ctl_set_value(ctl, id, value);
+}
+
+int SessionAlsaUtils::mixerCtlGetArray(struct mixer_ctl *ctl, void *data, size_t size)
+{
+    mixerCtlOps++;
+    mixerCtlOpsTotal++;
+    return mixer_ctl_get_array(ctl, data, size);
+}
+
+int SessionAlsaUtils::mixerCtlGetValue(struct mixer_ctl *ctl, unsigned int id)
+{
+    mixerCtlOps++;
+    mixerCtlOpsTotal++;
+    return mixer_ctl_get_value(ctl, id);
+}
+
 struct mixer_ctl *SessionAlsaUtils::getStaticMixerControl(struct mixer *am, std::string name)
 {
-    std::ostringstream cntrlName;
+    PAL_DBG(LOG_TAG, "mixer control name is %s", name.c_str());
+
+    return getMixerControl(am, name);
+}
+
+/*
+ * Keyed on the FE/BE and the control index rather than on the name, so a
+ * hit builds no string. The name is only put together to look it up.
+ */
+struct mixer_ctl *SessionAlsaUtils::getFeMixerControl(struct mixer *am,
+        const std::string &feName, uint32_t idx)
+{
+    struct mixer_ctl *ctl = NULL;
+
+    if (!am || idx >= FE_MAX_NUM_MIXER_CONTROLS)
+        return NULL;
+
+    PAL_DBG(LOG_TAG, "mixer control %s%s", feName.c_str(), feCtrlNames[idx]);
+    std::lock_guard<std::mutex> lock(mixerCtlCacheMutex);
+    auto &ctls = mixerCtlCache[am].fes[feName];
+    if (ctls[idx]) {
+        mixerCtlCacheHits++;
+        return ctls[idx];
+    }
 
-    cntrlName << name;
-    PAL_DBG(LOG_TAG, "mixer control name is %s", cntrlName.str().data());
+    mixerCtlCacheMisses++;
+    ctl = mixer_get_ctl_by_name(am, (feName + feCtrlNames[idx]).c_str());
+    ctls[idx] = ctl;
 
-    return mixer_get_ctl_by_name(am, cntrlName.str().data());
+    return ctl;
 }
 
-struct mixer_ctl *SessionAlsaUtils::getFeMixerControl(struct mixer *am, std::string feName,
-        uint32_t idx)
+struct mixer_ctl *SessionAlsaUtils::getFeMixerControl(struct mixer *am, int32_t feId,
+        uint32_t idx, bool compress)
 {
-    std::ostringstream cntrlName;
+    std::string cntrlName;
     struct mixer_ctl *ctl = NULL;
 
-    cntrlName << feName << feCtrlNames[idx];
-    PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
-    ctl = mixer_get_ctl_by_name(am, cntrlName.str().data());
-    if (!ctl)
-        PAL_FATAL(LOG_TAG, "invalid mixer control: %s", cntrlName.str().data());
+    if (!am || idx >= FE_MAX_NUM_MIXER_CONTROLS)
+        return NULL;
+
+    std::lock_guard<std::mutex> lock(mixerCtlCacheMutex);
+    auto &ctls = mixerCtlCache[am].feIds;
+    auto it = ctls.find(feCtlKey(feId, idx, compress));
+    if (it != ctls.end()) {
+        mixerCtlCacheHits++;
+        return it->second;
+    }
+
+    mixerCtlCacheMisses++;
+    cntrlName = (compress ? COMPRESS_SND_DEV_NAME_PREFIX : PCM_SND_DEV_NAME_PREFIX) +
+                std::to_string(feId) + feCtrlNames[idx];
+    ctl = mixer_get_ctl_by_name(am, cntrlName.c_str());
+    if (ctl)
+        ctls.emplace(feCtlKey(feId, idx, compress), ctl);
 
     return ctl;
 }
 
-struct mixer_ctl *SessionAlsaUtils::getBeMixerControl(struct mixer *am, std::string beName,
-        uint32_t idx)
+struct mixer_ctl *SessionAlsaUtils::getBeMixerControl(struct mixer *am,
+        const std::string &beName, uint32_t idx)
 {
-    std::ostringstream cntrlName;
+    struct mixer_ctl *ctl = NULL;
 
-    cntrlName << beName << beCtrlNames[idx];
-    PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
-    return mixer_get_ctl_by_name(am, cntrlName.str().data());
+    if (!am || idx >= BE_MAX_NUM_MIXER_CONTROLS)
+        return NULL;
+
+    PAL_DBG(LOG_TAG, "mixer control %s%s", beName.c_str(), beCtrlNames[idx]);
+    std::lock_guard<std::mutex> lock(mixerCtlCacheMutex);
+    auto &ctls = mixerCtlCache[am].bes[beName];
+    if (ctls[idx]) {
+        mixerCtlCacheHits++;
+        return ctls[idx];
+    }
+
+    mixerCtlCacheMisses++;
+    ctl = mixer_get_ctl_by_name(am, (beName + beCtrlNames[idx]).c_str());
+    ctls[idx] = ctl;
+
+    return ctl;
 }
 
 int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManager> rmHandle,
@@ -418,9 +585,9 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
             goto freeStreamMetaData;
         }
     }
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnum(feMixerCtrls[FE_CONTROL], "ZERO");
     if (streamMetaData.size)
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamMetaData.buf,
+        mixerCtlSetArray(feMixerCtrls[FE_METADATA], (void *)streamMetaData.buf,
                 streamMetaData.size);
 
     for (std::vector<std::pair<int32_t, std::string>>::const_iterator be = BackEnds.begin();
@@ -521,14 +688,14 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
 
         /** set mixer controls */
         if (deviceMetaData.size)
-            mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+            mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], be->second.data());
+        mixerCtlSetEnum(feMixerCtrls[FE_CONTROL], be->second.data());
         if (streamDeviceMetaData.size) {
-            mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
+            mixerCtlSetArray(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
                     streamDeviceMetaData.size);
         }
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONNECT], (be->second).data());
+        mixerCtlSetEnum(feMixerCtrls[FE_CONNECT], (be->second).data());
 
         deviceKV.clear();
         streamDeviceKV.clear();
@@ -627,21 +794,21 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
         }
 
         /** set mixer controls */
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_DISCONNECT], be->second.data());
+        mixerCtlSetEnum(feMixerCtrls[FE_DISCONNECT], be->second.data());
         for (auto freeDevmeta = freedevicemetadata.begin(); freeDevmeta != freedevicemetadata.end(); ++freeDevmeta) {
             PAL_DBG(LOG_TAG, "backend %s and freedevicemetadata %d", freeDevmeta->first.data(), freeDevmeta->second);
             if (!(freeDevmeta->first.compare(be->second))) {
                 if (freeDevmeta->second == 0) {
                     PAL_INFO(LOG_TAG, "No need to free device metadata as device is still active");
                 } else {
-                    mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+                    mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                                     deviceMetaData.size);
                 }
             }
         }
 
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], be->second.data());
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
+        mixerCtlSetEnum(feMixerCtrls[FE_CONTROL], be->second.data());
+        mixerCtlSetArray(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
                 streamDeviceMetaData.size);
 
         free(streamDeviceMetaData.buf);
@@ -651,11 +818,11 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     }
 
     // clear stream metadata
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnum(feMixerCtrls[FE_CONTROL], "ZERO");
     getAgmMetaData(emptyKV, emptyKV, (struct prop_data *)streamPropId,
             streamMetaData);
     if (streamMetaData.size)
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA],
+        mixerCtlSetArray(feMixerCtrls[FE_METADATA],
             (void *)streamMetaData.buf, streamMetaData.size);
 
 
@@ -799,7 +966,7 @@ int SessionAlsaUtils::rwACDBTunnel(Stream * streamHandle, std::shared_ptr<Resour
 
     /* set mixer controls */
     if (payloadSize) {
-        status = mixer_ctl_set_array(acdbMixerCtrl, payloadData,
+        status = mixerCtlSetArray(acdbMixerCtrl, payloadData,
                 payloadSize);
     }
 
@@ -840,7 +1007,7 @@ int SessionAlsaUtils::setDeviceCustomPayload(std::shared_ptr<ResourceManager> rm
         return -EINVAL;
     }
 
-    return mixer_ctl_set_array(ctl, payload, size);
+    return mixerCtlSetArray(ctl, payload, size);
 }
 
 int SessionAlsaUtils::setDeviceMetadata(std::shared_ptr<ResourceManager> rmHandle,
@@ -878,7 +1045,7 @@ int SessionAlsaUtils::setDeviceMetadata(std::shared_ptr<ResourceManager> rmHandl
     }
 
     if (deviceMetaData.size)
-        status = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        status = mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                         deviceMetaData.size);
 
     free(deviceMetaData.buf);
@@ -944,7 +1111,7 @@ int SessionAlsaUtils::setDeviceMediaConfig(std::shared_ptr<ResourceManager> rmHa
         aif_group_atrr_config[3] = AGM_DATA_FORMAT_FIXED_POINT;
         aif_group_atrr_config[4] = rmHandle->activeGroupDevConfig->grp_dev_hwep_cfg.slot_mask;
 
-        mixer_ctl_set_array(ctl, &aif_group_atrr_config,
+        mixerCtlSetArray(ctl, &aif_group_atrr_config,
                                sizeof(aif_group_atrr_config)/sizeof(aif_group_atrr_config[0]));
         PAL_INFO(LOG_TAG, "%s rate ch fmt data_fmt slot_mask %ld %ld %ld %ld %ld\n", truncatedBeName.c_str(),
                 aif_group_atrr_config[0], aif_group_atrr_config[1], aif_group_atrr_config[2],
@@ -962,7 +1129,7 @@ int SessionAlsaUtils::setDeviceMediaConfig(std::shared_ptr<ResourceManager> rmHa
                      aif_media_config[0], aif_media_config[1],
                      aif_media_config[2], aif_media_config[3]);
 
-    return mixer_ctl_set_array(ctl, &aif_media_config,
+    return mixerCtlSetArray(ctl, &aif_media_config,
                                sizeof(aif_media_config)/sizeof(aif_media_config[0]));
 }
 
@@ -991,7 +1158,7 @@ int SessionAlsaUtils::getTimestamp(struct mixer *mixer, const std::vector<int> &
         return -EINVAL;
     }
     CntrlName<<pcmDeviceName<<" "<<getParamControl;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = getMixerControl(mixer, CntrlName.str());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return -ENOENT;
@@ -1004,13 +1171,13 @@ int SessionAlsaUtils::getTimestamp(struct mixer *mixer, const std::vector<int> &
         status = -EINVAL;
         goto exit;
     }
-    status = mixer_ctl_set_array(ctl, payload->data(), payloadSize);
+    status = mixerCtlSetArray(ctl, payload->data(), payloadSize);
     if (0 != status) {
          PAL_ERR(LOG_TAG, "Set failed status = %d", status);
          goto exit;
     }
     memset(payload->data(), 0, payloadSize);
-    status = mixer_ctl_get_array(ctl, payload->data(), payloadSize);
+    status = mixerCtlGetArray(ctl, payload->data(), payloadSize);
     if (0 != status) {
          PAL_ERR(LOG_TAG, "Get failed status = %d", status);
          goto exit;
@@ -1064,7 +1231,7 @@ int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1077,7 +1244,7 @@ int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const
         return -ENOMEM;
     }
 
-    ret = mixer_ctl_get_array(ctl, payload, 1024);
+    ret = mixerCtlGetArray(ctl, payload, 1024);
     if (ret < 0) {
         PAL_ERR(LOG_TAG, "Failed to mixer_ctl_get_array\n");
         free(payload);
@@ -1148,7 +1315,7 @@ int SessionAlsaUtils::getTagsWithModuleInfo(struct mixer *mixer, int device, con
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1161,7 +1328,7 @@ int SessionAlsaUtils::getTagsWithModuleInfo(struct mixer *mixer, int device, con
         return -ENOMEM;
     }
 
-    ret = mixer_ctl_get_array(ctl, payload_, 1024);
+    ret = mixerCtlGetArray(ctl, payload_, 1024);
     if (ret < 0) {
         PAL_ERR(LOG_TAG, "Failed to mixer_ctl_get_array\n");
         free(payload);
@@ -1200,13 +1367,13 @@ int SessionAlsaUtils::setMixerParameter(struct mixer *mixer, int device,
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
-    ret = mixer_ctl_set_array(ctl, payload, size);
+    ret = mixerCtlSetArray(ctl, payload, size);
 
     PAL_DBG(LOG_TAG, "ret = %d, cnt = %d\n", ret, size);
     free(mixer_str);
@@ -1236,14 +1403,14 @@ int SessionAlsaUtils::setStreamMetadataType(struct mixer *mixer, int device, con
     }
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
 
-    ret = mixer_ctl_set_enum_by_string(ctl, val);
+    ret = mixerCtlSetEnum(ctl, val);
     free(mixer_str);
     return ret;
 }
@@ -1290,14 +1457,14 @@ int SessionAlsaUtils::registerMixerEvent(struct mixer *mixer, int device, void *
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
 
-    status = mixer_ctl_set_array(ctl, (struct agm_event_reg_cfg *)payload,
+    status = mixerCtlSetArray(ctl, (struct agm_event_reg_cfg *)payload,
                         payload_size);
     free(mixer_str);
     return status;
@@ -1329,14 +1496,14 @@ int SessionAlsaUtils::setECRefPath(struct mixer *mixer, int device, const char *
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     printf("%s mixer -%s-\n", __func__, mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = getMixerControl(mixer, mixer_str);
     if (!ctl) {
         printf("Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
 
-    ret = mixer_ctl_set_enum_by_string(ctl, intf_name);
+    ret = mixerCtlSetEnum(ctl, intf_name);
     free(mixer_str);
     return ret;
 }
@@ -1366,14 +1533,14 @@ int SessionAlsaUtils::mixerWriteDatapathParams(struct mixer *mixer, int device,
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
     PAL_DBG(LOG_TAG, "payload = %p\n", payload);
-    ret = mixer_ctl_set_array(ctl, payload, size);
+    ret = mixerCtlSetArray(ctl, payload, size);
 
     PAL_DBG(LOG_TAG, "ret = %d, cnt = %d\n", ret, size);
     free(mixer_str);
@@ -1641,34 +1808,34 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     txDevNum = !rxDevNum;
 
     /** set TX mixer controls */
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnum(txFeMixerCtrls[FE_CONTROL], "ZERO");
     if (streamTxMetaData.size)
-        mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
+        mixerCtlSetArray(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
                 streamTxMetaData.size);
     if (deviceTxMetaData.size)
-        mixer_ctl_set_array(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
+        mixerCtlSetArray(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
                 deviceTxMetaData.size);
     if (streamDeviceTxMetaData.size) {
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
-        mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
+        mixerCtlSetEnum(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
+        mixerCtlSetArray(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
                 streamDeviceTxMetaData.size);
     }
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONNECT], txBackEnds[0].second.data());
+    mixerCtlSetEnum(txFeMixerCtrls[FE_CONNECT], txBackEnds[0].second.data());
 
     /** set RX mixer controls */
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnum(rxFeMixerCtrls[FE_CONTROL], "ZERO");
     if (streamRxMetaData.size)
-        mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
+        mixerCtlSetArray(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
                 streamRxMetaData.size);
     if (deviceRxMetaData.size)
-        mixer_ctl_set_array(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
+        mixerCtlSetArray(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
                 deviceRxMetaData.size);
     if (streamDeviceRxMetaData.size) {
-        mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
-        mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
+        mixerCtlSetEnum(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
+        mixerCtlSetArray(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
                 streamDeviceRxMetaData.size);
     }
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONNECT], rxBackEnds[0].second.data());
+    mixerCtlSetEnum(rxFeMixerCtrls[FE_CONNECT], rxBackEnds[0].second.data());
 
     if (sAttr.type != PAL_STREAM_VOICE_CALL) {
         txFeMixerCtrls[FE_LOOPBACK] = getFeMixerControl(mixerHandle, txFeName.str(), FE_LOOPBACK);
@@ -1678,7 +1845,7 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
             status = -EINVAL;
             goto freeTxMetaData;
         }
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
+        mixerCtlSetEnum(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
     }
 freeTxMetaData:
     free(streamDeviceTxMetaData.buf);
@@ -1740,7 +1907,7 @@ int SessionAlsaUtils::openDev(std::shared_ptr<ResourceManager> rmHandle,
             goto freeMetaData;
         }
     }
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnum(feMixerCtrls[FE_CONTROL], "ZERO");
 
     if ((status = builder->populateDeviceKV(NULL, backEndId, deviceKV)) != 0) {
         PAL_ERR(LOG_TAG, "get device KV failed %d", status);
@@ -1767,9 +1934,9 @@ int SessionAlsaUtils::openDev(std::shared_ptr<ResourceManager> rmHandle,
 
     /** set mixer controls */
     if (deviceMetaData.size)
-        mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                 deviceMetaData.size);
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONNECT], backEndName.data());
+    mixerCtlSetEnum(feMixerCtrls[FE_CONNECT], backEndName.data());
     deviceKV.clear();
     free(deviceMetaData.buf);
     deviceMetaData.buf = nullptr;
@@ -1910,25 +2077,25 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
             status = -EINVAL;
             goto freeTxMetaData;
         }
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
+        mixerCtlSetEnum(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
     }
 
     /** set TX mixer controls */
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_DISCONNECT], txBackEnds[0].second.data());
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], "ZERO");
-    mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
+    mixerCtlSetEnum(txFeMixerCtrls[FE_DISCONNECT], txBackEnds[0].second.data());
+    mixerCtlSetEnum(txFeMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetArray(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
             streamTxMetaData.size);
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
-    mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
+    mixerCtlSetEnum(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
+    mixerCtlSetArray(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
             streamDeviceTxMetaData.size);
 
     /** set RX mixer controls */
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_DISCONNECT], rxBackEnds[0].second.data());
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], "ZERO");
-    mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
+    mixerCtlSetEnum(rxFeMixerCtrls[FE_DISCONNECT], rxBackEnds[0].second.data());
+    mixerCtlSetEnum(rxFeMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetArray(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
             streamRxMetaData.size);
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
-    mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
+    mixerCtlSetEnum(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
+    mixerCtlSetArray(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
             streamDeviceRxMetaData.size);
 
     /* set Backend mixer control */
@@ -1938,7 +2105,7 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
             if (freeDevMeta->second == 0) {
                 PAL_INFO(LOG_TAG, "No need to free TX device metadata as device is still active");
             } else {
-                mixer_ctl_set_array(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
+                mixerCtlSetArray(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
                                     deviceTxMetaData.size);
             }
         }
@@ -1946,7 +2113,7 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
             if (freeDevMeta->second == 0) {
                 PAL_INFO(LOG_TAG, "No need to free RX device metadata as device is still active");
             } else {
-                mixer_ctl_set_array(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
+                mixerCtlSetArray(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
                                     deviceRxMetaData.size);
             }
         }
@@ -1974,7 +2141,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
         const std::vector<int> &pcmDevIds,
         const std::vector<std::pair<int32_t, std::string>> &aifBackEndsToDisconnect)
 {
-    std::ostringstream disconnectCtrlName;
+    std::ostringstream disconnectFeName;
     int status = 0;
     struct mixer *mixerHandle = nullptr;
     struct mixer_ctl *disconnectCtrl = nullptr;
@@ -1994,7 +2161,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
 
     switch (streamType) {
         case PAL_STREAM_COMPRESSED:
-            disconnectCtrlName << COMPRESS_SND_DEV_NAME_PREFIX << pcmDevIds.at(0) << " disconnect";
+            disconnectFeName << COMPRESS_SND_DEV_NAME_PREFIX << pcmDevIds.at(0);
             feName << COMPRESS_SND_DEV_NAME_PREFIX << pcmDevIds.at(0);
             break;
         case PAL_STREAM_VOICE_CALL:
@@ -2010,21 +2177,21 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
                 sub = 2;
             if (dAttr.id >= PAL_DEVICE_OUT_HANDSET && dAttr.id <= PAL_DEVICE_OUT_HEARING_AID) {
                 feName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "p";
-                disconnectCtrlName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "p" << " disconnect";
+                disconnectFeName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "p";
             } else if (dAttr.id >= PAL_DEVICE_IN_HANDSET_MIC && dAttr.id <= PAL_DEVICE_IN_PROXY) {
                 feName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "c";
-                disconnectCtrlName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "c" << " disconnect";
+                disconnectFeName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "c";
             }
             break;
         default:
             feName << PCM_SND_DEV_NAME_PREFIX << pcmDevIds.at(0);
-            disconnectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmDevIds.at(0) << " disconnect";
+            disconnectFeName << PCM_SND_DEV_NAME_PREFIX << pcmDevIds.at(0);
             break;
     }
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
-    disconnectCtrl = mixer_get_ctl_by_name(mixerHandle, disconnectCtrlName.str().data());
+    disconnectCtrl = getFeMixerControl(mixerHandle, disconnectFeName.str(), FE_DISCONNECT);
     if (!disconnectCtrl) {
-        PAL_ERR(LOG_TAG, "invalid mixer control: %s", disconnectCtrlName.str().data());
+        PAL_ERR(LOG_TAG, "invalid mixer control: %s disconnect", disconnectFeName.str().data());
         return -EINVAL;
     }
     for (i = FE_CONTROL; i <= FE_DISCONNECT; ++i) {
@@ -2039,7 +2206,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     }
 
     /** Disconnect FE to BE */
-    mixer_ctl_set_enum_by_string(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
+    mixerCtlSetEnum(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
 
     /** clear device metadata*/
     getAgmMetaData(emptyKV, emptyKV, (struct prop_data*)devicePropId,
@@ -2066,13 +2233,13 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     if (activeStreamsDevices.size() > 1) {
         PAL_INFO(LOG_TAG, "No need to free device metadata since active streams present on device");
     } else {
-        mixer_ctl_set_array(beMetaDataMixerCtrl, (void*)deviceMetaData.buf,
+        mixerCtlSetArray(beMetaDataMixerCtrl, (void*)deviceMetaData.buf,
             deviceMetaData.size);
     }
 
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL],
+    mixerCtlSetEnum(feMixerCtrls[FE_CONTROL],
         aifBackEndsToDisconnect[0].second.data());
-    mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void*)streamDeviceMetaData.buf,
+    mixerCtlSetArray(feMixerCtrls[FE_METADATA], (void*)streamDeviceMetaData.buf,
         streamDeviceMetaData.size);
 
 freeMetaData:
@@ -2089,7 +2256,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
         const std::vector<int> &pcmTxDevIds,const std::vector<int> &pcmRxDevIds,
         const std::vector<std::pair<int32_t, std::string>> &aifBackEndsToDisconnect)
 {
-    std::ostringstream disconnectCtrlName;
+    std::ostringstream disconnectFeName;
     int status = 0;
     struct mixer *mixerHandle = nullptr;
     struct mixer_ctl *disconnectCtrl = nullptr;
@@ -2108,25 +2275,25 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
                  status = -EINVAL;
                  return status;
              }
-             mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
+             mixerCtlSetEnum(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
              if (dAttr.id > PAL_DEVICE_OUT_MIN && dAttr.id < PAL_DEVICE_OUT_MAX) {
-                 disconnectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmRxDevIds.at(0) << " disconnect";
+                 disconnectFeName << PCM_SND_DEV_NAME_PREFIX << pcmRxDevIds.at(0);
              } else if (dAttr.id > PAL_DEVICE_IN_MIN && dAttr.id < PAL_DEVICE_IN_MAX) {
-                 disconnectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmTxDevIds.at(0) << " disconnect";
+                 disconnectFeName << PCM_SND_DEV_NAME_PREFIX << pcmTxDevIds.at(0);
              }
             break;
         default:
-            disconnectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmRxDevIds.at(0) << " disconnect";
+            disconnectFeName << PCM_SND_DEV_NAME_PREFIX << pcmRxDevIds.at(0);
             break;
     }
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
-    disconnectCtrl = mixer_get_ctl_by_name(mixerHandle, disconnectCtrlName.str().data());
+    disconnectCtrl = getFeMixerControl(mixerHandle, disconnectFeName.str(), FE_DISCONNECT);
     if (!disconnectCtrl) {
-        PAL_ERR(LOG_TAG, "invalid mixer control: %s", disconnectCtrlName.str().data());
+        PAL_ERR(LOG_TAG, "invalid mixer control: %s disconnect", disconnectFeName.str().data());
         return -EINVAL;
     }
     /** Disconnect FE to BE */
-    mixer_ctl_set_enum_by_string(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
+    mixerCtlSetEnum(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
 
     return status;
 }
@@ -2140,7 +2307,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
     struct mixer *mixerHandle = nullptr;
     bool is_compress = false;
     int status = 0;
-    std::ostringstream connectCtrlName;
+    std::ostringstream connectFeName;
     struct pal_stream_attributes sAttr;
     uint8_t* payload = NULL;
     size_t payloadSize = 0;
@@ -2162,7 +2329,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
     }
     switch (streamType) {
         case PAL_STREAM_COMPRESSED:
-            connectCtrlName << COMPRESS_SND_DEV_NAME_PREFIX << pcmDevIds.at(0) << " connect";
+            connectFeName << COMPRESS_SND_DEV_NAME_PREFIX << pcmDevIds.at(0);
             is_compress = true;
             break;
         case PAL_STREAM_VOICE_CALL:
@@ -2173,13 +2340,13 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
                 sub = 2;
 
             if (dAttr.id >= PAL_DEVICE_OUT_HANDSET && dAttr.id <= PAL_DEVICE_OUT_HEARING_AID) {
-                connectCtrlName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "p" << " connect";
+                connectFeName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "p";
             } else if (dAttr.id >= PAL_DEVICE_IN_HANDSET_MIC && dAttr.id <= PAL_DEVICE_IN_PROXY) {
-                connectCtrlName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "c" << " connect";
+                connectFeName << PCM_SND_VOICE_DEV_NAME_PREFIX << sub << "c";
             }
             break;
         default:
-            connectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmDevIds.at(0) << " connect";
+            connectFeName << PCM_SND_DEV_NAME_PREFIX << pcmDevIds.at(0);
             break;
     }
 
@@ -2259,13 +2426,13 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
          }
     }
 
-    connectCtrl = mixer_get_ctl_by_name(mixerHandle, connectCtrlName.str().data());
+    connectCtrl = getFeMixerControl(mixerHandle, connectFeName.str(), FE_CONNECT);
     if (!connectCtrl) {
-        PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
+        PAL_ERR(LOG_TAG, "invalid mixer control: %s connect", connectFeName.str().data());
         status = -EINVAL;
         goto exit;
     }
-    status = mixer_ctl_set_enum_by_string(connectCtrl, aifBackEndsToConnect[0].second.data());
+    status = mixerCtlSetEnum(connectCtrl, aifBackEndsToConnect[0].second.data());
 
 exit:
     if(builder) {
@@ -2280,7 +2447,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
         const std::vector<int> &pcmTxDevIds,const std::vector<int> &pcmRxDevIds,
         const std::vector<std::pair<int32_t, std::string>> &aifBackEndsToConnect)
 {
-    std::ostringstream connectCtrlName;
+    std::ostringstream connectFeName;
     int status = 0;
     struct mixer *mixerHandle = nullptr;
     struct mixer_ctl *connectCtrl = nullptr;
@@ -2293,9 +2460,9 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
 
     if (dAttr.id > PAL_DEVICE_OUT_MIN && dAttr.id < PAL_DEVICE_OUT_MAX) {
         is_out_dev = true;
-        connectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmRxDevIds.at(0) << " connect";
+        connectFeName << PCM_SND_DEV_NAME_PREFIX << pcmRxDevIds.at(0);
     } else if (dAttr.id > PAL_DEVICE_IN_MIN && dAttr.id < PAL_DEVICE_IN_MAX) {
-        connectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmTxDevIds.at(0) << " connect";
+        connectFeName << PCM_SND_DEV_NAME_PREFIX << pcmTxDevIds.at(0);
     }
 
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
@@ -2329,14 +2496,14 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
         }
     }
 
-    connectCtrl = mixer_get_ctl_by_name(mixerHandle, connectCtrlName.str().data());
+    connectCtrl = getFeMixerControl(mixerHandle, connectFeName.str(), FE_CONNECT);
     if (!connectCtrl) {
-        PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
+        PAL_ERR(LOG_TAG, "invalid mixer control: %s connect", connectFeName.str().data());
         status = -EINVAL;
         goto exit;
     }
     /** connect FE to BE */
-    mixer_ctl_set_enum_by_string(connectCtrl, aifBackEndsToConnect[0].second.data());
+    mixerCtlSetEnum(connectCtrl, aifBackEndsToConnect[0].second.data());
 
     switch (streamType) {
          case PAL_STREAM_ULTRASOUND:
@@ -2351,7 +2518,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
                  status = -EINVAL;
                  goto exit;
              }
-             mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
+             mixerCtlSetEnum(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
              break;
          default:
              PAL_ERR(LOG_TAG, "unknown stream type %d",streamType);
@@ -2547,7 +2714,7 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
 
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
 
-    aifMdCtrl = mixer_get_ctl_by_name(mixerHandle, aifMdName.str().data());
+    aifMdCtrl = getMixerControl(mixerHandle, aifMdName.str());
     PAL_DBG(LOG_TAG, "mixer control %s", aifMdName.str().data());
     if (!aifMdCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", aifMdName.str().data());
@@ -2555,18 +2722,18 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
         goto freeMetaData;
     }
     if (deviceMetaData.size)
-        mixer_ctl_set_array(aifMdCtrl, (void *)deviceMetaData.buf, deviceMetaData.size);
+        mixerCtlSetArray(aifMdCtrl, (void *)deviceMetaData.buf, deviceMetaData.size);
 
-    feCtrl = mixer_get_ctl_by_name(mixerHandle, cntrlName.str().data());
+    feCtrl = getMixerControl(mixerHandle, cntrlName.str());
     PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
     if (!feCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", cntrlName.str().data());
         status = -EINVAL;
         goto freeMetaData;
     }
-    mixer_ctl_set_enum_by_string(feCtrl, aifBackEndsToConnect[0].second.data());
+    mixerCtlSetEnum(feCtrl, aifBackEndsToConnect[0].second.data());
 
-    feMdCtrl = mixer_get_ctl_by_name(mixerHandle, feMdName.str().data());
+    feMdCtrl = getMixerControl(mixerHandle, feMdName.str());
     PAL_DBG(LOG_TAG, "mixer control %s", feMdName.str().data());
     if (!feMdCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", feMdName.str().data());
@@ -2574,7 +2741,7 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
         goto freeMetaData;
     }
     if (streamDeviceMetaData.size)
-        mixer_ctl_set_array(feMdCtrl, (void *)streamDeviceMetaData.buf, streamDeviceMetaData.size);
+        mixerCtlSetArray(feMdCtrl, (void *)streamDeviceMetaData.buf, streamDeviceMetaData.size);
 freeMetaData:
     free(streamDeviceMetaData.buf);
     free(deviceMetaData.buf);
@@ -2623,7 +2790,7 @@ int SessionAlsaUtils::flush(std::shared_ptr<ResourceManager> rmHandle, uint32_t
         return -ENOENT;
     }
 
-    mixer_ctl_set_value(ctl, 0, doFlush);
+    mixerCtlSetValue(ctl, 0, doFlush);
 
     return status;
 }
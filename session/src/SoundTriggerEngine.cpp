@@ -105,7 +105,8 @@ int32_t SoundTriggerEngine::CreateBuffer(uint32_t buffer_size,
 
     PAL_DBG(LOG_TAG, "Enter");
     if (!buffer_) {
-        buffer_ = new PalRingBuffer(buffer_size);
+        /* the GSL buffering thread races up to three LAB/second stage readers */
+        buffer_ = new PalRingBuffer(buffer_size, PAL_RING_BUFFER_LOCK_FREE);
         if (!buffer_) {
             PAL_ERR(LOG_TAG, "Failed to allocate memory for ring buffer");
             status = -ENOMEM;
@@ -35,14 +35,28 @@
 
 #include <cutils/trace.h>
 #include <dlfcn.h>
+#include <time.h>
 
 #include "StreamSoundTrigger.h"
 #include "Stream.h"
 #include "SoundTriggerPlatformInfo.h"
+#include "PalTraceLog.h"
 
 ST_DBG_DECLARE(static int keyword_detection_cnt = 0);
 ST_DBG_DECLARE(static int user_verification_cnt = 0);
 
+#define READER_WAIT_TIMEOUT_MARGIN_MS 20
+
+static uint64_t GetThreadCpuTimeUs()
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+        return 0;
+
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 void SoundTriggerEngineCapi::BufferThreadLoop(
     SoundTriggerEngineCapi *capi_engine)
 {
@@ -128,6 +142,38 @@ void SoundTriggerEngineCapi::BufferThreadLoop(
     PAL_DBG(LOG_TAG, "Exit");
 }
 
+/*
+ * Block until the ring buffer writer has committed at least the given
+ * number of bytes for this engine's reader, the reader is reset/woken
+ * up, or the deadline of one buffer duration (plus margin) expires.
+ */
+int32_t SoundTriggerEngineCapi::WaitForBufferData(size_t bytes,
+    struct reader_wait_stats *stats)
+{
+    int32_t status = 0;
+    uint32_t timeout_ms = 0;
+    ChronoSteadyClock_t wait_start;
+
+    if (sample_rate_ && bit_width_ && channels_)
+        timeout_ms = (uint32_t)((bytes * BITS_PER_BYTE * MS_PER_SEC) /
+            (sample_rate_ * bit_width_ * channels_));
+    timeout_ms += READER_WAIT_TIMEOUT_MARGIN_MS;
+
+    wait_start = std::chrono::steady_clock::now();
+    status = reader_->waitForData(bytes, timeout_ms);
+    stats->wait_duration_us +=
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - wait_start).count();
+    stats->wait_count++;
+    if (status == -ETIMEDOUT) {
+        stats->timeout_count++;
+        PAL_DBG(LOG_TAG, "timed out waiting for %zu bytes, unread %zu",
+            bytes, reader_->getUnreadSize());
+    }
+
+    return status;
+}
+
 int32_t SoundTriggerEngineCapi::StartKeywordDetection()
 {
     int32_t status = 0;
@@ -150,6 +196,10 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     uint64_t process_duration = 0;
     uint64_t total_capi_process_duration = 0;
     uint64_t total_capi_get_param_duration = 0;
+    uint64_t cpu_time_start = 0;
+    uint64_t capi_cpu_time_start = 0;
+    uint64_t total_capi_process_cpu_time = 0;
+    struct reader_wait_stats wait_stats = {};
 
     PAL_DBG(LOG_TAG, "Enter");
     if (!reader_) {
@@ -224,6 +274,7 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     }
 
     process_start = std::chrono::steady_clock::now();
+    cpu_time_start = GetThreadCpuTimeUs();
     while (!exit_buffering_ &&
         (bytes_processed_ < buffer_end_ - buffer_start_)) {
         /* Original code had some time of wait will need to revisit*/
@@ -235,6 +286,10 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
 
         /* advance the offset to ensure we are reading at the right place */
         if (!buffer_advanced && buffer_start_ > 0) {
+            if (reader_->getUnreadSize() < buffer_start_) {
+                WaitForBufferData(buffer_start_, &wait_stats);
+                continue;
+            }
             if (reader_->advanceReadOffset(buffer_start_)) {
                 buffer_advanced = true;
             } else {
@@ -242,8 +297,10 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
             }
         }
 
-        if (reader_->getUnreadSize() < buffer_size_)
+        if (reader_->getUnreadSize() < buffer_size_) {
+            WaitForBufferData(buffer_size_, &wait_stats);
             continue;
+        }
 
         read_size = reader_->read((void*)process_input_buff, buffer_size_);
         if (read_size == 0) {
@@ -254,7 +311,7 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
             goto exit;
         }
 
-        PAL_INFO(LOG_TAG, "Processed: %u, start: %u, end: %u",
+        PAL_TRACE_INFO(LOG_TAG, "Processed: %u, start: %u, end: %u",
                  bytes_processed_, buffer_start_, buffer_end_);
         stream_input->bufs_num = 1;
         stream_input->buf_ptr->max_data_len = buffer_size_;
@@ -266,12 +323,15 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
                 process_input_buff, read_size);
         }
 
-        PAL_VERBOSE(LOG_TAG, "Calling Capi Process");
+        PAL_TRACE_VERBOSE(LOG_TAG, "Calling Capi Process");
         capi_call_start = std::chrono::steady_clock::now();
+        capi_cpu_time_start = GetThreadCpuTimeUs();
         ATRACE_BEGIN("Second stage KW process");
         rc = capi_handle_->vtbl_ptr->process(capi_handle_,
             &stream_input, nullptr);
         ATRACE_END();
+        total_capi_process_cpu_time +=
+            GetThreadCpuTimeUs() - capi_cpu_time_start;
         capi_call_end = std::chrono::steady_clock::now();
         total_capi_process_duration +=
             std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -288,7 +348,7 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
         capi_result.actual_data_len = sizeof(sva_result_t);
         capi_result.max_data_len = sizeof(sva_result_t);
 
-        PAL_VERBOSE(LOG_TAG, "Calling Capi get param for status");
+        PAL_TRACE_VERBOSE(LOG_TAG, "Calling Capi get param for status");
         capi_call_start = std::chrono::steady_clock::now();
         rc = capi_handle_->vtbl_ptr->get_param(capi_handle_,
             SVA_ID_RESULT, nullptr, &capi_result);
@@ -345,6 +405,11 @@ exit:
         bytes_processed_, (long long)process_duration,
         (long long)total_capi_process_duration,
         (long long)total_capi_get_param_duration);
+    PAL_INFO(LOG_TAG, "KW cpu time: Total %lluus, Algo process %lluus, "
+        "waited %u times for %lluus, %u wait timeouts",
+        (long long)(cpu_time_start ? GetThreadCpuTimeUs() - cpu_time_start : 0),
+        (long long)total_capi_process_cpu_time, wait_stats.wait_count,
+        (long long)wait_stats.wait_duration_us, wait_stats.timeout_count);
     if (st_info_->GetEnableDebugDumps()) {
         ST_DBG_FILE_CLOSE(keyword_detection_fd);
     }
@@ -389,6 +454,10 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     uint64_t process_duration = 0;
     uint64_t total_capi_process_duration = 0;
     uint64_t total_capi_get_param_duration = 0;
+    uint64_t cpu_time_start = 0;
+    uint64_t capi_cpu_time_start = 0;
+    uint64_t total_capi_process_cpu_time = 0;
+    struct reader_wait_stats wait_stats = {};
 
     PAL_DBG(LOG_TAG, "Enter");
     if (!reader_) {
@@ -497,6 +566,7 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
         buffer_start_ = UsToBytes(kw_start_timestamp_);
 
     process_start = std::chrono::steady_clock::now();
+    cpu_time_start = GetThreadCpuTimeUs();
     while (!exit_buffering_ &&
         (bytes_processed_ < buffer_end_ - buffer_start_)) {
         /* Original code had some time of wait will need to revisit*/
@@ -508,6 +578,10 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
 
         /* advance the offset to ensure we are reading at the right place */
         if (!buffer_advanced && buffer_start_ > 0) {
+            if (reader_->getUnreadSize() < buffer_start_) {
+                WaitForBufferData(buffer_start_, &wait_stats);
+                continue;
+            }
             if (reader_->advanceReadOffset(buffer_start_)) {
                 buffer_advanced = true;
             } else {
@@ -515,8 +589,10 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
             }
         }
 
-        if (reader_->getUnreadSize() < buffer_size_)
+        if (reader_->getUnreadSize() < buffer_size_) {
+            WaitForBufferData(buffer_size_, &wait_stats);
             continue;
+        }
 
         read_size = reader_->read((void*)process_input_buff, buffer_size_);
         if (read_size == 0) {
@@ -526,7 +602,7 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
             PAL_ERR(LOG_TAG, "Failed to read from buffer, status %d", status);
             goto exit;
         }
-        PAL_INFO(LOG_TAG, "Processed: %u, start: %u, end: %u",
+        PAL_TRACE_INFO(LOG_TAG, "Processed: %u, start: %u, end: %u",
                  bytes_processed_, buffer_start_, buffer_end_);
         stream_input->bufs_num = 1;
         stream_input->buf_ptr->max_data_len = buffer_size_;
@@ -538,12 +614,15 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
                 process_input_buff, read_size);
         }
 
-        PAL_VERBOSE(LOG_TAG, "Calling Capi Process\n");
+        PAL_TRACE_VERBOSE(LOG_TAG, "Calling Capi Process\n");
         capi_call_start = std::chrono::steady_clock::now();
+        capi_cpu_time_start = GetThreadCpuTimeUs();
         ATRACE_BEGIN("Second stage uv process");
         rc = capi_handle_->vtbl_ptr->process(capi_handle_,
             &stream_input, nullptr);
         ATRACE_END();
+        total_capi_process_cpu_time +=
+            GetThreadCpuTimeUs() - capi_cpu_time_start;
         capi_call_end = std::chrono::steady_clock::now();
         total_capi_process_duration +=
             std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -560,7 +639,7 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
         capi_result.actual_data_len = sizeof(stage2_uv_wrapper_result);
         capi_result.max_data_len = sizeof(stage2_uv_wrapper_result);
 
-        PAL_VERBOSE(LOG_TAG, "Calling Capi get param for result\n");
+        PAL_TRACE_VERBOSE(LOG_TAG, "Calling Capi get param for result\n");
         capi_call_start = std::chrono::steady_clock::now();
         ATRACE_BEGIN("Second stage uv get result");
         rc = capi_handle_->vtbl_ptr->get_param(capi_handle_,
@@ -597,6 +676,11 @@ exit:
         bytes_processed_, (long long)process_duration,
         (long long)total_capi_process_duration,
         (long long)total_capi_get_param_duration);
+    PAL_INFO(LOG_TAG, "UV cpu time: Total %lluus, Algo process %lluus, "
+        "waited %u times for %lluus, %u wait timeouts",
+        (long long)(cpu_time_start ? GetThreadCpuTimeUs() - cpu_time_start : 0),
+        (long long)total_capi_process_cpu_time, wait_stats.wait_count,
+        (long long)wait_stats.wait_duration_us, wait_stats.timeout_count);
     if (st_info_->GetEnableDebugDumps()) {
         ST_DBG_FILE_CLOSE(user_verification_fd);
     }
@@ -748,6 +832,8 @@ SoundTriggerEngineCapi::~SoundTriggerEngineCapi()
         std::unique_lock<std::mutex> lck(event_mutex_);
         exit_thread_ = true;
         exit_buffering_ = true;
+        if (reader_)
+            reader_->wakeUp();
         cv_.notify_one();
         lck.unlock();
         buffer_thread_handler_.join();
@@ -875,6 +961,8 @@ int32_t SoundTriggerEngineCapi::StopSoundEngine()
         std::lock_guard<std::mutex> lck(event_mutex_);
         exit_thread_ = true;
         exit_buffering_ = true;
+        if (reader_)
+            reader_->wakeUp();
 
         cv_.notify_one();
     }
@@ -227,11 +227,14 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
 
     std::memset(&buf, 0, sizeof(struct pal_buffer));
     buf.size = input_buf_size * input_buf_num;
-    buf.buffer = (uint8_t *)calloc(1, buf.size);
-    if (!buf.buffer) {
-        PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
-        status = -ENOMEM;
-        goto exit;
+    /* mmap data is copied from shared buffer to ring buffer directly */
+    if (mmap_buffer_size_ == 0) {
+        buf.buffer = (uint8_t *)calloc(1, buf.size);
+        if (!buf.buffer) {
+            PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
+            status = -ENOMEM;
+            goto exit;
+        }
     }
 
     if (!IS_MODULE_TYPE_PDK(module_type_)) {
@@ -311,35 +314,21 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
                 goto exit;
             }
 
-            if (size_to_read != buf.size) {
-                buf.buffer = (uint8_t *)realloc(buf.buffer, size_to_read);
-                if (!buf.buffer) {
-                    PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
-                    status = -ENOMEM;
-                    goto exit;
-                }
-                buf.size = size_to_read;
-            }
-
-            // TODO: directly write to PalRingBuffer with shared buffer pointer
-            if (read_offset + size_to_read <= mmap_buffer_size_) {
-                ar_mem_cpy(buf.buffer, size_to_read,
-                    (uint8_t *)mmap_buffer_.buffer + read_offset,
-                    size_to_read);
-                read_offset += size_to_read;
-            } else {
-                ar_mem_cpy(buf.buffer, mmap_buffer_size_ - read_offset,
-                    (uint8_t *)mmap_buffer_.buffer + read_offset,
-                    mmap_buffer_size_ - read_offset);
-                ar_mem_cpy(buf.buffer + mmap_buffer_size_ - read_offset,
-                    size_to_read + read_offset - mmap_buffer_size_,
-                    (uint8_t *)mmap_buffer_.buffer,
-                    size_to_read + read_offset - mmap_buffer_size_);
-                read_offset = size_to_read + read_offset - mmap_buffer_size_;
-            }
             size = size_to_read;
             PAL_VERBOSE(LOG_TAG, "read %d bytes from shared buffer", size);
             total_read_size += size;
+
+            // write data from shared buffer to ring buffer
+            if (bytes_to_drop >= size_to_read) {
+                bytes_to_drop -= size_to_read;
+            } else {
+                size_t ret = WriteMmapDataToRingBuffer(
+                    (read_offset + bytes_to_drop) % mmap_buffer_size_,
+                    size_to_read - bytes_to_drop, dsp_output_fd);
+                bytes_to_drop = 0;
+                PAL_VERBOSE(LOG_TAG, "%zu written to ring buffer", ret);
+            }
+            read_offset = (read_offset + size_to_read) % mmap_buffer_size_;
         } else if (buffer_->getFreeSize() >= buf.size) {
             if (total_read_size < ftrt_size &&
                 ftrt_size - total_read_size < buf.size) {
@@ -356,8 +345,8 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
             total_read_size += size;
         }
         ATRACE_ASYNC_END("stEngine: lab read", (int32_t)module_type_);
-        // write data to ring buffer
-        if (size) {
+        // write data to ring buffer, shared buffer data is written above
+        if (mmap_buffer_size_ == 0 && size) {
             size_t ret = 0;
             if (bytes_to_drop) {
                 if (size < bytes_to_drop) {
@@ -455,6 +444,39 @@ exit:
     return status;
 }
 
+/*
+ * Copy data from the DSP shared buffer straight into ring buffer storage,
+ * both sides may wrap so the copy is split at either buffer end.
+ */
+size_t SoundTriggerEngineGsl::WriteMmapDataToRingBuffer(size_t offset,
+    size_t size, FILE *dump_fd) {
+    pal_ring_buffer_span spans[2];
+    size_t reserved = 0;
+    size_t span_offset = 0;
+    size_t chunk = 0;
+    uint8_t *src = nullptr;
+
+    reserved = buffer_->reserve(size, spans);
+    if (reserved < size)
+        PAL_DBG(LOG_TAG, "ring buffer full, drop %zu bytes", size - reserved);
+
+    for (int i = 0; i < 2; i++) {
+        span_offset = 0;
+        while (span_offset < spans[i].size) {
+            chunk = std::min(spans[i].size - span_offset,
+                mmap_buffer_size_ - offset);
+            src = (uint8_t *)mmap_buffer_.buffer + offset;
+            ar_mem_cpy(spans[i].buffer + span_offset, chunk, src, chunk);
+            ST_DBG_FILE_WRITE(dump_fd, src, chunk);
+            span_offset += chunk;
+            offset = (offset + chunk) % mmap_buffer_size_;
+        }
+    }
+    buffer_->commit(reserved);
+
+    return reserved;
+}
+
 int32_t SoundTriggerEngineGsl::ParseDetectionPayloadPDK(void *event_data) {
     int32_t status = 0;
     uint32_t payload_size = 0;
@@ -39,13 +39,17 @@
 #include <math.h>
 #include <memory>
 #include <mutex>
+#include <atomic>
 #include <exception>
 #include <semaphore.h>
 #include <errno.h>
+#include <chrono>
 #ifdef LINUX_ENABLED
 #include <condition_variable>
 #endif
 #include "PalCommon.h"
+#include "StreamVirtualClock.h"
+#include "StreamLatencyStats.h"
 
 typedef enum {
     DATA_MODE_SHMEM = 0,
@@ -167,17 +171,30 @@ protected:
     static std::mutex pauseMutex;
     bool mutexLockedbyRm = false;
     sem_t mInUse;
+    StreamVirtualClock mVirtualClock;
+    StreamLatencyStats mLatencyStats;
     int connectToDefaultDevice(Stream* streamHandle, uint32_t dir);
 public:
     virtual ~Stream() {};
     struct pal_volume_data* mVolumeData = NULL;
-    pal_stream_callback streamCb;
-    uint64_t cookie;
+    pal_stream_callback streamCb = NULL;
+    uint64_t cookie = 0;
+    /* public handle given to the client, see StreamHandleTable */
+    pal_stream_handle_t *mHandle = NULL;
+    pal_stream_handle_t *getHandle() { return mHandle; }
+    void setHandle(pal_stream_handle_t *handle) { mHandle = handle; }
+    /* pal_stream_*_async operations queued or running on the executor */
+    std::atomic<uint32_t> mAsyncPending{0};
     bool isPaused = false;
     bool a2dpMuted = false;
     bool a2dpPaused = false;
     bool force_nlpi_vote = false;
     std::vector<pal_device_id_t> suspendedDevIds;
+    /* StreamPool bookkeeping */
+    bool mPoolable = true;
+    bool mFromPool = false;
+    bool mFirstWritePending = false;
+    std::chrono::steady_clock::time_point mOpenTime;
     virtual int32_t open() = 0;
     virtual int32_t close() = 0;
     virtual int32_t start() = 0;
@@ -244,6 +261,7 @@ public:
     int connectStreamDevice(Stream* streamHandle, struct pal_device *dattr);
     int connectStreamDevice_l(Stream* streamHandle, struct pal_device *dattr);
     int switchDevice(Stream* streamHandle, uint32_t no_of_devices, struct pal_device *deviceArray);
+    bool waitForA2dpReady(uint32_t no_of_devices, struct pal_device *deviceArray);
     bool isGKVMatch(pal_key_vector_t* gkv);
     int32_t getEffectParameters(void *effect_query, size_t *payload_size);
     uint32_t getInstanceId() { return mInstanceID; }
@@ -257,6 +275,7 @@ public:
     int32_t getEffectParameters(void *effect_query);
     int32_t rwACDBParameters(void *payload, uint32_t sampleRate,
                                 bool isParamWrite);
+    int32_t getLatencyStatsParam(void *payload);
     stream_state_t getCurState() { return currentState; }
     bool isActive() { return currentState == STREAM_STARTED; }
     bool isAlive() { return currentState != STREAM_IDLE; }
@@ -282,6 +301,8 @@ public:
     };
     bool isMutexLockedbyRm() { return mutexLockedbyRm; }
     void setCachedState(stream_state_t state);
+    void resetVirtualClock() { mVirtualClock.reset(); }
+    StreamLatencyStats *getLatencyStats() { return &mLatencyStats; }
 };
 
 class StreamNonTunnel : public Stream
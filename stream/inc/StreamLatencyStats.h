@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef STREAM_LATENCY_STATS_H
+#define STREAM_LATENCY_STATS_H
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+#include "PalDefs.h"
+
+/*
+ * Log2 bucketed duration histogram with a single writer.
+ *
+ * Samples are recorded with relaxed loads and stores instead of atomic
+ * read-modify-writes, which keeps a sample to a few nanoseconds; callers
+ * must serialize record() themselves. Readers may run at any time and see
+ * a sample half recorded.
+ */
+class StreamLatencyHistogram
+{
+public:
+    void record(uint64_t ns)
+    {
+        uint32_t i = ns ? 64 - __builtin_clzll(ns) : 0;
+
+        if (i >= PAL_LATENCY_HIST_BUCKETS)
+            i = PAL_LATENCY_HIST_BUCKETS - 1;
+        add(mCount, 1);
+        add(mTotalNs, ns);
+        mBuckets[i].store(mBuckets[i].load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+        if (ns > mMaxNs.load(std::memory_order_relaxed))
+            mMaxNs.store(ns, std::memory_order_relaxed);
+    }
+    void snapshot(struct pal_latency_histogram *hist) const;
+    void reset();
+
+private:
+    static void add(std::atomic<uint64_t> &v, uint64_t n)
+    {
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> mCount{0};
+    std::atomic<uint64_t> mTotalNs{0};
+    std::atomic<uint64_t> mMaxNs{0};
+    std::atomic<uint32_t> mBuckets[PAL_LATENCY_HIST_BUCKETS] = {};
+};
+
+/*
+ * Where pal_stream_write/pal_stream_read spend their time, reported through
+ * PAL_PARAM_ID_STREAM_LATENCY_STATS. The histograms are recorded with the
+ * stream mutex held, the counters may be bumped from anywhere.
+ */
+class StreamLatencyStats
+{
+public:
+    StreamLatencyHistogram lockWait;
+    StreamLatencyHistogram session;
+    StreamLatencyHistogram kernel;
+    std::atomic<uint64_t> xruns{0};
+    std::atomic<uint64_t> shortTransfers{0};
+    std::atomic<uint64_t> droppedBuffers{0};
+
+    static uint64_t now()
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+    /* a pcm write/read to the driver that started at beginNs */
+    void recordKernel(uint64_t beginNs, int status);
+    void snapshot(struct pal_stream_latency_stats *stats) const;
+    void reset();
+};
+
+#endif /* STREAM_LATENCY_STATS_H */
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef STREAM_POOL_H
+#define STREAM_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "PalDefs.h"
+
+class Stream;
+struct stream_pool_info;
+
+/*
+ * Pool of opened but idle playback streams.
+ *
+ * Closing a stream of a pooled type parks it here stopped instead of tearing
+ * down its graph, and pal_stream_open hands a parked stream back to a client
+ * asking for the same type, format and devices, so only pcm start is left to
+ * do before the first write. The new owner gets a new handle; parking retires
+ * the old one, so a late call through it fails instead of reaching the stream.
+ * Streams listed as prewarm entries are opened ahead of the first request.
+ * Everything is configured by the config_stream_pool node of the resource
+ * manager xml and the pool is disabled when it is absent.
+ *
+ * Parked streams hold their graph and device open, so they are dropped after
+ * the idle timeout, when the screen turns off, on device connection changes
+ * and when the sound card goes offline. Teardown runs on the pool thread,
+ * except for reclaim(), which closes them on the caller's thread when an open
+ * runs out of front ends.
+ *
+ * They deliberately stay registered on the resource manager's active stream
+ * lists. Their devices stay enabled, so the device switch paths, which walk
+ * getActiveStream_l(), have to move their graphs along with everyone else's,
+ * or a claim would resume on a stale device; and the device config and
+ * concurrency decisions taken from those lists have to account for a device
+ * that is still in use. Checks that care about playback test the stream
+ * state, and a parked stream is never STREAM_STARTED.
+ */
+class StreamPool
+{
+public:
+    static void init();
+    static void deinit();
+    static Stream* claim(struct pal_stream_attributes *sattr, struct pal_device *devices,
+                         uint32_t noOfDevices, uint32_t noOfModifiers);
+    static int park(Stream *s);
+    static void evictAll(const char *reason);
+    static size_t reclaim();
+    static void evictDevice(pal_device_id_t id);
+    static void requestPrewarm();
+    static void markOpened(Stream *s, bool pooled);
+    static void recordFirstWrite(Stream *s);
+    static void dump();
+
+private:
+    struct streamPoolEntry {
+        Stream *s;
+        std::chrono::steady_clock::time_point parkedAt;
+    };
+    struct firstWriteStats {
+        uint64_t count;
+        uint64_t sumUs;
+        uint64_t maxUs;
+    };
+
+    static bool isPoolableType(uint32_t type);
+    static bool isMatch(Stream *s, struct pal_stream_attributes *sattr,
+                        struct pal_device *devices, uint32_t noOfDevices);
+    static void prewarm();
+    static void destroy(Stream *s);
+    static void evictExpired_l(std::chrono::steady_clock::time_point now);
+    static void threadLoop();
+
+    static std::mutex mMutex;
+    static std::condition_variable mCV;
+    static std::thread mThread;
+    static bool mEnabled;
+    static bool mExit;
+    static bool mPrewarmPending;
+    static size_t mDestroying;
+    static struct stream_pool_info mInfo;
+    /* most recently parked first */
+    static std::list<streamPoolEntry> mIdle;
+    static std::vector<Stream *> mDoomed;
+    static uint64_t mClaims;
+    static uint64_t mMisses;
+    static struct firstWriteStats mPooledStats;
+    static struct firstWriteStats mFreshStats;
+};
+
+#endif //STREAM_POOL_H
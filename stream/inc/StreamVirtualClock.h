@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef STREAM_VIRTUAL_CLOCK_H
+#define STREAM_VIRTUAL_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include "PalDefs.h"
+
+/*
+ * Stand-in for the DSP clock while a stream cannot reach its session, i.e.
+ * when the sound card is offline or the stream has no device.
+ *
+ * Buffers handed to consume() are played out against the monotonic clock.
+ * The caller gets the time its buffer is due and waits for it after dropping
+ * the stream lock, so control calls are not held off for a buffer duration.
+ * getTimestamp() reports the played position, continuing from what was last
+ * reported by the session. Once the session is written again handOver()
+ * stops the clock and the session time is offset by adjust() so that the
+ * reported position carries on from the virtual one instead of jumping back
+ * to zero after SSR.
+ */
+class StreamVirtualClock
+{
+public:
+    std::chrono::steady_clock::time_point consume(uint32_t bytes, uint32_t frameSize,
+                                                  uint32_t sampleRate);
+    bool isRunning() const { return mRunning; }
+    void handOver();
+    void getTimestamp(struct pal_session_time *stime);
+    void adjust(struct pal_session_time *stime);
+    void reset();
+
+private:
+    uint64_t positionUs_l(std::chrono::steady_clock::time_point now);
+    static uint64_t toUs(const struct pal_time_us &t);
+    static void fromUs(struct pal_time_us &t, uint64_t us);
+
+    std::mutex mMutex;
+    std::atomic<bool> mRunning{false};
+    std::chrono::steady_clock::time_point mStart;
+    uint64_t mBaseUs = 0;        /* position when mStart was anchored */
+    uint64_t mQueuedUs = 0;      /* audio consumed since mStart */
+    uint64_t mLastUs = 0;        /* last session time reported */
+    int64_t mOffsetUs = 0;       /* added to the session time */
+    bool mRebasePending = false;
+    uint64_t mRebaseUs = 0;      /* virtual position at hand over */
+};
+
+#endif //STREAM_VIRTUAL_CLOCK_H
@@ -185,7 +185,7 @@ Stream* Stream::create(struct pal_stream_attributes *sAttr, struct pal_device *d
                goto exit;
             }
             // check if it's grouped device and group config needs to update
-            rm->lockActiveStream();
+            rm->lockActiveStream(PAL_LOCK_SITE);
             status = rm->checkAndUpdateGroupDevConfig((struct pal_device *)&palDevsAttr[count], sAttr,
                                                     streamsToSwitch, &streamDevAttr, true);
             rm->unlockActiveStream();
@@ -386,6 +386,20 @@ int32_t Stream::getEffectParameters(void *effect_query)
     return status;
 }
 
+int32_t Stream::getLatencyStatsParam(void *payload)
+{
+    pal_param_payload *pal_payload = (pal_param_payload *)payload;
+
+    if (!pal_payload ||
+        pal_payload->payload_size != sizeof(struct pal_stream_latency_stats)) {
+        PAL_ERR(LOG_TAG, "Invalid latency stats payload");
+        return -EINVAL;
+    }
+    mLatencyStats.snapshot((struct pal_stream_latency_stats *)pal_payload->payload);
+
+    return 0;
+}
+
 int32_t Stream::rwACDBParameters(void *payload, uint32_t sampleRate,
                                     bool isParamWrite)
 {
@@ -801,14 +815,20 @@ int32_t Stream::getTimestamp(struct pal_session_time *stime)
         PAL_ERR(LOG_TAG, "Invalid session time pointer, status %d", status);
         goto exit;
     }
+    /* buffers are being dropped against the virtual clock, report its position */
+    if (mVirtualClock.isRunning()) {
+        mVirtualClock.getTimestamp(stime);
+        goto exit;
+    }
     if (rm->cardState == CARD_STATUS_OFFLINE) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Sound card offline, status %d", status);
         goto exit;
     }
-    rm->lockResourceManagerMutex();
+    /* only keeps devices from being torn down, timestamps run in parallel */
+    rm->lockResourceManagerMutexShared(PAL_LOCK_SITE);
     status = session->getTimestamp(stime);
-    rm->unlockResourceManagerMutex();
+    rm->unlockResourceManagerMutexShared();
     if (0 != status) {
         PAL_ERR(LOG_TAG, "Failed to get session timestamp status %d", status);
         if (errno == -ENETRESET &&
@@ -817,6 +837,8 @@ int32_t Stream::getTimestamp(struct pal_session_time *stime)
             rm->ssrHandler(CARD_STATUS_OFFLINE);
             status = -EINVAL;
         }
+    } else {
+        mVirtualClock.adjust(stime);
     }
 exit:
     return status;
@@ -1257,6 +1279,53 @@ case 7
     same as case 4.
 
 */
+/*
+ * A2DP can take up to two seconds to become ready after it is connected.
+ * Poll for it before switchDevice takes the active stream lock, so other
+ * streams can start, stop and route meanwhile. Returns true when it polled,
+ * switchDevice then checks readiness only once.
+ */
+bool Stream::waitForA2dpReady(uint32_t numDev, struct pal_device *newDevices)
+{
+    uint32_t retryCnt = 20;
+    uint32_t retryPeriodMs = 100;
+    pal_param_bta2dp_t *param_bt_a2dp = nullptr;
+    std::shared_ptr<Device> dev = nullptr;
+    struct pal_device *a2dpDev = NULL;
+    bool isCurDeviceA2dp = false;
+
+    for (int i = 0; i < numDev && newDevices; i++) {
+        if (newDevices[i].id == PAL_DEVICE_OUT_BLUETOOTH_A2DP)
+            a2dpDev = &newDevices[i];
+    }
+    if (!a2dpDev || rm->cardState == CARD_STATUS_OFFLINE)
+        return false;
+
+    /* switchDevice does not wait when the stream is already on A2DP */
+    mStreamMutex.lock();
+    for (int i = 0; i < mDevices.size(); i++) {
+        if (mDevices[i]->getSndDeviceId() == PAL_DEVICE_OUT_BLUETOOTH_A2DP)
+            isCurDeviceA2dp = true;
+    }
+    mStreamMutex.unlock();
+    if (isCurDeviceA2dp)
+        return false;
+
+    dev = Device::getInstance(a2dpDev, rm);
+    if (!dev)
+        return false;
+    dev->getDeviceParameter(PAL_PARAM_ID_BT_A2DP_SUSPENDED, (void **)&param_bt_a2dp);
+    if (!param_bt_a2dp || param_bt_a2dp->a2dp_suspended)
+        return false;
+
+    while (!rm->isDeviceReady(a2dpDev->id) && --retryCnt)
+        usleep(retryPeriodMs * 1000);
+
+    PAL_DBG(LOG_TAG, "a2dp %s after %u ms", retryCnt ? "ready" : "not ready",
+            (20 - retryCnt) * retryPeriodMs);
+    return true;
+}
+
 int32_t Stream::switchDevice(Stream* streamHandle, uint32_t numDev, struct pal_device *newDevices)
 {
     int32_t status = 0;
@@ -1285,8 +1354,9 @@ int32_t Stream::switchDevice(Stream* streamHandle, uint32_t numDev, struct pal_d
     struct pal_volume_data *volume = NULL;
     pal_device_id_t newBtDevId;
     bool isBtReady = false;
+    bool a2dpPolled = waitForA2dpReady(numDev, newDevices);
 
-    rm->lockActiveStream();
+    rm->lockActiveStream(PAL_LOCK_SITE);
     mStreamMutex.lock();
 
     if ((numDev == 0) || (numDev > PAL_DEVICE_IN_MAX) || (!newDevices) || (!streamHandle)) {
@@ -1413,7 +1483,7 @@ int32_t Stream::switchDevice(Stream* streamHandle, uint32_t numDev, struct pal_d
                     if (devReadyStatus) {
                         isBtReady = true;
                         break;
-                    } else if (isCurDeviceA2dp) {
+                    } else if (isCurDeviceA2dp || a2dpPolled) {
                         break;
                     }
 
@@ -1776,7 +1846,7 @@ bool Stream::checkStreamMatch(pal_device_id_t pal_device_id,
 
 int Stream::initStreamSmph()
 {
-    return sem_init(&mInUse, 0, 1);
+    return sem_init(&mInUse, 0, 0);
 }
 
 int Stream::deinitStreamSmph()
@@ -552,7 +552,7 @@ notify:
          *  Unlock it before calling callback */
         notificationInProgress = true;
         mutex_.unlock();
-        callback_((pal_stream_handle_t *)this, 0, ev_payload, event_size, cookie_);
+        callback_(getHandle(), 0, ev_payload, event_size, cookie_);
         free(ev_payload);
         ev_payload = NULL;
         mutex_.lock();
@@ -294,7 +294,7 @@ int32_t StreamCommon::start()
          */
         currentState = STREAM_STARTED;
         mStreamMutex.unlock();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         mStreamMutex.lock();
         for (int i = 0; i < mDevices.size(); i++) {
             rm->registerDevice(mDevices[i], this);
@@ -374,7 +374,7 @@ int32_t StreamCommon::stop()
 
     if (currentState == STREAM_STARTED || currentState == STREAM_PAUSED) {
         mStreamMutex.unlock();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         mStreamMutex.lock();
         currentState = STREAM_STOPPED;
         for (int i = 0; i < mDevices.size(); i++) {
@@ -528,7 +528,7 @@ int32_t StreamCommon::ssrDownHandler()
         mStreamMutex.unlock();
         rm->unlockActiveStream();
         status = stop();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         if (0 != status)
             PAL_ERR(LOG_TAG, "Error:stream stop failed. status %d",  status);
         status = close();
@@ -577,7 +577,7 @@ int32_t StreamCommon::ssrUpHandler()
          }
          rm->unlockActiveStream();
          status = start();
-         rm->lockActiveStream();
+         rm->lockActiveStream(PAL_LOCK_SITE);
          if (0 != status) {
              PAL_ERR(LOG_TAG, "Error:stream start failed. status %d", status);
              goto exit;
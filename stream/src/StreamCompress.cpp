@@ -57,7 +57,7 @@ static void handleSessionCallBack(uint64_t hdl, uint32_t event_id, void *data,
     else {
         s = reinterpret_cast<Stream *>(hdl);
         if (s->getCallBack(&cb) == 0)
-            cb(reinterpret_cast<pal_stream_handle_t *>(s), event_id, (uint32_t *)data,
+            cb(s->getHandle(), event_id, (uint32_t *)data,
                event_size, s->cookie);
     }
 }
@@ -298,7 +298,7 @@ int32_t StreamCompress::stop()
                 currentState, session, mStreamAttr->direction);
     if (currentState == STREAM_STARTED || currentState == STREAM_PAUSED) {
         mStreamMutex.unlock();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         mStreamMutex.lock();
         currentState = STREAM_STOPPED;
         for (int i = 0; i < mDevices.size(); i++) {
@@ -590,11 +590,13 @@ int32_t StreamCompress::read(struct pal_buffer *buf)
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto err;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto err;
             } else {
@@ -652,7 +654,7 @@ int32_t StreamCompress::write(struct pal_buffer *buf)
             currentState = STREAM_STARTED;
             // register device only after graph is actually started
             mStreamMutex.unlock();
-            rm->lockActiveStream();
+            rm->lockActiveStream(PAL_LOCK_SITE);
             mStreamMutex.lock();
             for (int i = 0; i < mDevices.size(); i++) {
                 rm->registerDevice(mDevices[i], this);
@@ -1062,7 +1064,7 @@ int32_t StreamCompress::ssrDownHandler()
         mStreamMutex.unlock();
         rm->unlockActiveStream();
         status = stop();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         if (status)
             PAL_ERR(LOG_TAG, "stream stop failed. status %d",  status);
         status = close();
@@ -37,6 +37,7 @@
 #include "ResourceManager.h"
 #include "Device.h"
 #include <unistd.h>
+#include <thread>
 
 StreamInCall::StreamInCall(const struct pal_stream_attributes *sattr, struct pal_device *dattr,
                     const uint32_t no_of_devices, const struct modifier_kv *modifiers,
@@ -481,6 +482,7 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
 {
     int32_t status = 0;
     int32_t size;
+    std::chrono::steady_clock::time_point due;
     PAL_VERBOSE(LOG_TAG, "Enter. session handle - %pK, state %d",
             session, currentState);
 
@@ -501,10 +503,12 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
         }
         size = buf->size;
         memset(buf->buffer, 0, size);
-        usleep((uint64_t)size * 1000000 / streamSize / sampleRate);
+        due = mVirtualClock.consume(size, streamSize, sampleRate);
+        mLatencyStats.droppedBuffers++;
         PAL_DBG(LOG_TAG, "Sound card offline, dropped buffer size - %d", size);
-        status = size;
-        goto exit;
+        mStreamMutex.unlock();
+        std::this_thread::sleep_until(due);
+        return size;
     }
 
     if (currentState == STREAM_STARTED) {
@@ -517,11 +521,13 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else {
@@ -534,6 +540,7 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
         status = -EINVAL;
         goto exit;
     }
+    mVirtualClock.handOver();
     mStreamMutex.unlock();
     PAL_VERBOSE(LOG_TAG, "Exit. session read successful size - %d", size);
     return size;
@@ -551,6 +558,7 @@ int32_t  StreamInCall::write(struct pal_buffer* buf)
     uint32_t byteWidth = 0;
     uint32_t sampleRate = 0;
     uint32_t channelCount = 0;
+    std::chrono::steady_clock::time_point due;
 
     PAL_VERBOSE(LOG_TAG, "Enter. session handle - %pK, state %d",
             session, currentState);
@@ -570,15 +578,20 @@ int32_t  StreamInCall::write(struct pal_buffer* buf)
             return -EINVAL;
         }
         size = buf->size;
-        usleep((uint64_t)size * 1000000 / frameSize / sampleRate);
+        due = mVirtualClock.consume(size, frameSize, sampleRate);
+        mLatencyStats.droppedBuffers++;
         PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
         mStreamMutex.unlock();
+        /* pace the client without holding off control calls on the stream */
+        std::this_thread::sleep_until(due);
         PAL_VERBOSE(LOG_TAG, "Exit size: %d", size);
         return size;
     }
 
     if (currentState == STREAM_STARTED) {
         status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        if (0 == status)
+            mVirtualClock.handOver();
         mStreamMutex.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session write is failed with status %d", status);
@@ -590,11 +603,13 @@ int32_t  StreamInCall::write(struct pal_buffer* buf)
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else {
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include "StreamLatencyStats.h"
+
+void StreamLatencyHistogram::snapshot(struct pal_latency_histogram *hist) const
+{
+    hist->count = mCount.load(std::memory_order_relaxed);
+    hist->total_ns = mTotalNs.load(std::memory_order_relaxed);
+    hist->max_ns = mMaxNs.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < PAL_LATENCY_HIST_BUCKETS; i++)
+        hist->buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+}
+
+void StreamLatencyHistogram::reset()
+{
+    mCount.store(0, std::memory_order_relaxed);
+    mTotalNs.store(0, std::memory_order_relaxed);
+    mMaxNs.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < PAL_LATENCY_HIST_BUCKETS; i++)
+        mBuckets[i].store(0, std::memory_order_relaxed);
+}
+
+void StreamLatencyStats::recordKernel(uint64_t beginNs, int status)
+{
+    kernel.record(now() - beginNs);
+    /* tinyalsa returns -EPIPE or -1 with errno set depending on the version */
+    if (status == -EPIPE || (status < 0 && errno == EPIPE))
+        xruns++;
+}
+
+void StreamLatencyStats::snapshot(struct pal_stream_latency_stats *stats) const
+{
+    lockWait.snapshot(&stats->lock_wait);
+    session.snapshot(&stats->session);
+    kernel.snapshot(&stats->kernel);
+    stats->xruns = xruns.load(std::memory_order_relaxed);
+    stats->short_transfers = shortTransfers.load(std::memory_order_relaxed);
+    stats->dropped_buffers = droppedBuffers.load(std::memory_order_relaxed);
+}
+
+void StreamLatencyStats::reset()
+{
+    lockWait.reset();
+    session.reset();
+    kernel.reset();
+    xruns.store(0, std::memory_order_relaxed);
+    shortTransfers.store(0, std::memory_order_relaxed);
+    droppedBuffers.store(0, std::memory_order_relaxed);
+}
@@ -40,7 +40,7 @@ static void handleSessionCallBack(uint64_t hdl, uint32_t event_id, void *data,
     Stream *s = NULL;
     s = reinterpret_cast<Stream *>(hdl);
     if (s->streamCb)
-        s->streamCb(reinterpret_cast<pal_stream_handle_t *>(s), event_id, (uint32_t *)data,
+        s->streamCb(s->getHandle(), event_id, (uint32_t *)data,
           event_size, s->cookie);
 }
 
@@ -339,10 +339,12 @@ int32_t  StreamNonTunnel::read(struct pal_buffer* buf)
                 PAL_ERR(LOG_TAG, "Sound card offline, informing RM");
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
                 size = buf->size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
                 size = buf->size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else {
@@ -377,6 +379,7 @@ int32_t  StreamNonTunnel::write(struct pal_buffer* buf)
     if ((rm->cardState == CARD_STATUS_OFFLINE)
             || ssrInNTMode == true) {
         size = buf->size;
+        mLatencyStats.droppedBuffers++;
         PAL_DBG(LOG_TAG, "sound card offline dropped buffer size - %d", size);
         mStreamMutex.unlock();
         return -ENETRESET;
@@ -395,10 +398,12 @@ int32_t  StreamNonTunnel::write(struct pal_buffer* buf)
                 PAL_ERR(LOG_TAG, "Sound card offline, informing RM");
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
                 size = buf->size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
                 size = buf->size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else {
@@ -630,7 +635,7 @@ int32_t StreamNonTunnel::ssrDownHandler()
 
     ssrInNTMode = true;
     if (streamCb)
-        streamCb(reinterpret_cast<pal_stream_handle_t *>(this), PAL_STREAM_CBK_EVENT_ERROR, NULL, 0, this->cookie);
+        streamCb(getHandle(), PAL_STREAM_CBK_EVENT_ERROR, NULL, 0, this->cookie);
 
     mStreamMutex.unlock();
 
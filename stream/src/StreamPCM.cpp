@@ -36,6 +36,7 @@
 #include "ResourceManager.h"
 #include "Device.h"
 #include <unistd.h>
+#include <thread>
 #include <chrono>
 
 StreamPCM::StreamPCM(const struct pal_stream_attributes *sattr, struct pal_device *dattr,
@@ -490,7 +491,7 @@ int32_t StreamPCM::start()
             */
             rm->unlockGraph();
             mStreamMutex.unlock();
-            rm->lockActiveStream();
+            rm->lockActiveStream(PAL_LOCK_SITE);
             mStreamMutex.lock();
             rm->lockGraph();
 
@@ -591,7 +592,7 @@ int32_t StreamPCM::start()
          */
         if (mStreamAttr->direction != PAL_AUDIO_INPUT) {
             mStreamMutex.unlock();
-            rm->lockActiveStream();
+            rm->lockActiveStream(PAL_LOCK_SITE);
             mStreamMutex.lock();
         }
         for (int i = 0; i < mDevices.size(); i++) {
@@ -630,7 +631,7 @@ int32_t StreamPCM::stop()
 
     if (currentState == STREAM_STARTED || currentState == STREAM_PAUSED) {
         mStreamMutex.unlock();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         mStreamMutex.lock();
         currentState = STREAM_STOPPED;
         for (int i = 0; i < mDevices.size(); i++) {
@@ -865,10 +866,14 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
 {
     int32_t status = 0;
     int32_t size;
+    std::chrono::steady_clock::time_point due;
+    uint64_t beginNs;
     PAL_VERBOSE(LOG_TAG, "Enter. session handle - %pK, state %d",
             session, currentState);
 
+    beginNs = StreamLatencyStats::now();
     mStreamMutex.lock();
+    mLatencyStats.lockWait.record(StreamLatencyStats::now() - beginNs);
     if ((rm->cardState == CARD_STATUS_OFFLINE) || cachedState != STREAM_IDLE) {
        /* calculate sleep time based on buf->size, sleep and return buf->size */
         uint32_t streamSize;
@@ -885,14 +890,18 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
         }
         size = buf->size;
         memset(buf->buffer, 0, size);
-        usleep((uint64_t)size * 1000000 / streamSize / sampleRate);
+        due = mVirtualClock.consume(size, streamSize, sampleRate);
+        mLatencyStats.droppedBuffers++;
         PAL_DBG(LOG_TAG, "Sound card offline, dropped buffer size - %d", size);
-        status = size;
-        goto exit;
+        mStreamMutex.unlock();
+        std::this_thread::sleep_until(due);
+        return size;
     }
 
     if (currentState == STREAM_STARTED) {
+        beginNs = StreamLatencyStats::now();
         status = session->read(this, SHMEM_ENDPOINT, buf, &size);
+        mLatencyStats.session.record(StreamLatencyStats::now() - beginNs);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session read is failed with status %d", status);
             if (errno == -ENETRESET &&
@@ -901,11 +910,13 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else {
@@ -917,6 +928,9 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
         status = -EINVAL;
         goto exit;
     }
+    if ((uint32_t)size < buf->size)
+        mLatencyStats.shortTransfers++;
+    mVirtualClock.handOver();
     mStreamMutex.unlock();
     PAL_VERBOSE(LOG_TAG, "Exit. session read successful size - %d", size);
     return size;
@@ -934,11 +948,15 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
     uint32_t byteWidth = 0;
     uint32_t sampleRate = 0;
     uint32_t channelCount = 0;
+    std::chrono::steady_clock::time_point due;
+    uint64_t beginNs;
 
     PAL_VERBOSE(LOG_TAG, "Enter. session handle - %pK, state %d",
             session, currentState);
 
+    beginNs = StreamLatencyStats::now();
     mStreamMutex.lock();
+    mLatencyStats.lockWait.record(StreamLatencyStats::now() - beginNs);
     // If cached state is not STREAM_IDLE, we are still processing SSR up.
     if ((mDevices.size() == 0)
             || (rm->cardState == CARD_STATUS_OFFLINE)
@@ -955,9 +973,12 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
             goto exit;
         }
         size = buf->size;
-        usleep((uint64_t)size * 1000000 / frameSize / sampleRate);
+        due = mVirtualClock.consume(size, frameSize, sampleRate);
+        mLatencyStats.droppedBuffers++;
         PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
         mStreamMutex.unlock();
+        /* pace the client without holding off control calls on the stream */
+        std::this_thread::sleep_until(due);
         PAL_VERBOSE(LOG_TAG, "Exit size: %d", size);
         return size;
     }
@@ -965,7 +986,14 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
     // we should allow writes to go through in Start/Pause state as well.
     if ((currentState == STREAM_STARTED) ||
         (currentState == STREAM_PAUSED) ) {
+        beginNs = StreamLatencyStats::now();
         status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        mLatencyStats.session.record(StreamLatencyStats::now() - beginNs);
+        if (0 == status) {
+            mVirtualClock.handOver();
+            if ((uint32_t)size < buf->size)
+                mLatencyStats.shortTransfers++;
+        }
         mStreamMutex.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session write is failed with status %d", status);
@@ -977,18 +1005,20 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (rm->cardState == CARD_STATUS_OFFLINE) {
                 size = buf->size;
                 status = size;
+                mLatencyStats.droppedBuffers++;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else {
                 goto exit;
             }
         } else if (currentState == STREAM_PAUSED && !isPaused) {
-            rm->lockActiveStream();
+            rm->lockActiveStream(PAL_LOCK_SITE);
             mStreamMutex.lock();
             for (int i = 0; i < mDevices.size(); i++) {
                 rm->registerDevice(mDevices[i], this);
@@ -1435,7 +1465,7 @@ int32_t StreamPCM::ssrDownHandler()
         mStreamMutex.unlock();
         rm->unlockActiveStream();
         status = stop();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         if (0 != status)
             PAL_ERR(LOG_TAG, "stream stop failed. status %d",  status);
         status = close();
@@ -1479,7 +1509,7 @@ int32_t StreamPCM::ssrUpHandler()
         }
         rm->unlockActiveStream();
         status = start();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "stream start failed. status %d", status);
             goto exit;
@@ -1500,7 +1530,7 @@ int32_t StreamPCM::ssrUpHandler()
         }
         rm->unlockActiveStream();
         status = start();
-        rm->lockActiveStream();
+        rm->lockActiveStream(PAL_LOCK_SITE);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "stream start failed. status %d", status);
             goto exit;
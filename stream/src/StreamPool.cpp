@@ -0,0 +1,548 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: StreamPool"
+
+#include <algorithm>
+#include "StreamPool.h"
+#include "Stream.h"
+#include "Device.h"
+#include "ResourceManager.h"
+
+/* hard cap on the xml value, every parked stream holds a graph open */
+#define STREAM_POOL_MAX_STREAMS 4
+#define STREAM_POOL_DEFAULT_IDLE_TIMEOUT_MS 10000
+
+std::mutex StreamPool::mMutex;
+std::condition_variable StreamPool::mCV;
+std::thread StreamPool::mThread;
+bool StreamPool::mEnabled = false;
+bool StreamPool::mExit = false;
+bool StreamPool::mPrewarmPending = false;
+size_t StreamPool::mDestroying = 0;
+struct stream_pool_info StreamPool::mInfo;
+std::list<StreamPool::streamPoolEntry> StreamPool::mIdle;
+std::vector<Stream *> StreamPool::mDoomed;
+uint64_t StreamPool::mClaims = 0;
+uint64_t StreamPool::mMisses = 0;
+struct StreamPool::firstWriteStats StreamPool::mPooledStats = {};
+struct StreamPool::firstWriteStats StreamPool::mFreshStats = {};
+
+/* playback types served by StreamPCM, whose callbacks are no-ops */
+static bool isPcmPlaybackType(uint32_t type)
+{
+    switch (type) {
+    case PAL_STREAM_LOW_LATENCY:
+    case PAL_STREAM_DEEP_BUFFER:
+    case PAL_STREAM_ULTRA_LOW_LATENCY:
+    case PAL_STREAM_GENERIC:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void StreamPool::init()
+{
+    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    std::unique_lock<std::mutex> lock(mMutex);
+    struct stream_pool_info info;
+
+    if (mEnabled || !rm)
+        return;
+
+    rm->getStreamPoolInfo(&info);
+    mInfo = info;
+    mInfo.streams_.clear();
+    for (auto type : info.streams_) {
+        if (!isPcmPlaybackType(type)) {
+            PAL_ERR(LOG_TAG, "stream type %d can not be pooled", type);
+            continue;
+        }
+        mInfo.streams_.push_back(type);
+    }
+    if (mInfo.maxStreams > STREAM_POOL_MAX_STREAMS)
+        mInfo.maxStreams = STREAM_POOL_MAX_STREAMS;
+    if (!mInfo.idleTimeoutMs)
+        mInfo.idleTimeoutMs = STREAM_POOL_DEFAULT_IDLE_TIMEOUT_MS;
+
+    if (!mInfo.maxStreams || mInfo.streams_.empty()) {
+        PAL_DBG(LOG_TAG, "stream pool not configured");
+        return;
+    }
+
+    mEnabled = true;
+    mExit = false;
+    mPrewarmPending = !mInfo.prewarm_.empty();
+    mThread = std::thread(threadLoop);
+    PAL_INFO(LOG_TAG, "stream pool enabled, max %u streams, idle timeout %u ms, %zu prewarm",
+             mInfo.maxStreams, mInfo.idleTimeoutMs, mInfo.prewarm_.size());
+}
+
+void StreamPool::deinit()
+{
+    std::vector<Stream *> streams;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mEnabled)
+            return;
+        mEnabled = false;
+        mExit = true;
+    }
+    mCV.notify_all();
+    if (mThread.joinable())
+        mThread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto &entry : mIdle)
+            streams.push_back(entry.s);
+        streams.insert(streams.end(), mDoomed.begin(), mDoomed.end());
+        mIdle.clear();
+        mDoomed.clear();
+    }
+    for (auto s : streams)
+        destroy(s);
+
+    dump();
+}
+
+bool StreamPool::isPoolableType(uint32_t type)
+{
+    return std::find(mInfo.streams_.begin(), mInfo.streams_.end(), type) !=
+           mInfo.streams_.end();
+}
+
+bool StreamPool::isMatch(Stream *s, struct pal_stream_attributes *sattr,
+                         struct pal_device *devices, uint32_t noOfDevices)
+{
+    struct pal_stream_attributes attr;
+    struct pal_media_config *have = &attr.out_media_config;
+    struct pal_media_config *want = &sattr->out_media_config;
+    std::vector<std::shared_ptr<Device>> devs;
+    std::vector<struct pal_device> palDevs;
+
+    if (s->getStreamAttributes(&attr) != 0)
+        return false;
+
+    if (attr.type != sattr->type || attr.direction != sattr->direction ||
+        attr.flags != sattr->flags)
+        return false;
+
+    if (have->sample_rate != want->sample_rate || have->bit_width != want->bit_width ||
+        have->aud_fmt_id != want->aud_fmt_id ||
+        have->ch_info.channels != want->ch_info.channels ||
+        want->ch_info.channels > PAL_MAX_CHANNELS_SUPPORTED ||
+        memcmp(have->ch_info.ch_map, want->ch_info.ch_map, want->ch_info.channels))
+        return false;
+
+    /* current routing and the custom key the stream was opened with */
+    s->getAssociatedDevices(devs);
+    s->getAssociatedPalDevices(palDevs);
+    if (devs.size() != noOfDevices || palDevs.size() != noOfDevices)
+        return false;
+
+    for (uint32_t i = 0; i < noOfDevices; i++) {
+        if (devs[i]->getSndDeviceId() != devices[i].id || palDevs[i].id != devices[i].id ||
+            strncmp(palDevs[i].custom_config.custom_key,
+                    devices[i].custom_config.custom_key, PAL_MAX_CUSTOM_KEY_SIZE))
+            return false;
+    }
+
+    return true;
+}
+
+Stream* StreamPool::claim(struct pal_stream_attributes *sattr, struct pal_device *devices,
+                          uint32_t noOfDevices, uint32_t noOfModifiers)
+{
+    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    std::unique_lock<std::mutex> lock(mMutex);
+    stream_state_t state;
+    Stream *s = NULL;
+
+    if (!mEnabled || !sattr || !devices || !noOfDevices || noOfModifiers ||
+        sattr->direction != PAL_AUDIO_OUTPUT || sattr->flags ||
+        !isPoolableType(sattr->type))
+        return NULL;
+
+    for (auto it = mIdle.begin(); it != mIdle.end(); it++) {
+        if (isMatch(it->s, sattr, devices, noOfDevices)) {
+            s = it->s;
+            mIdle.erase(it);
+            break;
+        }
+    }
+
+    if (!s) {
+        mMisses++;
+        return NULL;
+    }
+
+    /* top the pool up again for the next request */
+    if (!mInfo.prewarm_.empty())
+        mPrewarmPending = true;
+    lock.unlock();
+    mCV.notify_all();
+
+    state = s->getCurState();
+    if (rm->cardState != CARD_STATUS_ONLINE ||
+        (state != STREAM_INIT && state != STREAM_STOPPED)) {
+        PAL_ERR(LOG_TAG, "parked stream %pK not reusable, state %d", s, state);
+        lock.lock();
+        mDoomed.push_back(s);
+        lock.unlock();
+        mCV.notify_all();
+        return NULL;
+    }
+
+    /* the previous owner's volume must not leak into the new one */
+    if (s->mVolumeData) {
+        s->mVolumeData->no_of_volpair = 1;
+        s->mVolumeData->volume_pair[0].channel_mask = 0x03;
+        s->mVolumeData->volume_pair[0].vol = 1.0f;
+    }
+
+    lock.lock();
+    mClaims++;
+    PAL_DBG(LOG_TAG, "claimed stream %pK state %d, claims %llu misses %llu", s, state,
+            (unsigned long long)mClaims, (unsigned long long)mMisses);
+    return s;
+}
+
+int StreamPool::park(Stream *s)
+{
+    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    struct pal_stream_attributes attr;
+    stream_state_t state;
+    int status = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mEnabled)
+            return -EINVAL;
+    }
+
+    if (!s->mPoolable || s->isPaused || s->a2dpMuted || !s->suspendedDevIds.empty() ||
+        rm->cardState != CARD_STATUS_ONLINE)
+        return -EINVAL;
+
+    if (s->getStreamAttributes(&attr) != 0 || attr.direction != PAL_AUDIO_OUTPUT ||
+        attr.flags || !isPoolableType(attr.type))
+        return -EINVAL;
+
+    state = s->getCurState();
+    if (state != STREAM_INIT && state != STREAM_STOPPED && state != STREAM_STARTED)
+        return -EINVAL;
+
+    if (rm->deactivateStreamUserCounter(s)) {
+        PAL_ERR(LOG_TAG, "stream is being closed by another client");
+        return -EBUSY;
+    }
+
+    if (s->getCurState() == STREAM_STARTED) {
+        s->setCachedState(STREAM_STOPPED);
+        status = s->stop();
+    }
+    s->mFirstWritePending = false;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (status || !mEnabled) {
+        PAL_ERR(LOG_TAG, "stream %pK not parked, status %d", s, status);
+        mDoomed.push_back(s);
+    } else {
+        if (mIdle.size() >= mInfo.maxStreams) {
+            mDoomed.push_back(mIdle.back().s);
+            mIdle.pop_back();
+        }
+        mIdle.push_front({s, std::chrono::steady_clock::now()});
+        PAL_DBG(LOG_TAG, "parked stream %pK type %d, %zu idle", s, attr.type, mIdle.size());
+    }
+    lock.unlock();
+    mCV.notify_all();
+
+    return 0;
+}
+
+void StreamPool::evictAll(const char *reason)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    mPrewarmPending = false;
+    if (mIdle.empty())
+        return;
+
+    PAL_INFO(LOG_TAG, "evicting %zu idle streams, %s", mIdle.size(), reason);
+    for (auto &entry : mIdle)
+        mDoomed.push_back(entry.s);
+    mIdle.clear();
+    lock.unlock();
+    mCV.notify_all();
+}
+
+/*
+ * Parked streams keep their front ends allocated. Close all of them, together
+ * with whatever the pool thread was tearing down, so that an open which ran
+ * out of front ends can retry. Returns the number of streams closed.
+ */
+size_t StreamPool::reclaim()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    std::vector<Stream *> streams;
+    size_t inFlight = mDestroying;
+
+    mPrewarmPending = false;
+    for (auto &entry : mIdle)
+        streams.push_back(entry.s);
+    streams.insert(streams.end(), mDoomed.begin(), mDoomed.end());
+    mIdle.clear();
+    mDoomed.clear();
+    /* front ends of streams the pool thread is closing come back when it is done */
+    mCV.wait(lock, [] { return !mDestroying; });
+    lock.unlock();
+
+    if (!streams.empty())
+        PAL_INFO(LOG_TAG, "reclaiming %zu pooled streams", streams.size());
+    for (auto s : streams)
+        destroy(s);
+
+    return streams.size() + inFlight;
+}
+
+void StreamPool::evictDevice(pal_device_id_t id)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    std::vector<std::shared_ptr<Device>> devs;
+    bool evicted = false;
+
+    for (auto it = mIdle.begin(); it != mIdle.end();) {
+        devs.clear();
+        it->s->getAssociatedDevices(devs);
+        if (std::none_of(devs.begin(), devs.end(),
+                [id](std::shared_ptr<Device> &dev) { return dev->getSndDeviceId() == id; })) {
+            it++;
+            continue;
+        }
+        PAL_DBG(LOG_TAG, "evicting stream %pK on device %d change", it->s, id);
+        mDoomed.push_back(it->s);
+        it = mIdle.erase(it);
+        evicted = true;
+    }
+    lock.unlock();
+    if (evicted)
+        mCV.notify_all();
+}
+
+void StreamPool::requestPrewarm()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (!mEnabled || mInfo.prewarm_.empty())
+        return;
+
+    mPrewarmPending = true;
+    lock.unlock();
+    mCV.notify_all();
+}
+
+void StreamPool::markOpened(Stream *s, bool pooled)
+{
+    struct pal_stream_attributes attr;
+
+    s->mFromPool = pooled;
+    s->mOpenTime = std::chrono::steady_clock::now();
+    /* a pooled stream starts over for its new owner */
+    s->getLatencyStats()->reset();
+    s->mFirstWritePending = s->getStreamAttributes(&attr) == 0 &&
+                            attr.direction == PAL_AUDIO_OUTPUT &&
+                            isPcmPlaybackType(attr.type);
+}
+
+void StreamPool::recordFirstWrite(Stream *s)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    struct firstWriteStats *stats = s->mFromPool ? &mPooledStats : &mFreshStats;
+    uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - s->mOpenTime).count();
+
+    s->mFirstWritePending = false;
+    stats->count++;
+    stats->sumUs += us;
+    stats->maxUs = std::max(stats->maxUs, us);
+    PAL_DBG(LOG_TAG, "stream %pK first write %llu us after open, %s", s,
+            (unsigned long long)us, s->mFromPool ? "pooled" : "fresh");
+}
+
+void StreamPool::dump()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    PAL_INFO(LOG_TAG, "claims %llu misses %llu, %zu idle", (unsigned long long)mClaims,
+             (unsigned long long)mMisses, mIdle.size());
+    PAL_INFO(LOG_TAG, "open to first write: pooled %llu avg %llu max %llu us,"
+             " fresh %llu avg %llu max %llu us",
+             (unsigned long long)mPooledStats.count,
+             (unsigned long long)(mPooledStats.count ?
+                                  mPooledStats.sumUs / mPooledStats.count : 0),
+             (unsigned long long)mPooledStats.maxUs,
+             (unsigned long long)mFreshStats.count,
+             (unsigned long long)(mFreshStats.count ?
+                                  mFreshStats.sumUs / mFreshStats.count : 0),
+             (unsigned long long)mFreshStats.maxUs);
+}
+
+void StreamPool::destroy(Stream *s)
+{
+    PAL_DBG(LOG_TAG, "closing stream %pK", s);
+    s->setCachedState(STREAM_IDLE);
+    if (s->close() != 0)
+        PAL_ERR(LOG_TAG, "stream %pK close failed", s);
+    delete s;
+}
+
+void StreamPool::prewarm()
+{
+    std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    struct pal_stream_attributes sattr;
+    struct pal_device dattr;
+    Stream *s = NULL;
+    bool found = false;
+
+    for (auto &pw : mInfo.prewarm_) {
+        if (!rm->getScreenState() || rm->cardState != CARD_STATUS_ONLINE)
+            return;
+        if (!isPoolableType(pw.type) || !rm->isDeviceAvailable(pw.device))
+            continue;
+
+        memset(&sattr, 0, sizeof(sattr));
+        memset(&dattr, 0, sizeof(dattr));
+        sattr.type = pw.type;
+        sattr.direction = PAL_AUDIO_OUTPUT;
+        sattr.out_media_config.sample_rate = pw.sampleRate;
+        sattr.out_media_config.bit_width = pw.bitWidth;
+        sattr.out_media_config.ch_info.channels = pw.channels;
+        rm->getChannelMap(sattr.out_media_config.ch_info.ch_map, pw.channels);
+        dattr.id = pw.device;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mExit || mIdle.size() >= mInfo.maxStreams)
+                return;
+            found = std::any_of(mIdle.begin(), mIdle.end(),
+                        [&](streamPoolEntry &entry) {
+                            return isMatch(entry.s, &sattr, &dattr, 1); });
+        }
+        if (found)
+            continue;
+
+        try {
+            sattr.out_media_config.aud_fmt_id = rm->getAudioFmt(pw.bitWidth);
+            s = Stream::create(&sattr, &dattr, 1, NULL, 0);
+        } catch (const std::exception& e) {
+            PAL_ERR(LOG_TAG, "prewarm stream create failed: %s", e.what());
+            continue;
+        }
+        if (!s)
+            continue;
+
+        if (s->open() != 0) {
+            PAL_ERR(LOG_TAG, "prewarm stream open failed, type %d device %d",
+                    pw.type, pw.device);
+            destroy(s);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        /* the screen may have turned off while the graph was opened */
+        if (mExit || mIdle.size() >= mInfo.maxStreams || !rm->getScreenState() ||
+            rm->cardState != CARD_STATUS_ONLINE) {
+            mDoomed.push_back(s);
+            return;
+        }
+        mIdle.push_front({s, std::chrono::steady_clock::now()});
+        PAL_INFO(LOG_TAG, "prewarmed stream %pK type %d device %d", s, pw.type, pw.device);
+    }
+}
+
+void StreamPool::evictExpired_l(std::chrono::steady_clock::time_point now)
+{
+    std::chrono::milliseconds timeout(mInfo.idleTimeoutMs);
+
+    while (!mIdle.empty() && now - mIdle.back().parkedAt >= timeout) {
+        PAL_DBG(LOG_TAG, "evicting stream %pK, idle timeout", mIdle.back().s);
+        mDoomed.push_back(mIdle.back().s);
+        mIdle.pop_back();
+    }
+}
+
+void StreamPool::threadLoop()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    std::chrono::milliseconds timeout(mInfo.idleTimeoutMs);
+    std::vector<Stream *> doomed;
+
+    PAL_DBG(LOG_TAG, "stream pool thread started");
+    while (!mExit) {
+        if (!mDoomed.empty()) {
+            doomed.swap(mDoomed);
+            mDestroying = doomed.size();
+            lock.unlock();
+            for (auto s : doomed)
+                destroy(s);
+            doomed.clear();
+            lock.lock();
+            mDestroying = 0;
+            mCV.notify_all();
+            continue;
+        }
+
+        if (mPrewarmPending) {
+            mPrewarmPending = false;
+            lock.unlock();
+            prewarm();
+            lock.lock();
+            continue;
+        }
+
+        evictExpired_l(std::chrono::steady_clock::now());
+        if (!mDoomed.empty())
+            continue;
+
+        if (mIdle.empty())
+            mCV.wait(lock);
+        else
+            mCV.wait_until(lock, mIdle.back().parkedAt + timeout);
+    }
+    PAL_DBG(LOG_TAG, "stream pool thread exit");
+}
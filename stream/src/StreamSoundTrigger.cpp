@@ -328,7 +328,7 @@ int32_t StreamSoundTrigger::start() {
      * Guard with mActiveStreamMutex to avoid concurrent
      * RX stream getting released during EC enable
      */
-    rm->lockActiveStream();
+    rm->lockActiveStream(PAL_LOCK_SITE);
     std::lock_guard<std::mutex> lck(mStreamMutex);
     // cache current state after mutex locked
     prev_state = currentState;
@@ -356,7 +356,7 @@ int32_t StreamSoundTrigger::stop() {
      * Guard with mActiveStreamMutex to avoid concurrent
      * RX stream getting released during EC disable
      */
-    rm->lockActiveStream();
+    rm->lockActiveStream(PAL_LOCK_SITE);
     std::lock_guard<std::mutex> lck(mStreamMutex);
     currentState = STREAM_STOPPED;
 
@@ -1913,7 +1913,7 @@ int32_t StreamSoundTrigger::notifyClient(bool detection) {
             " total processing time: %llums",
             (long long)total_process_duration);
         mStreamMutex.unlock();
-        callback_((pal_stream_handle_t *)this, 0, (uint32_t *)rec_event,
+        callback_(getHandle(), 0, (uint32_t *)rec_event,
                   event_size, cookie_);
 
         /*
@@ -101,7 +101,7 @@ void StreamUltraSound::HandleEvent(uint32_t event_id, void *data, uint32_t event
     if (callback_) {
         PAL_INFO(LOG_TAG, "Notify detection event to client");
         mStreamMutex.lock();
-        callback_((pal_stream_handle_t *)this, event_id, &event_type,
+        callback_(getHandle(), event_id, &event_type,
                   event_size, cookie_);
         mStreamMutex.unlock();
     }
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: StreamVirtualClock"
+
+#include <algorithm>
+#include "StreamVirtualClock.h"
+#include "PalCommon.h"
+
+uint64_t StreamVirtualClock::toUs(const struct pal_time_us &t)
+{
+    return ((uint64_t)t.value_msw << 32) | t.value_lsw;
+}
+
+void StreamVirtualClock::fromUs(struct pal_time_us &t, uint64_t us)
+{
+    t.value_lsw = (uint32_t)us;
+    t.value_msw = (uint32_t)(us >> 32);
+}
+
+uint64_t StreamVirtualClock::positionUs_l(std::chrono::steady_clock::time_point now)
+{
+    uint64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            now - mStart).count();
+
+    return mBaseUs + std::min(elapsedUs, mQueuedUs);
+}
+
+std::chrono::steady_clock::time_point StreamVirtualClock::consume(uint32_t bytes,
+        uint32_t frameSize, uint32_t sampleRate)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto now = std::chrono::steady_clock::now();
+    uint64_t elapsedUs = 0;
+    std::chrono::steady_clock::time_point due;
+
+    if (!mRunning) {
+        mBaseUs = mRebasePending ? std::max(mRebaseUs, mLastUs) : mLastUs;
+        mRebasePending = false;
+        mQueuedUs = 0;
+        mStart = now;
+        mRunning = true;
+        PAL_DBG(LOG_TAG, "virtual clock started at %llu us", (unsigned long long)mBaseUs);
+    }
+
+    elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - mStart).count();
+    if (elapsedUs > mQueuedUs) {
+        /* client fell behind, the clock does not run ahead of the data */
+        mBaseUs += mQueuedUs;
+        mQueuedUs = 0;
+        mStart = now;
+    }
+
+    /* the buffer starts playing once the ones before it are done */
+    due = mStart + std::chrono::microseconds(mQueuedUs);
+    mQueuedUs += (uint64_t)bytes * 1000000 / frameSize / sampleRate;
+    return due;
+}
+
+void StreamVirtualClock::handOver()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!mRunning)
+        return;
+    mRebaseUs = positionUs_l(std::chrono::steady_clock::now());
+    mRebasePending = true;
+    mRunning = false;
+    PAL_DBG(LOG_TAG, "virtual clock handed over at %llu us", (unsigned long long)mRebaseUs);
+}
+
+void StreamVirtualClock::getTimestamp(struct pal_session_time *stime)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto now = std::chrono::steady_clock::now();
+    uint64_t posUs = std::max(positionUs_l(now), mLastUs);
+
+    mLastUs = posUs;
+    fromUs(stime->session_time, posUs);
+    fromUs(stime->timestamp, posUs);
+    fromUs(stime->absolute_time,
+           std::chrono::duration_cast<std::chrono::microseconds>(
+               now.time_since_epoch()).count());
+}
+
+void StreamVirtualClock::adjust(struct pal_session_time *stime)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    uint64_t realUs = toUs(stime->session_time);
+    int64_t posUs = 0;
+
+    if (mRebasePending) {
+        mOffsetUs = (int64_t)mRebaseUs - (int64_t)realUs;
+        mRebasePending = false;
+        PAL_DBG(LOG_TAG, "session time offset %lld us", (long long)mOffsetUs);
+    }
+    if (!mOffsetUs) {
+        mLastUs = realUs;
+        return;
+    }
+
+    posUs = std::max((int64_t)realUs + mOffsetUs, (int64_t)mLastUs);
+    mLastUs = posUs;
+    fromUs(stime->session_time, posUs);
+    fromUs(stime->timestamp,
+           (uint64_t)std::max((int64_t)toUs(stime->timestamp) + mOffsetUs, (int64_t)0));
+}
+
+void StreamVirtualClock::reset()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mRunning = false;
+    mBaseUs = 0;
+    mQueuedUs = 0;
+    mLastUs = 0;
+    mOffsetUs = 0;
+    mRebasePending = false;
+    mRebaseUs = 0;
+}
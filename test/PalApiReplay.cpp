@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Replays a PAL API trace recorded with vendor.audio.pal.api_trace (see
+ * utils/inc/PalApiTrace.h) against the library, in process:
+ *
+ *   PalApiReplay [-s speed] [-v] trace.bin
+ *
+ * Calls are reissued from one thread in the order they were entered, with
+ * the recorded spacing divided by speed; -s 0 issues them back to back.
+ * Stream handles of the trace are mapped to the ones the replay opens.
+ * Nested calls, which PAL made itself, and pal_stream_start_async, whose
+ * start is recorded by the worker that ran it, are not reissued. At the end
+ * it prints per call how often it ran, how many statuses differ from the
+ * recording and the recorded and replayed time spent in it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+#include "PalApi.h"
+#include "PalCommon.h"
+#include "PalApiTrace.h"
+
+struct replayStats {
+    uint32_t runs = 0;
+    uint32_t mismatches = 0;
+    uint32_t skipped = 0;
+    uint64_t recordedNs = 0;
+    uint64_t replayedNs = 0;
+};
+
+static const char *callNames[PAL_API_TRACE_CALL_MAX] = {
+    "unknown",
+    "pal_stream_open",
+    "pal_stream_open_async",
+    "pal_stream_close",
+    "pal_stream_start",
+    "pal_stream_start_async",
+    "pal_stream_stop",
+    "pal_stream_pause",
+    "pal_stream_resume",
+    "pal_stream_flush",
+    "pal_stream_drain",
+    "pal_stream_suspend",
+    "pal_stream_set_device",
+    "pal_stream_set_param",
+    "pal_stream_set_volume",
+    "pal_stream_set_mute",
+    "pal_add_remove_effect",
+    "pal_set_param",
+};
+
+static bool verbose;
+
+static int32_t replayCallback(pal_stream_handle_t *stream_handle, uint32_t event_id,
+                              uint32_t * /*event_data*/, uint32_t event_data_size,
+                              uint64_t /*cookie*/)
+{
+    if (verbose)
+        printf("  event %u size %u on %p\n", event_id, event_data_size, stream_handle);
+    return 0;
+}
+
+static void *argData(PalApiTraceCall &call, uint32_t i)
+{
+    if (i >= call.args.size() || call.args[i].empty())
+        return NULL;
+    return call.args[i].data();
+}
+
+static uint32_t argCount(PalApiTraceCall &call, uint32_t i, size_t elemSize)
+{
+    if (i >= call.args.size())
+        return 0;
+    return call.args[i].size() / elemSize;
+}
+
+static uint64_t argValue(PalApiTraceCall &call, uint32_t i)
+{
+    uint64_t value = 0;
+
+    if (i < call.args.size() && call.args[i].size() == sizeof(value))
+        memcpy(&value, call.args[i].data(), sizeof(value));
+    return value;
+}
+
+static int32_t issueCall(PalApiTraceCall &call, pal_stream_handle_t *handle,
+                         pal_stream_handle_t **opened)
+{
+    struct pal_stream_attributes *attr = NULL;
+
+    switch (call.rec.call) {
+    case PAL_API_TRACE_STREAM_OPEN:
+    case PAL_API_TRACE_STREAM_OPEN_ASYNC:
+        attr = (struct pal_stream_attributes *)argData(call, 0);
+        if (!attr || call.args[0].size() != sizeof(*attr))
+            return -EINVAL;
+        if (call.rec.call == PAL_API_TRACE_STREAM_OPEN_ASYNC)
+            return pal_stream_open_async(attr,
+                    argCount(call, 1, sizeof(struct pal_device)),
+                    (struct pal_device *)argData(call, 1),
+                    argCount(call, 2, sizeof(struct modifier_kv)),
+                    (struct modifier_kv *)argData(call, 2),
+                    replayCallback, 0, opened);
+        return pal_stream_open(attr,
+                argCount(call, 1, sizeof(struct pal_device)),
+                (struct pal_device *)argData(call, 1),
+                argCount(call, 2, sizeof(struct modifier_kv)),
+                (struct modifier_kv *)argData(call, 2),
+                argValue(call, 3) ? replayCallback : NULL, 0, opened);
+    case PAL_API_TRACE_STREAM_CLOSE:
+        return pal_stream_close(handle);
+    case PAL_API_TRACE_STREAM_START:
+        return pal_stream_start(handle);
+    case PAL_API_TRACE_STREAM_STOP:
+        return pal_stream_stop(handle);
+    case PAL_API_TRACE_STREAM_PAUSE:
+        return pal_stream_pause(handle);
+    case PAL_API_TRACE_STREAM_RESUME:
+        return pal_stream_resume(handle);
+    case PAL_API_TRACE_STREAM_FLUSH:
+        return pal_stream_flush(handle);
+    case PAL_API_TRACE_STREAM_DRAIN:
+        return pal_stream_drain(handle, (pal_drain_type_t)argValue(call, 0));
+    case PAL_API_TRACE_STREAM_SUSPEND:
+        return pal_stream_suspend(handle);
+    case PAL_API_TRACE_STREAM_SET_DEVICE:
+        return pal_stream_set_device(handle, argCount(call, 0, sizeof(struct pal_device)),
+                                     (struct pal_device *)argData(call, 0));
+    case PAL_API_TRACE_STREAM_SET_PARAM:
+        return pal_stream_set_param(handle, argValue(call, 0),
+                                    (pal_param_payload *)argData(call, 1));
+    case PAL_API_TRACE_STREAM_SET_VOLUME:
+        return pal_stream_set_volume(handle, (struct pal_volume_data *)argData(call, 0));
+    case PAL_API_TRACE_STREAM_SET_MUTE:
+        return pal_stream_set_mute(handle, argValue(call, 0));
+    case PAL_API_TRACE_ADD_REMOVE_EFFECT:
+        return pal_add_remove_effect(handle, (pal_audio_effect_t)argValue(call, 0),
+                                     argValue(call, 1));
+    case PAL_API_TRACE_SET_PARAM:
+        return pal_set_param(argValue(call, 0), argData(call, 1),
+                             call.args.size() > 1 ? call.args[1].size() : 0);
+    default:
+        return -EINVAL;
+    }
+}
+
+static bool isOpen(uint16_t call)
+{
+    return call == PAL_API_TRACE_STREAM_OPEN || call == PAL_API_TRACE_STREAM_OPEN_ASYNC;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<PalApiTraceCall> calls;
+    std::map<uint64_t, pal_stream_handle_t *> handles;
+    replayStats stats[PAL_API_TRACE_CALL_MAX];
+    double speed = 1.0;
+    int32_t status;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:vh")) != -1) {
+        switch (opt) {
+        case 's':
+            speed = atof(optarg);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            speed = -1;
+            break;
+        }
+    }
+    if (optind >= argc || speed < 0) {
+        fprintf(stdout, "Usage: PalApiReplay [-s speed] [-v] trace.bin\n"
+                "  -s  divide the recorded spacing by speed, 0 for back to back (1)\n"
+                "  -v  print every call\n");
+        return 0;
+    }
+    status = PalApiTrace::load(argv[optind], calls);
+    if (status) {
+        fprintf(stderr, "cannot load %s, error %d\n", argv[optind], status);
+        return 1;
+    }
+    if (calls.empty()) {
+        fprintf(stdout, "%s: no calls\n", argv[optind]);
+        return 0;
+    }
+
+    pal_log_lvl = PAL_LOG_ERR;
+    status = pal_init();
+    if (status) {
+        fprintf(stderr, "pal_init failed %d\n", status);
+        return 1;
+    }
+
+    uint64_t firstNs = calls.front().rec.begin_ns;
+    auto begin = std::chrono::steady_clock::now();
+
+    for (auto &call : calls) {
+        replayStats &st = stats[call.rec.call];
+        pal_stream_handle_t *handle = NULL;
+        pal_stream_handle_t *opened = NULL;
+
+        if ((call.rec.flags & PAL_API_TRACE_FLAG_NESTED) ||
+            call.rec.call == PAL_API_TRACE_STREAM_START_ASYNC)
+            continue;
+        if (call.rec.handle && !isOpen(call.rec.call)) {
+            auto it = handles.find(call.rec.handle);
+            if (it == handles.end()) {
+                /* opened before the recording or its open failed here */
+                st.skipped++;
+                continue;
+            }
+            handle = it->second;
+        }
+
+        if (speed > 0)
+            std::this_thread::sleep_until(begin + std::chrono::nanoseconds(
+                    (uint64_t)((call.rec.begin_ns - firstNs) / speed)));
+
+        auto callBegin = std::chrono::steady_clock::now();
+        status = issueCall(call, handle, &opened);
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - callBegin).count();
+
+        if (isOpen(call.rec.call) && !status && call.rec.handle)
+            handles[call.rec.handle] = opened;
+        else if (call.rec.call == PAL_API_TRACE_STREAM_CLOSE)
+            handles.erase(call.rec.handle);
+
+        st.runs++;
+        st.recordedNs += call.rec.duration_ns;
+        st.replayedNs += ns;
+        if (status != call.rec.status)
+            st.mismatches++;
+        if (verbose)
+            printf("%10.3f ms tid %-6u %-24s handle 0x%llx status %d/%d, %.1f/%.1f us\n",
+                   (call.rec.begin_ns - firstNs) / 1e6, call.rec.tid,
+                   callNames[call.rec.call], (unsigned long long)call.rec.handle,
+                   call.rec.status, status, call.rec.duration_ns / 1e3, ns / 1e3);
+    }
+
+    printf("%-24s %6s %10s %8s %14s %14s\n", "call", "runs", "mismatches", "skipped",
+           "recorded us", "replayed us");
+    for (int i = 1; i < PAL_API_TRACE_CALL_MAX; i++) {
+        if (!stats[i].runs && !stats[i].skipped)
+            continue;
+        printf("%-24s %6u %10u %8u %14.1f %14.1f\n", callNames[i], stats[i].runs,
+               stats[i].mismatches, stats[i].skipped, stats[i].recordedNs / 1e3,
+               stats[i].replayedNs / 1e3);
+    }
+
+    /* streams the trace left open */
+    for (auto &it : handles)
+        pal_stream_close(it.second);
+    pal_deinit();
+    return 0;
+}
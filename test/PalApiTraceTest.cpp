@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Round trip checks of PalApiTrace, the recorder behind
+ * vendor.audio.pal.api_trace:
+ *
+ *   PalApiTraceTest [-d dir]
+ *
+ * Records calls the way Pal.cpp does, through PalApiTraceScope, and reads
+ * them back with PalApiTrace::load(), the loader PalApiReplay uses. Covers
+ * every argument coming back byte for byte with the call, handle, status,
+ * thread and timing it was recorded with, nested calls being flagged,
+ * records of concurrent threads staying whole and in entry order, the size
+ * limit stopping the recording at a record boundary, a record cut short at
+ * the end being dropped and traces of another version being rejected.
+ * Exits non-zero on the first failed check.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PalApi.h"
+#include "PalCommon.h"
+#include "PalApiTrace.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define STREAM_HANDLE ((void *)0x5000)
+#define NUM_THREADS 4
+#define CALLS_PER_THREAD 200
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __func__, __LINE__, #cond); \
+            return -1; \
+        } \
+    } while (0)
+
+static std::string tracePath;
+
+static bool argIs(const PalApiTraceCall &call, uint32_t i, const void *data, size_t size)
+{
+    return i < call.args.size() && call.args[i].size() == size &&
+           (!size || !memcmp(call.args[i].data(), data, size));
+}
+
+static bool argIs(const PalApiTraceCall &call, uint32_t i, uint64_t value)
+{
+    return argIs(call, i, &value, sizeof(value));
+}
+
+static int32_t traceOpen(const struct pal_stream_attributes *attr,
+                         const struct pal_device *devices, uint32_t numDevices)
+{
+    int32_t status = -EINVAL;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_OPEN, NULL, status,
+                           {{attr, sizeof(*attr)},
+                            {devices, numDevices * sizeof(*devices)},
+                            {NULL, 0},
+                            (uint64_t)1});
+
+    usleep(1000);
+    trace.setHandle(STREAM_HANDLE);
+    status = 0;
+    return status;
+}
+
+static int32_t traceSetParam(uint32_t paramId, pal_param_payload *payload)
+{
+    int32_t status = 0;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_SET_PARAM, STREAM_HANDLE, status,
+                           {(uint64_t)paramId,
+                            {payload, sizeof(*payload) + payload->payload_size}});
+
+    return status;
+}
+
+static int32_t traceStop()
+{
+    int32_t status = -ENODEV;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_STOP, STREAM_HANDLE, status);
+
+    return status;
+}
+
+/* close stops the stream itself, that stop is nested */
+static int32_t traceClose()
+{
+    int32_t status = 0;
+    PalApiTraceScope trace(PAL_API_TRACE_STREAM_CLOSE, STREAM_HANDLE, status);
+
+    traceStop();
+    return status;
+}
+
+static int testRoundTrip()
+{
+    struct pal_stream_attributes attr;
+    struct pal_device devices[2];
+    uint8_t buf[sizeof(pal_param_payload) + 12];
+    pal_param_payload *payload = (pal_param_payload *)buf;
+    std::vector<PalApiTraceCall> calls;
+    uint32_t tid = (uint32_t)syscall(SYS_gettid);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PAL_STREAM_LOW_LATENCY;
+    attr.direction = PAL_AUDIO_OUTPUT;
+    attr.out_media_config.sample_rate = 48000;
+    memset(devices, 0, sizeof(devices));
+    devices[0].id = PAL_DEVICE_OUT_SPEAKER;
+    devices[1].id = PAL_DEVICE_OUT_WIRED_HEADSET;
+    payload->payload_size = 12;
+    for (uint32_t i = 0; i < payload->payload_size; i++)
+        payload->payload[i] = i * 7;
+
+    CHECK(!PalApiTrace::enabled());
+    CHECK(PalApiTrace::start(tracePath.c_str(), PAL_API_TRACE_DEFAULT_MAX_BYTES) == 0);
+    CHECK(PalApiTrace::enabled());
+    CHECK(PalApiTrace::start(tracePath.c_str(), PAL_API_TRACE_DEFAULT_MAX_BYTES) == -EBUSY);
+    CHECK(traceOpen(&attr, devices, 2) == 0);
+    CHECK(traceSetParam(PAL_PARAM_ID_DEVICE_ROTATION, payload) == 0);
+    CHECK(traceClose() == 0);
+    PalApiTrace::stop();
+    CHECK(!PalApiTrace::enabled());
+    /* calls after stop are not recorded */
+    traceStop();
+
+    CHECK(PalApiTrace::load(tracePath.c_str(), calls) == 0);
+    CHECK(calls.size() == 4);
+
+    CHECK(calls[0].rec.call == PAL_API_TRACE_STREAM_OPEN);
+    CHECK(calls[0].rec.handle == (uint64_t)(uintptr_t)STREAM_HANDLE);
+    CHECK(calls[0].rec.status == 0);
+    CHECK(calls[0].rec.flags == 0);
+    CHECK(calls[0].rec.tid == tid);
+    CHECK(calls[0].rec.duration_ns >= 1000000);
+    CHECK(calls[0].rec.num_args == 4);
+    CHECK(argIs(calls[0], 0, &attr, sizeof(attr)));
+    CHECK(argIs(calls[0], 1, devices, sizeof(devices)));
+    CHECK(argIs(calls[0], 2, NULL, 0));
+    CHECK(argIs(calls[0], 3, (uint64_t)1));
+
+    CHECK(calls[1].rec.call == PAL_API_TRACE_STREAM_SET_PARAM);
+    CHECK(calls[1].rec.begin_ns >= calls[0].rec.begin_ns + calls[0].rec.duration_ns);
+    CHECK(argIs(calls[1], 0, (uint64_t)PAL_PARAM_ID_DEVICE_ROTATION));
+    CHECK(argIs(calls[1], 1, buf, sizeof(buf)));
+
+    /* the close was entered first, the stop it made is flagged as nested */
+    CHECK(calls[2].rec.call == PAL_API_TRACE_STREAM_CLOSE);
+    CHECK(calls[2].rec.flags == 0);
+    CHECK(calls[2].rec.num_args == 0);
+    CHECK(calls[3].rec.call == PAL_API_TRACE_STREAM_STOP);
+    CHECK(calls[3].rec.flags == PAL_API_TRACE_FLAG_NESTED);
+    CHECK(calls[3].rec.status == -ENODEV);
+    CHECK(calls[3].rec.begin_ns + calls[3].rec.duration_ns <=
+          calls[2].rec.begin_ns + calls[2].rec.duration_ns);
+    CHECK(PalApiTrace::depth == 0);
+    return 0;
+}
+
+/* records written concurrently stay whole and come back in entry order */
+static int testThreads()
+{
+    std::vector<std::thread> threads;
+    std::vector<PalApiTraceCall> calls;
+    uint32_t perThread[NUM_THREADS] = {};
+
+    CHECK(PalApiTrace::start(tracePath.c_str(), PAL_API_TRACE_DEFAULT_MAX_BYTES) == 0);
+    for (uint32_t t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([t] {
+            uint8_t buf[sizeof(pal_param_payload) + 64];
+            pal_param_payload *payload = (pal_param_payload *)buf;
+
+            for (uint32_t i = 0; i < CALLS_PER_THREAD; i++) {
+                /* payload sizes vary so a torn record shifts what follows */
+                payload->payload_size = (i * 13 + t) % 64;
+                memset(payload->payload, t, payload->payload_size);
+                traceSetParam(t, payload);
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    PalApiTrace::stop();
+
+    CHECK(PalApiTrace::load(tracePath.c_str(), calls) == 0);
+    CHECK(calls.size() == NUM_THREADS * CALLS_PER_THREAD);
+    for (size_t i = 0; i < calls.size(); i++) {
+        const PalApiTraceCall &call = calls[i];
+        pal_param_payload *payload;
+        uint64_t t;
+
+        CHECK(!i || call.rec.begin_ns >= calls[i - 1].rec.begin_ns);
+        CHECK(call.rec.call == PAL_API_TRACE_STREAM_SET_PARAM && call.args.size() == 2);
+        CHECK(call.args[0].size() == sizeof(t));
+        memcpy(&t, call.args[0].data(), sizeof(t));
+        CHECK(t < NUM_THREADS);
+        payload = (pal_param_payload *)call.args[1].data();
+        CHECK(call.args[1].size() == sizeof(*payload) + payload->payload_size);
+        CHECK(payload->payload_size == (perThread[t] * 13 + t) % 64);
+        for (uint32_t j = 0; j < payload->payload_size; j++)
+            CHECK(payload->payload[j] == t);
+        perThread[t]++;
+    }
+    return 0;
+}
+
+/* the size limit, a torn last record and a foreign trace */
+static int testLimits()
+{
+    std::vector<PalApiTraceCall> calls;
+    uint64_t maxBytes = sizeof(struct pal_api_trace_header) +
+                        3 * sizeof(struct pal_api_trace_record) + 1;
+    struct pal_api_trace_header header;
+    struct pal_api_trace_record rec;
+    uint32_t argSize;
+    int fd;
+
+    CHECK(PalApiTrace::start(tracePath.c_str(), maxBytes) == 0);
+    for (int i = 0; i < 5; i++)
+        traceStop();
+    CHECK(!PalApiTrace::enabled());
+    PalApiTrace::stop();
+    CHECK(PalApiTrace::load(tracePath.c_str(), calls) == 0);
+    CHECK(calls.size() == 3);
+
+    /* a record cut short in its arguments, as a crash in a write leaves */
+    rec = calls[0].rec;
+    rec.num_args = 1;
+    rec.size = sizeof(rec) + sizeof(uint32_t) + 64;
+    fd = open(tracePath.c_str(), O_WRONLY | O_APPEND);
+    CHECK(fd >= 0);
+    CHECK(write(fd, &rec, sizeof(rec)) == (ssize_t)sizeof(rec));
+    argSize = 64;
+    CHECK(write(fd, &argSize, sizeof(argSize)) == (ssize_t)sizeof(argSize));
+    CHECK(write(fd, &rec, 16) == 16);
+    close(fd);
+    calls.clear();
+    CHECK(PalApiTrace::load(tracePath.c_str(), calls) == 0);
+    CHECK(calls.size() == 3);
+
+    fd = open(tracePath.c_str(), O_RDWR);
+    CHECK(fd >= 0);
+    CHECK(pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header));
+    header.version++;
+    CHECK(pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header));
+    close(fd);
+    calls.clear();
+    CHECK(PalApiTrace::load(tracePath.c_str(), calls) == -EINVAL);
+    CHECK(calls.empty());
+
+    unlink(tracePath.c_str());
+    CHECK(PalApiTrace::load(tracePath.c_str(), calls) == -ENOENT);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string dir = "/data/local/tmp";
+    int status;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            dir = optarg;
+            break;
+        default:
+            fprintf(stdout, "Usage: PalApiTraceTest [-d dir]\n"
+                    "  -d  writable directory for the trace (/data/local/tmp)\n");
+            return 0;
+        }
+    }
+    tracePath = dir + "/pal_api_trace_test." + std::to_string(getpid());
+
+    status = testRoundTrip() || testThreads() || testLimits();
+    unlink(tracePath.c_str());
+    if (status)
+        return 1;
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks of BtPluginCache, the plugin registry and payload memo behind
+ * Bluetooth::getPluginPayload, with a stand in plugin:
+ *
+ *   PalBtPluginCacheTest [-p plugin library]
+ *
+ * Covers loading a plugin once per path, memo keys following what the
+ * AAC config pointers point to rather than the pointers, payloads handed
+ * out on a hit being identical to the packed ones and freed by the
+ * plugin's close_plugin, and least recently used eviction. Exits non-zero
+ * on the first failed check.
+ */
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include "PalCommon.h"
+#include "BtPluginCache.h"
+#undef NUM_CODEC
+#include "bt_bundle.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define TEST_PLUGIN_LIB "libpal_bt_test_plugin.so"
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __func__, __LINE__, #cond); \
+            return -1; \
+        } \
+    } while (0)
+
+typedef int (*packs_fn_t)(void);
+
+static std::string pluginLib = TEST_PLUGIN_LIB;
+static packs_fn_t pluginPacks;
+
+/* what Bluetooth::getPluginPayload does, minus the resource manager */
+static int getPayload(codec_type dir, void *codecInfo, bt_codec_t **codec,
+                      bt_enc_payload_t **out, bool *memoized)
+{
+    open_fn_t openFn = NULL;
+    bt_enc_payload_t *payload = NULL;
+    std::string key;
+    bool memoize;
+    int status;
+
+    status = BtPluginCache::getOpenFn(pluginLib, &openFn);
+    if (status)
+        return status;
+    status = openFn(codec, CODEC_TYPE_AAC, dir);
+    if (status)
+        return status;
+
+    memoize = BtPluginCache::getMemoKey(pluginLib, CODEC_TYPE_AAC, codecInfo, dir, key);
+    if (memoize)
+        payload = BtPluginCache::lookup(key);
+    if (payload) {
+        (*codec)->payload = payload;
+        *out = payload;
+    } else {
+        status = (*codec)->plugin_populate_payload(*codec, codecInfo, (void **)out);
+        if (status) {
+            (*codec)->close_plugin(*codec);
+            return status;
+        }
+        if (memoize)
+            BtPluginCache::insert(key, *out);
+    }
+    *memoized = payload != NULL;
+    return 0;
+}
+
+static bool samePayload(const bt_enc_payload_t *a, const bt_enc_payload_t *b)
+{
+    if (a->channel_count != b->channel_count || a->bit_format != b->bit_format ||
+        a->sample_rate != b->sample_rate || a->is_abr_enabled != b->is_abr_enabled ||
+        a->is_enc_config_set != b->is_enc_config_set ||
+        a->is_dec_config_set != b->is_dec_config_set || a->num_blks != b->num_blks)
+        return false;
+
+    for (uint32_t i = 0; i < a->num_blks; i++) {
+        if (a->blocks[i]->param_id != b->blocks[i]->param_id ||
+            a->blocks[i]->payload_sz != b->blocks[i]->payload_sz ||
+            memcmp(a->blocks[i]->payload, b->blocks[i]->payload, a->blocks[i]->payload_sz))
+            return false;
+    }
+    return true;
+}
+
+static int testRegistry()
+{
+    open_fn_t first = NULL, again = NULL;
+    void *handle;
+
+    CHECK(BtPluginCache::getOpenFn("libpal_bt_no_such_plugin.so", &first) == -EINVAL);
+    CHECK(BtPluginCache::getOpenFn(pluginLib, &first) == 0);
+    CHECK(BtPluginCache::getOpenFn(pluginLib, &again) == 0);
+    CHECK(first && first == again);
+
+    /* the registry keeps it loaded, this only takes another reference */
+    handle = dlopen(pluginLib.c_str(), RTLD_NOW | RTLD_NOLOAD);
+    CHECK(handle);
+    pluginPacks = (packs_fn_t)dlsym(handle, "test_plugin_packs");
+    CHECK(pluginPacks);
+    printf("registry: %s loaded once, missing library rejected\n", pluginLib.c_str());
+    return 0;
+}
+
+static int testMemo()
+{
+    struct aac_abr_control_t abr, abrCopy;
+    audio_aac_encoder_config_t aac;
+    bt_codec_t *codec = NULL, *packedCodec = NULL;
+    bt_enc_payload_t *packed = NULL, *out = NULL;
+    uint64_t hits = BtPluginCache::hits();
+    uint64_t misses = BtPluginCache::misses();
+    int packs = pluginPacks();
+    std::string key;
+    bool memoized;
+
+    memset(&abr, 0, sizeof(abr));
+    memset(&aac, 0, sizeof(aac));
+    abr.is_abr_enabled = true;
+    aac.bitrate = 320000;
+    aac.sampling_rate = 48000;
+    aac.abr_ctl_ptr = &abr;
+
+    CHECK(getPayload(ENC, &aac, &packedCodec, &packed, &memoized) == 0);
+    CHECK(!memoized && pluginPacks() == packs + 1);
+
+    /* same config, the ABR control now at another address */
+    abrCopy = abr;
+    aac.abr_ctl_ptr = &abrCopy;
+    for (int i = 0; i < 3; i++) {
+        CHECK(getPayload(ENC, &aac, &codec, &out, &memoized) == 0);
+        CHECK(memoized && out != packed);
+        CHECK(samePayload(out, packed));
+        codec->close_plugin(codec);
+    }
+    CHECK(pluginPacks() == packs + 1);
+
+    /* what the pointer points to is part of the key */
+    abrCopy.is_abr_enabled = false;
+    CHECK(getPayload(ENC, &aac, &codec, &out, &memoized) == 0);
+    CHECK(!memoized && !out->is_abr_enabled);
+    codec->close_plugin(codec);
+    packedCodec->close_plugin(packedCodec);
+
+    /* AAC decoders and formats without a known layout are not memoized */
+    CHECK(!BtPluginCache::getMemoKey(pluginLib, CODEC_TYPE_AAC, &aac, DEC, key));
+    CHECK(!BtPluginCache::getMemoKey(pluginLib, CODEC_TYPE_PCM, &aac, ENC, key));
+    CHECK(!BtPluginCache::getMemoKey(pluginLib, CODEC_TYPE_AAC, NULL, ENC, key));
+
+    CHECK(BtPluginCache::hits() == hits + 3);
+    CHECK(BtPluginCache::misses() == misses + 2);
+    printf("memo: %d packs for 5 configurations, hits equal the packed payload\n",
+           pluginPacks() - packs);
+    return 0;
+}
+
+static int testEviction()
+{
+    audio_aac_encoder_config_t aac;
+    bt_codec_t *codec = NULL;
+    bt_enc_payload_t *out = NULL;
+    bool memoized;
+
+    memset(&aac, 0, sizeof(aac));
+    aac.sampling_rate = 44100;
+
+    /* fill the memo, then keep the first entry the most recently used */
+    for (uint32_t i = 0; i < BT_PAYLOAD_MEMO_MAX_ENTRIES; i++) {
+        aac.bitrate = 1000 + i;
+        CHECK(getPayload(ENC, &aac, &codec, &out, &memoized) == 0);
+        codec->close_plugin(codec);
+    }
+    aac.bitrate = 1000;
+    CHECK(getPayload(ENC, &aac, &codec, &out, &memoized) == 0);
+    CHECK(memoized);
+    codec->close_plugin(codec);
+
+    /* one more evicts the least recently used, the second one */
+    aac.bitrate = 1000 + BT_PAYLOAD_MEMO_MAX_ENTRIES;
+    CHECK(getPayload(ENC, &aac, &codec, &out, &memoized) == 0);
+    CHECK(!memoized);
+    codec->close_plugin(codec);
+
+    aac.bitrate = 1000;
+    CHECK(getPayload(ENC, &aac, &codec, &out, &memoized) == 0);
+    CHECK(memoized);
+    codec->close_plugin(codec);
+    aac.bitrate = 1001;
+    CHECK(getPayload(ENC, &aac, &codec, &out, &memoized) == 0);
+    CHECK(!memoized);
+    codec->close_plugin(codec);
+    printf("eviction: %d entries kept, least recently used dropped\n",
+           BT_PAYLOAD_MEMO_MAX_ENTRIES);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:h")) != -1) {
+        switch (opt) {
+        case 'p':
+            pluginLib = optarg;
+            break;
+        default:
+            fprintf(stdout, "Usage: PalBtPluginCacheTest [-p plugin library]\n"
+                    "  -p  stand in plugin (%s)\n", TEST_PLUGIN_LIB);
+            return 0;
+        }
+    }
+
+    if (testRegistry() || testMemo() || testEviction())
+        return 1;
+
+    printf("PASS\n");
+    return 0;
+}
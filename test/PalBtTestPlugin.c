@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Stand in BT codec plugin for PalBtPluginCacheTest. Packs an AAC encoder
+ * config into two blocks, the bitrate and the ABR flag, allocated and
+ * freed the way the real plugins do, and counts how often it packed.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bt_intf.h"
+#include "bt_bundle.h"
+
+static int packs;
+
+__attribute__ ((visibility ("default")))
+int test_plugin_packs(void)
+{
+    return packs;
+}
+
+static int test_plugin_populate_payload(bt_codec_t *codec, void *src, void **dst)
+{
+    audio_aac_encoder_config_t *aac = (audio_aac_encoder_config_t *)src;
+    bt_enc_payload_t *payload;
+    uint32_t abr;
+    int i;
+
+    payload = calloc(1, sizeof(bt_enc_payload_t) + 2 * sizeof(custom_block_t *));
+    if (!payload)
+        return -ENOMEM;
+    payload->num_blks = 2;
+    payload->sample_rate = aac->sampling_rate;
+    payload->channel_count = 2;
+    payload->is_abr_enabled = aac->abr_ctl_ptr && aac->abr_ctl_ptr->is_abr_enabled;
+    payload->is_enc_config_set = true;
+    codec->payload = payload;
+
+    abr = payload->is_abr_enabled;
+    for (i = 0; i < 2; i++) {
+        payload->blocks[i] = calloc(1, sizeof(custom_block_t));
+        if (!payload->blocks[i])
+            return -ENOMEM;
+        payload->blocks[i]->param_id = i + 1;
+        payload->blocks[i]->payload_sz = sizeof(uint32_t);
+        payload->blocks[i]->payload = malloc(sizeof(uint32_t));
+        if (!payload->blocks[i]->payload)
+            return -ENOMEM;
+        memcpy(payload->blocks[i]->payload, i ? &abr : &aac->bitrate, sizeof(uint32_t));
+    }
+
+    packs++;
+    *dst = payload;
+    return 0;
+}
+
+static void test_plugin_close(bt_codec_t *codec)
+{
+    bt_enc_payload_t *payload = codec->payload;
+    uint32_t i;
+
+    if (payload) {
+        for (i = 0; i < payload->num_blks; i++) {
+            if (payload->blocks[i]) {
+                free(payload->blocks[i]->payload);
+                free(payload->blocks[i]);
+            }
+        }
+        free(payload);
+    }
+    free(codec);
+}
+
+__attribute__ ((visibility ("default")))
+int plugin_open(bt_codec_t **codec, uint32_t codecFmt, codec_type direction)
+{
+    bt_codec_t *bt_codec = calloc(1, sizeof(bt_codec_t));
+
+    if (!bt_codec)
+        return -ENOMEM;
+
+    bt_codec->codecFmt = codecFmt;
+    bt_codec->direction = direction;
+    bt_codec->plugin_populate_payload = test_plugin_populate_payload;
+    bt_codec->close_plugin = test_plugin_close;
+    *codec = bt_codec;
+    return 0;
+}
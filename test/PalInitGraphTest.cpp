@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks of PalInitGraph, the runner behind the pal_init phases:
+ *
+ *   PalInitGraphTest [-w workers]
+ *
+ * Covers phases only starting once their dependencies finished, with
+ * independent phases running in parallel and in add order on one worker,
+ * a failing or throwing phase failing its dependents without running them
+ * while independent phases still run, and run() only returning once every
+ * phase is done, with the worker threads gone. Exits non-zero on the first
+ * failed check.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "PalCommon.h"
+#include "PalInitGraph.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define NUM_LAYERS 4
+#define PHASES_PER_LAYER 4
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __func__, __LINE__, #cond); \
+            return -1; \
+        } \
+    } while (0)
+
+struct phaseLog {
+    std::mutex lock;
+    std::vector<std::string> started;
+    std::vector<std::string> finished;
+    std::atomic<int> running;
+    std::atomic<int> maxRunning;
+
+    phaseLog() : running(0), maxRunning(0) {}
+
+    void start(const std::string &name)
+    {
+        int now = ++running;
+        int max = maxRunning.load();
+
+        while (now > max && !maxRunning.compare_exchange_weak(max, now))
+            ;
+        std::lock_guard<std::mutex> guard(lock);
+        started.push_back(name);
+    }
+
+    void finish(const std::string &name)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        finished.push_back(name);
+        running--;
+    }
+
+    bool isFinished(const std::string &name)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto &n : finished) {
+            if (n == name)
+                return true;
+        }
+        return false;
+    }
+};
+
+static std::string phaseName(int layer, int i)
+{
+    return "L" + std::to_string(layer) + "P" + std::to_string(i);
+}
+
+/* every phase of a layer depends on two phases of the layer before it */
+static int testOrdering(uint32_t workers)
+{
+    PalInitGraph graph("ordering", workers);
+    phaseLog log;
+    std::atomic<int> early(0);
+    std::vector<std::string> added;
+
+    for (int layer = 0; layer < NUM_LAYERS; layer++) {
+        for (int i = 0; i < PHASES_PER_LAYER; i++) {
+            std::string name = phaseName(layer, i);
+            std::vector<std::string> deps;
+
+            if (layer > 0) {
+                deps.push_back(phaseName(layer - 1, i));
+                deps.push_back(phaseName(layer - 1, (i + 1) % PHASES_PER_LAYER));
+            }
+            CHECK(graph.addPhase(name, [&, name, deps] {
+                for (auto &dep : deps) {
+                    if (!log.isFinished(dep))
+                        early++;
+                }
+                log.start(name);
+                usleep(2000);
+                log.finish(name);
+                return 0;
+            }, deps) == (int)added.size());
+            added.push_back(name);
+        }
+    }
+
+    CHECK(graph.run() == 0);
+    CHECK(graph.failedPhase().empty());
+    CHECK(early.load() == 0);
+    CHECK(log.finished.size() == added.size());
+    CHECK(log.maxRunning.load() <= (int)workers);
+    if (workers > 1)
+        CHECK(log.maxRunning.load() > 1);
+    else
+        CHECK(log.started == added);
+    printf("ordering: %zu phases on %u workers, up to %d in parallel\n",
+           added.size(), workers, log.maxRunning.load());
+    return 0;
+}
+
+/*
+ *   a -> c -> e         a, b and x succeed, d throws so e and f are
+ *   b -> d -> e         skipped with -EINVAL. g fails with -EIO on its
+ *        d -> f         own and takes h with it.
+ *   x, g -> h
+ */
+static int testFailure(uint32_t workers)
+{
+    PalInitGraph graph("failure", workers);
+    std::atomic<bool> ran[8];
+    const char *names = "abcdefgh";
+    int status;
+
+    for (auto &r : ran)
+        r = false;
+
+    CHECK(graph.addPhase("a", [&] { ran[0] = true; return 0; }) == 0);
+    CHECK(graph.addPhase("b", [&] { ran[1] = true; return 0; }) == 1);
+    CHECK(graph.addPhase("c", [&] { ran[2] = true; return 0; }, {"a"}) == 2);
+    CHECK(graph.addPhase("d", [&]() -> int {
+        ran[3] = true;
+        throw std::runtime_error("phase failure");
+    }, {"b"}) == 3);
+    CHECK(graph.addPhase("e", [&] { ran[4] = true; return 0; }, {"c", "d"}) == 4);
+    CHECK(graph.addPhase("f", [&] { ran[5] = true; return 0; }, {"d"}) == 5);
+    CHECK(graph.addPhase("g", [&] {
+        usleep(10000);
+        ran[6] = true;
+        return -EIO;
+    }) == 6);
+    CHECK(graph.addPhase("x", [] { return 0; }) == 7);
+    CHECK(graph.addPhase("h", [&] { ran[7] = true; return 0; }, {"x", "g"}) == 8);
+
+    /* names are unique and dependencies have to exist already */
+    CHECK(graph.addPhase("a", [] { return 0; }) == -EINVAL);
+    CHECK(graph.addPhase("y", [] { return 0; }, {"z"}) == -EINVAL);
+
+    status = graph.run();
+    /* the first failure wins; on one worker g is ready before d */
+    CHECK(status == -EINVAL || status == -EIO);
+    CHECK(graph.failedPhase() == (status == -EINVAL ? "d" : "g"));
+    if (workers == 1)
+        CHECK(graph.failedPhase() == "g");
+    CHECK(ran[0] && ran[1] && ran[2] && ran[3] && ran[6]);
+    CHECK(!ran[4] && !ran[5] && !ran[7]);
+    printf("failure: %s failed with %d, ran", graph.failedPhase().c_str(), status);
+    for (int i = 0; i < 8; i++) {
+        if (ran[i])
+            printf(" %c", names[i]);
+    }
+    printf("\n");
+    return 0;
+}
+
+static int testDrain(uint32_t workers)
+{
+    PalInitGraph empty("empty", workers);
+    PalInitGraph graph("drain", workers);
+    std::atomic<int> done(0);
+    int phases = 0;
+
+    /* nothing to run, returns right away */
+    CHECK(empty.run() == 0);
+
+    /* slow leaves next to a failing phase still finish before run returns */
+    CHECK(graph.addPhase("fail", [] { return -ENODEV; }) == phases++);
+    for (int i = 0; i < PAL_INIT_MAX_WORKERS; i++) {
+        CHECK(graph.addPhase("slow" + std::to_string(i), [&] {
+            usleep(20000);
+            done++;
+            return 0;
+        }) == phases++);
+    }
+    CHECK(graph.addPhase("skipped", [&] { done += 100; return 0; },
+                         {"fail", "slow0"}) == phases++);
+
+    CHECK(graph.run() == -ENODEV);
+    CHECK(graph.failedPhase() == "fail");
+    CHECK(done.load() == PAL_INIT_MAX_WORKERS);
+    printf("drain: run returned after %d slow phases, dependent of the failure skipped\n",
+           done.load());
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t workers = PAL_INIT_DEFAULT_WORKERS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "w:h")) != -1) {
+        switch (opt) {
+        case 'w':
+            workers = atoi(optarg);
+            break;
+        default:
+            fprintf(stdout, "Usage: PalInitGraphTest [-w workers]\n"
+                    "  -w  threads, caller included, 1 to %d (%d)\n",
+                    PAL_INIT_MAX_WORKERS, PAL_INIT_DEFAULT_WORKERS);
+            return 0;
+        }
+    }
+    if (workers < 1 || workers > PAL_INIT_MAX_WORKERS)
+        workers = PAL_INIT_DEFAULT_WORKERS;
+
+    if (testOrdering(workers) || testFailure(workers) || testDrain(workers))
+        return 1;
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Per-buffer cost of the libpalclient data path, hidl_vec against the
+ * @1.1 shared buffer path, with pal_client_wrapper talking to an
+ * in-process IPAL stub:
+ *
+ *   PalIpcLoopbackBench [-n buffers] [-s buffer size] [-c buffer count]
+ *
+ * The stub does what pal_server_wrapper does around pal_stream_write/read
+ * (copy out of or into the request, or the shared mapping) but no PAL
+ * work. Calls are direct, not binder transactions, so the result is the
+ * client and server marshalling and copy cost of each path, not the
+ * parcel copies of the transport, which only add to the hidl_vec side.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <vendor/qti/hardware/pal/1.1/IPAL.h>
+#include "PalApi.h"
+#include "inc/PalCallback.h"
+
+using android::hardware::Return;
+using android::hardware::Void;
+using android::hardware::hidl_memory;
+using android::hardware::hidl_vec;
+using android::sp;
+using IPAL = vendor::qti::hardware::pal::V1_0::IPAL;
+using IPAL_V1_1 = vendor::qti::hardware::pal::V1_1::IPAL;
+using IPALCallback = vendor::qti::hardware::pal::V1_0::IPALCallback;
+
+/* owned by pal_client_wrapper.cpp, set directly instead of getService() */
+extern sp<IPAL> pal_client;
+extern sp<IPAL_V1_1> pal_client_v1_1;
+
+#define LOOPBACK_HANDLE 0x1000
+
+struct LoopbackPAL : public IPAL_V1_1 {
+    std::vector<uint8_t> sink;
+    std::vector<uint8_t> source;
+    uint8_t *sharedBase = nullptr;
+    size_t sharedSize = 0;
+
+    ~LoopbackPAL()
+    {
+        if (sharedBase)
+            munmap(sharedBase, sharedSize);
+    }
+
+    Return<void> ipc_pal_stream_set_buffer_size(const uint64_t streamHandle,
+                                                const PalBufferConfig& in_buff_cfg,
+                                                const PalBufferConfig& out_buff_cfg,
+                                                ipc_pal_stream_set_buffer_size_cb _hidl_cb) override
+    {
+        sink.resize(std::max(out_buff_cfg.buf_size, in_buff_cfg.buf_size));
+        source.assign(sink.size(), 0x5a);
+        _hidl_cb(0, in_buff_cfg, out_buff_cfg);
+        return Void();
+    }
+    Return<int32_t> ipc_pal_stream_write(const uint64_t streamHandle,
+                                         const hidl_vec<PalBuffer>& buff_hidl) override
+    {
+        uint32_t size = buff_hidl.data()->size;
+
+        if (size > sink.size() || buff_hidl.data()->buffer.size() != size)
+            return -EINVAL;
+        memcpy(sink.data(), buff_hidl.data()->buffer.data(), size);
+        return size;
+    }
+    Return<void> ipc_pal_stream_read(const uint64_t streamHandle,
+                                     const hidl_vec<PalBuffer>& inBuff_hidl,
+                                     ipc_pal_stream_read_cb _hidl_cb) override
+    {
+        hidl_vec<PalBuffer> outBuff_hidl;
+        uint32_t size = std::min<uint32_t>(inBuff_hidl.data()->size, source.size());
+
+        outBuff_hidl.resize(sizeof(struct pal_buffer));
+        outBuff_hidl.data()->size = size;
+        outBuff_hidl.data()->buffer.resize(size);
+        memcpy(outBuff_hidl.data()->buffer.data(), source.data(), size);
+        _hidl_cb(size, outBuff_hidl);
+        return Void();
+    }
+    Return<int32_t> ipc_pal_stream_set_shared_buffer(const uint64_t streamHandle,
+                                                     const hidl_memory& sharedMem,
+                                                     const PalBufferConfig& in_buff_cfg,
+                                                     const PalBufferConfig& out_buff_cfg) override
+    {
+        void *base = mmap(nullptr, sharedMem.size(), PROT_READ | PROT_WRITE, MAP_SHARED,
+                          sharedMem.handle()->data[0], 0);
+
+        if (base == MAP_FAILED)
+            return -ENOMEM;
+        if (sharedBase)
+            munmap(sharedBase, sharedSize);
+        sharedBase = (uint8_t *)base;
+        sharedSize = sharedMem.size();
+        return 0;
+    }
+    Return<int32_t> ipc_pal_stream_write_shared(const uint64_t streamHandle,
+                                                const PalSharedBufferDesc& desc) override
+    {
+        if (!sharedBase || (uint64_t)desc.offset + desc.size > sharedSize ||
+            desc.size > sink.size())
+            return -EINVAL;
+        memcpy(sink.data(), sharedBase + desc.offset, desc.size);
+        return desc.size;
+    }
+    Return<void> ipc_pal_stream_read_shared(const uint64_t streamHandle,
+                                            const PalSharedBufferDesc& desc,
+                                            ipc_pal_stream_read_shared_cb _hidl_cb) override
+    {
+        PalSharedBufferDesc desc_ret = desc;
+
+        if (!sharedBase || (uint64_t)desc.offset + desc.size > sharedSize ||
+            desc.size > source.size()) {
+            _hidl_cb(-EINVAL, desc_ret);
+            return Void();
+        }
+        memcpy(sharedBase + desc.offset, source.data(), desc.size);
+        _hidl_cb(desc.size, desc_ret);
+        return Void();
+    }
+    Return<int32_t> ipc_pal_stream_close(const uint64_t streamHandle) override
+    {
+        if (sharedBase)
+            munmap(sharedBase, sharedSize);
+        sharedBase = nullptr;
+        sharedSize = 0;
+        return 0;
+    }
+
+    /* the rest of IPAL is not on the data path */
+    Return<void> ipc_pal_stream_open(const hidl_vec<PalStreamAttributes>& attributes,
+                                     uint32_t noOfDevices, const hidl_vec<PalDevice>& devices,
+                                     uint32_t noOfModifiers, const hidl_vec<ModifierKV>& modifiers,
+                                     const sp<IPALCallback>& cb, uint64_t ipc_clt_data,
+                                     ipc_pal_stream_open_cb _hidl_cb) override
+    {
+        _hidl_cb(0, LOOPBACK_HANDLE);
+        return Void();
+    }
+    Return<int32_t> ipc_pal_stream_start(const uint64_t streamHandle) override { return 0; }
+    Return<int32_t> ipc_pal_stream_stop(const uint64_t streamHandle) override { return 0; }
+    Return<int32_t> ipc_pal_stream_pause(const uint64_t streamHandle) override { return -ENOSYS; }
+    Return<int32_t> ipc_pal_stream_suspend(const uint64_t streamHandle) override { return -ENOSYS; }
+    Return<int32_t> ipc_pal_stream_resume(const uint64_t streamHandle) override { return -ENOSYS; }
+    Return<int32_t> ipc_pal_stream_flush(const uint64_t streamHandle) override { return -ENOSYS; }
+    Return<int32_t> ipc_pal_stream_drain(const uint64_t streamHandle,
+                                         const PalDrainType type) override { return -ENOSYS; }
+    Return<void> ipc_pal_stream_get_buffer_size(const uint64_t streamHandle, uint32_t in_buf_size,
+                                                uint32_t out_buf_size,
+                                                ipc_pal_stream_get_buffer_size_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, 0, 0);
+        return Void();
+    }
+    Return<int32_t> ipc_pal_stream_set_param(const uint64_t streamHandle, uint32_t param_id,
+                                             const hidl_vec<PalParamPayload>& paramPayload) override
+    {
+        return -ENOSYS;
+    }
+    Return<void> ipc_pal_stream_get_param(const uint64_t streamHandle, uint32_t param_id,
+                                          ipc_pal_stream_get_param_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, hidl_vec<PalParamPayload>());
+        return Void();
+    }
+    Return<void> ipc_pal_stream_get_device(const uint64_t streamHandle,
+                                           ipc_pal_stream_get_device_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, hidl_vec<PalDevice>(), 0);
+        return Void();
+    }
+    Return<int32_t> ipc_pal_stream_set_device(const uint64_t streamHandle, uint32_t noOfDevices,
+                                              const hidl_vec<PalDevice>& devices) override
+    {
+        return -ENOSYS;
+    }
+    Return<void> ipc_pal_stream_get_volume(const uint64_t streamHandle,
+                                           ipc_pal_stream_get_volume_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, hidl_vec<PalVolumeData>());
+        return Void();
+    }
+    Return<int32_t> ipc_pal_stream_set_volume(const uint64_t streamHandle,
+                                              const hidl_vec<PalVolumeData>& vol) override
+    {
+        return -ENOSYS;
+    }
+    Return<void> ipc_pal_stream_get_mute(const uint64_t streamHandle,
+                                         ipc_pal_stream_get_mute_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, false);
+        return Void();
+    }
+    Return<int32_t> ipc_pal_stream_set_mute(const uint64_t streamHandle, bool state) override
+    {
+        return -ENOSYS;
+    }
+    Return<void> ipc_pal_get_mic_mute(ipc_pal_get_mic_mute_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, false);
+        return Void();
+    }
+    Return<int32_t> ipc_pal_set_mic_mute(bool state) override { return -ENOSYS; }
+    Return<void> ipc_pal_get_timestamp(const uint64_t streamHandle,
+                                       ipc_pal_get_timestamp_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, hidl_vec<PalSessionTime>());
+        return Void();
+    }
+    Return<int32_t> ipc_pal_add_remove_effect(const uint64_t streamHandle,
+                                              const PalAudioEffect effect, bool enable) override
+    {
+        return -ENOSYS;
+    }
+    Return<int32_t> ipc_pal_set_param(uint32_t paramId, const hidl_vec<uint8_t>& payload,
+                                      uint32_t size) override
+    {
+        return -ENOSYS;
+    }
+    Return<void> ipc_pal_get_param(uint32_t paramId, ipc_pal_get_param_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, hidl_vec<uint8_t>(), 0);
+        return Void();
+    }
+    Return<void> ipc_pal_stream_create_mmap_buffer(PalStreamHandle streamHandle,
+                                                   int32_t min_size_frames,
+                                                   ipc_pal_stream_create_mmap_buffer_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, hidl_vec<PalMmapBuffer>());
+        return Void();
+    }
+    Return<void> ipc_pal_stream_get_mmap_position(PalStreamHandle streamHandle,
+                                                  ipc_pal_stream_get_mmap_position_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, hidl_vec<PalMmapPosition>());
+        return Void();
+    }
+    Return<int32_t> ipc_pal_register_global_callback(const sp<IPALCallback>& cb,
+                                                     uint64_t cookie) override
+    {
+        return -ENOSYS;
+    }
+    Return<void> ipc_pal_gef_rw_param(uint32_t paramId, const hidl_vec<uint8_t>& param_payload,
+                                      int32_t payload_size, PalDeviceId dev_id,
+                                      PalStreamType strm_type, uint8_t dir,
+                                      ipc_pal_gef_rw_param_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, hidl_vec<uint8_t>());
+        return Void();
+    }
+    Return<void> ipc_pal_stream_get_tags_with_module_info(const uint64_t streamHandle,
+                                  uint32_t size,
+                                  ipc_pal_stream_get_tags_with_module_info_cb _hidl_cb) override
+    {
+        _hidl_cb(-ENOSYS, 0, hidl_vec<uint8_t>());
+        return Void();
+    }
+};
+
+struct benchResult {
+    std::vector<uint32_t> writeNs;
+    std::vector<uint32_t> readNs;
+    uint32_t errors = 0;
+};
+
+static uint32_t percentile(std::vector<uint32_t> &ns, double p)
+{
+    if (ns.empty())
+        return 0;
+    std::sort(ns.begin(), ns.end());
+    return ns[std::min(ns.size() - 1, (size_t)(ns.size() * p))];
+}
+
+static uint32_t elapsedNs(std::chrono::steady_clock::time_point begin)
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+}
+
+static benchResult runPath(bool shared, uint32_t buffers, uint32_t size, uint32_t count)
+{
+    sp<LoopbackPAL> stub = new LoopbackPAL();
+    pal_stream_handle_t *handle = (pal_stream_handle_t *)LOOPBACK_HANDLE;
+    struct pal_buffer_config in_cfg = {count, size, 0};
+    struct pal_buffer_config out_cfg = {count, size, 0};
+    struct pal_buffer buf;
+    std::vector<uint8_t> data(size, 0xa5);
+    struct timespec ts = {0, 0};
+    benchResult result;
+    ssize_t ret;
+
+    pal_client = stub;
+    pal_client_v1_1 = shared ? stub : nullptr;
+    if (pal_stream_set_buffer_size(handle, &in_cfg, &out_cfg)) {
+        result.errors++;
+        return result;
+    }
+
+    result.writeNs.reserve(buffers);
+    result.readNs.reserve(buffers);
+    for (uint32_t i = 0; i < buffers; i++) {
+        memset(&buf, 0, sizeof(buf));
+        buf.buffer = data.data();
+        buf.size = size;
+        buf.ts = &ts;
+        auto begin = std::chrono::steady_clock::now();
+        ret = pal_stream_write(handle, &buf);
+        result.writeNs.push_back(elapsedNs(begin));
+        if (ret != (ssize_t)size)
+            result.errors++;
+
+        memset(&buf, 0, sizeof(buf));
+        buf.buffer = data.data();
+        buf.size = size;
+        buf.ts = &ts;
+        begin = std::chrono::steady_clock::now();
+        ret = pal_stream_read(handle, &buf);
+        result.readNs.push_back(elapsedNs(begin));
+        if (ret != (ssize_t)size || data[size - 1] != 0x5a)
+            result.errors++;
+        data.assign(size, 0xa5);
+    }
+
+    pal_stream_close(handle);
+    pal_client = nullptr;
+    pal_client_v1_1 = nullptr;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t buffers = 100000;
+    uint32_t size = 3840;           /* 20 ms of 48 kHz stereo 16 bit */
+    uint32_t count = 4;
+    int status = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:c:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            buffers = atoi(optarg);
+            break;
+        case 's':
+            size = atoi(optarg);
+            break;
+        case 'c':
+            count = atoi(optarg);
+            break;
+        default:
+            buffers = 0;
+            break;
+        }
+    }
+    if (!buffers || !size || !count) {
+        fprintf(stdout, "Usage: PalIpcLoopbackBench [-n buffers] [-s buffer size] [-c buffer count]\n"
+                "  -n  buffers written and read on each path (100000)\n"
+                "  -s  bytes per buffer (3840)\n"
+                "  -c  buffers in the negotiated configuration (4)\n");
+        return 0;
+    }
+
+    printf("%u buffers of %u bytes, %u buffer configuration\n", buffers, size, count);
+    for (bool shared : {false, true}) {
+        benchResult r = runPath(shared, buffers, size, count);
+
+        printf("  %-8s write p50 %6u ns p99 %7u ns  read p50 %6u ns p99 %7u ns",
+               shared ? "shared" : "hidl_vec",
+               percentile(r.writeNs, 0.5), percentile(r.writeNs, 0.99),
+               percentile(r.readNs, 0.5), percentile(r.readNs, 0.99));
+        if (r.errors) {
+            printf("  %u errors", r.errors);
+            status = 1;
+        }
+        printf("\n");
+    }
+
+    return status;
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Replays every usecase of one or more usecaseKvManager XMLs through the
+ * graph KV lookup. Push the platform files next to the binary and run:
+ *
+ *   PalKvReplayBench [-n iterations] usecaseKvManager.xml...
+ *
+ * Every keys_values entry of every stream, streampp, device and devicepp
+ * block is looked up with its own selector tuple, once through the index
+ * built at init and once through the linear scan it replaced. The KVs both
+ * return have to be identical; the per lookup cost of each is printed as
+ * p50/p99 over all usecases of a table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "PalCommon.h"
+#include "PayloadBuilder.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+struct kvReplayStats {
+    uint32_t lookups;
+    uint32_t mismatches;
+    std::vector<double> indexed_ns;
+    std::vector<double> linear_ns;
+};
+
+/* the all_* tables and their indexes are only reachable from a subclass */
+class KvReplay : public PayloadBuilder
+{
+public:
+    static int load(const char *xmlFile)
+    {
+        int ret;
+
+        all_streams.clear();
+        all_streampps.clear();
+        all_devices.clear();
+        all_devicepps.clear();
+        for (int i = 0; i < SELECTOR_TYPE_MAX; i++)
+            selector_codes[i].clear();
+
+        ret = parseKVXml(xmlFile);
+        if (ret)
+            return ret;
+
+        buildKVIndex(all_streams, stream_index);
+        buildKVIndex(all_streampps, streampp_index);
+        buildKVIndex(all_devices, device_index);
+        buildKVIndex(all_devicepps, devicepp_index);
+        return 0;
+    }
+
+    static uint32_t replayAll(unsigned int iterations)
+    {
+        uint32_t mismatches = 0;
+
+        mismatches += replay("streams", all_streams, iterations);
+        mismatches += replay("streampps", all_streampps, iterations);
+        mismatches += replay("devices", all_devices, iterations);
+        mismatches += replay("devicepps", all_devicepps, iterations);
+        return mismatches;
+    }
+
+private:
+    static uint32_t replay(const char *name, std::vector<allKVs> &any_type,
+                           unsigned int iterations)
+    {
+        kvIndexTable *index = getKVIndex(any_type);
+        kvReplayStats stats = {};
+
+        if (!index) {
+            printf("  %-10s no index built\n", name);
+            return 1;
+        }
+
+        for (auto &block : any_type) {
+            for (auto type : block.id_type) {
+                for (auto &info : block.keys_values)
+                    replayUsecase(info.selector_pairs, type, any_type, *index,
+                                  iterations, stats);
+            }
+        }
+        report(name, stats);
+        return stats.mismatches;
+    }
+
+    static double timeFindKVs(std::vector<std::pair<selector_type_t, std::string>>
+        &selectors, uint32_t type, std::vector<allKVs> &any_type,
+        unsigned int iterations)
+    {
+        std::vector<std::pair<int, int>> keyVector;
+
+        auto begin = std::chrono::steady_clock::now();
+        for (unsigned int n = 0; n < iterations; n++) {
+            keyVector.clear();
+            findKVs(selectors, type, any_type, keyVector);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::nano>(end - begin).count() /
+               iterations;
+    }
+
+    static void replayUsecase(const std::vector<std::pair<selector_type_t, std::string>>
+        &selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
+        kvIndexTable &index, unsigned int iterations, kvReplayStats &stats)
+    {
+        std::vector<std::pair<selector_type_t, std::string>> selectors(selector_pairs);
+        std::vector<std::pair<int, int>> indexed, linear;
+        bool indexed_found, linear_found;
+
+        indexed_found = findKVs(selectors, type, any_type, indexed);
+        stats.indexed_ns.push_back(timeFindKVs(selectors, type, any_type, iterations));
+
+        /* getKVIndex() hands out no index until it is built again */
+        index.built = false;
+        linear_found = findKVs(selectors, type, any_type, linear);
+        stats.linear_ns.push_back(timeFindKVs(selectors, type, any_type, iterations));
+        index.built = true;
+
+        stats.lookups++;
+        if (indexed_found != linear_found || indexed != linear) {
+            stats.mismatches++;
+            printf("  FAIL: type/dev id %d, %zu selectors: indexed %zu kvs, linear %zu kvs\n",
+                   type, selector_pairs.size(), indexed.size(), linear.size());
+        }
+    }
+
+    static double percentile(std::vector<double> &ns, unsigned int pct)
+    {
+        if (ns.empty())
+            return 0;
+        std::sort(ns.begin(), ns.end());
+        return ns[(ns.size() - 1) * pct / 100];
+    }
+
+    static void report(const char *name, kvReplayStats &stats)
+    {
+        printf("  %-10s %5u usecases, indexed p50 %6.0f ns p99 %6.0f ns, "
+               "linear p50 %6.0f ns p99 %6.0f ns%s\n",
+               name, stats.lookups,
+               percentile(stats.indexed_ns, 50), percentile(stats.indexed_ns, 99),
+               percentile(stats.linear_ns, 50), percentile(stats.linear_ns, 99),
+               stats.mismatches ? ", MISMATCH" : "");
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    unsigned int iterations = 100;
+    uint32_t mismatches = 0;
+    int i = 1;
+
+    if (argc > 2 && !strcmp(argv[1], "-n")) {
+        iterations = atoi(argv[2]);
+        i = 3;
+    }
+    if (i >= argc || !iterations) {
+        fprintf(stdout, "Usage: PalKvReplayBench [-n iterations] usecaseKvManager.xml...\n");
+        return 0;
+    }
+
+    for (; i < argc; i++) {
+        printf("%s\n", argv[i]);
+        if (KvReplay::load(argv[i])) {
+            printf("  cannot parse %s\n", argv[i]);
+            return 1;
+        }
+        mismatches += KvReplay::replayAll(iterations);
+    }
+
+    return mismatches ? 1 : 0;
+}
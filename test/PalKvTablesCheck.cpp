@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks that the KV tables compiled in with PAL_STATIC_KV_TABLES load
+ * into exactly what parsing the XML they were generated from gives:
+ *
+ *   PalKvTablesCheck usecaseKvManager.xml
+ *
+ * tools/gen_kv_tables.py has its own copy of the selector splitting and
+ * hex conversion, so this is what keeps it honest. Returns non-zero on
+ * any difference, or if the tables do not match the XML at all.
+ */
+
+#include <stdio.h>
+#include <vector>
+#include "PalCommon.h"
+#include "PayloadBuilder.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+/* the all_* tables are only reachable from a subclass */
+class KvTablesCheck : public PayloadBuilder
+{
+public:
+    static void clear()
+    {
+        all_streams.clear();
+        all_streampps.clear();
+        all_devices.clear();
+        all_devicepps.clear();
+    }
+
+    static void save(std::vector<allKVs> (&tables)[4])
+    {
+        tables[0] = all_streams;
+        tables[1] = all_streampps;
+        tables[2] = all_devices;
+        tables[3] = all_devicepps;
+    }
+
+    static uint32_t compare(const char *name, const std::vector<allKVs> &parsed,
+                            const std::vector<allKVs> &loaded)
+    {
+        uint32_t diffs = 0;
+
+        if (parsed.size() != loaded.size()) {
+            printf("  %-10s %zu blocks parsed, %zu loaded\n", name,
+                   parsed.size(), loaded.size());
+            return 1;
+        }
+
+        for (size_t b = 0; b < parsed.size(); b++) {
+            const allKVs &p = parsed[b];
+            const allKVs &l = loaded[b];
+
+            if (p.id_type != l.id_type ||
+                p.keys_values.size() != l.keys_values.size()) {
+                printf("  %-10s block %zu: ids or entry count differ\n", name, b);
+                diffs++;
+                continue;
+            }
+            for (size_t e = 0; e < p.keys_values.size(); e++) {
+                if (!sameEntry(p.keys_values[e], l.keys_values[e])) {
+                    printf("  %-10s block %zu entry %zu differs\n", name, b, e);
+                    diffs++;
+                }
+            }
+        }
+        printf("  %-10s %zu blocks, %u differences\n", name, parsed.size(), diffs);
+        return diffs;
+    }
+
+private:
+    static bool sameEntry(const kvInfo &p, const kvInfo &l)
+    {
+        if (p.selector_names != l.selector_names ||
+            p.selector_pairs != l.selector_pairs ||
+            p.kv_pairs.size() != l.kv_pairs.size())
+            return false;
+
+        for (size_t i = 0; i < p.kv_pairs.size(); i++) {
+            if (p.kv_pairs[i].key != l.kv_pairs[i].key ||
+                p.kv_pairs[i].value != l.kv_pairs[i].value)
+                return false;
+        }
+        return true;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    const char *names[] = {"streams", "streampps", "devices", "devicepps"};
+    std::vector<allKVs> parsed[4], loaded[4];
+    uint32_t diffs = 0;
+    int ret;
+
+    if (argc != 2) {
+        fprintf(stdout, "Usage: PalKvTablesCheck usecaseKvManager.xml\n");
+        return 1;
+    }
+
+    KvTablesCheck::clear();
+    ret = PayloadBuilder::parseKVXml(argv[1]);
+    if (ret) {
+        printf("%s: parse failed %d\n", argv[1], ret);
+        return 1;
+    }
+    KvTablesCheck::save(parsed);
+
+    KvTablesCheck::clear();
+    ret = PayloadBuilder::loadStaticKVTables(argv[1]);
+    if (ret) {
+        printf("%s: built in KV tables not loaded %d\n", argv[1], ret);
+        return 1;
+    }
+    KvTablesCheck::save(loaded);
+    KvTablesCheck::clear();
+
+    printf("%s:\n", argv[1]);
+    for (int i = 0; i < 4; i++)
+        diffs += KvTablesCheck::compare(names[i], parsed[i], loaded[i]);
+
+    printf("%s\n", diffs ? "FAIL" : "PASS");
+    return diffs ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host independent benchmark of PalRingBuffer with the voice UI layout of
+ * one writer (the GSL buffering thread) and several readers (LAB read,
+ * second stage keyword and user verification):
+ *
+ *   PalRingBufferBench [-n writes] [-r readers] [-c chunk] [-s size]
+ *
+ * Runs the same load against PAL_RING_BUFFER_LOCKED and
+ * PAL_RING_BUFFER_LOCK_FREE. Readers block in waitForData() for a chunk and
+ * read it. It prints the throughput, which is the bytes written per second
+ * while every reader keeps up, and p50/p99 of a write() and of a read().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "PalCommon.h"
+#include "PalRingBuffer.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+struct benchResult {
+    double seconds = 0;
+    std::vector<uint32_t> writeNs;
+    std::vector<uint32_t> readNs;
+    uint32_t errors = 0;
+};
+
+static uint32_t percentile(std::vector<uint32_t> &ns, double p)
+{
+    if (ns.empty())
+        return 0;
+    std::sort(ns.begin(), ns.end());
+    return ns[std::min(ns.size() - 1, (size_t)(ns.size() * p))];
+}
+
+static uint32_t elapsedNs(std::chrono::steady_clock::time_point begin)
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+}
+
+static void readLoop(PalRingBufferReader *reader, size_t chunk, uint64_t total,
+                     std::vector<uint32_t> *readNs, std::atomic<uint32_t> *errors)
+{
+    std::vector<char> data(chunk);
+    uint64_t done = 0;
+    int32_t ret;
+
+    while (done < total) {
+        ret = reader->waitForData(std::min<uint64_t>(chunk, total - done), 1000);
+        if (ret == -ETIMEDOUT) {
+            (*errors)++;
+            break;
+        }
+        auto begin = std::chrono::steady_clock::now();
+        ret = reader->read(data.data(), chunk);
+        readNs->push_back(elapsedNs(begin));
+        if (ret < 0) {
+            (*errors)++;
+            break;
+        }
+        done += ret;
+    }
+}
+
+static benchResult runMode(pal_ring_buffer_mode mode, uint32_t writes, uint32_t numReaders,
+                           size_t chunk, size_t size)
+{
+    PalRingBuffer buffer(size, mode);
+    std::vector<PalRingBufferReader *> readers;
+    std::vector<std::vector<uint32_t>> readNs(numReaders);
+    std::vector<std::thread> threads;
+    std::vector<char> data(chunk, 0x5a);
+    std::atomic<uint32_t> errors(0);
+    benchResult result;
+    size_t written;
+
+    for (uint32_t i = 0; i < numReaders; i++) {
+        readers.push_back(buffer.newReader());
+        readers.back()->updateState(READER_ENABLED);
+        readNs[i].reserve(writes * 2);
+    }
+    result.writeNs.reserve(writes);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numReaders; i++)
+        threads.emplace_back(readLoop, readers[i], chunk, (uint64_t)writes * chunk,
+                             &readNs[i], &errors);
+
+    for (uint32_t i = 0; i < writes; i++) {
+        /* a full buffer waits for the slowest reader, as the GSL thread does */
+        for (written = 0; written < chunk;) {
+            auto writeBegin = std::chrono::steady_clock::now();
+            written += buffer.write(data.data() + written, chunk - written);
+            result.writeNs.push_back(elapsedNs(writeBegin));
+            if (written < chunk)
+                std::this_thread::yield();
+        }
+    }
+    for (auto &t : threads)
+        t.join();
+    result.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin).count();
+
+    for (auto &ns : readNs)
+        result.readNs.insert(result.readNs.end(), ns.begin(), ns.end());
+    result.errors = errors;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t writes = 100000;
+    uint32_t numReaders = 3;
+    size_t chunk = 640;             /* 20 ms of 16 kHz mono 16 bit */
+    size_t size = 64 * 1024;
+    const pal_ring_buffer_mode modes[] = {PAL_RING_BUFFER_LOCKED, PAL_RING_BUFFER_LOCK_FREE};
+    int status = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:c:s:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            writes = atoi(optarg);
+            break;
+        case 'r':
+            numReaders = atoi(optarg);
+            break;
+        case 'c':
+            chunk = atoi(optarg);
+            break;
+        case 's':
+            size = atoi(optarg);
+            break;
+        default:
+            writes = 0;
+            break;
+        }
+    }
+    if (!writes || !chunk || size < chunk) {
+        fprintf(stdout, "Usage: PalRingBufferBench [-n writes] [-r readers] [-c chunk] [-s size]\n"
+                "  -n  chunks written (100000)\n"
+                "  -r  reader threads (3)\n"
+                "  -c  bytes per write and read (640)\n"
+                "  -s  ring buffer size (65536)\n");
+        return 0;
+    }
+
+    printf("%u writes of %zu bytes, %u readers, %zu byte buffer\n", writes, chunk,
+           numReaders, size);
+    for (auto mode : modes) {
+        benchResult r = runMode(mode, writes, numReaders, chunk, size);
+
+        printf("  %-9s %8.1f MB/s  write p50 %5u ns p99 %6u ns  read p50 %5u ns p99 %6u ns",
+               mode == PAL_RING_BUFFER_LOCKED ? "locked" : "lock-free",
+               (double)writes * chunk / r.seconds / 1e6,
+               percentile(r.writeNs, 0.5), percentile(r.writeNs, 0.99),
+               percentile(r.readNs, 0.5), percentile(r.readNs, 0.99));
+        if (r.errors) {
+            printf("  %u errors", r.errors);
+            status = 1;
+        }
+        printf("\n");
+    }
+
+    return status;
+}
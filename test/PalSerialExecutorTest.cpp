@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks of PalSerialExecutor, the worker pool behind the pal_*_async calls:
+ *
+ *   PalSerialExecutorTest [-w workers]
+ *
+ * Covers per key ordering and parallelism across keys, a throwing task not
+ * taking its lane down, drain() from other threads and from the lane's own
+ * task (-EDEADLK instead of a hang), and stop() running what is queued and
+ * rejecting later posts. Exits non-zero on the first failed check.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "PalCommon.h"
+#include "PalSerialExecutor.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define NUM_KEYS 4
+#define TASKS_PER_KEY 50
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __func__, __LINE__, #cond); \
+            return -1; \
+        } \
+    } while (0)
+
+static int testOrdering(uint32_t workers)
+{
+    PalSerialExecutor ex("ordering", workers);
+    int keys[NUM_KEYS];
+    std::vector<int> order[NUM_KEYS];
+    std::atomic<int> running(0);
+    std::atomic<int> maxRunning(0);
+
+    for (int i = 0; i < NUM_KEYS * TASKS_PER_KEY; i++) {
+        int k = i % NUM_KEYS;
+        CHECK(ex.post(&keys[k], [&, k, i] {
+            int now = ++running;
+            int max = maxRunning.load();
+            while (now > max && !maxRunning.compare_exchange_weak(max, now))
+                ;
+            usleep(200);
+            order[k].push_back(i);
+            running--;
+        }) == 0);
+    }
+    for (int k = 0; k < NUM_KEYS; k++)
+        CHECK(ex.drain(&keys[k]) == 0);
+
+    for (int k = 0; k < NUM_KEYS; k++) {
+        CHECK(order[k].size() == TASKS_PER_KEY);
+        for (int j = 1; j < TASKS_PER_KEY; j++)
+            CHECK(order[k][j] > order[k][j - 1]);
+    }
+    CHECK(maxRunning.load() <= (int)workers);
+    if (workers > 1)
+        CHECK(maxRunning.load() > 1);
+    printf("ordering: %d tasks on %u workers, up to %d in parallel\n",
+           NUM_KEYS * TASKS_PER_KEY, workers, maxRunning.load());
+    return 0;
+}
+
+static int testFailure(uint32_t workers)
+{
+    PalSerialExecutor ex("failure", workers);
+    int key;
+    bool ranAfter = false;
+
+    CHECK(ex.post(&key, [] { throw std::runtime_error("task failure"); }) == 0);
+    CHECK(ex.post(&key, [&] { ranAfter = true; }) == 0);
+    CHECK(ex.drain(&key) == 0);
+    CHECK(ranAfter);
+    printf("failure: lane survives a throwing task\n");
+    return 0;
+}
+
+static int testDrain(uint32_t workers)
+{
+    PalSerialExecutor ex("drain", workers);
+    int key;
+    int otherKey;
+    std::atomic<bool> release(false);
+    std::atomic<bool> drained(false);
+    std::atomic<bool> otherDone(false);
+    int ownStatus = 0;
+    int otherStatus = -1;
+    bool finished = false;
+    bool waitedEarly;
+
+    /* from the lane's own task, what a callback calling stop or close does */
+    CHECK(ex.post(&key, [&] { ownStatus = ex.drain(&key); }) == 0);
+    CHECK(ex.post(&key, [&] { finished = true; }) == 0);
+    CHECK(ex.drain(&key) == 0);
+    CHECK(ownStatus == -EDEADLK);
+    CHECK(finished);
+
+    /* from another lane it waits like any other caller */
+    CHECK(ex.post(&key, [&] {
+        while (!release.load())
+            usleep(100);
+    }) == 0);
+    CHECK(ex.post(&otherKey, [&] {
+        otherStatus = ex.drain(&key);
+        otherDone = true;
+    }) == 0);
+    std::thread waiter([&] {
+        ex.drain(&key);
+        drained = true;
+    });
+    usleep(20000);
+    waitedEarly = drained.load() || (otherDone.load() && workers > 1);
+    release = true;
+    waiter.join();
+    CHECK(!waitedEarly);
+    CHECK(drained.load());
+    CHECK(ex.drain(&otherKey) == 0);
+    CHECK(otherStatus == 0);
+
+    /* nothing queued, returns right away */
+    CHECK(ex.drain(&otherKey) == 0);
+    printf("drain: waits for the lane, -EDEADLK from the lane itself\n");
+    return 0;
+}
+
+static int testStop(uint32_t workers)
+{
+    PalSerialExecutor ex("stop", workers);
+    int key;
+    std::atomic<int> ran(0);
+
+    for (int i = 0; i < TASKS_PER_KEY; i++)
+        CHECK(ex.post(&key, [&] { ran++; }) == 0);
+    ex.stop();
+    CHECK(ran.load() == TASKS_PER_KEY);
+    CHECK(ex.post(&key, [&] { ran++; }) == -EPIPE);
+    CHECK(ex.drain(&key) == 0);
+    /* stop is idempotent, the destructor calls it again */
+    ex.stop();
+    printf("stop: ran %d queued tasks, later posts rejected\n", ran.load());
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t workers = PAL_EXECUTOR_DEFAULT_WORKERS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "w:h")) != -1) {
+        switch (opt) {
+        case 'w':
+            workers = atoi(optarg);
+            break;
+        default:
+            fprintf(stdout, "Usage: PalSerialExecutorTest [-w workers]\n"
+                    "  -w  worker threads, 1 to %d (%d)\n",
+                    PAL_EXECUTOR_MAX_WORKERS, PAL_EXECUTOR_DEFAULT_WORKERS);
+            return 0;
+        }
+    }
+    if (workers < 1 || workers > PAL_EXECUTOR_MAX_WORKERS)
+        workers = PAL_EXECUTOR_DEFAULT_WORKERS;
+
+    if (testOrdering(workers) || testFailure(workers) || testDrain(workers) ||
+        testStop(workers))
+        return 1;
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Multi-threaded stress test of StreamHandleTable, the table behind the
+ * public stream handles:
+ *
+ *   PalStreamHandleStress [-s streams] [-t threads] [-n seconds]
+ *
+ * Every stream is owned by one thread, which keeps closing and reopening
+ * it the way pal_stream_close/pal_stream_open do with and without
+ * StreamPool: deactivate, wait for the users to drain, then either
+ * activate again (a pooled stream handed to a new owner) or remove and
+ * insert (slot reuse). All threads meanwhile acquire and release the
+ * current handle of random streams and retry handles of closed
+ * generations. It fails when a handle resolves to another stream, to a
+ * closed stream, or when a stale handle is accepted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "PalCommon.h"
+#include "StreamHandleTable.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define STALE_HANDLES 1024
+
+struct fakeStream {
+    std::atomic<bool> open;
+    std::atomic<uintptr_t> handle;
+    uint32_t owner;
+};
+
+struct stressState {
+    StreamHandleTable table;
+    std::vector<fakeStream> streams;
+    std::atomic<uintptr_t> stale[STALE_HANDLES];
+    std::atomic<uint32_t> staleNext;
+    std::atomic<bool> stop;
+    std::atomic<uint64_t> acquires;
+    std::atomic<uint64_t> reopens;
+    std::atomic<uint64_t> errors;
+
+    stressState(uint32_t numStreams) : streams(numStreams), staleNext(0), stop(false),
+                                       acquires(0), reopens(0), errors(0)
+    {
+        for (auto &h : stale)
+            h.store(0);
+    }
+};
+
+static void fail(stressState *st, const char *what, uintptr_t handle)
+{
+    if (st->errors.fetch_add(1) < 10)
+        fprintf(stderr, "error: %s, handle %#llx\n", what, (unsigned long long)handle);
+}
+
+static void closeStream(stressState *st, fakeStream *fs)
+{
+    uintptr_t handle = fs->handle.load();
+    uint32_t users = 0;
+
+    if (st->table.deactivate(fs, &users)) {
+        fail(st, "deactivate of an open stream failed", handle);
+        return;
+    }
+    /* pal_stream_close waits on the stream semaphore for the same thing */
+    while (st->table.getUsers(fs) > 0)
+        std::this_thread::yield();
+    fs->open.store(false);
+    fs->handle.store(0);
+    st->stale[st->staleNext.fetch_add(1) % STALE_HANDLES].store(handle);
+}
+
+static void openStream(stressState *st, fakeStream *fs)
+{
+    uintptr_t handle = 0;
+
+    if (st->table.activate(fs, &handle) || !handle) {
+        fail(st, "activate failed", handle);
+        return;
+    }
+    fs->open.store(true);
+    fs->handle.store(handle);
+}
+
+static void useHandle(stressState *st, uintptr_t handle, fakeStream *expected)
+{
+    uint32_t users = 0;
+    bool drained = false;
+    fakeStream *fs = static_cast<fakeStream *>(st->table.acquire(handle, &users));
+    fakeStream *lookedUp;
+
+    if (!fs)
+        return;
+    st->acquires++;
+    if (expected && fs != expected)
+        fail(st, "handle resolved to another stream", handle);
+    if (!fs->open.load())
+        fail(st, "handle resolved to a closed stream", handle);
+    /* a close may already have retired the handle, it must not move */
+    lookedUp = static_cast<fakeStream *>(st->table.lookup(handle));
+    if (lookedUp && lookedUp != fs)
+        fail(st, "lookup disagrees with acquire", handle);
+    if (st->table.release(fs, &users, &drained))
+        fail(st, "release failed", handle);
+}
+
+static void worker(stressState *st, uint32_t id, uint32_t numThreads)
+{
+    std::mt19937 rng(id + 1);
+    uint32_t numStreams = st->streams.size();
+    uintptr_t handle;
+    fakeStream *fs;
+    uint32_t users = 0;
+    bool drained = false;
+
+    while (!st->stop.load()) {
+        fs = &st->streams[rng() % numStreams];
+        if (fs->owner == id && rng() % 8 == 0) {
+            closeStream(st, fs);
+            if (rng() % 2) {
+                /* not pooled, the slot goes back to the table */
+                st->table.remove(fs);
+                if (st->table.insert(fs))
+                    fail(st, "insert failed", 0);
+            }
+            openStream(st, fs);
+            st->reopens++;
+            continue;
+        }
+
+        handle = fs->handle.load();
+        if (handle)
+            useHandle(st, handle, fs);
+
+        handle = st->stale[rng() % STALE_HANDLES].load();
+        fs = handle ? static_cast<fakeStream *>(st->table.acquire(handle, &users)) : NULL;
+        if (fs) {
+            fail(st, "stale handle accepted", handle);
+            st->table.release(fs, &users, &drained);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t numStreams = 64;
+    uint32_t numThreads = 8;
+    uint32_t seconds = 5;
+    std::vector<std::thread> threads;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:t:n:h")) != -1) {
+        switch (opt) {
+        case 's':
+            numStreams = atoi(optarg);
+            break;
+        case 't':
+            numThreads = atoi(optarg);
+            break;
+        case 'n':
+            seconds = atoi(optarg);
+            break;
+        default:
+            numStreams = 0;
+            break;
+        }
+    }
+    if (!numStreams || numStreams > STREAM_HANDLE_TABLE_SIZE / 2 || !numThreads || !seconds) {
+        fprintf(stdout, "Usage: PalStreamHandleStress [-s streams] [-t threads] [-n seconds]\n"
+                "  -s  streams, at most %d (64)\n"
+                "  -t  threads (8)\n"
+                "  -n  run time in seconds (5)\n", STREAM_HANDLE_TABLE_SIZE / 2);
+        return 0;
+    }
+
+    stressState *st = new stressState(numStreams);
+    for (uint32_t i = 0; i < numStreams; i++) {
+        st->streams[i].owner = i % numThreads;
+        st->streams[i].open.store(false);
+        st->streams[i].handle.store(0);
+        if (st->table.insert(&st->streams[i]))
+            fail(st, "insert failed", 0);
+        openStream(st, &st->streams[i]);
+    }
+
+    for (uint32_t i = 0; i < numThreads; i++)
+        threads.emplace_back(worker, st, i, numThreads);
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    st->stop.store(true);
+    for (auto &t : threads)
+        t.join();
+
+    for (auto &fs : st->streams) {
+        if (st->table.getUsers(&fs) != 0)
+            fail(st, "user count left behind", fs.handle.load());
+    }
+    if (st->table.size() != numStreams)
+        fail(st, "table size mismatch", st->table.size());
+
+    printf("%u streams, %u threads, %u s: %llu acquires, %llu reopens, %llu errors\n",
+           numStreams, numThreads, seconds, (unsigned long long)st->acquires.load(),
+           (unsigned long long)st->reopens.load(), (unsigned long long)st->errors.load());
+    int status = st->errors.load() ? 1 : 0;
+    delete st;
+    return status;
+}
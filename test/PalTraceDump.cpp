@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Formats the binary log written with vendor.audio.pal.trace_log (see
+ * utils/inc/PalTraceLog.h):
+ *
+ *   PalTraceDump [-t tid] trace.bin
+ *
+ * Entries of all threads are merged in time order and printed like the
+ * ALOG lines they stand for, prefixed with the monotonic time in seconds,
+ * the thread and the level.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "PalTraceLog.h"
+
+struct dumpSite {
+    uint32_t level;
+    uint32_t line;
+    std::string tag;
+    std::string func;
+    std::string fmt;
+};
+
+struct dumpEntry {
+    uint32_t tid;
+    struct pal_trace_entry entry;
+};
+
+static uint32_t longSize = sizeof(long);
+
+static char levelChar(uint32_t level)
+{
+    switch (level) {
+    case PAL_LOG_ERR:
+        return 'E';
+    case PAL_LOG_INFO:
+        return 'I';
+    case PAL_LOG_DBG:
+        return 'D';
+    default:
+        return 'V';
+    }
+}
+
+/* the argument as the recorded conversion would have read it */
+static uint64_t truncateArg(uint64_t value, const std::string &length, bool isSigned)
+{
+    uint32_t bits = 32;
+
+    if (length == "hh")
+        bits = 8;
+    else if (length == "h")
+        bits = 16;
+    else if (length == "l" || length == "z" || length == "t")
+        bits = longSize * 8;
+    else if (length == "ll" || length == "j" || length == "q")
+        bits = 64;
+    if (bits == 64)
+        return value;
+
+    value &= (1ULL << bits) - 1;
+    if (isSigned && (value & (1ULL << (bits - 1))))
+        value |= ~((1ULL << bits) - 1);
+    return value;
+}
+
+static std::string formatEntry(const std::string &fmt, const uint64_t *args)
+{
+    std::string out;
+    std::string spec;
+    std::string length;
+    char buf[128];
+    uint32_t argIdx = 0;
+    uint64_t value;
+    double d;
+    size_t i = 0;
+
+    while (i < fmt.size()) {
+        if (fmt[i] != '%') {
+            out += fmt[i++];
+            continue;
+        }
+        if (i + 1 < fmt.size() && fmt[i + 1] == '%') {
+            out += '%';
+            i += 2;
+            continue;
+        }
+
+        spec = "%";
+        i++;
+        while (i < fmt.size() && strchr("-+ #0123456789.", fmt[i]))
+            spec += fmt[i++];
+        length.clear();
+        while (i < fmt.size() && strchr("hlzjtqL", fmt[i]))
+            length += fmt[i++];
+        if (i >= fmt.size())
+            break;
+
+        value = argIdx < PAL_TRACE_MAX_ARGS ? args[argIdx] : 0;
+        argIdx++;
+        switch (fmt[i]) {
+        case 'd':
+        case 'i':
+            snprintf(buf, sizeof(buf), (spec + "lld").c_str(),
+                     (long long)truncateArg(value, length, true));
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            snprintf(buf, sizeof(buf), (spec + "ll" + fmt[i]).c_str(),
+                     (unsigned long long)truncateArg(value, length, false));
+            break;
+        case 'c':
+            snprintf(buf, sizeof(buf), (spec + "c").c_str(), (int)value);
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            memcpy(&d, &value, sizeof(d));
+            snprintf(buf, sizeof(buf), (spec + fmt[i]).c_str(), d);
+            break;
+        case 'p':
+            snprintf(buf, sizeof(buf), "0x%llx", (unsigned long long)value);
+            /* %pK as used for kernel pointers */
+            if (i + 1 < fmt.size() && fmt[i + 1] == 'K')
+                i++;
+            break;
+        default:
+            snprintf(buf, sizeof(buf), "<%%%c?>", fmt[i]);
+            break;
+        }
+        out += buf;
+        i++;
+    }
+
+    while (!out.empty() && (out.back() == '\n' || out.back() == ' '))
+        out.pop_back();
+    return out;
+}
+
+static bool readAll(FILE *fp, void *data, size_t size)
+{
+    return fread(data, 1, size, fp) == size;
+}
+
+static bool readString(FILE *fp, size_t size, std::string &str)
+{
+    str.resize(size);
+    return !size || readAll(fp, &str[0], size);
+}
+
+static bool loadLog(const char *path, std::map<uint64_t, dumpSite> &sites,
+                    std::vector<dumpEntry> &entries, uint32_t *lost)
+{
+    struct pal_trace_log_header header;
+    struct pal_trace_log_site siteRec;
+    struct pal_trace_log_thread threadRec;
+    dumpEntry de;
+    dumpSite site;
+    bool ok = false;
+    FILE *fp = fopen(path, "rb");
+
+    if (!fp) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    if (!readAll(fp, &header, sizeof(header)) || header.magic != PAL_TRACE_LOG_MAGIC ||
+        header.version != PAL_TRACE_LOG_VERSION) {
+        fprintf(stderr, "%s: not a PAL trace log\n", path);
+        goto done;
+    }
+    longSize = header.long_size;
+
+    for (uint32_t i = 0; i < header.num_sites; i++) {
+        if (!readAll(fp, &siteRec, sizeof(siteRec)) ||
+            !readString(fp, siteRec.tag_len, site.tag) ||
+            !readString(fp, siteRec.func_len, site.func) ||
+            !readString(fp, siteRec.fmt_len, site.fmt)) {
+            fprintf(stderr, "%s: truncated site table\n", path);
+            goto done;
+        }
+        site.level = siteRec.level;
+        site.line = siteRec.line;
+        sites[siteRec.site] = site;
+    }
+
+    for (uint32_t i = 0; i < header.num_threads; i++) {
+        if (!readAll(fp, &threadRec, sizeof(threadRec))) {
+            fprintf(stderr, "%s: truncated, %u of %u threads\n", path, i, header.num_threads);
+            break;
+        }
+        de.tid = threadRec.tid;
+        for (uint32_t j = 0; j < threadRec.num_entries; j++) {
+            if (!readAll(fp, &de.entry, sizeof(de.entry))) {
+                fprintf(stderr, "%s: truncated entries of thread %u\n", path, de.tid);
+                break;
+            }
+            if (!de.entry.site)
+                (*lost)++;
+            else
+                entries.push_back(de);
+        }
+    }
+    ok = true;
+
+done:
+    fclose(fp);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    std::map<uint64_t, dumpSite> sites;
+    std::vector<dumpEntry> entries;
+    uint32_t lost = 0;
+    uint32_t tid = 0;
+    bool usage = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:h")) != -1) {
+        switch (opt) {
+        case 't':
+            tid = atoi(optarg);
+            break;
+        default:
+            usage = true;
+            break;
+        }
+    }
+    if (optind >= argc || usage) {
+        fprintf(stdout, "Usage: PalTraceDump [-t tid] trace.bin\n"
+                "  -t  only print the entries of thread tid\n");
+        return 0;
+    }
+    if (!loadLog(argv[optind], sites, entries, &lost))
+        return 1;
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const dumpEntry &a, const dumpEntry &b) {
+                         return a.entry.ts_ns < b.entry.ts_ns;
+                     });
+
+    for (auto &de : entries) {
+        if (tid && de.tid != tid)
+            continue;
+        auto it = sites.find(de.entry.site);
+        if (it == sites.end()) {
+            printf("%5llu.%06llu %5u ? unknown site 0x%llx\n",
+                   (unsigned long long)(de.entry.ts_ns / 1000000000ULL),
+                   (unsigned long long)(de.entry.ts_ns % 1000000000ULL / 1000),
+                   de.tid, (unsigned long long)de.entry.site);
+            continue;
+        }
+        const dumpSite &site = it->second;
+        printf("%5llu.%06llu %5u %c %s: %s: %u: %s\n",
+               (unsigned long long)(de.entry.ts_ns / 1000000000ULL),
+               (unsigned long long)(de.entry.ts_ns % 1000000000ULL / 1000),
+               de.tid, levelChar(site.level), site.tag.c_str(), site.func.c_str(),
+               site.line, formatEntry(site.fmt, de.entry.args).c_str());
+    }
+    if (lost)
+        fprintf(stderr, "%u entries were overwritten while the log was dumped\n", lost);
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Round trip checks of PalTraceLog and PalTraceDump:
+ *
+ *   PalTraceLogTest [-d dir] [-p PalTraceDump]
+ *
+ * Traces more entries than a ring holds from one thread and a few from
+ * another, dumps them and runs PalTraceDump on the file. Covers a wrapped
+ * ring keeping exactly its newest entries in order, the ring size being
+ * rounded up to a power of two, every line carrying the thread, level, tag
+ * and function of its site and the arguments formatted as the ALOG line
+ * would have been, threads being merged in time order and -t keeping one
+ * thread. Exits non-zero on the first failed check.
+ */
+
+#define LOG_TAG "PAL: PalTraceLogTest"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PalTraceLog.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR | PAL_LOG_INFO | PAL_LOG_DBG;
+
+/* rounded up to a ring of 16, which keeps the newest 15 entries */
+#define RING_ENTRIES 10
+#define RING_KEPT 15
+#define MAIN_STEPS 40
+#define WORKER_STEPS 5
+
+#define STEP_FMT "step %d of %u: 0x%08x %hd %zu%%"
+#define RATIO_FMT "ratio %.3f at %p, %lld"
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __func__, __LINE__, #cond); \
+            return -1; \
+        } \
+    } while (0)
+
+struct dumpLine {
+    uint64_t us;
+    uint32_t tid;
+    char level;
+    std::string text;           /* tag: func: line: message */
+};
+
+static std::string tracePath;
+static std::string dumpTool = "PalTraceDump";
+
+static void traceStep(int i)
+{
+    PAL_TRACE_DBG(LOG_TAG, STEP_FMT, i, (uint32_t)MAIN_STEPS, (uint32_t)i * 0x1111,
+                  -i - 40000, (size_t)i << 33);
+}
+
+static void traceRatio(int i, void *p)
+{
+    PAL_TRACE_INFO(LOG_TAG, RATIO_FMT, i / 3.0, p, -(long long)i << 40);
+}
+
+static std::string expectedStep(int i)
+{
+    char buf[128];
+
+    snprintf(buf, sizeof(buf), STEP_FMT, i, (uint32_t)MAIN_STEPS, (uint32_t)i * 0x1111,
+             -i - 40000, (size_t)i << 33);
+    return buf;
+}
+
+static std::string expectedRatio(int i, void *p)
+{
+    char buf[128];
+
+    snprintf(buf, sizeof(buf), RATIO_FMT, i / 3.0, p, -(long long)i << 40);
+    return buf;
+}
+
+/* the site part of a line, followed by the line number and the message */
+static bool isLine(const dumpLine &line, const char *func, const std::string &message)
+{
+    std::string prefix = std::string(LOG_TAG) + ": " + func + ": ";
+    std::string suffix = ": " + message;
+
+    return line.text.compare(0, prefix.size(), prefix) == 0 &&
+           line.text.size() > prefix.size() + suffix.size() &&
+           line.text.compare(line.text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static int runDump(const std::string &args, std::vector<dumpLine> &lines)
+{
+    /* stderr too, nothing may be reported lost or truncated */
+    std::string cmd = dumpTool + " " + args + " " + tracePath + " 2>&1";
+    unsigned long long sec, usec;
+    unsigned int tid;
+    char level;
+    char buf[512];
+    int pos;
+    FILE *fp = popen(cmd.c_str(), "r");
+
+    if (!fp)
+        return -1;
+    lines.clear();
+    while (fgets(buf, sizeof(buf), fp)) {
+        dumpLine line;
+
+        buf[strcspn(buf, "\n")] = '\0';
+        if (sscanf(buf, "%llu.%llu %u %c %n", &sec, &usec, &tid, &level, &pos) != 4) {
+            fprintf(stderr, "unexpected line: %s\n", buf);
+            pclose(fp);
+            return -1;
+        }
+        line.us = sec * 1000000ULL + usec;
+        line.tid = tid;
+        line.level = level;
+        line.text = buf + pos;
+        lines.push_back(line);
+    }
+    return pclose(fp) == 0 ? 0 : -1;
+}
+
+static int testRoundTrip()
+{
+    std::vector<dumpLine> lines;
+    uint32_t mainTid = (uint32_t)syscall(SYS_gettid);
+    uint32_t workerTid = 0;
+    uint32_t mainLines = 0;
+    uint32_t workerLines = 0;
+    void *ptr = &lines;
+
+    CHECK(!PalTraceLog::enabled());
+    CHECK(PalTraceLog::start(tracePath.c_str(), RING_ENTRIES) == 0);
+    CHECK(PalTraceLog::start(tracePath.c_str(), RING_ENTRIES) == -EBUSY);
+
+    for (int i = 0; i < MAIN_STEPS / 2; i++)
+        traceStep(i);
+    std::thread worker([&] {
+        workerTid = (uint32_t)syscall(SYS_gettid);
+        for (int i = 0; i < WORKER_STEPS; i++)
+            traceRatio(i, ptr);
+    });
+    worker.join();
+    for (int i = MAIN_STEPS / 2; i < MAIN_STEPS; i++)
+        traceStep(i);
+    PalTraceLog::stop();
+    CHECK(!PalTraceLog::enabled());
+
+    CHECK(runDump("", lines) == 0);
+    CHECK(lines.size() == RING_KEPT + WORKER_STEPS);
+    for (size_t i = 0; i < lines.size(); i++) {
+        const dumpLine &line = lines[i];
+
+        CHECK(!i || line.us >= lines[i - 1].us);
+        if (line.tid == mainTid) {
+            /* the ring wrapped, only the newest entries are left, oldest first */
+            CHECK(line.level == 'D');
+            CHECK(isLine(line, "traceStep",
+                         expectedStep(MAIN_STEPS - RING_KEPT + mainLines)));
+            mainLines++;
+        } else {
+            CHECK(line.tid == workerTid);
+            CHECK(line.level == 'I');
+            CHECK(isLine(line, "traceRatio", expectedRatio(workerLines, ptr)));
+            workerLines++;
+        }
+    }
+    CHECK(mainLines == RING_KEPT && workerLines == WORKER_STEPS);
+
+    /* the worker ran between the two halves of the main thread */
+    CHECK(runDump("-t " + std::to_string(workerTid), lines) == 0);
+    CHECK(lines.size() == WORKER_STEPS);
+    for (auto &line : lines)
+        CHECK(line.tid == workerTid);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string dir = "/data/local/tmp";
+    int status;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:p:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            dir = optarg;
+            break;
+        case 'p':
+            dumpTool = optarg;
+            break;
+        default:
+            fprintf(stdout, "Usage: PalTraceLogTest [-d dir] [-p PalTraceDump]\n"
+                    "  -d  writable directory for the log (/data/local/tmp)\n"
+                    "  -p  PalTraceDump to format it with (from PATH)\n");
+            return 0;
+        }
+    }
+    tracePath = dir + "/pal_trace_log_test." + std::to_string(getpid());
+
+    status = testRoundTrip();
+    unlink(tracePath.c_str());
+    if (status)
+        return 1;
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host independent benchmark of the USB stream0 parser. Feed it
+ * /proc/asound/cardN/stream0 files, either captured from a device or the
+ * ones test/usb_stream0/gen_stream0.py writes in the kernel's format:
+ *
+ *   PalUsbStreamBench [-n iterations] stream0.txt...
+ *
+ * For every file and direction it prints the parsed altsets, the cost of a
+ * full parse and the cost of the hash that keys the capability cache, which
+ * is what a reconnect of a known device pays instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "PalCommon.h"
+#include "USBStreamParser.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+static bool readFile(const char *path, std::string &text)
+{
+    char buf[4096];
+    size_t num_read;
+    FILE *fp = fopen(path, "r");
+
+    if (!fp) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    while ((num_read = fread(buf, 1, sizeof(buf), fp)) > 0)
+        text.append(buf, num_read);
+    fclose(fp);
+    return true;
+}
+
+static void benchProfile(const std::string &text, usb_usecase_type_t type,
+                         unsigned int iterations)
+{
+    std::vector<usbStreamAltset> altsets;
+    int endian = 0;
+    int status;
+    volatile uint64_t hash = 0;
+
+    status = USBStreamParser::parse(text.c_str(), type, altsets, &endian);
+    printf("  %s: status %d, %zu altsets, %s endian\n",
+           type == USB_PLAYBACK ? "playback" : "capture", status, altsets.size(),
+           endian ? "big" : "little");
+    if (status == -ENOENT)
+        return;
+    for (auto &altset : altsets)
+        printf("    %u bit, %u ch, %zu rates (mask 0x%x), interval %lu us\n",
+               altset.bit_width, altset.channels, altset.rates.size(),
+               altset.sample_rates_mask, altset.service_interval_us);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < iterations; i++) {
+        altsets.clear();
+        USBStreamParser::parse(text.c_str(), type, altsets, &endian);
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < iterations; i++)
+        hash = USBStreamParser::hash(text.c_str(), text.size());
+    auto hashed = std::chrono::steady_clock::now();
+
+    printf("    parse %.0f ns, cache key %.0f ns\n",
+           std::chrono::duration<double, std::nano>(parsed - begin).count() / iterations,
+           std::chrono::duration<double, std::nano>(hashed - parsed).count() / iterations);
+    (void)hash;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int iterations = 10000;
+    int i = 1;
+
+    if (argc > 2 && !strcmp(argv[1], "-n")) {
+        iterations = atoi(argv[2]);
+        i = 3;
+    }
+    if (i >= argc || !iterations) {
+        fprintf(stdout, "Usage: PalUsbStreamBench [-n iterations] stream0.txt...\n");
+        return 0;
+    }
+
+    for (; i < argc; i++) {
+        std::string text;
+
+        if (!readFile(argv[i], text))
+            return 1;
+        printf("%s (%zu bytes)\n", argv[i], text.size());
+        benchProfile(text, USB_PLAYBACK, iterations);
+        benchProfile(text, USB_CAPTURE, iterations);
+    }
+
+    return 0;
+}
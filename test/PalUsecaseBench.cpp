@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * End to end latency benchmark of the PAL stream API, run in process on the
+ * test/sim backend (AUDIO_FEATURE_PAL_SIM := true):
+ *
+ *   PalUsecaseBench [-n iterations] [-u usecase,...] [-o out.json]
+ *
+ * Each usecase of the matrix below is opened, started, moved to another
+ * device, stopped and closed n times against the resource manager and
+ * usecase XML the platform loads at pal_init(). For every operation it
+ * reports the p50/p99 latency and, per call, the heap allocations and the
+ * mixer accesses libpal_sim counted, as JSON so runs can be diffed by a
+ * script. A failing operation is counted in "errors" and ends that
+ * iteration, e.g. a sound trigger start without a sound model.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "PalApi.h"
+#include "PalCommon.h"
+#include "PalSim.h"
+
+#define BENCH_NUM_OPS 5
+
+enum {
+    BENCH_OP_OPEN,
+    BENCH_OP_START,
+    BENCH_OP_SET_DEVICE,
+    BENCH_OP_STOP,
+    BENCH_OP_CLOSE,
+};
+
+static const char *benchOpNames[BENCH_NUM_OPS] = {
+    "open", "start", "set_device", "stop", "close",
+};
+
+struct benchUsecase {
+    const char *name;
+    pal_stream_type_t type;
+    pal_stream_direction_t direction;
+    pal_audio_fmt_t format;
+    uint32_t numDevices;
+    pal_device_id_t devices[2];
+    pal_device_id_t switchDevices[2];
+};
+
+static const benchUsecase benchUsecases[] = {
+    {"low-latency", PAL_STREAM_LOW_LATENCY, PAL_AUDIO_OUTPUT, PAL_AUDIO_FMT_PCM_S16_LE, 1,
+        {PAL_DEVICE_OUT_SPEAKER}, {PAL_DEVICE_OUT_HANDSET}},
+    {"deep-buffer", PAL_STREAM_DEEP_BUFFER, PAL_AUDIO_OUTPUT, PAL_AUDIO_FMT_PCM_S16_LE, 1,
+        {PAL_DEVICE_OUT_SPEAKER}, {PAL_DEVICE_OUT_HANDSET}},
+    {"compress", PAL_STREAM_COMPRESSED, PAL_AUDIO_OUTPUT, PAL_AUDIO_FMT_MP3, 1,
+        {PAL_DEVICE_OUT_SPEAKER}, {PAL_DEVICE_OUT_HANDSET}},
+    {"voip", PAL_STREAM_VOIP_RX, PAL_AUDIO_OUTPUT, PAL_AUDIO_FMT_PCM_S16_LE, 1,
+        {PAL_DEVICE_OUT_HANDSET}, {PAL_DEVICE_OUT_SPEAKER}},
+    {"voice-call", PAL_STREAM_VOICE_CALL, PAL_AUDIO_INPUT_OUTPUT, PAL_AUDIO_FMT_PCM_S16_LE, 2,
+        {PAL_DEVICE_OUT_HANDSET, PAL_DEVICE_IN_HANDSET_MIC},
+        {PAL_DEVICE_OUT_SPEAKER, PAL_DEVICE_IN_SPEAKER_MIC}},
+    {"record", PAL_STREAM_DEEP_BUFFER, PAL_AUDIO_INPUT, PAL_AUDIO_FMT_PCM_S16_LE, 1,
+        {PAL_DEVICE_IN_HANDSET_MIC}, {PAL_DEVICE_IN_SPEAKER_MIC}},
+    {"sound-trigger", PAL_STREAM_VOICE_UI, PAL_AUDIO_INPUT, PAL_AUDIO_FMT_PCM_S16_LE, 1,
+        {PAL_DEVICE_IN_HANDSET_VA_MIC}, {PAL_DEVICE_IN_HANDSET_VA_MIC}},
+    {"acd", PAL_STREAM_ACD, PAL_AUDIO_INPUT, PAL_AUDIO_FMT_PCM_S16_LE, 1,
+        {PAL_DEVICE_IN_HANDSET_VA_MIC}, {PAL_DEVICE_IN_HANDSET_VA_MIC}},
+};
+
+struct benchSample {
+    uint64_t ns;
+    uint64_t allocs;
+    uint64_t mixerCalls;
+    uint64_t mixerLookups;
+};
+
+struct benchOpResult {
+    std::vector<benchSample> samples;
+    uint32_t errors = 0;
+};
+
+/*
+ * Heap accounting: malloc, calloc and realloc are interposed here, which
+ * also covers operator new. Only the thread running the measured call is
+ * counted, the sim's AGM session threads and PAL's own worker threads keep
+ * allocating in the background. Calls made while dlsym() resolves the real
+ * allocator are served from a static arena.
+ */
+typedef void *(*malloc_fn_t)(size_t);
+typedef void *(*calloc_fn_t)(size_t, size_t);
+typedef void *(*realloc_fn_t)(void *, size_t);
+typedef void (*free_fn_t)(void *);
+
+static malloc_fn_t realMalloc;
+static calloc_fn_t realCalloc;
+static realloc_fn_t realRealloc;
+static free_fn_t realFree;
+static bool resolvingHeap;
+alignas(16) static char bootstrapHeap[8192];
+static size_t bootstrapUsed;
+static thread_local bool countAllocs;
+static uint64_t numAllocs;
+
+static void *bootstrapAlloc(size_t size)
+{
+    void *ptr = NULL;
+
+    size = (size + 15) & ~(size_t)15;
+    if (bootstrapUsed + size <= sizeof(bootstrapHeap)) {
+        ptr = bootstrapHeap + bootstrapUsed;
+        bootstrapUsed += size;
+    }
+    return ptr;
+}
+
+static bool isBootstrap(void *ptr)
+{
+    return (char *)ptr >= bootstrapHeap && (char *)ptr < bootstrapHeap + sizeof(bootstrapHeap);
+}
+
+static void resolveHeap()
+{
+    resolvingHeap = true;
+    realMalloc = (malloc_fn_t)dlsym(RTLD_NEXT, "malloc");
+    realCalloc = (calloc_fn_t)dlsym(RTLD_NEXT, "calloc");
+    realRealloc = (realloc_fn_t)dlsym(RTLD_NEXT, "realloc");
+    realFree = (free_fn_t)dlsym(RTLD_NEXT, "free");
+    resolvingHeap = false;
+}
+
+extern "C" void *malloc(size_t size)
+{
+    if (!realMalloc) {
+        if (resolvingHeap)
+            return bootstrapAlloc(size);
+        resolveHeap();
+    }
+    if (countAllocs)
+        numAllocs++;
+    return realMalloc(size);
+}
+
+extern "C" void *calloc(size_t nmemb, size_t size)
+{
+    if (!realCalloc) {
+        /* the arena is zero initialized and never reused */
+        if (resolvingHeap)
+            return bootstrapAlloc(nmemb * size);
+        resolveHeap();
+    }
+    if (countAllocs)
+        numAllocs++;
+    return realCalloc(nmemb, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    void *newPtr = NULL;
+
+    if (isBootstrap(ptr) || (!realRealloc && resolvingHeap)) {
+        newPtr = malloc(size);
+        if (newPtr && ptr)
+            memcpy(newPtr, ptr, std::min(size,
+                   (size_t)(bootstrapHeap + sizeof(bootstrapHeap) - (char *)ptr)));
+        return newPtr;
+    }
+    if (!realRealloc)
+        resolveHeap();
+    if (countAllocs)
+        numAllocs++;
+    return realRealloc(ptr, size);
+}
+
+extern "C" void free(void *ptr)
+{
+    if (!ptr || isBootstrap(ptr))
+        return;
+    if (!realFree)
+        resolveHeap();
+    realFree(ptr);
+}
+
+static int32_t benchCallback(pal_stream_handle_t * /*stream_handle*/,
+                             uint32_t /*event_id*/, uint32_t * /*event_data*/,
+                             uint32_t /*event_data_size*/, uint64_t /*cookie*/)
+{
+    return 0;
+}
+
+static void fillMediaConfig(struct pal_media_config *config, pal_audio_fmt_t format,
+                            uint16_t channels)
+{
+    config->sample_rate = 48000;
+    config->bit_width = 16;
+    config->aud_fmt_id = format;
+    config->ch_info.channels = channels;
+    config->ch_info.ch_map[0] = PAL_CHMAP_CHANNEL_FL;
+    if (channels > 1)
+        config->ch_info.ch_map[1] = PAL_CHMAP_CHANNEL_FR;
+}
+
+static void fillDevices(struct pal_device *devices, const pal_device_id_t *ids,
+                        uint32_t numDevices)
+{
+    for (uint32_t i = 0; i < numDevices; i++) {
+        memset(&devices[i], 0, sizeof(devices[i]));
+        devices[i].id = ids[i];
+        fillMediaConfig(&devices[i].config, PAL_AUDIO_FMT_PCM_S16_LE,
+                        ids[i] < PAL_DEVICE_IN_MIN ? 2 : 1);
+    }
+}
+
+static int32_t runOp(benchOpResult &result, int32_t (*op)(void *), void *arg)
+{
+    struct pal_sim_stats before, after;
+    benchSample sample;
+    int32_t status;
+
+    pal_sim_get_stats(&before);
+    numAllocs = 0;
+    countAllocs = true;
+    auto begin = std::chrono::steady_clock::now();
+    status = op(arg);
+    auto end = std::chrono::steady_clock::now();
+    countAllocs = false;
+    pal_sim_get_stats(&after);
+
+    if (status) {
+        result.errors++;
+        return status;
+    }
+    sample.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    sample.allocs = numAllocs;
+    sample.mixerCalls = (after.mixer_reads - before.mixer_reads) +
+                        (after.mixer_writes - before.mixer_writes);
+    sample.mixerLookups = after.mixer_lookups - before.mixer_lookups;
+    result.samples.push_back(sample);
+    return 0;
+}
+
+struct benchContext {
+    const benchUsecase *usecase;
+    struct pal_stream_attributes attr;
+    struct pal_device devices[2];
+    pal_stream_handle_t *handle;
+};
+
+static int32_t benchOpen(void *arg)
+{
+    benchContext *ctx = (benchContext *)arg;
+
+    return pal_stream_open(&ctx->attr, ctx->usecase->numDevices, ctx->devices, 0, NULL,
+                           benchCallback, 0, &ctx->handle);
+}
+
+static int32_t benchStart(void *arg)
+{
+    return pal_stream_start(((benchContext *)arg)->handle);
+}
+
+static int32_t benchSetDevice(void *arg)
+{
+    benchContext *ctx = (benchContext *)arg;
+
+    return pal_stream_set_device(ctx->handle, ctx->usecase->numDevices, ctx->devices);
+}
+
+static int32_t benchStop(void *arg)
+{
+    return pal_stream_stop(((benchContext *)arg)->handle);
+}
+
+static int32_t benchClose(void *arg)
+{
+    return pal_stream_close(((benchContext *)arg)->handle);
+}
+
+static void benchUsecaseRun(const benchUsecase &usecase, unsigned int iterations,
+                            benchOpResult *results)
+{
+    benchContext ctx;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.usecase = &usecase;
+    ctx.attr.type = usecase.type;
+    ctx.attr.direction = usecase.direction;
+    if (usecase.type == PAL_STREAM_VOICE_CALL) {
+        ctx.attr.info.voice_call_info.VSID = VOICEMMODE1;
+        ctx.attr.info.voice_call_info.tty_mode = PAL_TTY_OFF;
+    }
+    if (usecase.direction & PAL_AUDIO_INPUT)
+        fillMediaConfig(&ctx.attr.in_media_config, usecase.format, 1);
+    if (usecase.direction & PAL_AUDIO_OUTPUT)
+        fillMediaConfig(&ctx.attr.out_media_config, usecase.format, 2);
+
+    for (unsigned int i = 0; i < iterations; i++) {
+        ctx.handle = NULL;
+        fillDevices(ctx.devices, usecase.devices, usecase.numDevices);
+        if (runOp(results[BENCH_OP_OPEN], benchOpen, &ctx))
+            continue;
+        if (!runOp(results[BENCH_OP_START], benchStart, &ctx)) {
+            fillDevices(ctx.devices, usecase.switchDevices, usecase.numDevices);
+            runOp(results[BENCH_OP_SET_DEVICE], benchSetDevice, &ctx);
+            runOp(results[BENCH_OP_STOP], benchStop, &ctx);
+        }
+        runOp(results[BENCH_OP_CLOSE], benchClose, &ctx);
+    }
+}
+
+/* nearest rank percentile in microseconds */
+static double percentileUs(std::vector<uint64_t> &ns, unsigned int pct)
+{
+    size_t rank;
+
+    if (ns.empty())
+        return 0;
+    std::sort(ns.begin(), ns.end());
+    rank = (ns.size() * pct + 99) / 100;
+    return ns[rank ? rank - 1 : 0] / 1000.0;
+}
+
+static void printOp(FILE *out, const char *name, const benchOpResult &result, bool last)
+{
+    std::vector<uint64_t> ns;
+    double allocs = 0, mixerCalls = 0, mixerLookups = 0;
+    size_t runs = result.samples.size();
+
+    for (auto &sample : result.samples) {
+        ns.push_back(sample.ns);
+        allocs += sample.allocs;
+        mixerCalls += sample.mixerCalls;
+        mixerLookups += sample.mixerLookups;
+    }
+    if (runs) {
+        allocs /= runs;
+        mixerCalls /= runs;
+        mixerLookups /= runs;
+    }
+    fprintf(out, "        \"%s\": {\"runs\": %zu, \"errors\": %u, \"p50_us\": %.1f, "
+            "\"p99_us\": %.1f, \"allocs\": %.1f, \"mixer_calls\": %.1f, "
+            "\"mixer_lookups\": %.1f}%s\n", name, runs, result.errors,
+            percentileUs(ns, 50), percentileUs(ns, 99), allocs, mixerCalls,
+            mixerLookups, last ? "" : ",");
+}
+
+static bool isSelected(const char *list, const char *name)
+{
+    std::string names = std::string(",") + list + ",";
+
+    return names.find(std::string(",") + name + ",") != std::string::npos;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int iterations = 50;
+    const char *selected = NULL;
+    const char *outPath = NULL;
+    FILE *out = stdout;
+    bool first = true;
+    int32_t status;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:u:o:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 'u':
+            selected = optarg;
+            break;
+        case 'o':
+            outPath = optarg;
+            break;
+        default:
+            iterations = 0;
+            break;
+        }
+    }
+    if (!iterations) {
+        fprintf(stdout, "Usage: PalUsecaseBench [-n iterations] [-u usecase,...] [-o out.json]\n"
+                "usecases:");
+        for (auto &usecase : benchUsecases)
+            fprintf(stdout, " %s", usecase.name);
+        fprintf(stdout, "\n");
+        return 0;
+    }
+
+    pal_log_lvl = PAL_LOG_ERR;
+    status = pal_init();
+    if (status) {
+        fprintf(stderr, "pal_init failed %d\n", status);
+        return 1;
+    }
+    /* the resource manager XML may have set its own level */
+    pal_log_lvl = PAL_LOG_ERR;
+    if (outPath) {
+        out = fopen(outPath, "w");
+        if (!out) {
+            fprintf(stderr, "cannot open %s\n", outPath);
+            pal_deinit();
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"iterations\": %u,\n  \"usecases\": [\n", iterations);
+    for (auto &usecase : benchUsecases) {
+        benchOpResult results[BENCH_NUM_OPS];
+
+        if (selected && !isSelected(selected, usecase.name))
+            continue;
+        benchUsecaseRun(usecase, iterations, results);
+        fprintf(out, "%s    {\n      \"name\": \"%s\",\n      \"stream_type\": %d,\n"
+                "      \"ops\": {\n", first ? "" : ",\n", usecase.name, usecase.type);
+        for (int op = 0; op < BENCH_NUM_OPS; op++)
+            printOp(out, benchOpNames[op], results[op], op == BENCH_NUM_OPS - 1);
+        fprintf(out, "      }\n    }");
+        first = false;
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout)
+        fclose(out);
+    pal_deinit();
+    return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks of StreamVirtualClock, the clock streams fall back to while the
+ * sound card is offline:
+ *
+ *   PalVirtualClockTest [-n buffers]
+ *
+ * Covers consume() handing out due times one buffer duration apart and
+ * restarting from now instead of bursting once the client falls behind,
+ * getTimestamp() never going backwards nor ahead of the consumed data,
+ * handOver() and adjust() carrying the position on into the session time
+ * instead of jumping back to it, and reset(). Exits non-zero on the first
+ * failed check.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include "PalCommon.h"
+#include "StreamVirtualClock.h"
+
+uint32_t pal_log_lvl = PAL_LOG_ERR;
+
+#define SAMPLE_RATE 48000
+#define FRAME_SIZE 4                    /* stereo 16 bit */
+#define BUFFER_US 10000
+#define BUFFER_BYTES (SAMPLE_RATE / 100 * FRAME_SIZE)
+/* how late a thread may wake up or run on a loaded host */
+#define SLACK_US 20000
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __func__, __LINE__, #cond); \
+            return -1; \
+        } \
+    } while (0)
+
+typedef std::chrono::steady_clock::time_point timePoint;
+
+static int64_t usBetween(timePoint from, timePoint to)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+static uint64_t toUs(const struct pal_time_us &t)
+{
+    return ((uint64_t)t.value_msw << 32) | t.value_lsw;
+}
+
+static void fromUs(struct pal_time_us &t, uint64_t us)
+{
+    t.value_lsw = (uint32_t)us;
+    t.value_msw = (uint32_t)(us >> 32);
+}
+
+static uint64_t positionUs(StreamVirtualClock &clock)
+{
+    struct pal_session_time stime = {};
+
+    clock.getTimestamp(&stime);
+    return toUs(stime.session_time);
+}
+
+/* a client keeping up gets due times one buffer apart, starting now */
+static int testPacing(uint32_t buffers)
+{
+    StreamVirtualClock clock;
+    timePoint begin = std::chrono::steady_clock::now();
+    timePoint first = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+    timePoint due;
+
+    CHECK(clock.isRunning());
+    CHECK(usBetween(begin, first) >= 0 && usBetween(begin, first) < SLACK_US);
+
+    /* queued back to back without waiting */
+    for (uint32_t i = 1; i < buffers; i++) {
+        due = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+        CHECK(usBetween(first, due) == (int64_t)i * BUFFER_US);
+    }
+
+    /* waiting for each due time like the streams do keeps the schedule */
+    for (uint32_t i = buffers; i < 2 * buffers; i++) {
+        std::this_thread::sleep_until(due);
+        due = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+        CHECK(usBetween(first, due) == (int64_t)i * BUFFER_US);
+    }
+    return 0;
+}
+
+/* a client that stalls is not paid back with a burst of past due times */
+static int testFallBehind(uint32_t buffers)
+{
+    StreamVirtualClock clock;
+    timePoint due;
+    timePoint now;
+
+    for (uint32_t i = 0; i < buffers; i++)
+        due = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+    std::this_thread::sleep_until(due + std::chrono::microseconds(3 * BUFFER_US));
+
+    now = std::chrono::steady_clock::now();
+    due = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+    CHECK(usBetween(now, due) >= 0 && usBetween(now, due) < SLACK_US);
+    CHECK(usBetween(due, clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE)) == BUFFER_US);
+    return 0;
+}
+
+/* the position follows the clock, never passes the data and never goes back */
+static int testTimestamp(uint32_t buffers)
+{
+    StreamVirtualClock clock;
+    timePoint first;
+    timePoint due;
+    uint64_t last = 0;
+    uint64_t pos;
+    int64_t elapsed;
+
+    CHECK(positionUs(clock) == 0);
+    first = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+    for (uint32_t i = 1; i < buffers; i++) {
+        due = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+        std::this_thread::sleep_until(due - std::chrono::microseconds(BUFFER_US / 2));
+
+        pos = positionUs(clock);
+        elapsed = usBetween(first, std::chrono::steady_clock::now());
+        CHECK(pos >= last);
+        CHECK(pos <= (uint64_t)(i + 1) * BUFFER_US);
+        CHECK((int64_t)pos <= elapsed && (int64_t)pos > elapsed - SLACK_US);
+        last = pos;
+    }
+
+    /* out of data: the position stops where the data ends */
+    std::this_thread::sleep_until(due + std::chrono::microseconds(2 * BUFFER_US));
+    CHECK(positionUs(clock) == (uint64_t)buffers * BUFFER_US);
+    CHECK(positionUs(clock) == (uint64_t)buffers * BUFFER_US);
+    return 0;
+}
+
+/*
+ * Once the session is written again its time, which restarts from zero
+ * after SSR, is offset to carry on from the virtual position.
+ */
+static int testHandOver(uint32_t buffers)
+{
+    StreamVirtualClock clock;
+    struct pal_session_time stime = {};
+    timePoint due;
+    uint64_t before;
+    uint64_t pos;
+
+    /* the session had reported 5 s before the card went offline */
+    fromUs(stime.session_time, 5000000);
+    fromUs(stime.timestamp, 5000000);
+    clock.adjust(&stime);
+    CHECK(toUs(stime.session_time) == 5000000);
+    CHECK(positionUs(clock) == 5000000);
+
+    for (uint32_t i = 0; i < buffers; i++)
+        due = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+    std::this_thread::sleep_until(due);
+    before = positionUs(clock);
+    CHECK(before >= 5000000 + (uint64_t)(buffers - 1) * BUFFER_US);
+
+    clock.handOver();
+    CHECK(!clock.isRunning());
+
+    /* the first session time after recovery is rebased onto the hand over */
+    memset(&stime, 0, sizeof(stime));
+    fromUs(stime.session_time, 2000);
+    fromUs(stime.timestamp, 2000);
+    clock.adjust(&stime);
+    pos = toUs(stime.session_time);
+    CHECK(pos >= before);
+    CHECK(pos <= 5000000 + (uint64_t)buffers * BUFFER_US);
+    CHECK(pos == toUs(stime.timestamp));
+
+    /* and later ones keep the same offset */
+    memset(&stime, 0, sizeof(stime));
+    fromUs(stime.session_time, 2000 + BUFFER_US);
+    fromUs(stime.timestamp, 2000 + BUFFER_US);
+    clock.adjust(&stime);
+    CHECK(toUs(stime.session_time) == pos + BUFFER_US);
+
+    /* going offline again continues from the adjusted position */
+    clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+    CHECK(positionUs(clock) >= pos + BUFFER_US);
+
+    clock.reset();
+    CHECK(!clock.isRunning());
+    CHECK(positionUs(clock) == 0);
+    memset(&stime, 0, sizeof(stime));
+    fromUs(stime.session_time, 2000);
+    clock.adjust(&stime);
+    CHECK(toUs(stime.session_time) == 2000);
+    return 0;
+}
+
+/* handing over before the session reports anything keeps the position too */
+static int testOfflineAgain(uint32_t buffers)
+{
+    StreamVirtualClock clock;
+    timePoint due;
+    uint64_t before;
+
+    for (uint32_t i = 0; i < buffers; i++)
+        due = clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+    std::this_thread::sleep_until(due);
+    before = positionUs(clock);
+    clock.handOver();
+
+    clock.consume(BUFFER_BYTES, FRAME_SIZE, SAMPLE_RATE);
+    CHECK(clock.isRunning());
+    CHECK(positionUs(clock) >= before);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t buffers = 10;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            buffers = atoi(optarg);
+            break;
+        default:
+            fprintf(stdout, "Usage: PalVirtualClockTest [-n buffers]\n"
+                    "  -n  10 ms buffers per check, 2 or more (10)\n");
+            return 0;
+        }
+    }
+    if (buffers < 2)
+        buffers = 10;
+
+    if (testPacing(buffers) || testFallBehind(buffers) || testTimestamp(buffers) ||
+        testHandOver(buffers) || testOfflineAgain(buffers))
+        return 1;
+
+    printf("PASS\n");
+    return 0;
+}
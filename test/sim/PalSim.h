@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_SIM_H
+#define PAL_SIM_H
+
+/*
+ * Hardware free backend for PAL.
+ *
+ * libpal_sim implements the tinyalsa pcm and mixer, tinycompress,
+ * audio_route and AGM session calls that PAL makes, so a PAL built with
+ * AUDIO_FEATURE_PAL_SIM := true (Android.mk) or --with-sim (autotools) runs
+ * on a machine without a sound card or ADSP:
+ *
+ *  - mixers for the codec card and the AGM virtual card, padded with filler
+ *    controls to the size of a real card and searched linearly by name like
+ *    tinyalsa does. Unknown names are created on first lookup unless
+ *    PAL_SIM_STRICT_MIXER is set. Writes cost a configurable delay, the AGM
+ *    card being an IPC away on target. "getTaggedInfo" returns a fake graph
+ *    holding the tags of kvh2xml.h.
+ *  - pcm and compress devices played out and captured against the monotonic
+ *    clock at the configured rate, with xrun accounting and mmap support.
+ *  - audio_route paths that each write PAL_SIM_ROUTE_CTLS codec controls.
+ *  - AGM non tunnel sessions processing a buffer every PAL_SIM_AGM_NT_US and
+ *    posting the read/write done and eos events from a session thread.
+ *
+ * The backend is configured from the environment at first use:
+ *   PAL_SIM_CARD_NAME      codec card name, "waipio-qrd-snd-card"
+ *   PAL_SIM_HW_CARD        codec card number, 0
+ *   PAL_SIM_VIRT_CARD      AGM virtual card number, 100
+ *   PAL_SIM_HW_CTLS        controls on the codec card, 3000
+ *   PAL_SIM_VIRT_CTLS      controls on the virtual card, 1800
+ *   PAL_SIM_HW_CTL_US      cost of a codec control write, 10
+ *   PAL_SIM_VIRT_CTL_US    cost of a virtual control access, 100
+ *   PAL_SIM_ROUTE_CTLS     codec controls written per audio_route path, 8
+ *   PAL_SIM_AGM_NT_US      non tunnel buffer processing time, 500
+ *   PAL_SIM_STRICT_MIXER   fail lookups of unknown controls when set to 1
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct pal_sim_stats {
+    uint64_t mixer_lookups;
+    uint64_t mixer_lookup_ns;     /* time spent searching controls */
+    uint64_t mixer_ctls_created;  /* unknown names created on lookup */
+    uint64_t mixer_reads;
+    uint64_t mixer_writes;
+    uint64_t route_paths;
+    uint64_t pcm_opens;
+    uint64_t pcm_starts;
+    uint64_t pcm_frames;          /* frames written or read */
+    uint64_t pcm_xruns;
+    uint64_t compress_opens;
+    uint64_t compress_bytes;
+    uint64_t agm_sessions;
+    uint64_t agm_events;
+};
+
+/* counters since load or the last pal_sim_reset_stats() */
+void pal_sim_get_stats(struct pal_sim_stats *stats);
+void pal_sim_reset_stats(void);
+
+/* while offline pcm, compress and AGM i/o fails with ENETRESET */
+void pal_sim_set_card_online(bool online);
+
+/*
+ * Store payload in the named control of the virtual card and wake the
+ * mixer_wait_event() caller, like AGM does for "PCM<n> event".
+ */
+int pal_sim_post_mixer_event(const char *ctl_name, const void *payload, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAL_SIM_H */
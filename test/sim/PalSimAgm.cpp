@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: SimAgm"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <agm/agm_api.h>
+#include "PalSimInternal.h"
+#include "PalCommon.h"
+
+#define PAL_SIM_AGM_HANDLE_TAG (0x5A11ULL << 32)
+
+/*
+ * Non tunnel sessions. Buffers are queued by the read and write calls and
+ * handed back from the session thread PAL_SIM_AGM_NT_US apart once the
+ * session is started, as the read done and write done events PAL waits on.
+ */
+struct simAgmJob {
+    uint32_t eventId;
+    struct agm_buff buff;
+};
+
+struct simAgmSession {
+    uint32_t id = 0;
+    agm_event_cb dataCb = NULL;
+    void *dataCookie = NULL;
+    bool running = false;
+    bool exit = false;
+    std::deque<simAgmJob> jobs;
+    std::mutex lock;
+    std::condition_variable cv;
+    std::thread worker;
+};
+
+static std::mutex agmLock;
+static std::map<uint32_t, std::shared_ptr<simAgmSession>> agmSessions;
+
+static std::shared_ptr<simAgmSession> findSession(uint32_t sessionId)
+{
+    std::lock_guard<std::mutex> lock(agmLock);
+    auto it = agmSessions.find(sessionId);
+
+    return it == agmSessions.end() ? nullptr : it->second;
+}
+
+static std::shared_ptr<simAgmSession> fromHandle(uint64_t handle)
+{
+    if ((handle & ~0xFFFFFFFFULL) != PAL_SIM_AGM_HANDLE_TAG)
+        return nullptr;
+    return findSession((uint32_t)handle);
+}
+
+static void postEvent(simAgmSession *session, const simAgmJob &job)
+{
+    struct agm_event_cb_params *params = NULL;
+    struct agm_event_read_write_done_payload done = {};
+    size_t payloadSize = 0;
+    agm_event_cb cb = NULL;
+    void *cookie = NULL;
+
+    {
+        std::lock_guard<std::mutex> lock(session->lock);
+        cb = session->dataCb;
+        cookie = session->dataCookie;
+    }
+    if (!cb)
+        return;
+
+    if (job.eventId != AGM_EVENT_EOS_RENDERED)
+        payloadSize = sizeof(struct agm_event_read_write_done_payload);
+    params = (struct agm_event_cb_params *)calloc(1, sizeof(*params) + payloadSize);
+    if (!params) {
+        PAL_ERR(LOG_TAG, "no memory for event of session %u", session->id);
+        return;
+    }
+    params->event_id = job.eventId;
+    params->event_payload_size = payloadSize;
+    if (payloadSize) {
+        /* the payload follows the header unaligned */
+        done.buff = job.buff;
+        memcpy(params->event_payload, &done, payloadSize);
+    }
+    cb(session->id, params, cookie);
+    palSimStats.agmEvents++;
+    free(params);
+}
+
+static void sessionLoop(simAgmSession *session)
+{
+    std::unique_lock<std::mutex> lock(session->lock);
+
+    for (;;) {
+        session->cv.wait(lock, [session] {
+            return session->exit || (session->running && !session->jobs.empty());
+        });
+        if (session->exit)
+            return;
+        simAgmJob job = session->jobs.front();
+        session->jobs.pop_front();
+        lock.unlock();
+        palSimDelayUs(palSimConfig().agmNtUs);
+        postEvent(session, job);
+        lock.lock();
+    }
+}
+
+static int queueJob(uint64_t handle, uint32_t eventId, struct agm_buff *buff)
+{
+    std::shared_ptr<simAgmSession> session = fromHandle(handle);
+    simAgmJob job = {};
+
+    if (!session)
+        return -EINVAL;
+    if (!palSimOnline())
+        return -ENETRESET;
+
+    job.eventId = eventId;
+    if (buff)
+        job.buff = *buff;
+    std::lock_guard<std::mutex> lock(session->lock);
+    session->jobs.push_back(job);
+    session->cv.notify_one();
+    return 0;
+}
+
+static int setRunning(uint64_t handle, bool running, bool flush)
+{
+    std::shared_ptr<simAgmSession> session = fromHandle(handle);
+
+    if (!session)
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(session->lock);
+    session->running = running;
+    if (flush)
+        session->jobs.clear();
+    session->cv.notify_one();
+    return 0;
+}
+
+extern "C" {
+
+int agm_session_set_metadata(uint32_t session_id, uint32_t size, uint8_t * /*metadata*/)
+{
+    PAL_DBG(LOG_TAG, "session %u metadata of %u bytes", session_id, size);
+    palSimDelayUs(palSimConfig().virtCtlUs);
+    return 0;
+}
+
+int agm_session_open(uint32_t session_id, enum agm_session_mode sess_mode, uint64_t *handle)
+{
+    std::shared_ptr<simAgmSession> session;
+
+    if (!handle)
+        return -EINVAL;
+    if (!palSimOnline())
+        return -ENETRESET;
+
+    std::lock_guard<std::mutex> lock(agmLock);
+    if (agmSessions.count(session_id)) {
+        PAL_ERR(LOG_TAG, "session %u already open", session_id);
+        return -EALREADY;
+    }
+    session = std::make_shared<simAgmSession>();
+    session->id = session_id;
+    session->worker = std::thread(sessionLoop, session.get());
+    agmSessions[session_id] = session;
+    *handle = PAL_SIM_AGM_HANDLE_TAG | session_id;
+    palSimStats.agmSessions++;
+    PAL_DBG(LOG_TAG, "session %u opened, mode %d", session_id, sess_mode);
+    return 0;
+}
+
+int agm_session_register_cb(uint32_t session_id, agm_event_cb cb,
+                            enum event_type evt_type, void *client_data)
+{
+    std::shared_ptr<simAgmSession> session = findSession(session_id);
+
+    if (!session)
+        return -EINVAL;
+    /* module events are never raised by the sim */
+    if (evt_type != AGM_EVENT_DATA_PATH)
+        return 0;
+    std::lock_guard<std::mutex> lock(session->lock);
+    session->dataCb = cb;
+    session->dataCookie = client_data;
+    return 0;
+}
+
+int agm_session_set_non_tunnel_mode_config(uint64_t handle,
+        struct agm_session_config * /*session_config*/,
+        struct agm_media_config * /*in_media_config*/,
+        struct agm_media_config * /*out_media_config*/,
+        struct agm_buffer_config * /*in_buffer_config*/,
+        struct agm_buffer_config * /*out_buffer_config*/)
+{
+    return fromHandle(handle) ? 0 : -EINVAL;
+}
+
+int agm_session_close(uint64_t handle)
+{
+    std::shared_ptr<simAgmSession> session = fromHandle(handle);
+
+    if (!session)
+        return -EINVAL;
+    {
+        std::lock_guard<std::mutex> lock(agmLock);
+        agmSessions.erase(session->id);
+    }
+    {
+        std::lock_guard<std::mutex> lock(session->lock);
+        session->exit = true;
+        session->cv.notify_one();
+    }
+    session->worker.join();
+    PAL_DBG(LOG_TAG, "session %u closed", session->id);
+    return 0;
+}
+
+int agm_session_prepare(uint64_t handle)
+{
+    return fromHandle(handle) ? 0 : -EINVAL;
+}
+
+int agm_session_start(uint64_t handle)
+{
+    if (!palSimOnline())
+        return -ENETRESET;
+    return setRunning(handle, true, false);
+}
+
+int agm_session_stop(uint64_t handle)
+{
+    return setRunning(handle, false, true);
+}
+
+int agm_session_suspend(uint64_t handle)
+{
+    return setRunning(handle, false, false);
+}
+
+int agm_session_flush(uint64_t handle)
+{
+    std::shared_ptr<simAgmSession> session = fromHandle(handle);
+
+    if (!session)
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(session->lock);
+    session->jobs.clear();
+    return 0;
+}
+
+int agm_session_eos(uint64_t handle)
+{
+    return queueJob(handle, AGM_EVENT_EOS_RENDERED, NULL);
+}
+
+int agm_session_write_with_metadata(uint64_t handle, struct agm_buff *buff,
+                                    size_t *consumed_size)
+{
+    int ret = 0;
+
+    if (!buff)
+        return -EINVAL;
+    ret = queueJob(handle, AGM_EVENT_WRITE_DONE, buff);
+    if (!ret && consumed_size)
+        *consumed_size = buff->size;
+    return ret;
+}
+
+int agm_session_read_with_metadata(uint64_t handle, struct agm_buff *buff,
+                                   uint32_t *captured_size)
+{
+    int ret = 0;
+
+    if (!buff)
+        return -EINVAL;
+    if (buff->addr)
+        memset(buff->addr, 0, buff->size);
+    ret = queueJob(handle, AGM_EVENT_READ_DONE, buff);
+    if (!ret && captured_size)
+        *captured_size = buff->size;
+    return ret;
+}
+
+int agm_session_set_params(uint32_t session_id, void * /*payload*/, size_t size)
+{
+    PAL_DBG(LOG_TAG, "session %u params of %zu bytes", session_id, size);
+    palSimDelayUs(palSimConfig().virtCtlUs);
+    return 0;
+}
+
+int agm_session_aif_get_tag_module_info(uint32_t session_id, uint32_t /*aif_id*/,
+                                        void *payload, size_t *size)
+{
+    if (!size)
+        return -EINVAL;
+    palSimDelayUs(palSimConfig().virtCtlUs);
+    if (!payload)
+        *size = palSimTagModuleInfo(session_id, NULL, 0);
+    else
+        palSimTagModuleInfo(session_id, payload, *size);
+    return 0;
+}
+
+/* the sim service never goes away */
+int agm_register_service_crash_callback(agm_service_crash_cb /*cb*/, uint64_t /*cookie*/)
+{
+    return 0;
+}
+
+int agm_dump(struct agm_dump_info * /*dump_info*/)
+{
+    std::lock_guard<std::mutex> lock(agmLock);
+
+    PAL_INFO(LOG_TAG, "dump requested, %zu sessions open", agmSessions.size());
+    return 0;
+}
+
+}
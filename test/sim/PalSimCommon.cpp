@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: Sim"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include "PalSimInternal.h"
+#include "PalCommon.h"
+#include "kvh2xml.h"
+
+#define PAL_SIM_MODULE_ID_BASE 0x07001000
+#define PAL_SIM_MIID_BASE      0x4000
+
+struct pal_sim_counters palSimStats;
+static std::atomic<bool> simOnline{true};
+
+/* tags every fake graph carries, one module each */
+static const uint32_t simGraphTags[] = {
+    SHMEM_ENDPOINT,
+    STREAM_INPUT_MEDIA_FORMAT,
+    STREAM_OUTPUT_MEDIA_FORMAT,
+    DEVICE_HW_ENDPOINT_RX,
+    DEVICE_HW_ENDPOINT_TX,
+    TAG_PAUSE,
+    TAG_MUTE,
+    DEVICE_SVA,
+    DEVICE_ADAM,
+    TAG_ECNS,
+    STREAM_MFC,
+    DEVICE_MFC,
+    TAG_STREAM_VOLUME,
+    STREAM_PCM_DECODER,
+    STREAM_PCM_ENCODER,
+    STREAM_PCM_CONVERTER,
+    TAG_DEVICE_PP_MFC,
+    TAG_STREAM_PLACEHOLDER_DECODER,
+    TAG_STREAM_EQUALIZER,
+    TAG_STREAM_VIRTUALIZER,
+    TAG_STREAM_REVERB,
+    TAG_STREAM_PBE,
+    TAG_STREAM_BASS_BOOST,
+    PER_STREAM_PER_DEVICE_MFC,
+    TAG_STREAM_SLOWTALK,
+    TAG_MODULE_CHANNELS,
+    TAG_STREAM_MUXDEMUX,
+    TAG_DEVICE_MUX,
+};
+
+static unsigned int envValue(const char *name, unsigned int def)
+{
+    const char *value = getenv(name);
+
+    return value ? (unsigned int)strtoul(value, NULL, 0) : def;
+}
+
+const struct pal_sim_config &palSimConfig()
+{
+    static const struct pal_sim_config config = [] {
+        struct pal_sim_config c;
+        const char *name = getenv("PAL_SIM_CARD_NAME");
+
+        c.cardName = name ? name : "waipio-qrd-snd-card";
+        c.hwCard = envValue("PAL_SIM_HW_CARD", 0);
+        c.virtCard = envValue("PAL_SIM_VIRT_CARD", 100);
+        c.hwCtls = envValue("PAL_SIM_HW_CTLS", 3000);
+        c.virtCtls = envValue("PAL_SIM_VIRT_CTLS", 1800);
+        c.hwCtlUs = envValue("PAL_SIM_HW_CTL_US", 10);
+        c.virtCtlUs = envValue("PAL_SIM_VIRT_CTL_US", 100);
+        c.routeCtls = envValue("PAL_SIM_ROUTE_CTLS", 8);
+        c.agmNtUs = envValue("PAL_SIM_AGM_NT_US", 500);
+        c.strictMixer = envValue("PAL_SIM_STRICT_MIXER", 0) != 0;
+        PAL_INFO(LOG_TAG, "sim card %s, %u/%u controls, %u/%u us per control",
+                 c.cardName.c_str(), c.hwCtls, c.virtCtls, c.hwCtlUs, c.virtCtlUs);
+        return c;
+    }();
+
+    return config;
+}
+
+bool palSimOnline()
+{
+    return simOnline;
+}
+
+void palSimDelayUs(unsigned int us)
+{
+    if (us)
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+uint64_t palSimUnits(std::chrono::steady_clock::duration elapsed, uint64_t rate)
+{
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+    return (ns / 1000) * rate / 1000000 + (ns % 1000) * rate / 1000000000;
+}
+
+std::chrono::steady_clock::duration palSimDuration(uint64_t units, uint64_t rate)
+{
+    if (!rate)
+        return std::chrono::steady_clock::duration::zero();
+    /* rounded up so a waiter never wakes short of the data it waits for */
+    return std::chrono::microseconds((units * 1000000 + rate - 1) / rate);
+}
+
+size_t palSimTagModuleInfo(uint32_t graphId, void *payload, size_t size)
+{
+    const size_t numTags = sizeof(simGraphTags) / sizeof(simGraphTags[0]);
+    std::vector<uint32_t> info;
+
+    /* num_tags, then tag_id, num_modules and module_id, module_iid per tag */
+    info.push_back(numTags);
+    for (size_t i = 0; i < numTags; i++) {
+        info.push_back(simGraphTags[i]);
+        info.push_back(1);
+        info.push_back(PAL_SIM_MODULE_ID_BASE + i);
+        info.push_back(PAL_SIM_MIID_BASE + graphId * 0x100 + i);
+    }
+
+    if (payload)
+        memcpy(payload, info.data(), std::min(size, info.size() * sizeof(uint32_t)));
+    return info.size() * sizeof(uint32_t);
+}
+
+extern "C" void pal_sim_get_stats(struct pal_sim_stats *stats)
+{
+    stats->mixer_lookups = palSimStats.mixerLookups;
+    stats->mixer_lookup_ns = palSimStats.mixerLookupNs;
+    stats->mixer_ctls_created = palSimStats.mixerCtlsCreated;
+    stats->mixer_reads = palSimStats.mixerReads;
+    stats->mixer_writes = palSimStats.mixerWrites;
+    stats->route_paths = palSimStats.routePaths;
+    stats->pcm_opens = palSimStats.pcmOpens;
+    stats->pcm_starts = palSimStats.pcmStarts;
+    stats->pcm_frames = palSimStats.pcmFrames;
+    stats->pcm_xruns = palSimStats.pcmXruns;
+    stats->compress_opens = palSimStats.compressOpens;
+    stats->compress_bytes = palSimStats.compressBytes;
+    stats->agm_sessions = palSimStats.agmSessions;
+    stats->agm_events = palSimStats.agmEvents;
+}
+
+extern "C" void pal_sim_reset_stats(void)
+{
+    palSimStats.mixerLookups = 0;
+    palSimStats.mixerLookupNs = 0;
+    palSimStats.mixerCtlsCreated = 0;
+    palSimStats.mixerReads = 0;
+    palSimStats.mixerWrites = 0;
+    palSimStats.routePaths = 0;
+    palSimStats.pcmOpens = 0;
+    palSimStats.pcmStarts = 0;
+    palSimStats.pcmFrames = 0;
+    palSimStats.pcmXruns = 0;
+    palSimStats.compressOpens = 0;
+    palSimStats.compressBytes = 0;
+    palSimStats.agmSessions = 0;
+    palSimStats.agmEvents = 0;
+}
+
+extern "C" void pal_sim_set_card_online(bool online)
+{
+    PAL_INFO(LOG_TAG, "sim card %s", online ? "online" : "offline");
+    simOnline = online;
+}
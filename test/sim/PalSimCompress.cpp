@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: SimCompress"
+
+#include <errno.h>
+#include <string.h>
+#include <sound/compress_params.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include "PalSimInternal.h"
+#include "PalCommon.h"
+
+/* stream rate assumed for encoded data without a bit rate */
+#define PAL_SIM_COMPRESS_DEFAULT_BYTES_PER_SEC (320000 / 8)
+
+extern "C" {
+struct compr_config {
+    uint32_t fragment_size;
+    uint32_t fragments;
+    struct snd_codec *codec;
+};
+}
+
+struct compress {
+    unsigned int device = 0;
+    unsigned int flags = 0;
+    bool ready = false;
+    bool nonblock = false;
+    bool running = false;
+    bool paused = false;
+    uint64_t fragmentBytes = 0;
+    uint64_t bufferBytes = 0;
+    uint64_t bytesPerSec = 0;
+    uint64_t applBytes = 0;     /* bytes written or read by the client */
+    uint64_t hwBase = 0;        /* bytes played or captured at start */
+    uint64_t stops = 0;         /* wakes waiters out of a stopped stream */
+    std::chrono::steady_clock::time_point start;
+    std::string error;
+    std::mutex lock;
+    std::condition_variable cv;
+};
+
+static struct compress badCompress;
+
+static uint64_t bytesPerSec(const struct snd_codec *codec)
+{
+    if (!codec)
+        return PAL_SIM_COMPRESS_DEFAULT_BYTES_PER_SEC;
+    if (codec->id == SND_AUDIOCODEC_PCM && codec->sample_rate && codec->ch_in)
+        return (uint64_t)codec->sample_rate * codec->ch_in * 2;
+    if (codec->bit_rate)
+        return codec->bit_rate / 8;
+    return PAL_SIM_COMPRESS_DEFAULT_BYTES_PER_SEC;
+}
+
+static bool isCapture(const struct compress *compress)
+{
+    return !(compress->flags & PAL_SIM_COMPRESS_IN);
+}
+
+static uint64_t hwPos_l(struct compress *compress, std::chrono::steady_clock::time_point now)
+{
+    uint64_t pos = compress->hwBase;
+
+    if (compress->running && !compress->paused)
+        pos += palSimUnits(now - compress->start, compress->bytesPerSec);
+    /* a starved decoder waits for data instead of running ahead of it */
+    if (!isCapture(compress) && pos > compress->applBytes) {
+        compress->hwBase = compress->applBytes;
+        compress->start = now;
+        pos = compress->applBytes;
+    }
+    return pos;
+}
+
+/* bytes the client may write or read now */
+static uint64_t avail_l(struct compress *compress, std::chrono::steady_clock::time_point now)
+{
+    uint64_t hw = hwPos_l(compress, now);
+
+    if (isCapture(compress))
+        return std::min(hw - compress->applBytes, compress->bufferBytes);
+    return compress->bufferBytes - (compress->applBytes - hw);
+}
+
+/* time at which avail_l() reaches bytes, far away while nothing moves */
+static std::chrono::steady_clock::time_point due_l(struct compress *compress,
+        std::chrono::steady_clock::time_point now, uint64_t bytes)
+{
+    uint64_t avail = avail_l(compress, now);
+
+    if (!compress->running || compress->paused)
+        return now + std::chrono::hours(1);
+    return now + palSimDuration(bytes > avail ? bytes - avail : 0, compress->bytesPerSec);
+}
+
+static int fail(struct compress *compress, int err, const char *msg)
+{
+    compress->error = msg;
+    errno = err;
+    return -1;
+}
+
+extern "C" {
+
+struct compress *compress_open(unsigned int card, unsigned int device, unsigned int flags,
+                               struct compr_config *config)
+{
+    struct compress *compress = NULL;
+
+    if (!config || !config->fragment_size || !config->fragments) {
+        fail(&badCompress, EINVAL, "invalid config");
+        return &badCompress;
+    }
+    if (!palSimOnline()) {
+        fail(&badCompress, ENETRESET, "card offline");
+        return &badCompress;
+    }
+
+    compress = new struct compress();
+    compress->device = device;
+    compress->flags = flags;
+    compress->fragmentBytes = config->fragment_size;
+    compress->bufferBytes = (uint64_t)config->fragment_size * config->fragments;
+    compress->bytesPerSec = bytesPerSec(config->codec);
+    compress->ready = true;
+    palSimStats.compressOpens++;
+    PAL_DBG(LOG_TAG, "compress %u:%u %s buffer %llu bytes at %llu bytes/s", card, device,
+            isCapture(compress) ? "capture" : "playback",
+            (unsigned long long)compress->bufferBytes,
+            (unsigned long long)compress->bytesPerSec);
+    return compress;
+}
+
+void compress_close(struct compress *compress)
+{
+    if (!compress || compress == &badCompress)
+        return;
+    delete compress;
+}
+
+int is_compress_ready(struct compress *compress)
+{
+    return compress && compress->ready;
+}
+
+const char *compress_get_error(struct compress *compress)
+{
+    return compress ? compress->error.c_str() : "";
+}
+
+void compress_nonblock(struct compress *compress, int nonblock)
+{
+    if (!is_compress_ready(compress))
+        return;
+    std::lock_guard<std::mutex> lock(compress->lock);
+    compress->nonblock = nonblock;
+}
+
+int compress_set_codec_params(struct compress *compress, struct snd_codec *codec)
+{
+    if (!is_compress_ready(compress) || !codec)
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(compress->lock);
+    compress->bytesPerSec = bytesPerSec(codec);
+    return 0;
+}
+
+int compress_set_gapless_metadata(struct compress *compress, const void * /*mdata*/)
+{
+    return is_compress_ready(compress) ? 0 : -EINVAL;
+}
+
+int compress_write(struct compress *compress, const void * /*buf*/, unsigned int size)
+{
+    uint64_t written = 0;
+    uint64_t chunk = 0;
+    uint64_t stops = 0;
+
+    if (!is_compress_ready(compress) || isCapture(compress))
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(compress->lock);
+    stops = compress->stops;
+    while (written < size) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (!palSimOnline())
+            return fail(compress, ENETRESET, "card offline");
+        chunk = std::min<uint64_t>(avail_l(compress, now), size - written);
+        compress->applBytes += chunk;
+        written += chunk;
+        if (written == size || compress->nonblock || compress->stops != stops)
+            break;
+        compress->cv.wait_until(lock, due_l(compress, now,
+                std::min<uint64_t>(compress->fragmentBytes, size - written)));
+    }
+    palSimStats.compressBytes += written;
+    return written;
+}
+
+int compress_read(struct compress *compress, void *buf, unsigned int size)
+{
+    uint64_t bytes = 0;
+    uint64_t stops = 0;
+
+    if (!is_compress_ready(compress) || !isCapture(compress) || !buf)
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(compress->lock);
+    stops = compress->stops;
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (!palSimOnline())
+            return fail(compress, ENETRESET, "card offline");
+        bytes = std::min<uint64_t>(avail_l(compress, now), size);
+        if (bytes || compress->nonblock || compress->stops != stops)
+            break;
+        compress->cv.wait_until(lock, due_l(compress, now,
+                std::min<uint64_t>(compress->fragmentBytes, size)));
+    }
+    memset(buf, 0, bytes);
+    compress->applBytes += bytes;
+    palSimStats.compressBytes += bytes;
+    return bytes;
+}
+
+int compress_start(struct compress *compress)
+{
+    if (!is_compress_ready(compress))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(compress->lock);
+    if (!palSimOnline())
+        return fail(compress, ENETRESET, "card offline");
+    compress->running = true;
+    compress->paused = false;
+    compress->start = std::chrono::steady_clock::now();
+    compress->cv.notify_all();
+    return 0;
+}
+
+int compress_stop(struct compress *compress)
+{
+    if (!is_compress_ready(compress))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(compress->lock);
+    compress->running = false;
+    compress->paused = false;
+    compress->applBytes = 0;
+    compress->hwBase = 0;
+    compress->stops++;
+    compress->cv.notify_all();
+    return 0;
+}
+
+int compress_pause(struct compress *compress)
+{
+    if (!is_compress_ready(compress))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(compress->lock);
+    if (compress->running && !compress->paused) {
+        compress->hwBase = hwPos_l(compress, std::chrono::steady_clock::now());
+        compress->paused = true;
+    }
+    return 0;
+}
+
+int compress_resume(struct compress *compress)
+{
+    if (!is_compress_ready(compress))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(compress->lock);
+    if (compress->paused) {
+        compress->paused = false;
+        compress->start = std::chrono::steady_clock::now();
+        compress->cv.notify_all();
+    }
+    return 0;
+}
+
+/* returns once everything written was played, or the stream was stopped */
+int compress_drain(struct compress *compress)
+{
+    uint64_t stops = 0;
+
+    if (!is_compress_ready(compress))
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(compress->lock);
+    stops = compress->stops;
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (compress->stops != stops || !compress->running)
+            return 0;
+        if (hwPos_l(compress, now) >= compress->applBytes)
+            return 0;
+        compress->cv.wait_until(lock, due_l(compress, now, compress->bufferBytes));
+    }
+}
+
+int compress_partial_drain(struct compress *compress)
+{
+    return compress_drain(compress);
+}
+
+int compress_next_track(struct compress *compress)
+{
+    return is_compress_ready(compress) ? 0 : -EINVAL;
+}
+
+/* waits for a fragment of room to write into, or of data to read */
+int compress_wait(struct compress *compress, int timeout_ms)
+{
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t stops = 0;
+
+    if (!is_compress_ready(compress))
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(compress->lock);
+    stops = compress->stops;
+    deadline = std::chrono::steady_clock::now() + (timeout_ms < 0 ?
+            std::chrono::steady_clock::duration(std::chrono::hours(24 * 365)) :
+            std::chrono::steady_clock::duration(std::chrono::milliseconds(timeout_ms)));
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (!palSimOnline())
+            return fail(compress, ENETRESET, "card offline");
+        if (compress->stops != stops ||
+            avail_l(compress, now) >= std::min(compress->fragmentBytes, compress->bufferBytes))
+            return 0;
+        if (now >= deadline)
+            return fail(compress, ETIME, "poll timed out");
+        compress->cv.wait_until(lock, std::min(deadline,
+                due_l(compress, now, compress->fragmentBytes)));
+    }
+}
+
+}
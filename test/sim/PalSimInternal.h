@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_SIM_INTERNAL_H
+#define PAL_SIM_INTERNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "PalSim.h"
+
+/*
+ * The sim is built against no tinyalsa, tinycompress or audio_route headers
+ * since their variants differ in the constness of the prototypes; it only has
+ * to match them at link time. Structures the caller passes in are declared
+ * here with the layout shared by all of them.
+ */
+extern "C" {
+
+struct pcm_config {
+    unsigned int channels;
+    unsigned int rate;
+    unsigned int period_size;
+    unsigned int period_count;
+    int format;
+    unsigned int start_threshold;
+    unsigned int stop_threshold;
+    unsigned int silence_threshold;
+    unsigned int silence_size;
+    int avail_min;
+};
+
+struct mixer;
+struct mixer_ctl;
+
+struct mixer *mixer_open(unsigned int card);
+void mixer_close(struct mixer *mixer);
+unsigned int mixer_get_num_ctls(struct mixer *mixer);
+struct mixer_ctl *mixer_get_ctl(struct mixer *mixer, unsigned int id);
+struct mixer_ctl *mixer_get_ctl_by_name(struct mixer *mixer, const char *name);
+int mixer_ctl_set_value(struct mixer_ctl *ctl, unsigned int id, int value);
+
+}
+
+#define PAL_SIM_PCM_IN      0x10000000
+#define PAL_SIM_PCM_MMAP    0x00000001
+#define PAL_SIM_PCM_NOIRQ   0x00000002
+#define PAL_SIM_COMPRESS_IN 0x20000000
+
+struct pal_sim_config {
+    std::string cardName;
+    unsigned int hwCard;
+    unsigned int virtCard;
+    unsigned int hwCtls;
+    unsigned int virtCtls;
+    unsigned int hwCtlUs;
+    unsigned int virtCtlUs;
+    unsigned int routeCtls;
+    unsigned int agmNtUs;
+    bool strictMixer;
+};
+
+struct pal_sim_counters {
+    std::atomic<uint64_t> mixerLookups{0};
+    std::atomic<uint64_t> mixerLookupNs{0};
+    std::atomic<uint64_t> mixerCtlsCreated{0};
+    std::atomic<uint64_t> mixerReads{0};
+    std::atomic<uint64_t> mixerWrites{0};
+    std::atomic<uint64_t> routePaths{0};
+    std::atomic<uint64_t> pcmOpens{0};
+    std::atomic<uint64_t> pcmStarts{0};
+    std::atomic<uint64_t> pcmFrames{0};
+    std::atomic<uint64_t> pcmXruns{0};
+    std::atomic<uint64_t> compressOpens{0};
+    std::atomic<uint64_t> compressBytes{0};
+    std::atomic<uint64_t> agmSessions{0};
+    std::atomic<uint64_t> agmEvents{0};
+};
+
+const struct pal_sim_config &palSimConfig();
+extern struct pal_sim_counters palSimStats;
+bool palSimOnline();
+void palSimDelayUs(unsigned int us);
+
+/* position in units of rate per second after elapsed */
+uint64_t palSimUnits(std::chrono::steady_clock::duration elapsed, uint64_t rate);
+/* time it takes to go through units at rate per second */
+std::chrono::steady_clock::duration palSimDuration(uint64_t units, uint64_t rate);
+
+/*
+ * Fake graph in the gsl_tag_module_info layout returned by getTaggedInfo and
+ * agm_session_aif_get_tag_module_info, with module instance ids derived from
+ * graphId. Returns the size of the whole graph, filling at most size bytes.
+ */
+size_t palSimTagModuleInfo(uint32_t graphId, void *payload, size_t size);
+
+#endif /* PAL_SIM_INTERNAL_H */
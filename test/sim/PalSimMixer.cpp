@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: SimMixer"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sound/asound.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "PalSimInternal.h"
+#include "PalCommon.h"
+
+/* size reported for virtual card byte controls nothing was written to */
+#define PAL_SIM_VIRT_CTL_BYTES 1024
+
+struct mixer_ctl {
+    struct mixer *mixer;
+    std::string name;
+    std::vector<uint8_t> data;
+    std::vector<int> values;
+    std::string enumValue;
+};
+
+struct mixer {
+    unsigned int card;
+    bool isVirtual;
+    std::string name;
+    std::mutex lock;
+    std::vector<std::unique_ptr<struct mixer_ctl>> ctls;
+    unsigned int users = 0;
+    bool subscribed = false;
+    std::deque<std::string> events;
+    std::condition_variable eventCV;
+};
+
+static bool hasSuffix(const std::string &name, const char *suffix)
+{
+    size_t len = strlen(suffix);
+
+    return name.size() >= len && !name.compare(name.size() - len, len, suffix);
+}
+
+/* "PCM100 getTaggedInfo" belongs to the graph of frontend 100 */
+static uint32_t graphIdOf(const std::string &name)
+{
+    size_t pos = name.find_first_of("0123456789");
+
+    return pos == std::string::npos ? 0 : (uint32_t)strtoul(name.c_str() + pos, NULL, 10);
+}
+
+static struct mixer_ctl *addCtl(struct mixer *mixer, const char *name)
+{
+    std::unique_ptr<struct mixer_ctl> ctl(new struct mixer_ctl());
+
+    ctl->mixer = mixer;
+    ctl->name = name;
+    mixer->ctls.push_back(std::move(ctl));
+    return mixer->ctls.back().get();
+}
+
+/*
+ * Cards live as long as the process, so the event thread of the resource
+ * manager never waits on a freed mixer and control values survive a reopen
+ * like they do in the driver.
+ */
+static struct mixer *getCard(unsigned int card)
+{
+    static std::mutex cardsLock;
+    static std::unique_ptr<struct mixer> hwCard;
+    static std::unique_ptr<struct mixer> virtCard;
+    const struct pal_sim_config &config = palSimConfig();
+    std::unique_ptr<struct mixer> *slot = NULL;
+    unsigned int numCtls = 0;
+    char name[64];
+
+    if (card == config.hwCard) {
+        slot = &hwCard;
+        numCtls = config.hwCtls;
+    } else if (card == config.virtCard) {
+        slot = &virtCard;
+        numCtls = config.virtCtls;
+    } else {
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> lock(cardsLock);
+    if (!*slot) {
+        slot->reset(new struct mixer());
+        (*slot)->card = card;
+        (*slot)->isVirtual = (card == config.virtCard);
+        (*slot)->name = (*slot)->isVirtual ? "AGM virtual card" : config.cardName;
+        for (unsigned int i = 0; i < numCtls; i++) {
+            snprintf(name, sizeof(name), "%s Control %u",
+                     (*slot)->isVirtual ? "Sim AGM" : "Sim Codec", i);
+            addCtl(slot->get(), name);
+        }
+    }
+    return slot->get();
+}
+
+static void ctlAccess(struct mixer_ctl *ctl, bool write)
+{
+    const struct pal_sim_config &config = palSimConfig();
+
+    if (write)
+        palSimStats.mixerWrites++;
+    else
+        palSimStats.mixerReads++;
+    palSimDelayUs(ctl->mixer->isVirtual ? config.virtCtlUs : config.hwCtlUs);
+}
+
+extern "C" {
+
+struct mixer *mixer_open(unsigned int card)
+{
+    struct mixer *mixer = getCard(card);
+
+    if (!mixer) {
+        errno = ENODEV;
+        return NULL;
+    }
+    std::lock_guard<std::mutex> lock(mixer->lock);
+    mixer->users++;
+    return mixer;
+}
+
+void mixer_close(struct mixer *mixer)
+{
+    if (!mixer)
+        return;
+    std::lock_guard<std::mutex> lock(mixer->lock);
+    if (mixer->users)
+        mixer->users--;
+    mixer->eventCV.notify_all();
+}
+
+const char *mixer_get_name(struct mixer *mixer)
+{
+    return mixer ? mixer->name.c_str() : NULL;
+}
+
+unsigned int mixer_get_num_ctls(struct mixer *mixer)
+{
+    if (!mixer)
+        return 0;
+    std::lock_guard<std::mutex> lock(mixer->lock);
+    return mixer->ctls.size();
+}
+
+struct mixer_ctl *mixer_get_ctl(struct mixer *mixer, unsigned int id)
+{
+    if (!mixer)
+        return NULL;
+    std::lock_guard<std::mutex> lock(mixer->lock);
+    return id < mixer->ctls.size() ? mixer->ctls[id].get() : NULL;
+}
+
+struct mixer_ctl *mixer_get_ctl_by_name(struct mixer *mixer, const char *name)
+{
+    struct mixer_ctl *ctl = NULL;
+    auto begin = std::chrono::steady_clock::now();
+
+    if (!mixer || !name)
+        return NULL;
+
+    std::lock_guard<std::mutex> lock(mixer->lock);
+    /* linear like tinyalsa, the cost PAL pays for every uncached lookup */
+    for (auto &c : mixer->ctls) {
+        if (!strcmp(c->name.c_str(), name)) {
+            ctl = c.get();
+            break;
+        }
+    }
+    if (!ctl && !palSimConfig().strictMixer) {
+        PAL_VERBOSE(LOG_TAG, "creating %s on card %u", name, mixer->card);
+        ctl = addCtl(mixer, name);
+        palSimStats.mixerCtlsCreated++;
+    }
+
+    palSimStats.mixerLookups++;
+    palSimStats.mixerLookupNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+    return ctl;
+}
+
+const char *mixer_ctl_get_name(struct mixer_ctl *ctl)
+{
+    return ctl ? ctl->name.c_str() : NULL;
+}
+
+unsigned int mixer_ctl_get_num_values(struct mixer_ctl *ctl)
+{
+    if (!ctl)
+        return 0;
+    std::lock_guard<std::mutex> lock(ctl->mixer->lock);
+    if (!ctl->data.empty())
+        return ctl->data.size();
+    if (!ctl->values.empty())
+        return ctl->values.size();
+    return ctl->mixer->isVirtual ? PAL_SIM_VIRT_CTL_BYTES : 1;
+}
+
+void mixer_ctl_update(struct mixer_ctl * /*ctl*/)
+{
+}
+
+int mixer_ctl_get_value(struct mixer_ctl *ctl, unsigned int id)
+{
+    if (!ctl)
+        return -EINVAL;
+    ctlAccess(ctl, false);
+    std::lock_guard<std::mutex> lock(ctl->mixer->lock);
+    return id < ctl->values.size() ? ctl->values[id] : 0;
+}
+
+int mixer_ctl_set_value(struct mixer_ctl *ctl, unsigned int id, int value)
+{
+    if (!ctl)
+        return -EINVAL;
+    ctlAccess(ctl, true);
+    std::lock_guard<std::mutex> lock(ctl->mixer->lock);
+    if (id >= ctl->values.size())
+        ctl->values.resize(id + 1);
+    ctl->values[id] = value;
+    return 0;
+}
+
+int mixer_ctl_get_array(struct mixer_ctl *ctl, void *array, size_t count)
+{
+    if (!ctl || !array)
+        return -EINVAL;
+    ctlAccess(ctl, false);
+    if (hasSuffix(ctl->name, " getTaggedInfo")) {
+        palSimTagModuleInfo(graphIdOf(ctl->name), array, count);
+        return 0;
+    }
+    /* no shared memory to hand out, mmap users fall back to the poll fd */
+    if (hasSuffix(ctl->name, " getBufInfo"))
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(ctl->mixer->lock);
+    memset(array, 0, count);
+    memcpy(array, ctl->data.data(), std::min(count, ctl->data.size()));
+    return 0;
+}
+
+int mixer_ctl_set_array(struct mixer_ctl *ctl, const void *array, size_t count)
+{
+    if (!ctl || !array)
+        return -EINVAL;
+    ctlAccess(ctl, true);
+    std::lock_guard<std::mutex> lock(ctl->mixer->lock);
+    ctl->data.assign((const uint8_t *)array, (const uint8_t *)array + count);
+    return 0;
+}
+
+int mixer_ctl_set_enum_by_string(struct mixer_ctl *ctl, const char *string)
+{
+    if (!ctl || !string)
+        return -EINVAL;
+    ctlAccess(ctl, true);
+    std::lock_guard<std::mutex> lock(ctl->mixer->lock);
+    ctl->enumValue = string;
+    return 0;
+}
+
+int mixer_subscribe_events(struct mixer *mixer, int subscribe)
+{
+    if (!mixer)
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(mixer->lock);
+    mixer->subscribed = subscribe;
+    if (!subscribe) {
+        mixer->events.clear();
+        mixer->eventCV.notify_all();
+    }
+    return 0;
+}
+
+int mixer_wait_event(struct mixer *mixer, int timeout)
+{
+    if (!mixer)
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(mixer->lock);
+    auto ready = [mixer] {
+        return !mixer->events.empty() || !mixer->users || !mixer->subscribed;
+    };
+
+    if (timeout < 0)
+        mixer->eventCV.wait(lock, ready);
+    else if (!mixer->eventCV.wait_for(lock, std::chrono::milliseconds(timeout), ready))
+        return 0;
+
+    if (mixer->events.empty()) {
+        errno = EBADF;
+        return -1;
+    }
+    return 1;
+}
+
+int mixer_read_event(struct mixer *mixer, struct snd_ctl_event *ev)
+{
+    if (!mixer || !ev)
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(mixer->lock);
+    if (mixer->events.empty())
+        return -EAGAIN;
+
+    memset(ev, 0, sizeof(*ev));
+    ev->type = SNDRV_CTL_EVENT_ELEM;
+    ev->data.elem.mask = SNDRV_CTL_EVENT_MASK_VALUE;
+    strncpy((char *)ev->data.elem.id.name, mixer->events.front().c_str(),
+            sizeof(ev->data.elem.id.name) - 1);
+    mixer->events.pop_front();
+    return 0;
+}
+
+int pal_sim_post_mixer_event(const char *ctl_name, const void *payload, size_t size)
+{
+    struct mixer *mixer = getCard(palSimConfig().virtCard);
+    struct mixer_ctl *ctl = NULL;
+
+    if (!ctl_name || (size && !payload))
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(mixer->lock);
+    if (!mixer->subscribed)
+        return -EAGAIN;
+    for (auto &c : mixer->ctls) {
+        if (c->name == ctl_name) {
+            ctl = c.get();
+            break;
+        }
+    }
+    if (!ctl)
+        ctl = addCtl(mixer, ctl_name);
+    ctl->data.assign((const uint8_t *)payload, (const uint8_t *)payload + size);
+    mixer->events.push_back(ctl_name);
+    mixer->eventCV.notify_all();
+    return 0;
+}
+
+}
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: SimPcm"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sound/asound.h>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include "PalSimInternal.h"
+#include "PalCommon.h"
+
+struct pcm {
+    unsigned int card = 0;
+    unsigned int device = 0;
+    unsigned int flags = 0;
+    struct pcm_config config = {};
+    unsigned int frameBytes = 0;
+    unsigned int bufferFrames = 0;
+    unsigned int startThreshold = 0;
+    bool ready = false;
+    bool running = false;
+    uint64_t applPtr = 0;   /* frames written or read by the client */
+    uint64_t hwBase = 0;    /* hardware position when start was taken */
+    std::chrono::steady_clock::time_point start;
+    std::vector<uint8_t> mmapBuffer;
+    int pollFd = -1;
+    std::string error;
+    std::mutex lock;
+};
+
+/* handed out when the open fails, like tinyalsa's bad_pcm */
+static struct pcm badPcm;
+
+static unsigned int formatBytes(int format)
+{
+    switch (format) {
+    case 1:     /* PCM_FORMAT_S32_LE */
+    case 3:     /* PCM_FORMAT_S24_LE */
+        return 4;
+    case 2:     /* PCM_FORMAT_S8 */
+        return 1;
+    case 4:     /* PCM_FORMAT_S24_3LE */
+        return 3;
+    default:    /* PCM_FORMAT_S16_LE */
+        return 2;
+    }
+}
+
+static bool isCapture(const struct pcm *pcm)
+{
+    return pcm->flags & PAL_SIM_PCM_IN;
+}
+
+static uint64_t hwPos_l(const struct pcm *pcm, std::chrono::steady_clock::time_point now)
+{
+    if (!pcm->running)
+        return pcm->hwBase;
+    return pcm->hwBase + palSimUnits(now - pcm->start, pcm->config.rate);
+}
+
+static void start_l(struct pcm *pcm, std::chrono::steady_clock::time_point now)
+{
+    pcm->running = true;
+    pcm->start = now;
+    palSimStats.pcmStarts++;
+}
+
+static void xrun_l(struct pcm *pcm, std::chrono::steady_clock::time_point now)
+{
+    PAL_VERBOSE(LOG_TAG, "xrun on pcm %u at %llu", pcm->device,
+                (unsigned long long)pcm->applPtr);
+    palSimStats.pcmXruns++;
+    pcm->hwBase = pcm->applPtr;
+    pcm->start = now;
+}
+
+static int fail(struct pcm *pcm, int err, const char *msg)
+{
+    pcm->error = msg;
+    errno = err;
+    return -1;
+}
+
+/* blocks until frames fit in the ring, the device drains it at the rate */
+static int playback(struct pcm *pcm, unsigned int frames)
+{
+    std::unique_lock<std::mutex> lock(pcm->lock);
+    std::chrono::steady_clock::time_point now;
+    uint64_t hw = 0;
+    uint64_t queued = 0;
+
+    for (;;) {
+        if (!palSimOnline())
+            return fail(pcm, ENETRESET, "card offline");
+        now = std::chrono::steady_clock::now();
+        /* a full buffer starts the device whatever the threshold */
+        if (!pcm->running && pcm->applPtr - pcm->hwBase + frames > pcm->bufferFrames)
+            start_l(pcm, now);
+        hw = hwPos_l(pcm, now);
+        if (hw > pcm->applPtr) {
+            xrun_l(pcm, now);
+            hw = pcm->applPtr;
+        }
+        queued = pcm->applPtr - hw;
+        if (queued + frames <= pcm->bufferFrames)
+            break;
+        auto due = now + palSimDuration(queued + frames - pcm->bufferFrames, pcm->config.rate);
+        lock.unlock();
+        std::this_thread::sleep_until(due);
+        lock.lock();
+    }
+
+    pcm->applPtr += frames;
+    if (!pcm->running && pcm->applPtr - pcm->hwBase >= pcm->startThreshold)
+        start_l(pcm, now);
+    palSimStats.pcmFrames += frames;
+    return 0;
+}
+
+/* blocks until the device captured frames, dropping what overflowed */
+static int capture(struct pcm *pcm, unsigned int frames)
+{
+    std::unique_lock<std::mutex> lock(pcm->lock);
+    std::chrono::steady_clock::time_point now;
+    uint64_t hw = 0;
+
+    for (;;) {
+        if (!palSimOnline())
+            return fail(pcm, ENETRESET, "card offline");
+        now = std::chrono::steady_clock::now();
+        if (!pcm->running)
+            start_l(pcm, now);
+        hw = hwPos_l(pcm, now);
+        if (hw - pcm->applPtr > pcm->bufferFrames) {
+            xrun_l(pcm, now);
+            hw = pcm->applPtr;
+        }
+        if (hw - pcm->applPtr >= frames)
+            break;
+        auto due = now + palSimDuration(frames - (hw - pcm->applPtr), pcm->config.rate);
+        lock.unlock();
+        std::this_thread::sleep_until(due);
+        lock.lock();
+    }
+
+    pcm->applPtr += frames;
+    palSimStats.pcmFrames += frames;
+    return 0;
+}
+
+static int transfer(struct pcm *pcm, unsigned int count)
+{
+    unsigned int frames = 0;
+    unsigned int chunk = 0;
+    int ret = 0;
+
+    if (!pcm || !pcm->ready)
+        return -EINVAL;
+
+    frames = count / pcm->frameBytes;
+    while (frames && !ret) {
+        chunk = std::min(frames, pcm->bufferFrames);
+        ret = isCapture(pcm) ? capture(pcm, chunk) : playback(pcm, chunk);
+        frames -= chunk;
+    }
+    return ret;
+}
+
+extern "C" {
+
+struct pcm *pcm_open(unsigned int card, unsigned int device, unsigned int flags,
+                     struct pcm_config *config)
+{
+    struct pcm *pcm = NULL;
+
+    if (!config) {
+        fail(&badPcm, EINVAL, "no config");
+        return &badPcm;
+    }
+    if (!palSimOnline()) {
+        fail(&badPcm, ENETRESET, "card offline");
+        return &badPcm;
+    }
+
+    pcm = new struct pcm();
+    pcm->card = card;
+    pcm->device = device;
+    pcm->flags = flags;
+    pcm->config = *config;
+    pcm->frameBytes = config->channels * formatBytes(config->format);
+    pcm->bufferFrames = config->period_size * config->period_count;
+    if (!pcm->frameBytes || !pcm->bufferFrames || !config->rate) {
+        PAL_ERR(LOG_TAG, "invalid config for pcm %u: ch %u rate %u period %u x %u",
+                device, config->channels, config->rate, config->period_size,
+                config->period_count);
+        delete pcm;
+        fail(&badPcm, EINVAL, "invalid config");
+        return &badPcm;
+    }
+    pcm->startThreshold = config->start_threshold ?
+            std::min(config->start_threshold, pcm->bufferFrames) : pcm->bufferFrames;
+    if (flags & PAL_SIM_PCM_MMAP)
+        pcm->mmapBuffer.resize((size_t)pcm->bufferFrames * pcm->frameBytes);
+    pcm->ready = true;
+    palSimStats.pcmOpens++;
+    PAL_DBG(LOG_TAG, "pcm %u:%u %s rate %u ch %u buffer %u frames", card, device,
+            isCapture(pcm) ? "capture" : "playback", config->rate, config->channels,
+            pcm->bufferFrames);
+    return pcm;
+}
+
+int pcm_close(struct pcm *pcm)
+{
+    if (!pcm || pcm == &badPcm)
+        return 0;
+    if (pcm->pollFd >= 0)
+        close(pcm->pollFd);
+    delete pcm;
+    return 0;
+}
+
+int pcm_is_ready(struct pcm *pcm)
+{
+    return pcm && pcm->ready;
+}
+
+const char *pcm_get_error(struct pcm *pcm)
+{
+    return pcm ? pcm->error.c_str() : "";
+}
+
+unsigned int pcm_get_buffer_size(struct pcm *pcm)
+{
+    return pcm ? pcm->bufferFrames : 0;
+}
+
+unsigned int pcm_frames_to_bytes(struct pcm *pcm, unsigned int frames)
+{
+    return pcm ? frames * pcm->frameBytes : 0;
+}
+
+unsigned int pcm_bytes_to_frames(struct pcm *pcm, unsigned int bytes)
+{
+    return pcm && pcm->frameBytes ? bytes / pcm->frameBytes : 0;
+}
+
+unsigned int pcm_format_to_bits(int format)
+{
+    return formatBytes(format) * 8;
+}
+
+int pcm_prepare(struct pcm *pcm)
+{
+    if (!pcm_is_ready(pcm))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    pcm->running = false;
+    pcm->applPtr = 0;
+    pcm->hwBase = 0;
+    return 0;
+}
+
+int pcm_start(struct pcm *pcm)
+{
+    if (!pcm_is_ready(pcm))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!palSimOnline())
+        return fail(pcm, ENETRESET, "card offline");
+    if (!pcm->running)
+        start_l(pcm, std::chrono::steady_clock::now());
+    return 0;
+}
+
+int pcm_stop(struct pcm *pcm)
+{
+    if (!pcm_is_ready(pcm))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    pcm->running = false;
+    pcm->applPtr = 0;
+    pcm->hwBase = 0;
+    return 0;
+}
+
+int pcm_write(struct pcm *pcm, const void * /*data*/, unsigned int count)
+{
+    return transfer(pcm, count);
+}
+
+int pcm_read(struct pcm *pcm, void *data, unsigned int count)
+{
+    if (data)
+        memset(data, 0, count);
+    return transfer(pcm, count);
+}
+
+int pcm_mmap_write(struct pcm *pcm, const void *data, unsigned int count)
+{
+    return pcm_write(pcm, data, count);
+}
+
+int pcm_mmap_read(struct pcm *pcm, void *data, unsigned int count)
+{
+    return pcm_read(pcm, data, count);
+}
+
+int pcm_mmap_begin(struct pcm *pcm, void **areas, unsigned int *offset,
+                   unsigned int *frames)
+{
+    uint64_t hw = 0;
+    uint64_t avail = 0;
+
+    if (!pcm_is_ready(pcm) || pcm->mmapBuffer.empty() || !areas || !offset || !frames)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    hw = hwPos_l(pcm, std::chrono::steady_clock::now());
+    if (isCapture(pcm))
+        avail = hw > pcm->applPtr ? hw - pcm->applPtr : 0;
+    else
+        avail = hw > pcm->applPtr ? pcm->bufferFrames :
+                pcm->bufferFrames - std::min<uint64_t>(pcm->applPtr - hw, pcm->bufferFrames);
+
+    *areas = pcm->mmapBuffer.data();
+    *offset = pcm->applPtr % pcm->bufferFrames;
+    *frames = std::min<uint64_t>({*frames, avail, pcm->bufferFrames - *offset});
+    return 0;
+}
+
+int pcm_mmap_commit(struct pcm *pcm, unsigned int /*offset*/, unsigned int frames)
+{
+    if (!pcm_is_ready(pcm))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    pcm->applPtr += frames;
+    palSimStats.pcmFrames += frames;
+    return frames;
+}
+
+/* the mmap position runs free, the client keeps up with it on its own */
+int pcm_mmap_get_hw_ptr(struct pcm *pcm, unsigned int *hw_ptr, struct timespec *tstamp)
+{
+    if (!pcm_is_ready(pcm) || !hw_ptr || !tstamp)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!pcm->running)
+        return fail(pcm, EAGAIN, "not running");
+    *hw_ptr = (unsigned int)hwPos_l(pcm, std::chrono::steady_clock::now());
+    clock_gettime(CLOCK_MONOTONIC, tstamp);
+    return 0;
+}
+
+int pcm_get_poll_fd(struct pcm *pcm)
+{
+    if (!pcm_is_ready(pcm))
+        return -1;
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (pcm->pollFd < 0)
+        pcm->pollFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    return pcm->pollFd;
+}
+
+int pcm_ioctl(struct pcm *pcm, int request, ...)
+{
+    if (!pcm_is_ready(pcm))
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    /* reset drops what is queued or captured, the other requests are no-ops */
+    if (request == (int)SNDRV_PCM_IOCTL_RESET)
+        pcm->applPtr = hwPos_l(pcm, std::chrono::steady_clock::now());
+    return 0;
+}
+
+}
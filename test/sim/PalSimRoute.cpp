@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: SimRoute"
+
+#include <errno.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include "PalSimInternal.h"
+#include "PalCommon.h"
+
+/*
+ * The mixer paths xml is not parsed, a path stands for PAL_SIM_ROUTE_CTLS
+ * codec controls picked from its name. Like audio_route, apply and reset
+ * only mark the path and the writes happen on update.
+ */
+struct audio_route {
+    struct mixer *mixer;
+    std::mutex lock;
+    std::map<std::string, bool> pending;    /* path name, applied or reset */
+};
+
+static int update_l(struct audio_route *ar)
+{
+    const struct pal_sim_config &config = palSimConfig();
+    unsigned int numCtls = mixer_get_num_ctls(ar->mixer);
+    struct mixer_ctl *ctl = NULL;
+    size_t first = 0;
+
+    for (auto &path : ar->pending) {
+        first = std::hash<std::string>()(path.first);
+        for (unsigned int i = 0; numCtls && i < config.routeCtls; i++) {
+            ctl = mixer_get_ctl(ar->mixer, (first + i) % numCtls);
+            if (ctl)
+                mixer_ctl_set_value(ctl, 0, path.second);
+        }
+        palSimStats.routePaths++;
+    }
+    ar->pending.clear();
+    return 0;
+}
+
+static int mark(struct audio_route *ar, const char *name, bool apply)
+{
+    if (!ar || !name)
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(ar->lock);
+    ar->pending[name] = apply;
+    return 0;
+}
+
+extern "C" {
+
+struct audio_route *audio_route_init(unsigned int card, const char *xml_path)
+{
+    struct audio_route *ar = NULL;
+    struct mixer *mixer = mixer_open(card);
+
+    if (!mixer) {
+        PAL_ERR(LOG_TAG, "no sim card %u", card);
+        return NULL;
+    }
+    ar = new struct audio_route();
+    ar->mixer = mixer;
+    PAL_INFO(LOG_TAG, "card %u, paths of %s not loaded", card, xml_path ? xml_path : "");
+    return ar;
+}
+
+void audio_route_free(struct audio_route *ar)
+{
+    if (!ar)
+        return;
+    mixer_close(ar->mixer);
+    delete ar;
+}
+
+int audio_route_apply_path(struct audio_route *ar, const char *name)
+{
+    return mark(ar, name, true);
+}
+
+int audio_route_reset_path(struct audio_route *ar, const char *name)
+{
+    return mark(ar, name, false);
+}
+
+int audio_route_update_mixer(struct audio_route *ar)
+{
+    if (!ar)
+        return -EINVAL;
+    std::lock_guard<std::mutex> lock(ar->lock);
+    return update_l(ar);
+}
+
+int audio_route_apply_and_update_path(struct audio_route *ar, const char *name)
+{
+    int ret = audio_route_apply_path(ar, name);
+
+    return ret ? ret : audio_route_update_mixer(ar);
+}
+
+int audio_route_reset_and_update_path(struct audio_route *ar, const char *name)
+{
+    int ret = audio_route_reset_path(ar, name);
+
+    return ret ? ret : audio_route_update_mixer(ar);
+}
+
+}
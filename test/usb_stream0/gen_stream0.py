@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+# SPDX-License-Identifier: BSD-3-Clause-Clear
+#
+# Writes the stream0 files in this directory. They are not captures: each
+# one is what the kernel's snd-usb-audio driver prints to
+# /proc/asound/cardN/stream0 (sound/usb/proc.c, proc_pcm_format_read) for
+# the device described below, so every line has the layout and units the
+# kernel uses. In particular "Data packet interval" is only printed for
+# high speed devices and always in us, 125 << bInterval-1 (datainterval).
+# Replace a file with a real capture of the same device class when one is
+# at hand; the parser has to handle both the same.
+#
+# usage: gen_stream0.py [output directory]
+
+import os
+import sys
+
+SYNC_TYPES = ['NONE', 'ASYNC', 'ADAPTIVE', 'SYNC']
+
+
+def altset(iface, alt, fmt, channels, ep, sync, rates, bits, chmap,
+           datainterval=0, sync_ep=None):
+    return dict(iface=iface, alt=alt, fmt=fmt, channels=channels, ep=ep,
+                sync=sync, rates=rates, bits=bits, chmap=chmap,
+                datainterval=datainterval, sync_ep=sync_ep)
+
+
+DEVICES = {
+    # USB-C headset adapter, full speed, adaptive playback
+    'usbc_headset.txt': dict(
+        name='Generic USB-C to 3.5mm Headphone Jack Adapter at usb-a600000.dwc3-1, full speed',
+        high_speed=False,
+        playback=[
+            altset(1, 1, 'S16_LE', 2, 0x01, 'ADAPTIVE', [44100, 48000], 16, 'FL FR'),
+            altset(1, 2, 'S24_3LE', 2, 0x01, 'ADAPTIVE', [44100, 48000], 24, 'FL FR'),
+        ],
+        capture=[
+            altset(2, 1, 'S16_LE', 1, 0x82, 'ASYNC', [44100, 48000], 16, 'MONO'),
+        ]),
+    # UAC2 DAC, high speed, async playback with an explicit feedback
+    # endpoint; the 16 bit altset polls every 2 microframes
+    'hifi_dac.txt': dict(
+        name='XMOS USB Audio 2.0 at usb-a600000.dwc3-1, high speed',
+        high_speed=True,
+        playback=[
+            altset(1, 1, 'S32_LE', 2, 0x01, 'ASYNC',
+                   [44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000], 32,
+                   'FL FR', 0, (0x81, 1, 1)),
+            altset(1, 2, 'S24_3LE', 2, 0x01, 'ASYNC',
+                   [44100, 48000, 88200, 96000, 176400, 192000], 24,
+                   'FL FR', 0, (0x81, 1, 2)),
+            altset(1, 3, 'S16_LE', 2, 0x01, 'ASYNC',
+                   [44100, 48000, 88200, 96000], 16, 'FL FR', 1, (0x81, 1, 3)),
+        ],
+        capture=[]),
+    # USB microphone, full speed, big endian 24 bit altset
+    'mic_be.txt': dict(
+        name='Studio USB Microphone at usb-a600000.dwc3-1, full speed',
+        high_speed=False,
+        playback=[],
+        capture=[
+            altset(1, 1, 'S24_3BE', 1, 0x81, 'SYNC',
+                   [16000, 32000, 44100, 48000, 96000, 192000, 384000], 24, 'MONO'),
+            altset(1, 2, 'S16_LE', 1, 0x81, 'SYNC', [16000, 48000], 16, 'MONO'),
+        ]),
+    # dock with continuous rate ranges, high speed, 1 ms playback packets
+    'dock_continuous.txt': dict(
+        name='Realtek USB2.0 Audio at usb-xhci-hcd.1.auto-1.4, high speed',
+        high_speed=True,
+        playback=[
+            altset(1, 1, 'S16_LE', 6, 0x01, 'SYNC', (8000, 96000), 16,
+                   'FL FR FC LFE RL RR', 3),
+            altset(1, 2, 'S24_3LE', 6, 0x01, 'SYNC', (8000, 96000), 24,
+                   'FL FR FC LFE RL RR', 3),
+        ],
+        capture=[
+            altset(2, 1, 'S16_LE', 2, 0x83, 'ASYNC', (8000, 384000), 16, 'FL FR', 0),
+        ]),
+}
+
+
+def dump_altsets(out, dev, altsets):
+    # proc_dump_substream_formats()
+    for a in altsets:
+        out.append('  Interface %d' % a['iface'])
+        out.append('    Altset %d' % a['alt'])
+        out.append('    Format: %s' % a['fmt'])
+        out.append('    Channels: %d' % a['channels'])
+        out.append('    Endpoint: 0x%02x (%d %s) (%s)' % (
+            a['ep'], a['ep'] & 0xf, 'IN' if a['ep'] & 0x80 else 'OUT', a['sync']))
+        if isinstance(a['rates'], tuple):
+            out.append('    Rates: %d - %d (continuous)' % a['rates'])
+        else:
+            out.append('    Rates: ' + ', '.join('%d' % r for r in a['rates']))
+        if dev['high_speed']:
+            out.append('    Data packet interval: %d us' % (125 * (1 << a['datainterval'])))
+        out.append('    Bits: %d' % a['bits'])
+        out.append('    Channel map: %s' % a['chmap'])
+        if a['sync_ep']:
+            ep, iface, alt = a['sync_ep']
+            out.append('    Sync Endpoint: 0x%02x (%d %s)' % (
+                ep, ep & 0xf, 'IN' if ep & 0x80 else 'OUT'))
+            out.append('    Sync EP Interface: %d' % iface)
+            out.append('    Sync EP Altset: %d' % alt)
+            out.append('    Implicit Feedback Mode: No')
+
+
+def stream0(dev):
+    # proc_pcm_format_read(): playback first, then capture
+    out = ['%s : USB Audio' % dev['name']]
+    for name, altsets in (('Playback', dev['playback']), ('Capture', dev['capture'])):
+        if not altsets:
+            continue
+        out.append('')
+        out.append('%s:' % name)
+        out.append('  Status: Stop')
+        dump_altsets(out, dev, altsets)
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    outdir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    for name, dev in sorted(DEVICES.items()):
+        with open(os.path.join(outdir, name), 'w') as f:
+            f.write(stream0(dev))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
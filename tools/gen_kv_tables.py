@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+# SPDX-License-Identifier: BSD-3-Clause-Clear
+#
+# Convert a platform usecaseKvManager.xml into a C++ header with static
+# tables, which PayloadBuilder::init loads instead of parsing the XML when
+# libpal is built with PAL_STATIC_KV_TABLES. The tables are a fast load
+# cache for PayloadBuilder's all_* tables, nothing looks them up directly.
+#
+# The tables mirror what PayloadBuilder::startTag/endTag build from the XML:
+# blocks of stream/streampp/device/devicepp ids, each with its
+# keys_and_values entries (selectors and graph key values) in document
+# order. Type ids are kept as names and selector values as strings, all
+# interned into one sorted string table, so the header does not depend on
+# PalDefs.h enum values. PayloadBuilder resolves names and sorts entries
+# at load time exactly like the XML path does.
+#
+# remove_spaces, split_strings and char_to_hex below have to match their
+# C++ counterparts. PalKvTablesCheck (make check with --with-kv-xml) loads
+# the XML through both paths and fails on any difference.
+#
+# usage: gen_kv_tables.py <usecaseKvManager.xml> <output header>
+
+import re
+import sys
+import xml.parsers.expat
+
+SECTIONS = ['KV_TABLE_STREAMS', 'KV_TABLE_STREAMPPS',
+            'KV_TABLE_DEVICES', 'KV_TABLE_DEVICEPPS']
+
+
+def fnv1a64(data):
+    h = 0xcbf29ce484222325
+    for b in data:
+        h ^= b
+        h = (h * 0x100000001b3) & 0xffffffffffffffff
+    return h
+
+
+def remove_spaces(s):
+    # same as PayloadBuilder::removeSpaces
+    return re.sub(r'^ +| +$|( ) +', r'\1', s)
+
+
+def split_strings(s):
+    # same as PayloadBuilder::splitStrings
+    return [remove_spaces(t) for t in s.split(',') if remove_spaces(t)]
+
+
+def char_to_hex(s):
+    # same as ResourceManager::convertCharToHex: skip "0x", ignore non hex
+    v = 0
+    for c in s[2:]:
+        if c in '0123456789abcdefABCDEF':
+            v = (v << 4) | int(c, 16)
+    return v & 0xffffffff
+
+
+class KVParser:
+    def __init__(self):
+        # one list of [section, ids, entries] per section, like all_streams etc.
+        self.blocks = [[], [], [], []]
+        self.parsing = [False, False, False, False]
+        self.tag = None
+
+    def current(self):
+        for i in range(4):
+            if self.parsing[i]:
+                return self.blocks[i]
+        return None
+
+    def start(self, name, attrs):
+        if name in ('streams', 'streampps', 'devices', 'devicepps'):
+            self.parsing[('streams', 'streampps', 'devices', 'devicepps').index(name)] = True
+        elif name in ('stream', 'streampp', 'device', 'devicepp'):
+            section = ('stream', 'streampp', 'device', 'devicepp').index(name)
+            self.tag = section
+            key = 'type' if section < 2 else 'id'
+            if len(attrs) >= 2 and attrs[0] == key:
+                self.blocks[section].append((split_strings(attrs[1]), []))
+        elif name == 'keys_and_values':
+            selectors = []
+            for i in range(0, len(attrs), 2):
+                selectors.append((attrs[i], split_strings(attrs[i + 1])))
+            blocks = self.current()
+            if blocks:
+                blocks[-1][1].append((selectors, []))
+        elif name == 'graph_kv':
+            if len(attrs) < 4 or attrs[0] != 'key' or attrs[2] != 'value':
+                return
+            blocks = self.current()
+            if blocks and blocks[-1][1]:
+                blocks[-1][1][-1][1].append((char_to_hex(attrs[1]), char_to_hex(attrs[3])))
+
+    def end(self, name):
+        if name in ('streams', 'streampps', 'devices', 'devicepps'):
+            self.parsing[('streams', 'streampps', 'devices', 'devicepps').index(name)] = False
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write('usage: %s <usecaseKvManager.xml> <output header>\n' % sys.argv[0])
+        return 1
+
+    with open(sys.argv[1], 'rb') as f:
+        data = f.read()
+
+    kv = KVParser()
+    parser = xml.parsers.expat.ParserCreate()
+    parser.ordered_attributes = True
+    parser.StartElementHandler = kv.start
+    parser.EndElementHandler = kv.end
+    parser.Parse(data, True)
+
+    strings = set()
+    for section in kv.blocks:
+        for ids, entries in section:
+            strings.update(ids)
+            for selectors, _ in entries:
+                for name, values in selectors:
+                    strings.add(name)
+                    strings.update(values)
+    strings = sorted(strings)
+    sid = {s: i for i, s in enumerate(strings)}
+
+    blocks, ids, entries, selectors, values, kvs = [], [], [], [], [], []
+    for section, section_blocks in enumerate(kv.blocks):
+        for block_ids, block_entries in section_blocks:
+            blocks.append((SECTIONS[section], len(ids), len(block_ids),
+                           len(entries), len(block_entries)))
+            ids.extend(sid[i] for i in block_ids)
+            for entry_selectors, entry_kvs in block_entries:
+                entries.append((len(selectors), len(entry_selectors),
+                                len(kvs), len(entry_kvs)))
+                for name, sel_values in entry_selectors:
+                    selectors.append((sid[name], len(values), len(sel_values)))
+                    values.extend(sid[v] for v in sel_values)
+                kvs.extend(entry_kvs)
+
+    def table(decl, fmt, rows):
+        out.append('static constexpr %s[] = {' % decl)
+        for r in rows:
+            out.append(('    ' + fmt + ',') % r)
+        if not rows:
+            # zero sized arrays are not valid C++, keep a dummy row
+            out.append('    {},')
+        out.append('};')
+        out.append('')
+
+    out = []
+    out.append('/* Generated by tools/gen_kv_tables.py from %s, do not edit. */' %
+               sys.argv[1].split('/')[-1])
+    out.append('')
+    out.append('#ifndef USECASE_KV_TABLES_H')
+    out.append('#define USECASE_KV_TABLES_H')
+    out.append('')
+    out.append('#define PAL_KV_TABLES_XML_SIZE %dULL' % len(data))
+    out.append('#define PAL_KV_TABLES_XML_HASH 0x%016xULL' % fnv1a64(data))
+    out.append('#define PAL_KV_TABLES_NUM_BLOCKS %d' % len(blocks))
+    out.append('')
+    table('const char *kv_table_strings', '%s',
+          ['"%s"' % t.replace('\\', '\\\\').replace('"', '\\"') for t in strings])
+    table('kvTableBlock kv_table_blocks', '{%s, %d, %d, %d, %d}', blocks)
+    table('uint32_t kv_table_ids', '%d', ids)
+    table('kvTableEntry kv_table_entries', '{%d, %d, %d, %d}', entries)
+    table('kvTableSelector kv_table_selectors', '{%d, %d, %d}', selectors)
+    table('uint32_t kv_table_values', '%d', values)
+    table('kvPairs kv_table_kvs', '{0x%08x, 0x%08x}', kvs)
+    out.append('#endif //USECASE_KV_TABLES_H')
+
+    with open(sys.argv[2], 'w') as f:
+        f.write('\n'.join(out) + '\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_API_TRACE_H
+#define PAL_API_TRACE_H
+
+#include <atomic>
+#include <initializer_list>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+ * Opt-in recorder of the PAL API calls that change stream and routing
+ * state, enabled by pointing vendor.audio.pal.api_trace at a file. Each
+ * call is appended as a record carrying the thread, the monotonic time it
+ * was entered, how long it took, its status, the stream handle and the
+ * arguments it was given, payloads included. load() reads a trace back and
+ * test/PalApiReplay reissues it against the library.
+ *
+ * File layout, native endianness:
+ *   struct pal_api_trace_header
+ *   struct pal_api_trace_record, followed by num_args times
+ *       uint32_t size, size bytes of argument
+ *   ...
+ * Arguments are copied flat, pointers inside a payload are not followed.
+ */
+
+#define PAL_API_TRACE_MAGIC 0x54495041 /* "APIT" */
+#define PAL_API_TRACE_VERSION 1
+#define PAL_API_TRACE_MAX_ARGS 4
+#define PAL_API_TRACE_DEFAULT_MAX_BYTES (64 * 1024 * 1024)
+
+/* made by PAL itself from within another API call, e.g. by ContextManager */
+#define PAL_API_TRACE_FLAG_NESTED 0x1
+
+enum pal_api_trace_call {
+    PAL_API_TRACE_STREAM_OPEN = 1,  /* attributes, devices, modifiers, has cb */
+    PAL_API_TRACE_STREAM_OPEN_ASYNC,
+    PAL_API_TRACE_STREAM_CLOSE,
+    PAL_API_TRACE_STREAM_START,
+    PAL_API_TRACE_STREAM_START_ASYNC,
+    PAL_API_TRACE_STREAM_STOP,
+    PAL_API_TRACE_STREAM_PAUSE,
+    PAL_API_TRACE_STREAM_RESUME,
+    PAL_API_TRACE_STREAM_FLUSH,
+    PAL_API_TRACE_STREAM_DRAIN,     /* drain type */
+    PAL_API_TRACE_STREAM_SUSPEND,
+    PAL_API_TRACE_STREAM_SET_DEVICE, /* devices */
+    PAL_API_TRACE_STREAM_SET_PARAM, /* param id, pal_param_payload */
+    PAL_API_TRACE_STREAM_SET_VOLUME, /* pal_volume_data */
+    PAL_API_TRACE_STREAM_SET_MUTE,  /* state */
+    PAL_API_TRACE_ADD_REMOVE_EFFECT, /* effect, enable */
+    PAL_API_TRACE_SET_PARAM,        /* param id, payload */
+    PAL_API_TRACE_CALL_MAX,
+};
+
+struct pal_api_trace_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t stream_attributes_size; /* to reject traces of another ABI */
+    uint32_t device_size;
+};
+
+struct pal_api_trace_record {
+    uint32_t size;          /* whole record, arguments included */
+    uint16_t call;
+    uint8_t num_args;
+    uint8_t flags;          /* PAL_API_TRACE_FLAG_* */
+    uint32_t tid;
+    int32_t status;
+    uint64_t begin_ns;      /* CLOCK_MONOTONIC at entry */
+    uint64_t duration_ns;
+    uint64_t handle;        /* stream handle, the opened one for opens */
+};
+
+struct PalApiTraceArg {
+    const void *data;
+    uint32_t size;
+    uint64_t value;
+
+    PalApiTraceArg(const void *d, size_t s) : data(d), size(d ? s : 0), value(0) {}
+    /* scalars are kept in the argument itself */
+    PalApiTraceArg(uint64_t v) : data(nullptr), size(sizeof(value)), value(v) {}
+};
+
+/* a record read back by PalApiTrace::load() */
+struct PalApiTraceCall {
+    struct pal_api_trace_record rec;
+    std::vector<std::vector<uint8_t>> args;
+};
+
+class PalApiTrace
+{
+public:
+    static int start(const char *path, uint64_t maxBytes);
+    static void stop();
+    static bool enabled() { return active_.load(std::memory_order_relaxed); }
+    static uint64_t now();
+    static void record(uint16_t call, uint8_t flags, uint64_t beginNs, const void *handle,
+                       int32_t status, const PalApiTraceArg *args, uint32_t numArgs);
+    /* appends the calls of a trace, in the order they were entered */
+    static int load(const char *path, std::vector<PalApiTraceCall> &calls);
+
+    /* API calls in progress on this thread */
+    static thread_local uint32_t depth;
+
+private:
+    static std::atomic<bool> active_;
+    static std::mutex lock_;
+    static int fd_;
+    static uint64_t written_;
+    static uint64_t maxBytes_;
+};
+
+/*
+ * Records the enclosing API call when it returns, with the status it
+ * returns. Declare it after the status variable so that it is still alive.
+ */
+class PalApiTraceScope
+{
+public:
+    PalApiTraceScope(uint16_t call, const void *handle, const int32_t &status,
+                     std::initializer_list<PalApiTraceArg> args = {})
+        : call_(call), flags_(0), handle_(handle), status_(status), numArgs_(0), beginNs_(0)
+    {
+        if (!PalApiTrace::enabled())
+            return;
+        if (PalApiTrace::depth++)
+            flags_ |= PAL_API_TRACE_FLAG_NESTED;
+        beginNs_ = PalApiTrace::now();
+        for (auto &arg : args) {
+            if (numArgs_ == PAL_API_TRACE_MAX_ARGS)
+                break;
+            args_[numArgs_++] = arg;
+        }
+    }
+    ~PalApiTraceScope()
+    {
+        if (!beginNs_)
+            return;
+        PalApiTrace::depth--;
+        PalApiTrace::record(call_, flags_, beginNs_, handle_, status_, args_, numArgs_);
+    }
+    void setHandle(const void *handle) { handle_ = handle; }
+
+private:
+    uint16_t call_;
+    uint8_t flags_;
+    const void *handle_;
+    const int32_t &status_;
+    uint32_t numArgs_;
+    uint64_t beginNs_;
+    PalApiTraceArg args_[PAL_API_TRACE_MAX_ARGS] = {
+        {nullptr, 0}, {nullptr, 0}, {nullptr, 0}, {nullptr, 0}};
+};
+
+#endif /* PAL_API_TRACE_H */
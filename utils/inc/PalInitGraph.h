@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_INIT_GRAPH_H
+#define PAL_INIT_GRAPH_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/* threads used to run init phases, the calling thread included */
+#define PAL_INIT_DEFAULT_WORKERS 3
+#define PAL_INIT_MAX_WORKERS 8
+
+/*
+ * Dependency aware runner for the phases of pal_init.
+ *
+ * Phases are added with the names of the phases they depend on and run()
+ * executes every phase once all of its dependencies completed, on a small
+ * pool of worker threads plus the calling thread. A phase that fails (non
+ * zero return or exception) makes its dependents fail with the same status
+ * without running them; independent phases still run. run() returns once
+ * every phase is done and logs the start offset and duration of each one,
+ * so startup regressions show up per phase. With one worker the phases run
+ * sequentially on the caller in the order they were added.
+ */
+class PalInitGraph
+{
+public:
+    typedef std::function<int()> PhaseFn;
+
+    PalInitGraph(const char *name, uint32_t workers);
+    int addPhase(const std::string &name, PhaseFn fn,
+                 const std::vector<std::string> &deps = {});
+    int run();
+    const std::string &failedPhase() const { return failedPhase_; }
+
+private:
+    struct phase {
+        std::string name;
+        PhaseFn fn;
+        std::vector<uint32_t> dependents;
+        uint32_t pending;
+        int status;
+        bool ran;
+        int64_t start_us;
+        int64_t end_us;
+    };
+
+    void worker();
+    void execute(uint32_t id);
+    int64_t nowUs();
+
+    const char *name_;
+    uint32_t workers_;
+    std::vector<phase> phases_;
+    std::vector<uint32_t> ready_;
+    uint32_t remaining_;
+    int status_;
+    std::string failedPhase_;
+    int64_t begin_us_;
+    std::mutex lock_;
+    std::condition_variable cv_;
+};
+
+#endif //PAL_INIT_GRAPH_H
@@ -34,6 +34,9 @@
 
 
 #include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -51,48 +54,81 @@ typedef enum {
     READER_ENABLED = 1,
 } pal_ring_buffer_reader_state;
 
+/*
+ * PAL_RING_BUFFER_LOCKED serializes every write, reserve/commit, read and
+ * advance on the buffer mutex, as the buffer always did.
+ * PAL_RING_BUFFER_LOCK_FREE leaves the data path to the atomic counts, for
+ * one writer racing several readers.
+ */
+typedef enum {
+    PAL_RING_BUFFER_LOCKED = 0,
+    PAL_RING_BUFFER_LOCK_FREE = 1,
+} pal_ring_buffer_mode;
+
+/*
+ * Contiguous region of ring buffer storage returned by reserve(). A
+ * reservation crossing the end of the buffer is returned as two spans.
+ */
+typedef struct {
+    char *buffer;
+    size_t size;
+} pal_ring_buffer_span;
+
 class PalRingBuffer;
 
+/*
+ * Ring buffer with one writer and any number of readers. The writer
+ * publishes a monotonic byte count and every reader owns a monotonic read
+ * count, so unread size of a reader is the difference of the two. In
+ * PAL_RING_BUFFER_LOCK_FREE mode mutex_ only serializes control operations
+ * (reset, state update) and backs the condition variable readers may
+ * block on in waitForData(). readersMutex_ guards the list of readers.
+ */
 class PalRingBufferReader {
  public:
      PalRingBufferReader(PalRingBuffer *buffer)
          : ringBuffer_(buffer),
-           unreadSize_(0),
-           readOffset_(0),
-           state_(READER_DISABLED) {}
+           readCount_(0),
+           state_(READER_DISABLED),
+           wakeUp_(false) {}
 
     ~PalRingBufferReader() {};
 
     size_t advanceReadOffset(size_t advanceSize);
     int32_t read(void* readBuffer, size_t readSize);
+    int32_t waitForData(size_t bytes, uint32_t timeoutMs);
+    void wakeUp();
     void updateState(pal_ring_buffer_reader_state state);
     void getIndices(uint32_t *startIndice, uint32_t *endIndice);
     size_t getUnreadSize();
     void reset();
-    bool isEnabled() { return state_ == READER_ENABLED; }
+    bool isEnabled() { return state_.load(std::memory_order_acquire) == READER_ENABLED; }
 
     friend class PalRingBuffer;
     friend class StreamSoundTrigger;
 
  protected:
     PalRingBuffer *ringBuffer_;
-    size_t unreadSize_;
-    size_t readOffset_;
-    pal_ring_buffer_reader_state state_;
+    std::atomic<uint64_t> readCount_;
+    std::atomic<pal_ring_buffer_reader_state> state_;
+    bool wakeUp_; /* guarded by ringBuffer_->mutex_ */
 };
 
 class PalRingBuffer {
  public:
-    explicit PalRingBuffer(size_t bufferSize)
+    explicit PalRingBuffer(size_t bufferSize,
+                           pal_ring_buffer_mode mode = PAL_RING_BUFFER_LOCKED)
         : buffer_((char*)(new char[bufferSize])),
           startIndex(0),
           endIndex(0),
-          writeOffset_(0),
-          bufferEnd_(bufferSize) {}
+          writeCount_(0),
+          bufferEnd_(bufferSize),
+          waiters_(0),
+          mode_(mode) {}
 
     ~PalRingBuffer() {
         if (buffer_)
-            delete buffer_;
+            delete[] buffer_;
 
         for (int i = 0; i < readOffsets_.size(); i++)
             delete readOffsets_[i];
@@ -104,21 +140,31 @@ class PalRingBuffer {
     size_t read(std::shared_ptr<PalRingBufferReader>reader, void* readBuffer,
                 size_t readSize);
     size_t write(void* writeBuffer, size_t writeSize);
+    /* every reserve() must be followed by a commit(), even of 0 bytes */
+    size_t reserve(size_t writeSize, pal_ring_buffer_span spans[2]);
+    void commit(size_t writtenSize);
+    int32_t waitForData(PalRingBufferReader *reader, size_t bytes,
+                        uint32_t timeoutMs);
     size_t getFreeSize();
     void updateIndices(uint32_t startIndice, uint32_t endIndice);
     void reset();
     size_t getBufferSize() { return bufferEnd_; };
     void resizeRingBuffer(size_t bufferSize);
+    pal_ring_buffer_mode getMode() { return mode_; };
 
  protected:
     std::mutex mutex_;
+    std::condition_variable cv_;
     char* buffer_;
     uint32_t startIndex;
     uint32_t endIndex;
-    size_t writeOffset_;
+    std::atomic<uint64_t> writeCount_;
     size_t bufferEnd_;
+    std::atomic<uint32_t> waiters_;
+    pal_ring_buffer_mode mode_;
+    std::mutex readersMutex_;
     std::vector<PalRingBufferReader*> readOffsets_;
-    void updateUnReadSize(size_t writtenSize);
+    void notifyReaders();
     friend class PalRingBufferReader;
 };
 #endif
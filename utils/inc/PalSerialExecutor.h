@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_SERIAL_EXECUTOR_H
+#define PAL_SERIAL_EXECUTOR_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#define PAL_EXECUTOR_DEFAULT_WORKERS 2
+#define PAL_EXECUTOR_MAX_WORKERS 8
+
+/*
+ * Worker pool running tasks in per key lanes.
+ *
+ * Tasks posted with the same key run one at a time in the order they were
+ * posted; tasks of different keys run in parallel on up to 'workers'
+ * threads. Threads are only spawned once there is work for them. drain()
+ * waits for every task of a key; called from a task of the same key it
+ * returns -EDEADLK right away. stop() runs what is queued and joins the
+ * threads, later posts are rejected.
+ */
+class PalSerialExecutor
+{
+public:
+    typedef std::function<void()> TaskFn;
+
+    PalSerialExecutor(const char *name, uint32_t workers);
+    ~PalSerialExecutor();
+    int post(const void *key, TaskFn fn);
+    int drain(const void *key);
+    void stop();
+
+private:
+    struct lane {
+        std::deque<TaskFn> tasks;
+        bool running;
+        std::thread::id runner;
+    };
+
+    void worker();
+
+    const char *name_;
+    uint32_t workers_;
+    uint32_t idle_;
+    bool exit_;
+    std::unordered_map<const void *, lane> lanes_;
+    /* keys with queued tasks and none running */
+    std::deque<const void *> ready_;
+    std::vector<std::thread> threads_;
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::condition_variable doneCv_;
+};
+
+#endif //PAL_SERIAL_EXECUTOR_H
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_SHARED_MUTEX_H
+#define PAL_SHARED_MUTEX_H
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <stdint.h>
+
+#define PAL_LOCK_STATS_MAX_SITES 128
+/* exclusive holds longer than this are logged as they happen */
+#define PAL_LOCK_HOLD_WARN_NS (50 * 1000 * 1000ULL)
+
+/* where a lock is taken, filled in at the call site by PAL_LOCK_SITE */
+typedef struct {
+    const char *func;
+    uint32_t line;
+} pal_lock_site;
+
+#define PAL_LOCK_SITE (pal_lock_site{__func__, __LINE__})
+#define PAL_LOCK(m) (m).lock(PAL_LOCK_SITE)
+#define PAL_LOCK_SHARED(m) (m).lock_shared(PAL_LOCK_SITE)
+
+typedef struct {
+    pal_lock_site site;
+    uint64_t exclusive_count;
+    uint64_t shared_count;
+    uint64_t contended_count;
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+    uint64_t hold_ns;
+    uint64_t max_hold_ns;
+} pal_lock_site_stats;
+
+/*
+ * Reader/writer mutex for the ResourceManager registries.
+ *
+ * lock()/unlock() keep std::mutex semantics for the existing lock/unlock
+ * pairs; pure lookups use lock_shared() and run concurrently with each
+ * other. Every acquisition takes the function and line of its call site,
+ * use PAL_LOCK()/PAL_LOCK_SHARED() or pass PAL_LOCK_SITE, and when
+ * statistics are enabled the wait time, contention and exclusive hold time
+ * are accumulated per call site and can be dumped to the log.
+ */
+class PalSharedMutex
+{
+public:
+    PalSharedMutex(const char *name);
+    void lock(pal_lock_site site);
+    bool try_lock(pal_lock_site site);
+    void unlock();
+    void lock_shared(pal_lock_site site);
+    void unlock_shared();
+    void enableStats(bool enable);
+    void dumpStats();
+
+private:
+    uint64_t now();
+    pal_lock_site_stats *getSiteStats_l(pal_lock_site site);
+    void recordAcquire(pal_lock_site site, bool shared, bool contended,
+                       uint64_t waitNs);
+    void recordRelease(pal_lock_site site, uint64_t holdNs);
+
+    std::shared_timed_mutex mutex_;
+    const char *name_;
+    std::atomic<bool> statsEnabled_;
+    /* valid only while held exclusively */
+    pal_lock_site ownerSite_;
+    uint64_t acquiredNs_;
+    std::mutex statsMutex_;
+    pal_lock_site_stats stats_[PAL_LOCK_STATS_MAX_SITES];
+    uint32_t numSites_;
+};
+
+/* std::lock_guard for PalSharedMutex, which needs the call site */
+class PalLockGuard
+{
+public:
+    PalLockGuard(PalSharedMutex &mutex, pal_lock_site site) : mutex_(mutex)
+    {
+        mutex_.lock(site);
+    }
+    ~PalLockGuard() { mutex_.unlock(); }
+    PalLockGuard(const PalLockGuard &) = delete;
+    PalLockGuard &operator=(const PalLockGuard &) = delete;
+
+private:
+    PalSharedMutex &mutex_;
+};
+
+#endif //PAL_SHARED_MUTEX_H
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PAL_TRACE_LOG_H
+#define PAL_TRACE_LOG_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "PalCommon.h"
+
+/*
+ * Binary log for the sites that run once per buffer. With
+ * vendor.audio.pal.trace_log pointing at a file, PAL_TRACE_* sites no longer
+ * format anything: each call stores the monotonic time, the address of its
+ * static site descriptor (the format id) and its raw arguments in a ring
+ * owned by the calling thread, which no other thread writes. The rings are
+ * written to the file on pal_deinit and on the crash signals PAL handles,
+ * test/PalTraceDump formats them. Without the property the sites log
+ * through ALOG as usual.
+ *
+ * Arguments are kept as 64 bit values, so only integers, enums, floating
+ * point and pointers printed with %p can be traced; strings cannot.
+ *
+ * File layout, native endianness:
+ *   struct pal_trace_log_header
+ *   num_sites times struct pal_trace_log_site, followed by
+ *       tag_len + func_len + fmt_len bytes of strings, not terminated
+ *   num_threads times struct pal_trace_log_thread, followed by
+ *       num_entries times struct pal_trace_entry, oldest first
+ * A ring is the entries given to start() rounded up to a power of two and
+ * keeps one less than that, the slot its owner fills next is not dumped.
+ * Entries overwritten while the dump was taken have a site of 0.
+ */
+
+#define PAL_TRACE_LOG_MAGIC 0x474c5450 /* "PTLG" */
+#define PAL_TRACE_LOG_VERSION 1
+#define PAL_TRACE_MAX_ARGS 6
+#define PAL_TRACE_MAX_THREADS 64
+#define PAL_TRACE_DEFAULT_ENTRIES 2048
+
+struct pal_trace_site {
+    uint32_t level;         /* PAL_LOG_* */
+    uint32_t line;
+    const char *tag;
+    const char *func;
+    const char *fmt;
+    std::atomic<bool> registered;
+    struct pal_trace_site *next;
+};
+
+struct pal_trace_entry {
+    uint64_t ts_ns;         /* CLOCK_MONOTONIC */
+    uint64_t site;          /* address of the pal_trace_site */
+    uint64_t args[PAL_TRACE_MAX_ARGS];
+};
+
+struct pal_trace_log_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t long_size;     /* to print %l and %z arguments */
+    uint32_t num_sites;
+    uint32_t num_threads;
+    uint32_t reserved;
+};
+
+struct pal_trace_log_site {
+    uint64_t site;
+    uint32_t level;
+    uint32_t line;
+    uint16_t tag_len;
+    uint16_t func_len;
+    uint32_t fmt_len;
+};
+
+struct pal_trace_log_thread {
+    uint32_t tid;
+    uint32_t num_entries;
+};
+
+struct PalTraceRing;
+
+class PalTraceLog
+{
+public:
+    static int start(const char *path, uint32_t entries);
+    /* writes the rings to the file given to start, safe from a signal */
+    static int dump();
+    static void stop();
+    static bool enabled() { return active_.load(std::memory_order_relaxed); }
+    static uint64_t now();
+
+    template<typename... T>
+    static void record(struct pal_trace_site *site, T... args)
+    {
+        static_assert(sizeof...(T) <= PAL_TRACE_MAX_ARGS, "too many arguments to trace");
+        const uint64_t values[] = {toArg(args)..., 0};
+        struct pal_trace_entry *entry;
+
+        if (!site->registered.load(std::memory_order_acquire))
+            registerSite(site);
+        entry = begin();
+        if (!entry)
+            return;
+        entry->site = (uint64_t)(uintptr_t)site;
+        memcpy(entry->args, values, sizeof...(T) * sizeof(uint64_t));
+        commit();
+    }
+
+private:
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value,
+                                   uint64_t>::type toArg(T v)
+    {
+        /* sign extends signed types, PalTraceDump truncates per conversion */
+        return (uint64_t)(int64_t)v;
+    }
+    template<typename T>
+    static uint64_t toArg(T *p)
+    {
+        static_assert(!std::is_same<typename std::remove_cv<T>::type, char>::value,
+                      "strings cannot be traced, the pointer may not outlive the call");
+        return (uint64_t)(uintptr_t)p;
+    }
+    static uint64_t toArg(double v)
+    {
+        uint64_t bits;
+
+        memcpy(&bits, &v, sizeof(bits));
+        return bits;
+    }
+
+    static void registerSite(struct pal_trace_site *site);
+    static struct pal_trace_entry *begin();
+    static void commit();
+
+    static std::atomic<bool> active_;
+    static std::atomic<struct pal_trace_site *> sites_;
+    static std::atomic<PalTraceRing *> rings_[PAL_TRACE_MAX_THREADS];
+    static uint32_t entries_;
+    static char path_[256];
+};
+
+#define PAL_TRACE_LOG(lvl, alog, log_tag, arg, ...)                            \
+    if (PAL_LOG_ENABLED(lvl)) {                                                \
+        static struct pal_trace_site _pal_trace_site =                         \
+            {lvl, __LINE__, log_tag, __func__, arg, {false}, nullptr};         \
+        if (PalTraceLog::enabled())                                            \
+            PalTraceLog::record(&_pal_trace_site, ##__VA_ARGS__);              \
+        else                                                                   \
+            alog("%s: %d: " arg, __func__, __LINE__, ##__VA_ARGS__);           \
+    }
+
+#define PAL_TRACE_DBG(log_tag, arg, ...) \
+    PAL_TRACE_LOG(PAL_LOG_DBG, ALOGD, log_tag, arg, ##__VA_ARGS__)
+#define PAL_TRACE_INFO(log_tag, arg, ...) \
+    PAL_TRACE_LOG(PAL_LOG_INFO, ALOGI, log_tag, arg, ##__VA_ARGS__)
+#define PAL_TRACE_VERBOSE(log_tag, arg, ...) \
+    PAL_TRACE_LOG(PAL_LOG_VERBOSE, ALOGV, log_tag, arg, ##__VA_ARGS__)
+
+#endif /* PAL_TRACE_LOG_H */
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: PalApiTrace"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "PalApi.h"
+#include "PalCommon.h"
+#include "PalApiTrace.h"
+
+std::atomic<bool> PalApiTrace::active_(false);
+std::mutex PalApiTrace::lock_;
+int PalApiTrace::fd_ = -1;
+uint64_t PalApiTrace::written_ = 0;
+uint64_t PalApiTrace::maxBytes_ = 0;
+thread_local uint32_t PalApiTrace::depth = 0;
+
+int PalApiTrace::start(const char *path, uint64_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    struct pal_api_trace_header header;
+    int fd;
+
+    if (fd_ >= 0) {
+        PAL_ERR(LOG_TAG, "already recording");
+        return -EBUSY;
+    }
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        PAL_ERR(LOG_TAG, "cannot open %s, error %d", path, errno);
+        return -errno;
+    }
+
+    header.magic = PAL_API_TRACE_MAGIC;
+    header.version = PAL_API_TRACE_VERSION;
+    header.stream_attributes_size = sizeof(struct pal_stream_attributes);
+    header.device_size = sizeof(struct pal_device);
+    if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+        PAL_ERR(LOG_TAG, "cannot write %s, error %d", path, errno);
+        close(fd);
+        return -EIO;
+    }
+
+    fd_ = fd;
+    written_ = sizeof(header);
+    maxBytes_ = maxBytes;
+    active_.store(true);
+    PAL_INFO(LOG_TAG, "recording API calls to %s, up to %llu bytes", path,
+             (unsigned long long)maxBytes);
+    return 0;
+}
+
+void PalApiTrace::stop()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    active_.store(false);
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+uint64_t PalApiTrace::now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void PalApiTrace::record(uint16_t call, uint8_t flags, uint64_t beginNs, const void *handle,
+                         int32_t status, const PalApiTraceArg *args, uint32_t numArgs)
+{
+    struct pal_api_trace_record rec;
+    std::vector<uint8_t> buf;
+    size_t offset;
+
+    rec.size = sizeof(rec);
+    for (uint32_t i = 0; i < numArgs; i++)
+        rec.size += sizeof(uint32_t) + args[i].size;
+    rec.call = call;
+    rec.num_args = numArgs;
+    rec.flags = flags;
+    rec.tid = (uint32_t)syscall(SYS_gettid);
+    rec.status = status;
+    rec.begin_ns = beginNs;
+    rec.duration_ns = now() - beginNs;
+    rec.handle = (uint64_t)(uintptr_t)handle;
+
+    /* one write per record, a crash loses at most the call in flight */
+    buf.resize(rec.size);
+    memcpy(buf.data(), &rec, sizeof(rec));
+    offset = sizeof(rec);
+    for (uint32_t i = 0; i < numArgs; i++) {
+        memcpy(buf.data() + offset, &args[i].size, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+        if (args[i].size)
+            memcpy(buf.data() + offset, args[i].data ? args[i].data : &args[i].value,
+                   args[i].size);
+        offset += args[i].size;
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    if (fd_ < 0)
+        return;
+    if (written_ + rec.size > maxBytes_) {
+        PAL_ERR(LOG_TAG, "trace reached %llu bytes, recording stopped",
+                (unsigned long long)written_);
+        active_.store(false);
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+    if (write(fd_, buf.data(), rec.size) != (ssize_t)rec.size) {
+        PAL_ERR(LOG_TAG, "write failed, error %d, recording stopped", errno);
+        active_.store(false);
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+    written_ += rec.size;
+}
+
+int PalApiTrace::load(const char *path, std::vector<PalApiTraceCall> &calls)
+{
+    struct pal_api_trace_header header;
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    ssize_t num_read;
+    size_t offset, end, first;
+    uint32_t size;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        PAL_ERR(LOG_TAG, "cannot open %s, error %d", path, errno);
+        return -errno;
+    }
+    while ((num_read = read(fd, buf, sizeof(buf))) > 0)
+        data.insert(data.end(), buf, buf + num_read);
+    close(fd);
+    if (num_read < 0) {
+        PAL_ERR(LOG_TAG, "cannot read %s, error %d", path, errno);
+        return -EIO;
+    }
+
+    if (data.size() < sizeof(header)) {
+        PAL_ERR(LOG_TAG, "%s is not a trace", path);
+        return -EINVAL;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != PAL_API_TRACE_MAGIC || header.version != PAL_API_TRACE_VERSION ||
+        header.stream_attributes_size != sizeof(struct pal_stream_attributes) ||
+        header.device_size != sizeof(struct pal_device)) {
+        PAL_ERR(LOG_TAG, "%s: trace version or ABI does not match this build", path);
+        return -EINVAL;
+    }
+
+    /* a record cut short by a crash ends the trace */
+    first = calls.size();
+    for (offset = sizeof(header); offset + sizeof(struct pal_api_trace_record) <= data.size();
+         offset = end) {
+        PalApiTraceCall call;
+
+        memcpy(&call.rec, data.data() + offset, sizeof(call.rec));
+        end = offset + call.rec.size;
+        if (call.rec.size < sizeof(call.rec) || end > data.size())
+            break;
+        offset += sizeof(call.rec);
+        for (uint32_t i = 0; i < call.rec.num_args; i++) {
+            if (offset + sizeof(size) > end)
+                break;
+            memcpy(&size, data.data() + offset, sizeof(size));
+            offset += sizeof(size);
+            if (offset + size > end)
+                break;
+            call.args.emplace_back(data.begin() + offset, data.begin() + offset + size);
+            offset += size;
+        }
+        if (call.args.size() != call.rec.num_args || call.rec.call >= PAL_API_TRACE_CALL_MAX) {
+            PAL_ERR(LOG_TAG, "%s: bad record at offset %zu, skipped", path,
+                    end - call.rec.size);
+            continue;
+        }
+        calls.push_back(std::move(call));
+    }
+
+    std::stable_sort(calls.begin() + first, calls.end(),
+                     [](const PalApiTraceCall &a, const PalApiTraceCall &b) {
+        return a.rec.begin_ns < b.rec.begin_ns;
+    });
+    return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: PalInitGraph"
+
+#include <errno.h>
+#include <chrono>
+#include <exception>
+#include <thread>
+#include "PalCommon.h"
+#include "PalInitGraph.h"
+
+PalInitGraph::PalInitGraph(const char *name, uint32_t workers)
+    : name_(name), remaining_(0), status_(0), begin_us_(0)
+{
+    if (workers < 1)
+        workers = 1;
+    if (workers > PAL_INIT_MAX_WORKERS)
+        workers = PAL_INIT_MAX_WORKERS;
+    workers_ = workers;
+}
+
+int64_t PalInitGraph::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Dependencies must have been added before, which also keeps the graph
+ * acyclic. Returns the phase index or -EINVAL.
+ */
+int PalInitGraph::addPhase(const std::string &name, PhaseFn fn,
+                           const std::vector<std::string> &deps)
+{
+    phase p;
+    uint32_t id = phases_.size();
+
+    for (auto &other : phases_) {
+        if (other.name == name) {
+            PAL_ERR(LOG_TAG, "%s: duplicate phase %s", name_, name.c_str());
+            return -EINVAL;
+        }
+    }
+
+    p.name = name;
+    p.fn = fn;
+    p.pending = 0;
+    p.status = 0;
+    p.ran = false;
+    p.start_us = 0;
+    p.end_us = 0;
+    for (auto &dep : deps) {
+        uint32_t i;
+
+        for (i = 0; i < phases_.size(); i++) {
+            if (phases_[i].name == dep)
+                break;
+        }
+        if (i == phases_.size()) {
+            PAL_ERR(LOG_TAG, "%s: phase %s depends on unknown phase %s",
+                    name_, name.c_str(), dep.c_str());
+            return -EINVAL;
+        }
+        phases_[i].dependents.push_back(id);
+        p.pending++;
+    }
+    phases_.push_back(p);
+
+    return id;
+}
+
+void PalInitGraph::execute(uint32_t id)
+{
+    phase &p = phases_[id];
+    int status = 0;
+
+    p.start_us = nowUs() - begin_us_;
+    try {
+        status = p.fn();
+    } catch (const std::exception &e) {
+        PAL_ERR(LOG_TAG, "%s: phase %s threw: %s", name_, p.name.c_str(), e.what());
+        status = -EINVAL;
+    } catch (...) {
+        PAL_ERR(LOG_TAG, "%s: phase %s threw", name_, p.name.c_str());
+        status = -EINVAL;
+    }
+    p.end_us = nowUs() - begin_us_;
+    p.status = status;
+    p.ran = true;
+}
+
+void PalInitGraph::worker()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    uint32_t id;
+
+    while (1) {
+        cv_.wait(lock, [this] { return !ready_.empty() || remaining_ == 0; });
+        if (remaining_ == 0)
+            return;
+
+        id = ready_.front();
+        ready_.erase(ready_.begin());
+        /* a failed dependency already stored its status in this phase */
+        if (!phases_[id].status) {
+            lock.unlock();
+            execute(id);
+            lock.lock();
+        }
+
+        phase &p = phases_[id];
+        if (p.status && !status_) {
+            status_ = p.status;
+            failedPhase_ = p.name;
+        }
+        for (auto dep : p.dependents) {
+            if (p.status && !phases_[dep].status)
+                phases_[dep].status = p.status;
+            if (--phases_[dep].pending == 0)
+                ready_.push_back(dep);
+        }
+        remaining_--;
+        cv_.notify_all();
+    }
+}
+
+int PalInitGraph::run()
+{
+    std::vector<std::thread> threads;
+    int64_t total_us, busy_us = 0;
+
+    begin_us_ = nowUs();
+    remaining_ = phases_.size();
+    for (uint32_t i = 0; i < phases_.size(); i++) {
+        if (!phases_[i].pending)
+            ready_.push_back(i);
+    }
+
+    for (uint32_t i = 1; i < workers_ && i < phases_.size(); i++)
+        threads.emplace_back(&PalInitGraph::worker, this);
+    worker();
+    for (auto &t : threads)
+        t.join();
+
+    total_us = nowUs() - begin_us_;
+    for (auto &p : phases_) {
+        if (p.ran) {
+            busy_us += p.end_us - p.start_us;
+            PAL_INFO(LOG_TAG, "%s: phase %s +%lld us took %lld us, status %d", name_,
+                     p.name.c_str(), (long long)p.start_us,
+                     (long long)(p.end_us - p.start_us), p.status);
+        } else {
+            PAL_INFO(LOG_TAG, "%s: phase %s skipped, status %d", name_,
+                     p.name.c_str(), p.status);
+        }
+    }
+    PAL_INFO(LOG_TAG, "%s: %zu phases on %u workers took %lld us, %lld us of work",
+             name_, phases_.size(), workers_, (long long)total_us, (long long)busy_us);
+
+    return status_;
+}
@@ -33,10 +33,12 @@
 #endif
 #include "PalRingBuffer.h"
 #include "PalCommon.h"
+#include "PalTraceLog.h"
 #define LOG_TAG "PAL: PalRingBuffer"
 
 int32_t PalRingBuffer::removeReader(PalRingBufferReader *reader)
 {
+    std::lock_guard<std::mutex> lock(readersMutex_);
     auto iter = std::find(readOffsets_.begin(), readOffsets_.end(), reader);
     if (iter != readOffsets_.end())
         readOffsets_.erase(iter);
@@ -52,243 +54,345 @@ size_t PalRingBuffer::read(std::shared_ptr<PalRingBufferReader>reader __unused,
 
 size_t PalRingBuffer::getFreeSize()
 {
-
     size_t freeSize = bufferEnd_;
+    size_t unreadSize = 0;
+    uint64_t writeCount = writeCount_.load(std::memory_order_acquire);
     std::vector<PalRingBufferReader*>::iterator it;
 
+    std::lock_guard<std::mutex> lock(readersMutex_);
     for (it = readOffsets_.begin(); it != readOffsets_.end(); it++) {
-        if ((*(it))->state_ == READER_ENABLED)
-            freeSize = std::min(freeSize, bufferEnd_ - (*(it))->unreadSize_);
+        if ((*(it))->state_.load(std::memory_order_acquire) != READER_ENABLED)
+            continue;
+        unreadSize = writeCount -
+            (*(it))->readCount_.load(std::memory_order_acquire);
+        freeSize = std::min(freeSize, bufferEnd_ - std::min(unreadSize, bufferEnd_));
     }
     return freeSize;
 }
 
-void PalRingBuffer::updateUnReadSize(size_t writtenSize)
-{
-    int32_t i = 0;
-    std::vector<PalRingBufferReader*>::iterator it;
-
-    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++, i++) {
-        (*(it))->unreadSize_ += writtenSize;
-        PAL_VERBOSE(LOG_TAG, "Reader (%d), unreadSize(%zu)", i, (*(it))->unreadSize_);
-    }
-}
-
 void PalRingBuffer::updateIndices(uint32_t startIndice, uint32_t endIndice)
 {
     startIndex = startIndice;
     endIndex = endIndice;
-    PAL_VERBOSE(LOG_TAG, "start index = %u, end index = %u", startIndex, endIndex);
+    PAL_TRACE_VERBOSE(LOG_TAG, "start index = %u, end index = %u", startIndex, endIndex);
 }
 
-size_t PalRingBuffer::write(void* writeBuffer, size_t writeSize)
+void PalRingBuffer::notifyReaders()
 {
-    /* update the unread size for each reader*/
+    /*
+     * Pairs with the increment of waiters_ in waitForData: either the
+     * waiter observes the new write count in its predicate, or we observe
+     * the waiter here and wake it up under mutex_.
+     */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0)
+        return;
+
     mutex_.lock();
-    size_t freeSize = getFreeSize();
-    size_t writtenSize = 0;
-    int32_t i = 0;
+    mutex_.unlock();
+    cv_.notify_all();
+}
+
+size_t PalRingBuffer::reserve(size_t writeSize, pal_ring_buffer_span spans[2])
+{
+    uint64_t writeCount = 0;
+    size_t writeOffset = 0;
+    size_t freeSize = 0;
     size_t sizeToCopy = 0;
 
-    PAL_DBG(LOG_TAG, "Enter. freeSize(%zu), writeOffset(%zu)", freeSize, writeOffset_);
+    /* held until commit() */
+    if (mode_ == PAL_RING_BUFFER_LOCKED)
+        mutex_.lock();
+
+    /* only the writer advances writeCount_, so a relaxed load is enough */
+    writeCount = writeCount_.load(std::memory_order_relaxed);
+    writeOffset = writeCount % bufferEnd_;
+    freeSize = getFreeSize();
+
+    PAL_TRACE_DBG(LOG_TAG, "Enter. freeSize(%zu), writeOffset(%zu)", freeSize, writeOffset);
 
     if (writeSize <= freeSize)
         sizeToCopy = writeSize;
     else
         sizeToCopy = freeSize;
 
-    if (sizeToCopy) {
-        //buffer wrapped around
-        if (writeOffset_ + sizeToCopy > bufferEnd_) {
-            i = bufferEnd_ - writeOffset_;
-
-            ar_mem_cpy(buffer_ + writeOffset_, i, writeBuffer, i);
-            writtenSize += i;
-            sizeToCopy -= writtenSize;
-            ar_mem_cpy(buffer_, sizeToCopy, (char*)writeBuffer + writtenSize,
-                             sizeToCopy);
-            writtenSize += sizeToCopy;
-            writeOffset_ = sizeToCopy;
-        } else {
-            ar_mem_cpy(buffer_ + writeOffset_, sizeToCopy, writeBuffer,
-                             sizeToCopy);
-            writeOffset_ += sizeToCopy;
-            writtenSize = sizeToCopy;
-        }
+    spans[0].buffer = buffer_ + writeOffset;
+    spans[1].buffer = buffer_;
+    //buffer wrapped around
+    if (writeOffset + sizeToCopy > bufferEnd_) {
+        spans[0].size = bufferEnd_ - writeOffset;
+        spans[1].size = sizeToCopy - spans[0].size;
+    } else {
+        spans[0].size = sizeToCopy;
+        spans[1].size = 0;
     }
-    updateUnReadSize(writtenSize);
-    writeOffset_ = writeOffset_ % bufferEnd_;
-    PAL_DBG(LOG_TAG, "Exit. writeOffset(%zu)", writeOffset_);
-    mutex_.unlock();
+
+    return sizeToCopy;
+}
+
+void PalRingBuffer::commit(size_t writtenSize)
+{
+    uint64_t writeCount = writeCount_.load(std::memory_order_relaxed);
+
+    /* publish the copied bytes to all readers */
+    if (writtenSize)
+        writeCount_.store(writeCount + writtenSize, std::memory_order_release);
+    if (mode_ == PAL_RING_BUFFER_LOCKED)
+        mutex_.unlock();
+    if (!writtenSize)
+        return;
+
+    notifyReaders();
+    PAL_TRACE_DBG(LOG_TAG, "Exit. writeOffset(%zu)",
+        (size_t)((writeCount + writtenSize) % bufferEnd_));
+}
+
+size_t PalRingBuffer::write(void* writeBuffer, size_t writeSize)
+{
+    pal_ring_buffer_span spans[2];
+    size_t writtenSize = 0;
+
+    writtenSize = reserve(writeSize, spans);
+    if (spans[0].size)
+        ar_mem_cpy(spans[0].buffer, spans[0].size, writeBuffer,
+                         spans[0].size);
+    if (spans[1].size)
+        ar_mem_cpy(spans[1].buffer, spans[1].size,
+                         (char*)writeBuffer + spans[0].size, spans[1].size);
+    commit(writtenSize);
+
     return writtenSize;
 }
 
+int32_t PalRingBuffer::waitForData(PalRingBufferReader *reader, size_t bytes,
+                                   uint32_t timeoutMs)
+{
+    int32_t status = 0;
+    bool ready = false;
+
+    if (!reader)
+        return -EINVAL;
+
+    if (!reader->isEnabled())
+        return -EINVAL;
+
+    if (reader->getUnreadSize() >= bytes)
+        return 0;
+
+    waiters_.fetch_add(1);
+    {
+        std::unique_lock<std::mutex> lck(mutex_);
+        ready = cv_.wait_for(lck, std::chrono::milliseconds(timeoutMs),
+            [&] {
+                return !reader->isEnabled() || reader->wakeUp_ ||
+                    reader->getUnreadSize() >= bytes;
+            });
+        if (reader->wakeUp_) {
+            reader->wakeUp_ = false;
+            status = -EINTR;
+        }
+    }
+    waiters_.fetch_sub(1);
+
+    if (status)
+        return status;
+    if (!reader->isEnabled())
+        return -EINVAL;
+
+    return ready ? 0 : -ETIMEDOUT;
+}
+
 void PalRingBuffer::reset()
 {
+    uint64_t writeCount = 0;
     std::vector<PalRingBufferReader*>::iterator it;
 
     mutex_.lock();
     startIndex = 0;
     endIndex = 0;
-    writeOffset_ = 0;
-    mutex_.unlock();
 
-    /* Reset all the associated readers */
-    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++)
-        (*(it))->reset();
+    /* Reset all the associated readers to the current write position */
+    writeCount = writeCount_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> readersLock(readersMutex_);
+    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++) {
+        (*(it))->readCount_.store(writeCount, std::memory_order_release);
+        (*(it))->state_.store(READER_DISABLED, std::memory_order_release);
+        (*(it))->wakeUp_ = false;
+    }
+    readersLock.unlock();
+    mutex_.unlock();
+    cv_.notify_all();
 }
 
 void PalRingBuffer::resizeRingBuffer(size_t bufferSize)
 {
+    std::vector<PalRingBufferReader*>::iterator it;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> readersLock(readersMutex_);
     if (buffer_) {
         delete[] buffer_;
         buffer_ = nullptr;
     }
     buffer_ = (char *)new char[bufferSize];
     bufferEnd_ = bufferSize;
+
+    writeCount_.store(0, std::memory_order_release);
+    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++)
+        (*(it))->readCount_.store(0, std::memory_order_release);
 }
 
 int32_t PalRingBufferReader::read(void* readBuffer, size_t bufferSize)
 {
-    int32_t readSize = 0;
-
-    if (state_ == READER_DISABLED)
+    uint64_t readCount = 0;
+    uint64_t writeCount = 0;
+    size_t unreadSize = 0;
+    size_t readOffset = 0;
+    size_t readSize = 0;
+    size_t i = 0;
+    std::unique_lock<std::mutex> lock(ringBuffer_->mutex_, std::defer_lock);
+
+    if (ringBuffer_->mode_ == PAL_RING_BUFFER_LOCKED)
+        lock.lock();
+
+    if (!isEnabled())
         return -EINVAL;
 
+    readCount = readCount_.load(std::memory_order_acquire);
+    writeCount = ringBuffer_->writeCount_.load(std::memory_order_acquire);
+
     // Return 0 when no data can be read for current reader
-    if (unreadSize_ == 0)
+    unreadSize = writeCount - readCount;
+    if (unreadSize == 0)
         return 0;
 
-    ringBuffer_->mutex_.lock();
+    readSize = std::min(bufferSize, unreadSize);
+    readOffset = readCount % ringBuffer_->bufferEnd_;
+    i = ringBuffer_->bufferEnd_ - readOffset;
 
-    // when writeOffset leads readOffset
-    if (ringBuffer_->writeOffset_ > readOffset_) {
-        unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-
-        if (bufferSize >= unreadSize_) {
-            ar_mem_cpy(readBuffer, unreadSize_, ringBuffer_->buffer_ +
-                             readOffset_, unreadSize_);
-            readOffset_ += unreadSize_;
-            readSize = unreadSize_;
-            unreadSize_ = 0;
-        } else {
-            ar_mem_cpy(readBuffer, unreadSize_, ringBuffer_->buffer_ +
-                             readOffset_, bufferSize);
-            readOffset_ += bufferSize;
-            readSize = bufferSize;
-            unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-        }
+    if (readSize > i) {
+        // unread data wraps around the end of ring buffer
+        ar_mem_cpy(readBuffer, i, ringBuffer_->buffer_ + readOffset, i);
+        ar_mem_cpy((char *)readBuffer + i, readSize - i,
+                         ringBuffer_->buffer_, readSize - i);
     } else {
-        //When readOffset leads WriteOffset
-        int32_t freeClientSize = bufferSize;
-        int32_t i = ringBuffer_->bufferEnd_ - readOffset_;
-
-        if (bufferSize >= i) {
-            ar_mem_cpy(readBuffer, i, (char*)(ringBuffer_->buffer_ +
-                             readOffset_), i);
-            readSize = i;
-            freeClientSize -= readSize;
-            unreadSize_ = ringBuffer_->writeOffset_;
-            readOffset_ = 0;
-            //copy remaining unread buffer
-            if (freeClientSize > unreadSize_) {
-                ar_mem_cpy((char *)readBuffer + readSize, unreadSize_,
-                                 ringBuffer_->buffer_, unreadSize_);
-                readSize += unreadSize_;
-                readOffset_ = unreadSize_;
-                unreadSize_ = 0;
-            } else {
-                //copy whatever we can
-                ar_mem_cpy((char *)readBuffer + readSize, freeClientSize,
-                                 ringBuffer_->buffer_, freeClientSize);
-                readSize += freeClientSize;
-                readOffset_ = freeClientSize;
-                unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-            }
-
-        } else {
-            ar_mem_cpy(readBuffer, bufferSize, ringBuffer_->buffer_ +
-                             readOffset_, bufferSize);
-            readSize = bufferSize;
-            readOffset_ += bufferSize;
-            unreadSize_ = ringBuffer_->bufferEnd_ - readOffset_ +
-                          ringBuffer_->writeOffset_;
-        }
+        ar_mem_cpy(readBuffer, readSize, ringBuffer_->buffer_ + readOffset,
+                         readSize);
+    }
+
+    /*
+     * Release the consumed bytes to the writer. If the reader was reset
+     * while copying, the copied data is stale and must not be consumed.
+     */
+    if (!readCount_.compare_exchange_strong(readCount, readCount + readSize,
+            std::memory_order_acq_rel)) {
+        PAL_DBG(LOG_TAG, "reader reset during read, drop %zu bytes", readSize);
+        return 0;
     }
+
+    return (int32_t)readSize;
+}
+
+int32_t PalRingBufferReader::waitForData(size_t bytes, uint32_t timeoutMs)
+{
+    return ringBuffer_->waitForData(this, bytes, timeoutMs);
+}
+
+void PalRingBufferReader::wakeUp()
+{
+    ringBuffer_->mutex_.lock();
+    wakeUp_ = true;
     ringBuffer_->mutex_.unlock();
-    return readSize;
+    ringBuffer_->cv_.notify_all();
 }
 
 size_t PalRingBufferReader::advanceReadOffset(size_t advanceSize)
 {
-    size_t size_advanced = 0;
+    uint64_t readCount = 0;
+    size_t unreadSize = 0;
+    std::unique_lock<std::mutex> lock(ringBuffer_->mutex_, std::defer_lock);
 
-    std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
+    if (ringBuffer_->mode_ == PAL_RING_BUFFER_LOCKED)
+        lock.lock();
 
+    readCount = readCount_.load(std::memory_order_acquire);
     /* add code to advance the offset here*/
-    if (unreadSize_ < advanceSize) {
+    unreadSize = ringBuffer_->writeCount_.load(std::memory_order_acquire) -
+        readCount;
+    if (unreadSize < advanceSize) {
         PAL_ERR(LOG_TAG, "Cannot advance read offset %zu greater than unread size %zu",
-            advanceSize, unreadSize_);
-        return size_advanced;
+            advanceSize, unreadSize);
+        return 0;
     }
 
-    unreadSize_ -= advanceSize;
-    if (readOffset_ + advanceSize < ringBuffer_->bufferEnd_) {
-        readOffset_ += advanceSize;
-    } else {
-        readOffset_ = readOffset_ + advanceSize - ringBuffer_->bufferEnd_;
+    if (!readCount_.compare_exchange_strong(readCount, readCount + advanceSize,
+            std::memory_order_acq_rel)) {
+        PAL_ERR(LOG_TAG, "reader reset while advancing read offset");
+        return 0;
     }
-    size_advanced += advanceSize;
 
-    return size_advanced;
+    return advanceSize;
 }
 
 void PalRingBufferReader::updateState(pal_ring_buffer_reader_state state)
 {
-    PAL_DBG(LOG_TAG, "update reader state to %d", state);
-    std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
-
-    if (state_ == READER_DISABLED && state == READER_ENABLED) {
-        if (unreadSize_ > ringBuffer_->bufferEnd_)
-           unreadSize_ = ringBuffer_->bufferEnd_;
+    uint64_t writeCount = 0;
 
-        if (unreadSize_ <= ringBuffer_->writeOffset_) {
-            readOffset_ = ringBuffer_->writeOffset_ - unreadSize_;
-        } else {
-            readOffset_ = ringBuffer_->writeOffset_ +
-                ringBuffer_->bufferEnd_ - unreadSize_;
-        }
+    PAL_DBG(LOG_TAG, "update reader state to %d", state);
+    std::unique_lock<std::mutex> lock(ringBuffer_->mutex_);
+
+    if (state_.load(std::memory_order_acquire) == READER_DISABLED &&
+        state == READER_ENABLED) {
+        /* data older than one buffer length has been overwritten */
+        writeCount = ringBuffer_->writeCount_.load(std::memory_order_acquire);
+        if (writeCount - readCount_.load(std::memory_order_acquire) >
+            ringBuffer_->bufferEnd_)
+            readCount_.store(writeCount - ringBuffer_->bufferEnd_,
+                std::memory_order_release);
     }
-    state_ = state;
+    state_.store(state, std::memory_order_release);
+    lock.unlock();
+
+    if (state == READER_DISABLED)
+        ringBuffer_->cv_.notify_all();
 }
 
 void PalRingBufferReader::getIndices(uint32_t *startIndice, uint32_t *endIndice)
 {
     *startIndice = ringBuffer_->startIndex;
     *endIndice = ringBuffer_->endIndex;
-    PAL_VERBOSE(LOG_TAG, "start index = %u, end index = %u",
+    PAL_TRACE_VERBOSE(LOG_TAG, "start index = %u, end index = %u",
                 ringBuffer_->startIndex, ringBuffer_->endIndex);
 }
 
 size_t PalRingBufferReader::getUnreadSize()
 {
-    PAL_VERBOSE(LOG_TAG, "unread size %zu", unreadSize_);
-    return unreadSize_;
+    size_t unreadSize = ringBuffer_->writeCount_.load(std::memory_order_acquire) -
+        readCount_.load(std::memory_order_acquire);
+
+    PAL_TRACE_VERBOSE(LOG_TAG, "unread size %zu", unreadSize);
+    return unreadSize;
 }
 
 void PalRingBufferReader::reset()
 {
     ringBuffer_->mutex_.lock();
-    readOffset_ = 0;
-    unreadSize_ = 0;
-    state_ = READER_DISABLED;
+    readCount_.store(ringBuffer_->writeCount_.load(std::memory_order_acquire),
+        std::memory_order_release);
+    state_.store(READER_DISABLED, std::memory_order_release);
+    wakeUp_ = false;
     ringBuffer_->mutex_.unlock();
+    ringBuffer_->cv_.notify_all();
 }
 
 PalRingBufferReader* PalRingBuffer::newReader()
 {
     PalRingBufferReader* readOffset =
                   new PalRingBufferReader(this);
+
+    readOffset->readCount_.store(writeCount_.load(std::memory_order_acquire),
+        std::memory_order_release);
+    std::lock_guard<std::mutex> lock(readersMutex_);
     readOffsets_.push_back(readOffset);
     return readOffset;
 }
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: PalSerialExecutor"
+
+#include <errno.h>
+#include <exception>
+#include "PalCommon.h"
+#include "PalSerialExecutor.h"
+
+PalSerialExecutor::PalSerialExecutor(const char *name, uint32_t workers)
+    : name_(name), idle_(0), exit_(false)
+{
+    if (workers < 1)
+        workers = 1;
+    if (workers > PAL_EXECUTOR_MAX_WORKERS)
+        workers = PAL_EXECUTOR_MAX_WORKERS;
+    workers_ = workers;
+}
+
+PalSerialExecutor::~PalSerialExecutor()
+{
+    stop();
+}
+
+int PalSerialExecutor::post(const void *key, TaskFn fn)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+
+    if (exit_) {
+        PAL_ERR(LOG_TAG, "%s: stopped, task rejected", name_);
+        return -EPIPE;
+    }
+
+    lane &l = lanes_[key];
+    l.tasks.push_back(std::move(fn));
+    if (!l.running && l.tasks.size() == 1)
+        ready_.push_back(key);
+
+    /* every idle thread takes one ready lane, spawn for the rest */
+    if (idle_ < ready_.size() && threads_.size() < workers_) {
+        try {
+            threads_.emplace_back(&PalSerialExecutor::worker, this);
+        } catch (const std::exception& e) {
+            /* the threads already there still drain the queue */
+            PAL_ERR(LOG_TAG, "%s: worker spawn failed: %s", name_, e.what());
+            if (threads_.empty()) {
+                l.tasks.pop_back();
+                if (l.tasks.empty() && !l.running) {
+                    ready_.pop_back();
+                    lanes_.erase(key);
+                }
+                return -ENOMEM;
+            }
+        }
+    }
+    lock.unlock();
+    cv_.notify_one();
+
+    return 0;
+}
+
+int PalSerialExecutor::drain(const void *key)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    auto it = lanes_.find(key);
+
+    /* the lane would wait for the caller itself */
+    if (it != lanes_.end() && it->second.running &&
+        it->second.runner == std::this_thread::get_id())
+        return -EDEADLK;
+
+    doneCv_.wait(lock, [&] { return lanes_.find(key) == lanes_.end(); });
+    return 0;
+}
+
+void PalSerialExecutor::stop()
+{
+    std::vector<std::thread> threads;
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        exit_ = true;
+        threads.swap(threads_);
+    }
+    cv_.notify_all();
+    for (auto &t : threads)
+        t.join();
+}
+
+void PalSerialExecutor::worker()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    const void *key = NULL;
+    TaskFn fn;
+
+    while (true) {
+        idle_++;
+        cv_.wait(lock, [&] { return !ready_.empty() || exit_; });
+        idle_--;
+        if (ready_.empty())
+            break;
+
+        key = ready_.front();
+        ready_.pop_front();
+        lane &l = lanes_[key];
+        fn = std::move(l.tasks.front());
+        l.tasks.pop_front();
+        l.running = true;
+        l.runner = std::this_thread::get_id();
+        lock.unlock();
+
+        try {
+            fn();
+        } catch (const std::exception& e) {
+            PAL_ERR(LOG_TAG, "%s: task for %pK threw: %s", name_, key, e.what());
+        }
+        fn = nullptr;
+
+        lock.lock();
+        /* a running lane is never erased, so l is still valid */
+        l.running = false;
+        if (l.tasks.empty()) {
+            lanes_.erase(key);
+            doneCv_.notify_all();
+        } else {
+            ready_.push_back(key);
+        }
+    }
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: PalSharedMutex"
+
+#include <string.h>
+#include <time.h>
+#include "PalCommon.h"
+#include "PalSharedMutex.h"
+
+PalSharedMutex::PalSharedMutex(const char *name)
+    : name_(name),
+      statsEnabled_(false),
+      ownerSite_({nullptr, 0}),
+      acquiredNs_(0),
+      numSites_(0)
+{
+    memset(stats_, 0, sizeof(stats_));
+}
+
+uint64_t PalSharedMutex::now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void PalSharedMutex::lock(pal_lock_site site)
+{
+    uint64_t start;
+    uint64_t acquired;
+    bool contended;
+
+    if (!statsEnabled_.load(std::memory_order_relaxed)) {
+        mutex_.lock();
+        ownerSite_ = site;
+        acquiredNs_ = 0;
+        return;
+    }
+
+    start = now();
+    contended = !mutex_.try_lock();
+    if (contended)
+        mutex_.lock();
+    acquired = now();
+    ownerSite_ = site;
+    acquiredNs_ = acquired;
+    recordAcquire(site, false, contended, acquired - start);
+}
+
+bool PalSharedMutex::try_lock(pal_lock_site site)
+{
+    if (!mutex_.try_lock())
+        return false;
+
+    ownerSite_ = site;
+    acquiredNs_ = 0;
+    if (statsEnabled_.load(std::memory_order_relaxed)) {
+        acquiredNs_ = now();
+        recordAcquire(site, false, false, 0);
+    }
+    return true;
+}
+
+void PalSharedMutex::unlock()
+{
+    pal_lock_site site = ownerSite_;
+    uint64_t acquired = acquiredNs_;
+
+    ownerSite_ = {nullptr, 0};
+    acquiredNs_ = 0;
+    mutex_.unlock();
+
+    if (acquired && statsEnabled_.load(std::memory_order_relaxed))
+        recordRelease(site, now() - acquired);
+}
+
+void PalSharedMutex::lock_shared(pal_lock_site site)
+{
+    uint64_t start;
+    bool contended;
+
+    if (!statsEnabled_.load(std::memory_order_relaxed)) {
+        mutex_.lock_shared();
+        return;
+    }
+
+    start = now();
+    contended = !mutex_.try_lock_shared();
+    if (contended)
+        mutex_.lock_shared();
+    recordAcquire(site, true, contended, now() - start);
+}
+
+void PalSharedMutex::unlock_shared()
+{
+    mutex_.unlock_shared();
+}
+
+void PalSharedMutex::enableStats(bool enable)
+{
+    PAL_INFO(LOG_TAG, "%s lock statistics %s", name_,
+             enable ? "enabled" : "disabled");
+    statsEnabled_.store(enable, std::memory_order_relaxed);
+}
+
+pal_lock_site_stats *PalSharedMutex::getSiteStats_l(pal_lock_site site)
+{
+    if (!site.func)
+        site.func = "unknown";
+
+    for (uint32_t i = 0; i < numSites_; i++) {
+        if (stats_[i].site.line == site.line &&
+            (stats_[i].site.func == site.func || !strcmp(stats_[i].site.func, site.func)))
+            return &stats_[i];
+    }
+
+    if (numSites_ == PAL_LOCK_STATS_MAX_SITES)
+        return nullptr;
+
+    stats_[numSites_].site = site;
+    return &stats_[numSites_++];
+}
+
+void PalSharedMutex::recordAcquire(pal_lock_site site, bool shared,
+                                   bool contended, uint64_t waitNs)
+{
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    pal_lock_site_stats *st = getSiteStats_l(site);
+
+    if (!st)
+        return;
+
+    if (shared)
+        st->shared_count++;
+    else
+        st->exclusive_count++;
+    if (contended)
+        st->contended_count++;
+    st->wait_ns += waitNs;
+    if (waitNs > st->max_wait_ns)
+        st->max_wait_ns = waitNs;
+}
+
+void PalSharedMutex::recordRelease(pal_lock_site site, uint64_t holdNs)
+{
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    pal_lock_site_stats *st = getSiteStats_l(site);
+
+    if (holdNs > PAL_LOCK_HOLD_WARN_NS)
+        PAL_INFO(LOG_TAG, "%s held by %s:%u for %llu ms", name_,
+                 site.func ? site.func : "unknown", site.line,
+                 (unsigned long long)(holdNs / 1000000));
+
+    if (!st)
+        return;
+
+    st->hold_ns += holdNs;
+    if (holdNs > st->max_hold_ns)
+        st->max_hold_ns = holdNs;
+}
+
+void PalSharedMutex::dumpStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    uint64_t total;
+
+    if (numSites_ == 0)
+        return;
+
+    PAL_INFO(LOG_TAG, "%s lock statistics, %u call sites", name_, numSites_);
+    for (uint32_t i = 0; i < numSites_; i++) {
+        pal_lock_site_stats *st = &stats_[i];
+
+        total = st->exclusive_count + st->shared_count;
+        PAL_INFO(LOG_TAG, "%s:%u: excl %llu shared %llu contended %llu "
+                 "wait avg %llu max %llu us, hold avg %llu max %llu us",
+                 st->site.func, st->site.line,
+                 (unsigned long long)st->exclusive_count,
+                 (unsigned long long)st->shared_count,
+                 (unsigned long long)st->contended_count,
+                 (unsigned long long)(total ? st->wait_ns / total / 1000 : 0),
+                 (unsigned long long)(st->max_wait_ns / 1000),
+                 (unsigned long long)(st->exclusive_count ?
+                     st->hold_ns / st->exclusive_count / 1000 : 0),
+                 (unsigned long long)(st->max_hold_ns / 1000));
+    }
+}
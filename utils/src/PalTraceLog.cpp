@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the
+ * disclaimer below) provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+ * GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+ * HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "PAL: PalTraceLog"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "PalTraceLog.h"
+
+/* owned by one thread at a time, which is the only one writing it */
+struct PalTraceRing {
+    std::atomic<uint64_t> head;
+    std::atomic<bool> inUse;
+    uint32_t tid;
+    uint32_t mask;
+    struct pal_trace_entry *entries;
+};
+
+struct PalTraceThread {
+    PalTraceRing *ring = nullptr;
+    bool noRing = false;
+
+    /* the ring and what is in it outlive the thread, until another one needs it */
+    ~PalTraceThread()
+    {
+        if (ring)
+            ring->inUse.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local PalTraceThread traceThread;
+
+std::atomic<bool> PalTraceLog::active_(false);
+std::atomic<struct pal_trace_site *> PalTraceLog::sites_(nullptr);
+std::atomic<PalTraceRing *> PalTraceLog::rings_[PAL_TRACE_MAX_THREADS];
+uint32_t PalTraceLog::entries_ = PAL_TRACE_DEFAULT_ENTRIES;
+char PalTraceLog::path_[256];
+static std::atomic<bool> dumping(false);
+
+int PalTraceLog::start(const char *path, uint32_t entries)
+{
+    if (enabled()) {
+        PAL_ERR(LOG_TAG, "already tracing");
+        return -EBUSY;
+    }
+    if (strlen(path) >= sizeof(path_)) {
+        PAL_ERR(LOG_TAG, "path %s is too long", path);
+        return -EINVAL;
+    }
+
+    /* a power of two, so that the writer only masks the head */
+    entries_ = 1;
+    while (entries_ < entries && entries_ < (1U << 20))
+        entries_ <<= 1;
+    strlcpy(path_, path, sizeof(path_));
+    active_.store(true);
+    PAL_INFO(LOG_TAG, "tracing to %s, %u entries per thread", path_, entries_);
+    return 0;
+}
+
+void PalTraceLog::stop()
+{
+    if (!enabled())
+        return;
+
+    active_.store(false);
+    dump();
+}
+
+uint64_t PalTraceLog::now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void PalTraceLog::registerSite(struct pal_trace_site *site)
+{
+    bool expected = false;
+
+    if (!site->registered.compare_exchange_strong(expected, true))
+        return;
+
+    site->next = sites_.load(std::memory_order_relaxed);
+    while (!sites_.compare_exchange_weak(site->next, site, std::memory_order_release,
+                                         std::memory_order_relaxed))
+        ;
+}
+
+static PalTraceRing *attachRing(std::atomic<PalTraceRing *> *rings, uint32_t entries)
+{
+    PalTraceRing *ring;
+    PalTraceRing *expected;
+    bool free;
+    uint32_t i;
+
+    for (i = 0; i < PAL_TRACE_MAX_THREADS; i++) {
+        if (rings[i].load(std::memory_order_acquire))
+            continue;
+        ring = new (std::nothrow) PalTraceRing;
+        if (!ring)
+            return nullptr;
+        ring->entries = new (std::nothrow) struct pal_trace_entry[entries];
+        if (!ring->entries) {
+            delete ring;
+            return nullptr;
+        }
+        ring->head.store(0, std::memory_order_relaxed);
+        ring->inUse.store(true, std::memory_order_relaxed);
+        ring->tid = (uint32_t)syscall(SYS_gettid);
+        ring->mask = entries - 1;
+        expected = nullptr;
+        if (rings[i].compare_exchange_strong(expected, ring, std::memory_order_release))
+            return ring;
+        delete[] ring->entries;
+        delete ring;
+    }
+
+    /* all taken, the history of a thread that exited goes first */
+    for (i = 0; i < PAL_TRACE_MAX_THREADS; i++) {
+        ring = rings[i].load(std::memory_order_acquire);
+        free = false;
+        if (ring->inUse.compare_exchange_strong(free, true)) {
+            ring->tid = (uint32_t)syscall(SYS_gettid);
+            ring->head.store(0, std::memory_order_release);
+            return ring;
+        }
+    }
+
+    return nullptr;
+}
+
+struct pal_trace_entry *PalTraceLog::begin()
+{
+    PalTraceRing *ring = traceThread.ring;
+    struct pal_trace_entry *entry;
+
+    if (!ring) {
+        if (traceThread.noRing)
+            return nullptr;
+        ring = attachRing(rings_, entries_);
+        if (!ring) {
+            traceThread.noRing = true;
+            PAL_ERR(LOG_TAG, "no trace ring left for thread %d", (int)syscall(SYS_gettid));
+            return nullptr;
+        }
+        traceThread.ring = ring;
+    }
+
+    entry = &ring->entries[ring->head.load(std::memory_order_relaxed) & ring->mask];
+    entry->ts_ns = now();
+    return entry;
+}
+
+void PalTraceLog::commit()
+{
+    PalTraceRing *ring = traceThread.ring;
+
+    /* publishes the entry to dump() */
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+}
+
+static bool writeAll(int fd, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    ssize_t ret;
+
+    while (size) {
+        ret = write(fd, p, size);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        p += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+/*
+ * Does not allocate or lock, it may run from a signal handler while the
+ * owners keep writing their rings. Heads are sampled before the sites, so
+ * that every dumped entry has its site in the file.
+ */
+int PalTraceLog::dump()
+{
+    struct pal_trace_log_header header;
+    struct pal_trace_log_site siteRec;
+    struct pal_trace_log_thread threadRec;
+    struct pal_trace_entry chunk[32];
+    PalTraceRing *rings[PAL_TRACE_MAX_THREADS];
+    uint64_t heads[PAL_TRACE_MAX_THREADS];
+    struct pal_trace_site *sites;
+    struct pal_trace_site *site;
+    uint64_t size, first, idx, head;
+    uint32_t numRings = 0;
+    uint32_t numSites = 0;
+    uint32_t n, i;
+    bool expected = false;
+    int fd;
+    int ret = 0;
+
+    if (!path_[0])
+        return -EINVAL;
+    if (!dumping.compare_exchange_strong(expected, true))
+        return -EBUSY;
+
+    for (i = 0; i < PAL_TRACE_MAX_THREADS; i++) {
+        rings[numRings] = rings_[i].load(std::memory_order_acquire);
+        if (!rings[numRings])
+            break;
+        heads[numRings] = rings[numRings]->head.load(std::memory_order_acquire);
+        numRings++;
+    }
+    sites = sites_.load(std::memory_order_acquire);
+    for (site = sites; site; site = site->next)
+        numSites++;
+
+    fd = open(path_, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        ret = -errno;
+        PAL_ERR(LOG_TAG, "cannot open %s, error %d", path_, errno);
+        goto done;
+    }
+
+    header.magic = PAL_TRACE_LOG_MAGIC;
+    header.version = PAL_TRACE_LOG_VERSION;
+    header.long_size = sizeof(long);
+    header.num_sites = numSites;
+    header.num_threads = numRings;
+    header.reserved = 0;
+    if (!writeAll(fd, &header, sizeof(header)))
+        goto write_error;
+
+    for (site = sites; site; site = site->next) {
+        siteRec.site = (uint64_t)(uintptr_t)site;
+        siteRec.level = site->level;
+        siteRec.line = site->line;
+        siteRec.tag_len = strlen(site->tag);
+        siteRec.func_len = strlen(site->func);
+        siteRec.fmt_len = strlen(site->fmt);
+        if (!writeAll(fd, &siteRec, sizeof(siteRec)) ||
+            !writeAll(fd, site->tag, siteRec.tag_len) ||
+            !writeAll(fd, site->func, siteRec.func_len) ||
+            !writeAll(fd, site->fmt, siteRec.fmt_len))
+            goto write_error;
+    }
+
+    for (i = 0; i < numRings; i++) {
+        /* the slot at the head is the one the owner fills next, leave it out */
+        size = rings[i]->mask + 1;
+        first = heads[i] >= size ? heads[i] - size + 1 : 0;
+        threadRec.tid = rings[i]->tid;
+        threadRec.num_entries = heads[i] - first;
+        if (!writeAll(fd, &threadRec, sizeof(threadRec)))
+            goto write_error;
+
+        for (idx = first; idx < heads[i]; idx += n) {
+            n = std::min<uint64_t>(heads[i] - idx, sizeof(chunk) / sizeof(chunk[0]));
+            for (uint32_t j = 0; j < n; j++)
+                chunk[j] = rings[i]->entries[(idx + j) & rings[i]->mask];
+            /* the owner got around to these while they were copied */
+            head = rings[i]->head.load(std::memory_order_acquire);
+            for (uint32_t j = 0; j < n; j++) {
+                if (idx + j + size <= head)
+                    chunk[j].site = 0;
+            }
+            if (!writeAll(fd, chunk, n * sizeof(chunk[0])))
+                goto write_error;
+        }
+    }
+
+    PAL_INFO(LOG_TAG, "wrote %u sites of %u threads to %s", numSites, numRings, path_);
+    goto close_fd;
+
+write_error:
+    ret = -EIO;
+    PAL_ERR(LOG_TAG, "cannot write %s, error %d", path_, errno);
+close_fd:
+    close(fd);
+done:
+    dumping.store(false);
+    return ret;
+}